@@ -1,54 +1,82 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-using UnrealBuildTool;
-
-public class MultiplayerSessions : ModuleRules
-{
-	public MultiplayerSessions(ReadOnlyTargetRules Target) : base(Target)
-	{
-		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
-		
-		PublicIncludePaths.AddRange(
-			new string[] {
-				// ... add public include paths required here ...
-			}
-			);
-				
-		PrivateIncludePaths.AddRange(
-			new string[] {
-				// ... add other private include paths required here ...
-			}
-			);
-			
-		PublicDependencyModuleNames.AddRange(
-			new string[]
-			{
-				"Core",
-				"OnlineSubsystem",
-				"OnlineSubsystemSteam",
-				"UMG",
-				"Slate",
-				"SlateCore",
-				// ... add other public dependencies that you statically link with here ...
-			}
-			);
-			
-		PrivateDependencyModuleNames.AddRange(
-			new string[]
-			{
-				"CoreUObject",
-				"Engine",
-				"Slate",
-				"SlateCore",
-				// ... add private dependencies that you statically link with here ...	
-			}
-			);
-		
-		DynamicallyLoadedModuleNames.AddRange(
-			new string[]
-			{
-				// ... add any modules that your module loads dynamically here ...
-			}
-			);
-	}
-}
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class MultiplayerSessions : ModuleRules
+{
+	public MultiplayerSessions(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+		
+		PublicIncludePaths.AddRange(
+			new string[] {
+				// ... add public include paths required here ...
+			}
+			);
+				
+		PrivateIncludePaths.AddRange(
+			new string[] {
+				// ... add other private include paths required here ...
+			}
+			);
+			
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"DeveloperSettings",
+				"OnlineSubsystem",
+				"OnlineSubsystemSteam",
+				"UMG",
+				"Slate",
+				"SlateCore",
+				// ... add other public dependencies that you statically link with here ...
+			}
+			);
+			
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"CoreUObject",
+				"Engine",
+				"Slate",
+				"SlateCore",
+				// ... add private dependencies that you statically link with here ...	
+			}
+			);
+		
+		DynamicallyLoadedModuleNames.AddRange(
+			new string[]
+			{
+				// ... add any modules that your module loads dynamically here ...
+			}
+			);
+
+		// Log levels above MULTIPLAYERSESSIONS_LOG_LEVEL, and disabled sinks, are compiled out (see Logger.h).
+		// Levels: 0 = Off, 1 = Error, 2 = Warning, 3 = Info, 4 = Verbose.
+		int LogLevel = 4;
+		bool bLogToScreen = true;
+		bool bLogToFile = true;
+		bool bLogToTrace = false;
+		switch (Target.Configuration)
+		{
+			case UnrealTargetConfiguration.Shipping:
+				LogLevel = 0;
+				bLogToScreen = false;
+				bLogToFile = false;
+				break;
+			case UnrealTargetConfiguration.Test:
+				LogLevel = 2;
+				bLogToScreen = false;
+				break;
+			case UnrealTargetConfiguration.Debug:
+			case UnrealTargetConfiguration.DebugGame:
+				bLogToTrace = true;
+				break;
+		}
+		PublicDefinitions.Add("MULTIPLAYERSESSIONS_LOG_LEVEL=" + LogLevel);
+		PublicDefinitions.Add("MULTIPLAYERSESSIONS_LOG_TO_SCREEN=" + (bLogToScreen ? "1" : "0"));
+		PublicDefinitions.Add("MULTIPLAYERSESSIONS_LOG_TO_FILE=" + (bLogToFile ? "1" : "0"));
+		PublicDefinitions.Add("MULTIPLAYERSESSIONS_LOG_TO_TRACE=" + (bLogToTrace ? "1" : "0"));
+	}
+}
@@ -0,0 +1,453 @@
+// (c) 2023 Will Roberts
+
+#include "AdmissionController.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+#include "Logger.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsTrace.h"
+
+namespace
+{
+    // Prefixes of PreLogin errors sent to queued and rejected clients.
+    const TCHAR* QueuedMessagePrefix = TEXT("MultiplayerSessions.Queued");
+    const TCHAR* FullMessagePrefix = TEXT("MultiplayerSessions.Full");
+}
+
+/***********************
+FAdmissionResult Methods
+***********************/
+
+// ToErrorMessage writes the retry delay and queue position as key-value pairs, which ParseErrorMessage reads on the client.
+FString FAdmissionResult::ToErrorMessage() const
+{
+    switch (Decision)
+    {
+    case EAdmissionDecision::Queued:
+        return FString::Printf(TEXT("%s RetryAfter=%.1f Position=%d"), QueuedMessagePrefix, RetryAfterSeconds, QueuePosition);
+    case EAdmissionDecision::Rejected:
+        return FString::Printf(TEXT("%s RetryAfter=%.1f"), FullMessagePrefix, RetryAfterSeconds);
+    default:
+        return FString();
+    }
+}
+
+/*************
+Public Methods
+*************/
+
+// FAdmissionController starts with a full bucket, so the first LoginBurst logins are admitted at once.
+FAdmissionController::FAdmissionController(const FMultiplayerAdmissionSettings& InSettings):
+    Settings(InSettings)
+{
+    Settings.LoginsPerSecond = FMath::Max(Settings.LoginsPerSecond, 0.1f);
+    Settings.LoginBurst = FMath::Max(Settings.LoginBurst, 1);
+    Tokens = Settings.LoginBurst;
+}
+
+// UpdateCapacity is called before each decision, since players also arrive and leave without going through PreLogin.
+void FAdmissionController::UpdateCapacity(int32 InNumPlayers, int32 InMaxPlayers)
+{
+    NumPlayers = FMath::Max(InNumPlayers, 0);
+    MaxPlayers = InMaxPlayers;
+    NoteUsedSlots();
+}
+
+// PreLogin admits a client which claims its reserved place in the queue, or a new client when nobody is queued and a slot and token are free.
+// Other new clients are queued until the queue is full, and rejected after that, as are clients without a unique key. Admitted clients hold a reservation until PostLogin.
+FAdmissionResult FAdmissionController::PreLogin(const FString& ClientKey, double Now, bool bUniqueKey)
+{
+    MULTIPLAYER_TRACE_SCOPE("FAdmissionController::PreLogin");
+
+    Refill(Now);
+    FAdmissionResult Result;
+
+    // A client which was admitted but retried its connection keeps its reservation.
+    // Without a unique key, the attempt may come from another client, so it must be admitted on its own.
+    if (double* ReservedTime = bUniqueKey ? Reservations.Find(ClientKey) : nullptr)
+    {
+        *ReservedTime = Now;
+        return Result;
+    }
+
+    // Without a unique key, a retry cannot be told apart from another client's first attempt, so it never claims a ticket.
+    const int32 TicketIndex = bUniqueKey ? Queue.IndexOfByPredicate([&ClientKey](const FTicket& Ticket) { return Ticket.ClientKey == ClientKey; }) : INDEX_NONE;
+    if (TicketIndex != INDEX_NONE)
+    {
+        FTicket& Ticket = Queue[TicketIndex];
+        Ticket.LastAttemptTime = Now;
+        Stats.QueueRetries++;
+        if (Ticket.bReserved)
+        {
+            Stats.Accepted++;
+            Stats.AcceptedFromQueue++;
+            Stats.QueueWait.Record(Now - Ticket.EnqueueTime);
+            Reservations.Add(ClientKey, Now);
+            Queue.RemoveAt(TicketIndex);
+            return Result;
+        }
+
+        Result.Decision = EAdmissionDecision::Queued;
+        Result.QueuePosition = TicketIndex + 1;
+        Result.RetryAfterSeconds = GetRetryAfterSeconds(Result.QueuePosition);
+        return Result;
+    }
+
+    // Clients which are already queued go first, so new clients cannot overtake them.
+    if (Queue.Num() == 0 && NumFreeSlots() > 0 && TakeToken())
+    {
+        Stats.Accepted++;
+        Reservations.Add(ClientKey, Now);
+        NoteUsedSlots();
+        return Result;
+    }
+
+    // Nobody could ever claim a ticket taken without a unique key, so such clients are turned away until the queue has drained.
+    if (!bUniqueKey)
+    {
+        Stats.Rejected++;
+        Result.Decision = EAdmissionDecision::Rejected;
+        Result.RetryAfterSeconds = GetRetryAfterSeconds(Queue.Num() + 1);
+        return Result;
+    }
+
+    if (Queue.Num() < Settings.MaxQueueLength)
+    {
+        FTicket& Ticket = Queue.AddDefaulted_GetRef();
+        Ticket.ClientKey = ClientKey;
+        Ticket.EnqueueTime = Now;
+        Ticket.LastAttemptTime = Now;
+        Stats.Queued++;
+        Stats.PeakQueueLength = FMath::Max(Stats.PeakQueueLength, Queue.Num());
+
+        Result.Decision = EAdmissionDecision::Queued;
+        Result.QueuePosition = Queue.Num();
+        Result.RetryAfterSeconds = GetRetryAfterSeconds(Result.QueuePosition);
+        return Result;
+    }
+
+    Stats.Rejected++;
+    Result.Decision = EAdmissionDecision::Rejected;
+    Result.RetryAfterSeconds = Settings.QueueTicketTimeoutSeconds;
+    return Result;
+}
+
+// PostLogin is also called for players which were never admitted here, such as the listen server's own player.
+// Reservations under one key are interchangeable, so any of them is released.
+void FAdmissionController::PostLogin(const FString& ClientKey)
+{
+    for (auto It = Reservations.CreateKeyIterator(ClientKey); It; ++It)
+    {
+        It.RemoveCurrent();
+        break;
+    }
+}
+
+// Tick releases reservations which were not used in time, removes clients which stopped retrying from the queue,
+// and reserves free slots for the front of the queue, in order.
+// Queued clients must claim their reserved slot within the reservation timeout too, or they lose their place and the slot is freed.
+void FAdmissionController::Tick(double Now)
+{
+    MULTIPLAYER_TRACE_SCOPE("FAdmissionController::Tick");
+
+    Refill(Now);
+
+    for (auto It = Reservations.CreateIterator(); It; ++It)
+    {
+        if (Now - It.Value() > Settings.ReservationTimeoutSeconds)
+        {
+            Stats.ReservationsExpired++;
+            It.RemoveCurrent();
+        }
+    }
+
+    Queue.RemoveAll([this, Now](const FTicket& Ticket)
+    {
+        if (Ticket.bReserved && Now - Ticket.ReservedTime > Settings.ReservationTimeoutSeconds)
+        {
+            Stats.ReservationsExpired++;
+            return true;
+        }
+        if (Now - Ticket.LastAttemptTime > Settings.QueueTicketTimeoutSeconds)
+        {
+            Stats.TicketsExpired++;
+            return true;
+        }
+        return false;
+    });
+
+    for (FTicket& Ticket : Queue)
+    {
+        if (Ticket.bReserved)
+        {
+            continue;
+        }
+        if (NumFreeSlots() <= 0 || !TakeToken())
+        {
+            break;
+        }
+        Ticket.bReserved = true;
+        Ticket.ReservedTime = Now;
+    }
+    NoteUsedSlots();
+}
+
+// NumReserved counts admitted clients which are still logging in, and queued clients with a reserved slot.
+int32 FAdmissionController::NumReserved() const
+{
+    int32 NumReservedTickets = 0;
+    for (const FTicket& Ticket : Queue)
+    {
+        NumReservedTickets += Ticket.bReserved ? 1 : 0;
+    }
+    return Reservations.Num() + NumReservedTickets;
+}
+
+// ParseErrorMessage reads "RetryAfter" and "Position" values, which are missing from rejections.
+bool FAdmissionController::ParseErrorMessage(const FString& ErrorMessage, float& OutRetryAfterSeconds, int32& OutQueuePosition)
+{
+    if (!ErrorMessage.StartsWith(QueuedMessagePrefix) && !ErrorMessage.StartsWith(FullMessagePrefix))
+    {
+        return false;
+    }
+    OutRetryAfterSeconds = 0.f;
+    OutQueuePosition = 0;
+    FParse::Value(*ErrorMessage, TEXT("RetryAfter="), OutRetryAfterSeconds);
+    FParse::Value(*ErrorMessage, TEXT("Position="), OutQueuePosition);
+    return true;
+}
+
+/**************
+Private Methods
+**************/
+
+// Refill adds the tokens earned since the last refill, up to LoginBurst.
+void FAdmissionController::Refill(double Now)
+{
+    if (LastRefillTime >= 0.0 && Now > LastRefillTime)
+    {
+        Tokens = FMath::Min<double>(Settings.LoginBurst, Tokens + (Now - LastRefillTime) * Settings.LoginsPerSecond);
+    }
+    LastRefillTime = FMath::Max(LastRefillTime, Now);
+}
+
+bool FAdmissionController::TakeToken()
+{
+    if (Tokens < 1.0)
+    {
+        return false;
+    }
+    Tokens -= 1.0;
+    return true;
+}
+
+// NumFreeSlots subtracts players and reservations from the slots.
+int32 FAdmissionController::NumFreeSlots() const
+{
+    if (MaxPlayers <= 0)
+    {
+        return MAX_int32;
+    }
+    return MaxPlayers - NumPlayers - NumReserved();
+}
+
+// GetRetryAfterSeconds estimates when the client's turn comes from the login rate, and asks it to retry
+// well before its place in the queue expires.
+float FAdmissionController::GetRetryAfterSeconds(int32 QueuePosition) const
+{
+    const float Estimate = QueuePosition / Settings.LoginsPerSecond;
+    const float Latest = FMath::Max(Settings.QueueTicketTimeoutSeconds * 0.5f, Settings.MinRetryAfterSeconds);
+    return FMath::Clamp(Estimate, Settings.MinRetryAfterSeconds, Latest);
+}
+
+void FAdmissionController::NoteUsedSlots()
+{
+    Stats.PeakUsedSlots = FMath::Max(Stats.PeakUsedSlots, NumPlayers + NumReserved());
+}
+
+/***************
+Console Commands
+***************/
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+    /*
+     * FStormClient is one simulated client of a join storm.
+     */
+    struct FStormClient
+    {
+        double NextAttemptTime{ 0.0 };
+        double FirstAttemptTime{ 0.0 };
+        double LoginTime{ -1.0 };
+        double JoinTime{ -1.0 };
+        int32 Attempts{ 0 };
+        bool bGaveUp{ false };
+    };
+}
+
+// RunJoinStorm simulates clients which all try to join one host within ArrivalSeconds, using the project's admission settings.
+// Admitted clients finish logging in after LoadSeconds. Queued and rejected clients retry when told to,
+// and give up after MaxWaitSeconds. The simulation runs on a virtual clock, so a storm of any size completes at once.
+static void RunJoinStorm(const TArray<FString>& Args)
+{
+    int32 NumClients = 100;
+    int32 Slots = 16;
+    double ArrivalSeconds = 1.0;
+    double LoadSeconds = 2.0;
+    double MaxWaitSeconds = 60.0;
+    const double StepSeconds = 0.05;
+    for (const FString& Arg : Args)
+    {
+        FString Key;
+        FString Value;
+        if (!Arg.Split(TEXT("="), &Key, &Value))
+        {
+            continue;
+        }
+        if (Key == TEXT("Clients"))
+        {
+            NumClients = FMath::Max(FCString::Atoi(*Value), 1);
+        }
+        else if (Key == TEXT("Slots"))
+        {
+            Slots = FMath::Max(FCString::Atoi(*Value), 1);
+        }
+        else if (Key == TEXT("ArrivalSeconds"))
+        {
+            ArrivalSeconds = FMath::Max(FCString::Atod(*Value), 0.0);
+        }
+        else if (Key == TEXT("LoadSeconds"))
+        {
+            LoadSeconds = FMath::Max(FCString::Atod(*Value), 0.0);
+        }
+        else if (Key == TEXT("MaxWaitSeconds"))
+        {
+            MaxWaitSeconds = FMath::Max(FCString::Atod(*Value), 1.0);
+        }
+    }
+
+    FAdmissionController Controller(GetDefault<UMultiplayerSessionsSettings>()->AdmissionControl);
+    FRandomStream Random(NumClients);
+    TArray<FStormClient> Clients;
+    Clients.SetNum(NumClients);
+    for (FStormClient& Client : Clients)
+    {
+        Client.NextAttemptTime = Random.FRandRange(0.0, ArrivalSeconds);
+        Client.FirstAttemptTime = Client.NextAttemptTime;
+    }
+
+    FLatencyHistogram PreLoginTime;
+    FLatencyHistogram TimeToJoin;
+    int32 NumPlayers = 0;
+    int32 NumResolved = 0;
+    double TimeToFill = -1.0;
+    int32 PeakLoginsPerSecond = 0;
+    TArray<double> RecentLogins;
+
+    double Now = 0.0;
+    for (; NumResolved < NumClients && Now < ArrivalSeconds + MaxWaitSeconds + LoadSeconds + StepSeconds; Now += StepSeconds)
+    {
+        Controller.UpdateCapacity(NumPlayers, Slots);
+        Controller.Tick(Now);
+
+        for (int32 Index = 0; Index < Clients.Num(); ++Index)
+        {
+            FStormClient& Client = Clients[Index];
+            const FString ClientKey = FString::Printf(TEXT("StormClient%d"), Index);
+
+            // Admitted clients finish loading, and are counted as players.
+            if (Client.LoginTime >= 0.0 && Client.JoinTime < 0.0 && Now >= Client.LoginTime + LoadSeconds)
+            {
+                Controller.PostLogin(ClientKey);
+                Client.JoinTime = Now;
+                NumPlayers++;
+                NumResolved++;
+                TimeToJoin.Record(Now - Client.FirstAttemptTime);
+                if (NumPlayers == Slots && TimeToFill < 0.0)
+                {
+                    TimeToFill = Now;
+                }
+                continue;
+            }
+            if (Client.LoginTime >= 0.0 || Client.bGaveUp || Now < Client.NextAttemptTime)
+            {
+                continue;
+            }
+            if (Now - Client.FirstAttemptTime > MaxWaitSeconds)
+            {
+                Client.bGaveUp = true;
+                NumResolved++;
+                continue;
+            }
+
+            Controller.UpdateCapacity(NumPlayers, Slots);
+            const double StartTime = FPlatformTime::Seconds();
+            const FAdmissionResult Result = Controller.PreLogin(ClientKey, Now);
+            PreLoginTime.Record(FPlatformTime::Seconds() - StartTime);
+            Client.Attempts++;
+
+            if (Result.Decision == EAdmissionDecision::Admitted)
+            {
+                Client.LoginTime = Now;
+                RecentLogins.Add(Now);
+                RecentLogins.RemoveAll([Now](double LoginTime) { return Now - LoginTime >= 1.0; });
+                PeakLoginsPerSecond = FMath::Max(PeakLoginsPerSecond, RecentLogins.Num());
+            }
+            else
+            {
+                Client.NextAttemptTime = Now + Result.RetryAfterSeconds;
+            }
+        }
+    }
+
+    int32 NumGaveUp = 0;
+    int32 MaxAttempts = 0;
+    for (const FStormClient& Client : Clients)
+    {
+        NumGaveUp += Client.bGaveUp ? 1 : 0;
+        MaxAttempts = FMath::Max(MaxAttempts, Client.Attempts);
+    }
+
+    const FAdmissionStats& Stats = Controller.GetStats();
+    const bool bOvercommitted = Stats.PeakUsedSlots > Slots;
+    MULTIPLAYER_LOG(Info, TEXT("JoinStorm: %d clients, %d slots: %d joined, %d gave up, full after %.2fs, peak %d logins/s, peak %d slots used%s"),
+        NumClients, Slots, NumPlayers, NumGaveUp, TimeToFill, PeakLoginsPerSecond, Stats.PeakUsedSlots, bOvercommitted ? TEXT(" (OVERCOMMITTED)") : TEXT(""));
+    MULTIPLAYER_LOG(Info, TEXT("JoinStorm: %lld accepted (%lld from queue), %lld queued, %lld retries, %lld rejected, %lld queue places expired, peak queue %d"),
+        Stats.Accepted, Stats.AcceptedFromQueue, Stats.Queued, Stats.QueueRetries, Stats.Rejected, Stats.TicketsExpired, Stats.PeakQueueLength);
+    MULTIPLAYER_LOG(Info, TEXT("JoinStorm: Time to join p50 %.2fs p95 %.2fs, queue wait p95 %.2fs, at most %d attempts, PreLogin mean %.2fus max %.2fus"),
+        TimeToJoin.GetPercentile(50.0), TimeToJoin.GetPercentile(95.0), Stats.QueueWait.GetPercentile(95.0), MaxAttempts,
+        PreLoginTime.GetMeanSeconds() * 1e6, PreLoginTime.GetMaxSeconds() * 1e6);
+
+    FString Csv = TEXT("Clients,Slots,Joined,GaveUp,TimeToFillSeconds,PeakLoginsPerSecond,PeakUsedSlots,Accepted,AcceptedFromQueue,Queued,QueueRetries,Rejected,TicketsExpired,PeakQueueLength,TimeToJoinP50Seconds,TimeToJoinP95Seconds,QueueWaitP95Seconds\n");
+    Csv += FString::Printf(TEXT("%d,%d,%d,%d,%.3f,%d,%d,%lld,%lld,%lld,%lld,%lld,%lld,%d,%.3f,%.3f,%.3f\n"),
+        NumClients, Slots, NumPlayers, NumGaveUp, TimeToFill, PeakLoginsPerSecond, Stats.PeakUsedSlots,
+        Stats.Accepted, Stats.AcceptedFromQueue, Stats.Queued, Stats.QueueRetries, Stats.Rejected, Stats.TicketsExpired, Stats.PeakQueueLength,
+        TimeToJoin.GetPercentile(50.0), TimeToJoin.GetPercentile(95.0), Stats.QueueWait.GetPercentile(95.0));
+    const FString Path = FPaths::Combine(
+        FPaths::ProjectSavedDir(),
+        TEXT("MultiplayerSessions"),
+        FString::Printf(TEXT("JoinStorm-%s.csv"), *FDateTime::Now().ToString())
+    );
+    if (FFileHelper::SaveStringToFile(Csv, *Path))
+    {
+        MULTIPLAYER_LOG(Info, TEXT("JoinStorm: Wrote %s"), *Path);
+    }
+    else
+    {
+        MULTIPLAYER_LOG(Error, TEXT("JoinStorm: Failed to write %s"), *Path);
+    }
+}
+
+static FAutoConsoleCommand JoinStormCommand(
+    TEXT("MultiplayerSessions.JoinStorm"),
+    TEXT("Simulates many clients joining one host at once through admission control, and reports how the slots filled. ")
+    TEXT("Usage: MultiplayerSessions.JoinStorm [Clients=100] [Slots=16] [ArrivalSeconds=1] [LoadSeconds=2] [MaxWaitSeconds=60]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunJoinStorm)
+);
+#endif
\ No newline at end of file
@@ -0,0 +1,126 @@
+// (c) 2023 Will Roberts
+
+#include "AdmissionGameMode.h"
+#include "Logger.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTrace.h"
+
+#include "Engine/GameInstance.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+
+/*************
+Public Methods
+*************/
+
+// AAdmissionGameMode ticks, so slots and tokens are reserved for queued clients between their retries.
+AAdmissionGameMode::AAdmissionGameMode():
+	Admission(GetDefault<UMultiplayerSessionsSettings>()->AdmissionControl)
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+// PreLogin runs the base class checks first, then asks admission control whether the client may log in.
+// Queued and rejected clients receive the decision as the error message.
+void AAdmissionGameMode::PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage)
+{
+	MULTIPLAYER_TRACE_SCOPE("AAdmissionGameMode::PreLogin");
+
+	Super::PreLogin(Options, Address, UniqueId, ErrorMessage);
+	if (!ErrorMessage.IsEmpty())
+	{
+		return;
+	}
+
+	UpdateCapacity();
+	const FString ClientKey = GetClientKey(UniqueId, Address);
+	const FAdmissionResult Result = Admission.PreLogin(ClientKey, FPlatformTime::Seconds(), UniqueId.IsValid());
+	if (Result.Decision == EAdmissionDecision::Admitted)
+	{
+		MULTIPLAYER_LOG(Verbose, TEXT("PreLogin: Admitted %s"), *ClientKey);
+		return;
+	}
+
+	ErrorMessage = Result.ToErrorMessage();
+	MULTIPLAYER_LOG(Info, TEXT("PreLogin: %s %s"), Result.Decision == EAdmissionDecision::Queued ? TEXT("Queued") : TEXT("Rejected"), *ClientKey);
+}
+
+// PostLogin releases the player's reservation, since the player now counts towards the session's slots.
+void AAdmissionGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	const APlayerState* PlayerState = NewPlayer->GetPlayerState<APlayerState>();
+	const UNetConnection* Connection = NewPlayer->GetNetConnection();
+	const FString Address = Connection ? Connection->LowLevelGetRemoteAddress() : FString();
+	Admission.PostLogin(GetClientKey(PlayerState ? PlayerState->GetUniqueId() : FUniqueNetIdRepl(), Address));
+	UpdateCapacity();
+}
+
+// Tick expires reservations and queue places, and reserves free slots for queued clients.
+void AAdmissionGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	UpdateCapacity();
+	Admission.Tick(FPlatformTime::Seconds());
+}
+
+/**************
+Private Methods
+**************/
+
+// GetClientKey uses the same key in PreLogin and PostLogin, which both see the client's unique net ID and address.
+// Clients behind one NAT share an address, so address keys are not unique, and admission control reserves a slot per attempt for them and never queues them.
+FString AAdmissionGameMode::GetClientKey(const FUniqueNetIdRepl& UniqueId, const FString& Address)
+{
+	return UniqueId.IsValid() ? UniqueId->ToString() : Address;
+}
+
+// UpdateCapacity reads the slots from the settings, or from the hosted game session when they are not set.
+void AAdmissionGameMode::UpdateCapacity()
+{
+	int32 MaxPlayers = Admission.GetSettings().MaxPlayers;
+	if (MaxPlayers <= 0)
+	{
+		const UGameInstance* GameInstance = GetGameInstance();
+		const UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+		MaxPlayers = Subsystem ? Subsystem->GetHostedPublicConnections() : 0;
+	}
+	Admission.UpdateCapacity(GetNumPlayers(), MaxPlayers);
+}
+
+/***************
+Console Commands
+***************/
+
+#if !UE_BUILD_SHIPPING
+// LogAdmissionStats logs the admission decisions of the world's game mode, when it uses admission control.
+static void LogAdmissionStats(const TArray<FString>& Args, UWorld* World)
+{
+	const AAdmissionGameMode* GameMode = World ? World->GetAuthGameMode<AAdmissionGameMode>() : nullptr;
+	if (!GameMode)
+	{
+		MULTIPLAYER_LOG(Error, TEXT("AdmissionStats: The world's game mode does not use admission control"));
+		return;
+	}
+
+	const FAdmissionController& Admission = GameMode->GetAdmissionController();
+	const FAdmissionStats& Stats = Admission.GetStats();
+	MULTIPLAYER_LOG(Info, TEXT("AdmissionStats: %lld accepted (%lld from queue), %lld queued, %lld rejected, %lld reservations expired, %lld queue places expired"),
+		Stats.Accepted, Stats.AcceptedFromQueue, Stats.Queued, Stats.Rejected, Stats.ReservationsExpired, Stats.TicketsExpired);
+	MULTIPLAYER_LOG(Info, TEXT("AdmissionStats: %d queued, %d reserved, peak queue %d, peak slots used %d, queue wait p50 %.2fs p95 %.2fs"),
+		Admission.NumQueued(), Admission.NumReserved(), Stats.PeakQueueLength, Stats.PeakUsedSlots,
+		Stats.QueueWait.GetPercentile(50.0), Stats.QueueWait.GetPercentile(95.0));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs AdmissionStatsCommand(
+	TEXT("MultiplayerSessions.AdmissionStats"),
+	TEXT("Logs the accepted, queued and rejected logins of the host's admission control."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&LogAdmissionStats)
+);
+#endif
\ No newline at end of file
@@ -1,65 +1,78 @@
-// (c) 2023 Will Roberts
-
-#include "DebugGameMode.h"
-#include "Logger.h"
-
-#include "GameFramework/GameStateBase.h"
-#include "GameFramework/PlayerState.h"
-
-/*************
-Public Methods
-*************/
-
-// PostLogin overrides the corresponding base class function to log player names and counts.
-void ADebugGameMode::PostLogin(APlayerController* NewPlayer)
-{
-	Super::PostLogin(NewPlayer);
-
-	APlayerState* PlayerState = NewPlayer->GetPlayerState<APlayerState>();
-	if (PlayerState)
-	{
-		FString PlayerName = PlayerState->GetPlayerName();
-		Logger::Log(FString::Printf(TEXT("Player %s has joined"), *PlayerName), false);
-	}
-	else
-	{
-		Logger::Log(TEXT("PostLogin: Failed to get PlayerState"), true);
-	}
-
-	if (GameState)
-	{
-		int32 NumPlayers = GameState.Get()->PlayerArray.Num();
-		Logger::Log(FString::Printf(TEXT("Players in game: %d"), NumPlayers), false);
-	}
-	else
-	{
-		Logger::Log(TEXT("PostLogin: Failed to get GameState"), true);
-	}
-}
-
-// Logout overrides the corresponding base class function to log player names and counts.
-void ADebugGameMode::Logout(AController* ExitingPlayer)
-{
-	Super::Logout(ExitingPlayer);
-
-	APlayerState* PlayerState = ExitingPlayer->GetPlayerState<APlayerState>();
-	if (PlayerState)
-	{
-		FString PlayerName = PlayerState->GetPlayerName();
-		Logger::Log(FString::Printf(TEXT("Player %s has disconnected"), *PlayerName), false);
-	}
-	else
-	{
-		Logger::Log(TEXT("Logout: Failed to get PlayerState"), true);
-	}
-
-	if (GameState)
-	{
-		int32 NumPlayers = GameState.Get()->PlayerArray.Num();
-		Logger::Log(FString::Printf(TEXT("Players in game: %d"), NumPlayers - 1), false);
-	}
-	else
-	{
-		Logger::Log(TEXT("Logout: Failed to get GameState"), true);
-	}
+// (c) 2023 Will Roberts
+
+#include "DebugGameMode.h"
+#include "Logger.h"
+#include "MultiplayerSessionsTrace.h"
+
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+
+/*************
+Public Methods
+*************/
+
+// ADebugGameMode enables seamless travel. The engine falls back to hard travel in PIE, unless net.AllowPIESeamlessTravel is set.
+ADebugGameMode::ADebugGameMode()
+{
+	bUseSeamlessTravel = true;
+}
+
+// PostLogin overrides the corresponding base class function to log player names and counts.
+void ADebugGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	MULTIPLAYER_TRACE_SCOPE("ADebugGameMode::PostLogin");
+	TRACE_BOOKMARK(TEXT("MultiplayerSessions PostLogin"));
+
+	Super::PostLogin(NewPlayer);
+
+	APlayerState* PlayerState = NewPlayer->GetPlayerState<APlayerState>();
+	if (PlayerState)
+	{
+		FString PlayerName = PlayerState->GetPlayerName();
+		MULTIPLAYER_LOG(Info, TEXT("Player %s has joined"), *PlayerName);
+	}
+	else
+	{
+		MULTIPLAYER_LOG(Error, TEXT("PostLogin: Failed to get PlayerState"));
+	}
+
+	if (GameState)
+	{
+		int32 NumPlayers = GameState.Get()->PlayerArray.Num();
+		MULTIPLAYER_LOG(Info, TEXT("Players in game: %d"), NumPlayers);
+	}
+	else
+	{
+		MULTIPLAYER_LOG(Error, TEXT("PostLogin: Failed to get GameState"));
+	}
+}
+
+// Logout overrides the corresponding base class function to log player names and counts.
+void ADebugGameMode::Logout(AController* ExitingPlayer)
+{
+	MULTIPLAYER_TRACE_SCOPE("ADebugGameMode::Logout");
+	TRACE_BOOKMARK(TEXT("MultiplayerSessions Logout"));
+
+	Super::Logout(ExitingPlayer);
+
+	APlayerState* PlayerState = ExitingPlayer->GetPlayerState<APlayerState>();
+	if (PlayerState)
+	{
+		FString PlayerName = PlayerState->GetPlayerName();
+		MULTIPLAYER_LOG(Info, TEXT("Player %s has disconnected"), *PlayerName);
+	}
+	else
+	{
+		MULTIPLAYER_LOG(Error, TEXT("Logout: Failed to get PlayerState"));
+	}
+
+	if (GameState)
+	{
+		int32 NumPlayers = GameState.Get()->PlayerArray.Num();
+		MULTIPLAYER_LOG(Info, TEXT("Players in game: %d"), NumPlayers - 1);
+	}
+	else
+	{
+		MULTIPLAYER_LOG(Error, TEXT("Logout: Failed to get GameState"));
+	}
 }
\ No newline at end of file
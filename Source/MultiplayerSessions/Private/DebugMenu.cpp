@@ -1,291 +1,406 @@
-// (c) 2023 Will Roberts
-
-#include "DebugMenu.h"
-#include "Logger.h"
-
-#include "Components/Button.h"
-#include "Interfaces/OnlineSessionInterface.h"
-#include "MultiplayerSessionsSubsystem.h"
-#include "OnlineSessionSettings.h"
-#include "OnlineSubsystem.h"
-
-/*************
-Public Methods
-*************/
-
-// AddMultiplayerDebugMenu implements the user-facing setup method for new debug menus.
-// This function is callable from Blueprints.
-void UDebugMenu::AddMultiplayerDebugMenu(
-    int32 MaxSearchResults,
-    int32 NumPlayers,
-    FString GameMode,
-    FString LobbyMap
-) {
-    // Save arguments for later reference.
-    SessionSearchLimit = MaxSearchResults;
-    NumPublicConnections = NumPlayers;
-    MatchType = GameMode;
-    LobbyMapPath = FString::Printf(TEXT("%s?listen"), *LobbyMap);
-
-    // Add the widget to the viewport.
-    AddToViewport();
-    SetVisibility(ESlateVisibility::Visible);
-    bIsFocusable = true;
-
-    // Get the player controller from the World.
-    UWorld* World = GetWorld();
-    if (!World)
-    {
-        Logger::Log(FString(TEXT("DebugMenu: Failed to get World")), true);
-        return;
-    }
-    APlayerController* PlayerController = World->GetFirstPlayerController();
-    if (!PlayerController)
-    {
-        Logger::Log(FString(TEXT("DebugMenu: Failed to get PlayerController")), true);
-        return;
-    }
-
-    // Configure mouse input for the menu widget.
-    /*
-    FInputModeUIOnly InputModeData;
-    InputModeData.SetWidgetToFocus(TakeWidget());
-    InputModeData.SetLockMouseToViewportBehavior(EMouseLockMode::DoNotLock);
-    PlayerController->SetInputMode(InputModeData);
-    PlayerController->SetShowMouseCursor(true);
-    */
-
-    // Get the Subsystem from the GameInstance.
-    UGameInstance* GameInstance = GetGameInstance();
-    if (!GameInstance)
-    {
-        Logger::Log(FString(TEXT("DebugMenu: Failed to get GameInstance")), true);
-        return;
-    }
-    MultiplayerSessionsSubsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
-    if (!MultiplayerSessionsSubsystem)
-    {
-        Logger::Log(FString(TEXT("DebugMenu: Failed to get MultiplayerSessionSubsystem")), true);
-        return;
-    }
-
-    // Bind callbacks.
-    MultiplayerSessionsSubsystem->MultiplayerOnCreateSessionComplete.AddDynamic(this, &ThisClass::OnCreateSession);
-    MultiplayerSessionsSubsystem->MultiplayerOnFindSessionsComplete.AddUObject(this, &ThisClass::OnFindSessions);
-    MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionComplete.AddUObject(this, &ThisClass::OnJoinSession);
-    MultiplayerSessionsSubsystem->MultiplayerOnDestroySessionComplete.AddDynamic(this, &ThisClass::OnDestroySession);
-    MultiplayerSessionsSubsystem->MultiplayerOnStartSessionComplete.AddDynamic(this, &ThisClass::OnStartSession);
-}
-
-/****************
-Protected Methods
-****************/
-
-// Initialize adds click handlers to the Host and Join buttons.
-bool UDebugMenu::Initialize()
-{
-    if (!Super::Initialize())
-    {
-        Logger::Log(FString(TEXT("Initialize: Failed to initialize DebugMenu")), true);
-        return false;
-    }
-
-    if (!HostButton)
-    {
-        Logger::Log(FString(TEXT("Initialize: HostButton not found")), true);
-    }
-    else
-    {
-        HostButton->OnClicked.AddDynamic(this, &UDebugMenu::HostButtonClicked);
-    }
-
-    if (!JoinButton)
-    {
-        Logger::Log(FString(TEXT("Initialize: HostButton not found")), true);
-    }
-    else
-    {
-        JoinButton->OnClicked.AddDynamic(this, &UDebugMenu::JoinButtonClicked);
-    }
-
-    return true;
-}
-
-// NativeDestruct calls the custom UDebugMenu::Destroy() function when the parent widget is destroyed.
-void UDebugMenu::NativeDestruct()
-{
-    Destroy();
-    Super::NativeDestruct();
-}
-
-// OnCreateSession is the delegate callback for session creation.
-// When session creation was successful, initiates server travel to the lobby map.
-void UDebugMenu::OnCreateSession(bool bWasSuccessful)
-{
-    Logger::Log(FString(TEXT("UDebugMenu::OnCreateSession callback fired")), false);
-
-    if (!bWasSuccessful)
-    {
-        Logger::Log(FString(TEXT("OnCreateSession: Failed to create session")), true);
-        HostButton->SetIsEnabled(true);
-        return;
-    }
-
-    UWorld* World = GetWorld();
-    if (!World)
-    {
-        Logger::Log(FString(TEXT("OnCreateSession: Failed to get World")), true);
-        return;
-    }
-
-    Logger::Log(FString::Printf(TEXT("OnCreateSession: Initiating server travel to map %s"), *LobbyMapPath), false);
-    bWasSuccessful = World->ServerTravel(*LobbyMapPath);
-    if (!bWasSuccessful)
-    {
-        Logger::Log(FString(TEXT("OnCreateSession: Server travel failed")), true);
-    }
-}
-
-// OnFindSessions is the delegate callback for session search.
-// When a valid session is found, initiate a session join.
-void UDebugMenu::OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful)
-{
-    if (!bWasSuccessful || SessionResults.Num() == 0)
-    {
-        Logger::Log(FString(TEXT("OnFindSessions: No sessions found")), true);
-        JoinButton->SetIsEnabled(true);
-        return;
-    }
-
-    if (!MultiplayerSessionsSubsystem)
-    {
-        Logger::Log(FString(TEXT("OnFindSessions: Failed to get MultiplayerSessionsSubsystem")), true);
-        return;
-    }
-
-    for (auto Result : SessionResults)
-    {
-        FString SettingsValue;
-        Result.Session.SessionSettings.Get(FName("MatchType"), SettingsValue);
-        if (SettingsValue != MatchType)
-        {
-            continue;
-        }
-
-        MultiplayerSessionsSubsystem->JoinSession(Result);
-        return;
-    }
-
-    Logger::Log(FString(TEXT("OnFindSessions: No sessions matched")), true);
-}
-
-// OnJoinSession is the delegate callback for session joins.
-// When joining succeeds, initiate client travel to the session's platform-specific connection address.
-void UDebugMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
-{
-    // Check the result of the call.
-    if (Result != EOnJoinSessionCompleteResult::Success)
-    {
-        JoinButton->SetIsEnabled(true);
-        Logger::Log(FString(TEXT("OnJoinSession: Failed to join session")), true);
-        return;
-    }
-
-    // Get a pointer to the SessionInterface from the OnlineSubsystem.
-    IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get();
-    if (!OnlineSubsystem)
-    {
-        Logger::Log(FString(TEXT("OnJoinSession: Failed to get OnlineSubsystem")), true);
-        return;
-    }
-    IOnlineSessionPtr SessionInterface = OnlineSubsystem->GetSessionInterface();
-    if (!SessionInterface.IsValid())
-    {
-        Logger::Log(FString(TEXT("OnJoinSession: Failed to get SessionInterface")), true);
-        return;
-    }
-
-    // Get the platform-specific address of the session.
-    FString Address;
-    SessionInterface->GetResolvedConnectString(NAME_GameSession, Address);
-
-    // Get the PlayerController and initiate client travel to the session.
-    APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
-    if (!PlayerController)
-    {
-        Logger::Log(FString(TEXT("OnJoinSession: Failed to get PlayerController")), true);
-        return;
-    }
-
-    Logger::Log(FString(TEXT("OnJoinSession: Initiating client travel")), false);
-    PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);
-}
-
-// OnDestroySession is the delegate callback for session destruction.
-void UDebugMenu::OnDestroySession(bool bWasSuccessful)
-{
-    if (!bWasSuccessful)
-    {
-        Logger::Log(FString(TEXT("OnDestroySession: Failed to destroy session")), true);
-        return;
-    }
-    Logger::Log(FString(TEXT("OnDestroySession: Destroyed session")), false);
-}
-
-// OnStartSession is the delegate callback for session initiation.
-void UDebugMenu::OnStartSession(bool bWasSuccessful)
-{
-    if (!bWasSuccessful)
-    {
-        Logger::Log(FString(TEXT("OnStartSession: Failed to start session")), true);
-        return;
-    }
-    Logger::Log(FString(TEXT("OnStartSession: Started session")), false);
-}
-
-/**************
-Private Methods
-**************/
-
-// Destroy the menu widget and return control to the player controller.
-void UDebugMenu::Destroy()
-{
-    // Remove the Widget from the UI.
-    RemoveFromParent();
-}
-
-// HostButtonClicked temporarily disables the Host button before initiating session creation.
-void UDebugMenu::HostButtonClicked()
-{
-    HostButton->SetIsEnabled(false);
-
-    if (!MultiplayerSessionsSubsystem)
-    {
-        Logger::Log(FString(TEXT("HostButtonClicked: Failed to get MultiplayerSessionsSubsystem")), true);
-        return;
-    }
-
-    Logger::Log(
-        FString::Printf(
-            TEXT("HostButtonClicked: Creating session with match type: %s, connections: %d"),
-            *MatchType,
-            NumPublicConnections
-        ), false);
-
-    Logger::Log(FString(TEXT("UDebugMenu::HostButtonClicked creating session")), false);
-    MultiplayerSessionsSubsystem->CreateSession(NumPublicConnections, MatchType); 
-}
-
-// JoinButtonClicked temporarily disables the Join button before initiating session search.
-void UDebugMenu::JoinButtonClicked()
-{
-    JoinButton->SetIsEnabled(false);
-
-    if (!MultiplayerSessionsSubsystem)
-    {
-        Logger::Log(FString(TEXT("JoinButtonClicked: Failed to get MultiplayerSessionsSubsystem")), true);
-        return;
-    }
-
-    MultiplayerSessionsSubsystem->FindSessions(SessionSearchLimit);
+// (c) 2023 Will Roberts
+
+#include "DebugMenu.h"
+#include "Logger.h"
+
+#include "Components/Button.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTrace.h"
+#include "OnlineSessionSettings.h"
+#include "SessionSearchIndex.h"
+
+/*************
+Public Methods
+*************/
+
+// AddMultiplayerDebugMenu implements the user-facing setup method for new debug menus.
+// This function is callable from Blueprints.
+void UDebugMenu::AddMultiplayerDebugMenu(
+    int32 MaxSearchResults,
+    int32 NumPlayers,
+    FString GameMode,
+    FString LobbyMap
+) {
+    // Save arguments for later reference.
+    SessionSearchLimit = MaxSearchResults;
+    NumPublicConnections = NumPlayers;
+    MatchType = GameMode;
+    LobbyMapPath = FString::Printf(TEXT("%s?listen"), *LobbyMap);
+
+    // Add the widget to the viewport.
+    AddToViewport();
+    SetVisibility(ESlateVisibility::Visible);
+    bIsFocusable = true;
+
+    // Get the player controller from the World.
+    UWorld* World = GetWorld();
+    if (!World)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("DebugMenu: Failed to get World"));
+        return;
+    }
+    APlayerController* PlayerController = World->GetFirstPlayerController();
+    if (!PlayerController)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("DebugMenu: Failed to get PlayerController"));
+        return;
+    }
+
+    // Configure mouse input for the menu widget.
+    /*
+    FInputModeUIOnly InputModeData;
+    InputModeData.SetWidgetToFocus(TakeWidget());
+    InputModeData.SetLockMouseToViewportBehavior(EMouseLockMode::DoNotLock);
+    PlayerController->SetInputMode(InputModeData);
+    PlayerController->SetShowMouseCursor(true);
+    */
+
+    // Get the Subsystem from the GameInstance.
+    UGameInstance* GameInstance = GetGameInstance();
+    if (!GameInstance)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("DebugMenu: Failed to get GameInstance"));
+        return;
+    }
+    MultiplayerSessionsSubsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
+    if (!MultiplayerSessionsSubsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("DebugMenu: Failed to get MultiplayerSessionSubsystem"));
+        return;
+    }
+
+    // Bind callbacks.
+    MultiplayerSessionsSubsystem->MultiplayerOnCreateSessionComplete.AddDynamic(this, &ThisClass::OnCreateSession);
+    MultiplayerSessionsSubsystem->MultiplayerOnFindSessionsComplete.AddUObject(this, &ThisClass::OnFindSessions);
+    MultiplayerSessionsSubsystem->MultiplayerOnFindSessionsBatch.AddUObject(this, &ThisClass::OnFindSessionsBatch);
+    MultiplayerSessionsSubsystem->MultiplayerOnFindSessionsMatch.AddUObject(this, &ThisClass::OnFindSessionsMatch);
+    MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionComplete.AddUObject(this, &ThisClass::OnJoinSession);
+    MultiplayerSessionsSubsystem->MultiplayerOnDestroySessionComplete.AddDynamic(this, &ThisClass::OnDestroySession);
+    MultiplayerSessionsSubsystem->MultiplayerOnStartSessionComplete.AddDynamic(this, &ThisClass::OnStartSession);
+
+    // Search in the background while the menu is open, so Quick Play can join without waiting for a search.
+    if (QuickPlayButton)
+    {
+        MultiplayerSessionsSubsystem->StartQuickPlay(MakeSearchFilter());
+    }
+}
+
+/****************
+Protected Methods
+****************/
+
+// Initialize adds click handlers to the Host, Join and Quick Play buttons.
+bool UDebugMenu::Initialize()
+{
+    if (!Super::Initialize())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Initialize: Failed to initialize DebugMenu"));
+        return false;
+    }
+
+    if (!HostButton)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Initialize: HostButton not found"));
+    }
+    else
+    {
+        HostButton->OnClicked.AddDynamic(this, &UDebugMenu::HostButtonClicked);
+    }
+
+    if (!JoinButton)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Initialize: HostButton not found"));
+    }
+    else
+    {
+        JoinButton->OnClicked.AddDynamic(this, &UDebugMenu::JoinButtonClicked);
+    }
+
+    if (QuickPlayButton)
+    {
+        QuickPlayButton->OnClicked.AddDynamic(this, &UDebugMenu::QuickPlayButtonClicked);
+    }
+
+    return true;
+}
+
+// NativeDestruct calls the custom UDebugMenu::Destroy() function when the parent widget is destroyed.
+void UDebugMenu::NativeDestruct()
+{
+    Destroy();
+    Super::NativeDestruct();
+}
+
+// OnCreateSession is the delegate callback for session creation.
+// When session creation was successful, initiates server travel to the lobby map.
+// This travel is always a hard travel, since seamless travel cannot start listening for connections.
+void UDebugMenu::OnCreateSession(bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("UDebugMenu::OnCreateSession");
+    MULTIPLAYER_LOG(Verbose, TEXT("UDebugMenu::OnCreateSession callback fired"));
+
+    if (!bWasSuccessful)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnCreateSession: Failed to create session"));
+        HostButton->SetIsEnabled(true);
+        return;
+    }
+
+    UWorld* World = GetWorld();
+    if (!World)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnCreateSession: Failed to get World"));
+        return;
+    }
+
+    MULTIPLAYER_LOG(Info, TEXT("OnCreateSession: Initiating server travel to map %s"), *LobbyMapPath);
+    FMultiplayerSessionsTrace::BeginTravel();
+    {
+        MULTIPLAYER_TRACE_SCOPE("UDebugMenu::ServerTravel");
+        bWasSuccessful = World->ServerTravel(*LobbyMapPath);
+    }
+    if (!bWasSuccessful)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnCreateSession: Server travel failed"));
+        MultiplayerSessionsSubsystem->ReleasePreloadedMap();
+    }
+}
+
+// OnFindSessions is the delegate callback for session search.
+// When valid sessions are found, initiate a session join with the best ranked sessions.
+void UDebugMenu::OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("UDebugMenu::OnFindSessions");
+
+    if (!bWasSuccessful || SessionResults.Num() == 0)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnFindSessions: No sessions found"));
+        JoinButton->SetIsEnabled(true);
+        return;
+    }
+
+    if (!MultiplayerSessionsSubsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnFindSessions: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    // Use the subsystem's index over the results, which compares interned match types instead of strings.
+    const FSessionSearchIndex& SearchIndex = MultiplayerSessionsSubsystem->GetSearchIndex();
+    const int32 MatchTypeId = SearchIndex.FindMatchTypeId(MatchType);
+    if (MatchTypeId != INDEX_NONE)
+    {
+        // Rank the sessions of the requested match type which have an open slot.
+        // The subsystem joins the best one, and falls back to the next best if the join fails.
+        TArray<int32> Candidates;
+        SearchIndex.FindAll(MatchTypeId, 1, Candidates);
+
+        TArray<int32> BestIndices;
+        MultiplayerSessionsSubsystem->GetBestSessions(GetDefault<UMultiplayerSessionsSettings>()->MaxJoinAttempts, BestIndices, &Candidates);
+        if (BestIndices.Num() > 0)
+        {
+            MultiplayerSessionsSubsystem->JoinRankedSessions(BestIndices);
+            return;
+        }
+    }
+
+    MULTIPLAYER_LOG(Error, TEXT("OnFindSessions: No sessions matched"));
+}
+
+// OnFindSessionsBatch is the delegate callback for streamed search results.
+// Matching sessions are handled by OnFindSessionsMatch, so this only needs to handle a search which ends without a match.
+void UDebugMenu::OnFindSessionsBatch(TArrayView<const FOnlineSessionSearchResult> SessionResults, bool bIsFinalBatch)
+{
+    if (!bIsFinalBatch || bSearchMatched)
+    {
+        return;
+    }
+
+    MULTIPLAYER_LOG(Error, TEXT("OnFindSessionsBatch: No sessions matched"));
+    JoinButton->SetIsEnabled(true);
+}
+
+// OnFindSessionsMatch is the delegate callback for the first streamed result with the requested match type and an open slot.
+// The search stops at this result, and a session join is initiated immediately.
+void UDebugMenu::OnFindSessionsMatch(const FOnlineSessionSearchResult& SessionResult)
+{
+    if (!MultiplayerSessionsSubsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnFindSessionsMatch: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    bSearchMatched = true;
+    MultiplayerSessionsSubsystem->JoinSession(SessionResult);
+}
+
+// OnJoinSession is the delegate callback for session joins.
+// When joining succeeds, initiate client travel to the session's platform-specific connection address.
+// Connecting to a new server requires a hard travel, but the subsystem has prefetched the session's map during the join,
+// so the map loads from memory. Later server travels from the lobby are seamless.
+void UDebugMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
+{
+    MULTIPLAYER_TRACE_SCOPE("UDebugMenu::OnJoinSession");
+
+    // Check the result of the call.
+    if (Result != EOnJoinSessionCompleteResult::Success)
+    {
+        JoinButton->SetIsEnabled(true);
+        if (QuickPlayButton)
+        {
+            QuickPlayButton->SetIsEnabled(true);
+        }
+        MULTIPLAYER_LOG(Error, TEXT("OnJoinSession: Failed to join session"));
+        return;
+    }
+
+    // Get the platform-specific address of the session from the session backend.
+    FString Address;
+    {
+        MULTIPLAYER_TRACE_SCOPE("UDebugMenu::GetResolvedConnectString");
+        if (!MultiplayerSessionsSubsystem || !MultiplayerSessionsSubsystem->GetResolvedConnectString(Address))
+        {
+            MULTIPLAYER_LOG(Error, TEXT("OnJoinSession: Failed to get session address"));
+            return;
+        }
+    }
+
+    // Get the PlayerController and initiate client travel to the session.
+    APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
+    if (!PlayerController)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnJoinSession: Failed to get PlayerController"));
+        return;
+    }
+
+    MULTIPLAYER_LOG(Info, TEXT("OnJoinSession: Initiating client travel"));
+    FMultiplayerSessionsTrace::BeginTravel();
+    {
+        MULTIPLAYER_TRACE_SCOPE("UDebugMenu::ClientTravel");
+        PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);
+    }
+}
+
+// OnDestroySession is the delegate callback for session destruction.
+void UDebugMenu::OnDestroySession(bool bWasSuccessful)
+{
+    if (!bWasSuccessful)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnDestroySession: Failed to destroy session"));
+        return;
+    }
+    MULTIPLAYER_LOG(Info, TEXT("OnDestroySession: Destroyed session"));
+}
+
+// OnStartSession is the delegate callback for session initiation.
+void UDebugMenu::OnStartSession(bool bWasSuccessful)
+{
+    if (!bWasSuccessful)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnStartSession: Failed to start session"));
+        return;
+    }
+    MULTIPLAYER_LOG(Info, TEXT("OnStartSession: Started session"));
+}
+
+// MakeSearchFilter is applied by the provider where possible, and locally otherwise.
+FMultiplayerSessionSearchFilter UDebugMenu::MakeSearchFilter() const
+{
+    FMultiplayerSessionSearchFilter Filter;
+    Filter.MatchType = MatchType;
+    Filter.MinOpenSlots = 1;
+    return Filter;
+}
+
+/**************
+Private Methods
+**************/
+
+// Destroy the menu widget and return control to the player controller.
+// Quick play stops searching once the menu is gone, unless a quick play join is still in progress.
+void UDebugMenu::Destroy()
+{
+    if (QuickPlayButton && MultiplayerSessionsSubsystem)
+    {
+        MultiplayerSessionsSubsystem->StopQuickPlay();
+    }
+
+    // Remove the Widget from the UI.
+    RemoveFromParent();
+}
+
+// HostButtonClicked temporarily disables the Host button, then preloads the lobby map and initiates session creation.
+void UDebugMenu::HostButtonClicked()
+{
+    HostButton->SetIsEnabled(false);
+
+    if (!MultiplayerSessionsSubsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("HostButtonClicked: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    MULTIPLAYER_LOG(
+        Info,
+        TEXT("HostButtonClicked: Creating session with match type: %s, connections: %d"),
+        *MatchType,
+        NumPublicConnections
+    );
+
+    // Load the lobby while the session is created, so travel starts with the map in memory.
+    MultiplayerSessionsSubsystem->PreloadMap(LobbyMapPath);
+
+    MULTIPLAYER_LOG(Verbose, TEXT("UDebugMenu::HostButtonClicked creating session"));
+    MultiplayerSessionsSubsystem->CreateSession(NumPublicConnections, MatchType); 
+}
+
+// JoinButtonClicked temporarily disables the Join button before initiating session search.
+void UDebugMenu::JoinButtonClicked()
+{
+    JoinButton->SetIsEnabled(false);
+
+    if (!MultiplayerSessionsSubsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("JoinButtonClicked: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    bSearchMatched = false;
+    const FMultiplayerSessionSearchFilter Filter = MakeSearchFilter();
+
+    // Wait for all results so they can be ranked, and join the best session.
+    if (bJoinBestSession)
+    {
+        MultiplayerSessionsSubsystem->FindSessions(SessionSearchLimit, Filter);
+        return;
+    }
+
+    // Otherwise, stream results so the first joinable session is used without waiting for the slowest responder.
+
+    const FVariantData WantedMatchType(MatchType);
+    MultiplayerSessionsSubsystem->FindSessionsStreaming(
+        SessionSearchLimit,
+        Filter,
+        SessionSearchBatchSize,
+        [WantedMatchType](const FOnlineSessionSearchResult& Result)
+        {
+            return Result.Session.NumOpenPublicConnections > 0 && FSessionSearchIndex::ResultHasMatchType(Result, WantedMatchType);
+        }
+    );
+}
+
+// QuickPlayButtonClicked temporarily disables the Quick Play button, and joins the best session from the warm pool.
+// OnJoinSession travels to the session, or enables the button again when the join fails.
+void UDebugMenu::QuickPlayButtonClicked()
+{
+    QuickPlayButton->SetIsEnabled(false);
+
+    if (!MultiplayerSessionsSubsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("QuickPlayButtonClicked: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+    MultiplayerSessionsSubsystem->QuickPlay();
 }
\ No newline at end of file
@@ -0,0 +1,404 @@
+// (c) 2023 Will Roberts
+
+#include "DirectorySessionBackend.h"
+#include "Misc/Guid.h"
+#include "OnlineSessionSettings.h"
+#include "OnlineSubsystemTypes.h"
+
+#include "MultiplayerSessionsTrace.h"
+
+namespace
+{
+    /*
+     * FDirectorySessionInfo identifies a directory session, so joins can look it up by session ID.
+     */
+    class FDirectorySessionInfo final : public FOnlineSessionInfo
+    {
+    public:
+        explicit FDirectorySessionInfo(const FString& InSessionId):
+            SessionId(FUniqueNetIdString::Create(InSessionId, FName("Directory")))
+        {}
+
+        virtual const uint8* GetBytes() const override { return nullptr; }
+        virtual int32 GetSize() const override { return sizeof(FDirectorySessionInfo); }
+        virtual bool IsValid() const override { return true; }
+        virtual const FUniqueNetId& GetSessionId() const override { return *SessionId; }
+        virtual FString ToString() const override { return SessionId->ToString(); }
+        virtual FString ToDebugString() const override { return FString::Printf(TEXT("DirectorySession %s"), *SessionId->ToString()); }
+
+    private:
+        FUniqueNetIdRef SessionId;
+    };
+
+    // MakeSearchResult converts a directory entry to a search result, with its indexed fields and attributes as advertised settings.
+    FOnlineSessionSearchResult MakeSearchResult(const FSessionDirectoryEntry& Entry)
+    {
+        FOnlineSessionSearchResult Result;
+        FOnlineSession& Session = Result.Session;
+        Session.OwningUserName = Entry.OwnerName;
+        Session.SessionInfo = MakeShared<FDirectorySessionInfo>(Entry.SessionId);
+        Session.NumOpenPublicConnections = Entry.NumOpenPublicConnections;
+        Session.SessionSettings.NumPublicConnections = Entry.NumPublicConnections;
+        Session.SessionSettings.BuildUniqueId = Entry.BuildUniqueId;
+        Session.SessionSettings.bShouldAdvertise = true;
+        Session.SessionSettings.bAllowJoinInProgress = true;
+        if (!Entry.MatchType.IsEmpty())
+        {
+            Session.SessionSettings.Set(FName("MatchType"), Entry.MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+        if (!Entry.Region.IsEmpty())
+        {
+            Session.SessionSettings.Set(FName("Region"), Entry.Region, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+        for (const TPair<FName, FString>& Attribute : Entry.Attributes)
+        {
+            Session.SessionSettings.Set(Attribute.Key, Attribute.Value, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+        return Result;
+    }
+}
+
+/*************
+Public Methods
+*************/
+
+// FDirectorySessionBackend starts ticking unless it is driven manually.
+FDirectorySessionBackend::FDirectorySessionBackend(
+    const FMultiplayerDirectoryBackendSettings& InSettings,
+    TSharedRef<FSessionDirectory> InDirectory,
+    bool bInManualTick
+):
+    Settings(InSettings),
+    Directory(MoveTemp(InDirectory))
+{
+    if (!bInManualTick)
+    {
+        TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FDirectorySessionBackend::Tick));
+    }
+}
+
+// ~FDirectorySessionBackend removes hosted sessions from the directory right away, rather than leaving them to expire.
+// Pending completions are dropped without being delivered.
+FDirectorySessionBackend::~FDirectorySessionBackend()
+{
+    if (TickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+    }
+
+    TArray<FString> SessionIds = MoveTemp(PendingRemovals);
+    for (const TPair<FName, FNamedSession>& Pair : NamedSessions)
+    {
+        if (Pair.Value.bIsHost)
+        {
+            SessionIds.Add(Pair.Value.SessionId);
+        }
+    }
+    Directory->Remove(SessionIds);
+}
+
+// CreateSession registers the session with the next batch. Sessions which are not advertised are hosted without being registered.
+bool FDirectorySessionBackend::CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+    if (NamedSessions.Contains(SessionName))
+    {
+        PendingCompletions.Add([this, SessionName]() { TriggerOnCreateSessionCompleteDelegates(SessionName, false); });
+        return false;
+    }
+
+    FNamedSession& Session = NamedSessions.Add(SessionName);
+    Session.SessionId = FGuid::NewGuid().ToString(EGuidFormats::Digits);
+    Session.OwnerName = HostingPlayerId.ToString();
+    Session.ConnectAddress = Settings.HostAddress;
+    Session.bIsHost = true;
+    if (NewSessionSettings.bShouldAdvertise)
+    {
+        PendingRegistrations.Add(MakeEntry(Session.SessionId, Session.OwnerName, NewSessionSettings));
+    }
+    PendingCompletions.Add([this, SessionName]() { TriggerOnCreateSessionCompleteDelegates(SessionName, true); });
+    return true;
+}
+
+// FindSessions pages through the directory, one page per tick, until MaxSearchResults are found or no pages remain.
+// The match type, region and minimum open slots are filtered inside the directory. Only one search runs at a time.
+bool FDirectorySessionBackend::FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    return StartSearch(SearchSettings, 0, false);
+}
+
+// FindSessionsPage fetches a single page after Cursor, and completes with the cursor of the page after it.
+bool FDirectorySessionBackend::FindSessionsPage(
+    const FUniqueNetId& SearchingPlayerId,
+    const TSharedRef<FOnlineSessionSearch>& SearchSettings,
+    uint64 Cursor
+) {
+    return StartSearch(SearchSettings, Cursor, true);
+}
+
+// CancelFindSessions stops paging. Its completion is never delivered.
+bool FDirectorySessionBackend::CancelFindSessions()
+{
+    if (!ActiveSearch.IsValid())
+    {
+        return false;
+    }
+    ActiveSearch->SearchState = EOnlineAsyncTaskState::Failed;
+    ActiveSearch.Reset();
+    return true;
+}
+
+// JoinSession looks the session up in the directory, so sessions which expired or filled up since the search fail to join.
+bool FDirectorySessionBackend::JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+    if (NamedSessions.Contains(SessionName))
+    {
+        PendingCompletions.Add([this, SessionName]() { TriggerOnJoinSessionCompleteDelegates(SessionName, EOnJoinSessionCompleteResult::AlreadyInSession); });
+        return false;
+    }
+
+    FSessionDirectoryEntry Entry;
+    EOnJoinSessionCompleteResult::Type Result = EOnJoinSessionCompleteResult::Success;
+    if (!Directory->Find(DesiredSession.GetSessionIdStr(), Entry))
+    {
+        Result = EOnJoinSessionCompleteResult::SessionDoesNotExist;
+    }
+    else if (Entry.NumOpenPublicConnections <= 0)
+    {
+        Result = EOnJoinSessionCompleteResult::SessionIsFull;
+    }
+    else
+    {
+        FNamedSession& Session = NamedSessions.Add(SessionName);
+        Session.SessionId = Entry.SessionId;
+        Session.ConnectAddress = Entry.HostAddress;
+    }
+    PendingCompletions.Add([this, SessionName, Result]() { TriggerOnJoinSessionCompleteDelegates(SessionName, Result); });
+    return true;
+}
+
+// DestroySession removes a hosted session from the directory with the next batch, dropping any registration still waiting to be sent.
+bool FDirectorySessionBackend::DestroySession(FName SessionName)
+{
+    FNamedSession Session;
+    if (!NamedSessions.RemoveAndCopyValue(SessionName, Session))
+    {
+        PendingCompletions.Add([this, SessionName]() { TriggerOnDestroySessionCompleteDelegates(SessionName, false); });
+        return false;
+    }
+
+    if (Session.bIsHost)
+    {
+        PendingRegistrations.RemoveAll([&Session](const FSessionDirectoryEntry& Entry) { return Entry.SessionId == Session.SessionId; });
+        PendingRemovals.Add(Session.SessionId);
+    }
+    PendingCompletions.Add([this, SessionName]() { TriggerOnDestroySessionCompleteDelegates(SessionName, true); });
+    return true;
+}
+
+// StartSession succeeds for any session this player is in. The directory does not track whether matches are in progress.
+bool FDirectorySessionBackend::StartSession(FName SessionName)
+{
+    const bool bExists = NamedSessions.Contains(SessionName);
+    PendingCompletions.Add([this, SessionName, bExists]() { TriggerOnStartSessionCompleteDelegates(SessionName, bExists); });
+    return true;
+}
+
+// UpdateSession re-registers a hosted session with its new settings. It keeps its session ID, so it stays visible throughout.
+bool FDirectorySessionBackend::UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData)
+{
+    const FNamedSession* Session = NamedSessions.Find(SessionName);
+    const bool bIsHost = Session && Session->bIsHost;
+    if (bIsHost)
+    {
+        if (UpdatedSessionSettings.bShouldAdvertise)
+        {
+            PendingRegistrations.Add(MakeEntry(Session->SessionId, Session->OwnerName, UpdatedSessionSettings));
+        }
+        else
+        {
+            PendingRemovals.Add(Session->SessionId);
+        }
+    }
+    PendingCompletions.Add([this, SessionName, bIsHost]() { TriggerOnUpdateSessionCompleteDelegates(SessionName, bIsHost); });
+    return true;
+}
+
+// HasSession returns 'true' for sessions which have been created or joined, including those whose completion is still pending.
+bool FDirectorySessionBackend::HasSession(FName SessionName) const
+{
+    return NamedSessions.Contains(SessionName);
+}
+
+// GetResolvedConnectString returns the address the session's host advertised.
+bool FDirectorySessionBackend::GetResolvedConnectString(FName SessionName, FString& ConnectInfo)
+{
+    const FNamedSession* Session = NamedSessions.Find(SessionName);
+    if (!Session)
+    {
+        return false;
+    }
+    ConnectInfo = Session->ConnectAddress;
+    return true;
+}
+
+// GetDefaultPlayerId returns a fixed player ID, so the directory can be used without a local player.
+FUniqueNetIdPtr FDirectorySessionBackend::GetDefaultPlayerId() const
+{
+    return FUniqueNetIdString::Create(TEXT("DirectoryPlayer"), FName("Directory"));
+}
+
+// ProcessPending sends removals before registrations, so a session destroyed and hosted again in one tick is not removed twice.
+bool FDirectorySessionBackend::ProcessPending()
+{
+    MULTIPLAYER_TRACE_SCOPE("FDirectorySessionBackend::ProcessPending");
+
+    const double Now = FPlatformTime::Seconds();
+    if (PendingRegistrations.Num() > 0 || PendingRemovals.Num() > 0)
+    {
+        Stats.Batches++;
+        Stats.Registrations += PendingRegistrations.Num();
+        Stats.Removals += PendingRemovals.Num();
+        Directory->Remove(PendingRemovals);
+        Directory->Register(MoveTemp(PendingRegistrations), Now);
+        PendingRemovals.Reset();
+        PendingRegistrations.Reset();
+    }
+
+    if (Now - LastHeartbeatTime >= Settings.HeartbeatIntervalSeconds)
+    {
+        LastHeartbeatTime = Now;
+        TArray<FString> SessionIds;
+        for (const TPair<FName, FNamedSession>& Pair : NamedSessions)
+        {
+            if (Pair.Value.bIsHost)
+            {
+                SessionIds.Add(Pair.Value.SessionId);
+            }
+        }
+        if (SessionIds.Num() > 0)
+        {
+            Stats.Heartbeats += Directory->Heartbeat(SessionIds, Now);
+        }
+        Directory->ExpireStale(Now, Settings.ExpirySeconds);
+    }
+
+    if (ActiveSearch.IsValid())
+    {
+        FetchSearchPage();
+    }
+
+    // Completions may start new operations, whose completions are delivered by the next call.
+    TArray<TUniqueFunction<void()>> Completions = MoveTemp(PendingCompletions);
+    PendingCompletions.Reset();
+    for (TUniqueFunction<void()>& Complete : Completions)
+    {
+        Complete();
+    }
+    return ActiveSearch.IsValid() || PendingCompletions.Num() > 0;
+}
+
+/**************
+Private Methods
+**************/
+
+// Tick does the pending work once per frame.
+bool FDirectorySessionBackend::Tick(float DeltaTime)
+{
+    ProcessPending();
+    return true;
+}
+
+// StartSearch builds the directory query from the search's query settings. It fails while another search is in flight.
+bool FDirectorySessionBackend::StartSearch(const TSharedRef<FOnlineSessionSearch>& SearchSettings, uint64 Cursor, bool bIsPage)
+{
+    if (ActiveSearch.IsValid())
+    {
+        if (bIsPage)
+        {
+            PendingCompletions.Add([this]() { TriggerOnFindSessionsPageCompleteDelegates(false, 0); });
+        }
+        else
+        {
+            PendingCompletions.Add([this]() { TriggerOnFindSessionsCompleteDelegates(false); });
+        }
+        return false;
+    }
+
+    ActiveQuery = FSessionDirectoryQuery();
+    ActiveQuery.Cursor = Cursor;
+    SearchSettings->QuerySettings.Get(FName("MatchType"), ActiveQuery.MatchType);
+    SearchSettings->QuerySettings.Get(FName("Region"), ActiveQuery.Region);
+    SearchSettings->QuerySettings.Get(SEARCH_MINSLOTSAVAILABLE, ActiveQuery.MinOpenSlots);
+
+    ActiveSearch = SearchSettings;
+    bActiveSearchIsPage = bIsPage;
+    SearchSettings->SearchResults.Reset();
+    SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+    return true;
+}
+
+// MakeEntry describes a hosted session for the directory. Advertised settings other than the indexed fields become attributes.
+FSessionDirectoryEntry FDirectorySessionBackend::MakeEntry(
+    const FString& SessionId,
+    const FString& OwnerName,
+    const FOnlineSessionSettings& SessionSettings
+) const {
+    FSessionDirectoryEntry Entry;
+    Entry.SessionId = SessionId;
+    Entry.OwnerName = OwnerName;
+    Entry.HostAddress = Settings.HostAddress;
+    Entry.NumPublicConnections = SessionSettings.NumPublicConnections;
+    Entry.NumOpenPublicConnections = SessionSettings.NumPublicConnections;
+    Entry.BuildUniqueId = SessionSettings.BuildUniqueId;
+    SessionSettings.Get(FName("MatchType"), Entry.MatchType);
+    SessionSettings.Get(FName("Region"), Entry.Region);
+    for (const TPair<FName, FOnlineSessionSetting>& Setting : SessionSettings.Settings)
+    {
+        const bool bIsIndexed = Setting.Key == FName("MatchType") || Setting.Key == FName("Region");
+        if (!bIsIndexed && Setting.Value.AdvertisementType != EOnlineDataAdvertisementType::DontAdvertise)
+        {
+            Entry.Attributes.Add(Setting.Key, Setting.Value.Data.ToString());
+        }
+    }
+    return Entry;
+}
+
+// FetchSearchPage appends the next page to the in-flight search, and completes it after the last page.
+// Searches started by FindSessionsPage complete after one page, which holds up to MaxSearchResults sessions.
+void FDirectorySessionBackend::FetchSearchPage()
+{
+    FOnlineSessionSearch& Search = *ActiveSearch;
+    const int32 Remaining = Search.MaxSearchResults - Search.SearchResults.Num();
+    uint64 NextCursor = 0;
+    if (Remaining > 0)
+    {
+        ActiveQuery.PageSize = bActiveSearchIsPage ? Remaining : FMath::Min(Settings.PageSize, Remaining);
+        const double StartTime = FPlatformTime::Seconds();
+        const FSessionDirectoryPage Page = Directory->Query(ActiveQuery);
+        Stats.PageLatency.Record(FPlatformTime::Seconds() - StartTime);
+        Stats.PagesFetched++;
+
+        Search.SearchResults.Reserve(Search.SearchResults.Num() + Page.Entries.Num());
+        for (const FSessionDirectoryEntry& Entry : Page.Entries)
+        {
+            Search.SearchResults.Add(MakeSearchResult(Entry));
+        }
+        NextCursor = Page.NextCursor;
+        if (!bActiveSearchIsPage && NextCursor != 0 && Search.SearchResults.Num() < Search.MaxSearchResults)
+        {
+            ActiveQuery.Cursor = NextCursor;
+            return;
+        }
+    }
+
+    Search.SearchState = EOnlineAsyncTaskState::Done;
+    ActiveSearch.Reset();
+    if (bActiveSearchIsPage)
+    {
+        PendingCompletions.Add([this, NextCursor]() { TriggerOnFindSessionsPageCompleteDelegates(true, NextCursor); });
+    }
+    else
+    {
+        PendingCompletions.Add([this]() { TriggerOnFindSessionsCompleteDelegates(true); });
+    }
+}
\ No newline at end of file
@@ -1,43 +1,466 @@
-// (c) 2023 Will Roberts
-
-#include "Logger.h"
-
-#include "Engine/Engine.h"
-#include "Logging/LogCategory.h"
-#include "Logging/LogVerbosity.h"
-
-DEFINE_LOG_CATEGORY(LogMultiplayerSessions);
-
-/*************
-Public Methods
-*************/
-
-Logger::Logger() {}
-
-Logger::~Logger() {}
-
-// Log writes a log message to the screen via GEngine and to file log via ULOG.
-void Logger::Log(FString Message, bool bIsError)
-{
-    // Log the message to the screen if the engine is available.
-    if (GEngine)
-    {
-        GEngine->AddOnScreenDebugMessage(
-            -1, // Message index -1 avoids overwriting existing log messages.
-            15.f, // Show the message for 15 seconds.
-            bIsError ? FColor::Red : FColor::Cyan,
-            Message
-        );
-    }
-
-    // Log the message to file.
-    ELogVerbosity::Type LogVerbosity = bIsError ? ELogVerbosity::Error : ELogVerbosity::Display;
-    if (bIsError)
-    {
-        UE_LOG(LogMultiplayerSessions, Error, TEXT("%s"), *Message);
-    }
-    else
-    {
-        UE_LOG(LogMultiplayerSessions, Display, TEXT("%s"), *Message);
-    }
-}
\ No newline at end of file
+// (c) 2023 Will Roberts
+
+#include "Logger.h"
+#include "LogRingBuffer.h"
+
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Logging/LogCategory.h"
+#include "Logging/LogVerbosity.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+#include "MultiplayerSessionsSettings.h"
+
+#include <atomic>
+
+DEFINE_LOG_CATEGORY(LogMultiplayerSessions);
+
+std::atomic<uint8> Logger::RuntimeLevel{ static_cast<uint8>(MULTIPLAYERSESSIONS_LOG_LEVEL) };
+
+namespace
+{
+    constexpr uint32 QueueCapacity = 4096;
+
+    // The logging thread wakes at this interval, or sooner when the queue is filling up.
+    constexpr uint32 DrainIntervalMilliseconds = 10;
+
+    // On-screen messages are shown for this long, and identical messages within this time are merged.
+    constexpr float OnScreenSeconds = 15.f;
+
+    // At most this many new on-screen messages are shown per second. Bursts of up to the same number are allowed.
+    constexpr float OnScreenMessagesPerSecond = 8.f;
+
+    // Key of the on-screen line which reports messages hidden by the rate limit.
+    constexpr uint64 SuppressedMessageKey = 0x4D534C4F47ull;
+
+    struct FOnScreenMessage
+    {
+        FString Text;
+        EMultiplayerLogLevel Level;
+    };
+
+    // WriteToFile writes a message to the output log at the verbosity matching its level.
+    void WriteToFile(const FString& Message, EMultiplayerLogLevel Level)
+    {
+        switch (Level)
+        {
+        case EMultiplayerLogLevel::Error: UE_LOG(LogMultiplayerSessions, Error, TEXT("%s"), *Message); break;
+        case EMultiplayerLogLevel::Warning: UE_LOG(LogMultiplayerSessions, Warning, TEXT("%s"), *Message); break;
+        case EMultiplayerLogLevel::Info: UE_LOG(LogMultiplayerSessions, Display, TEXT("%s"), *Message); break;
+        default: UE_LOG(LogMultiplayerSessions, Log, TEXT("%s"), *Message); break;
+        }
+    }
+
+    FColor GetScreenColor(EMultiplayerLogLevel Level)
+    {
+        switch (Level)
+        {
+        case EMultiplayerLogLevel::Error: return FColor::Red;
+        case EMultiplayerLogLevel::Warning: return FColor::Yellow;
+        case EMultiplayerLogLevel::Info: return FColor::Cyan;
+        default: return FColor::White;
+        }
+    }
+
+    struct FOnScreenEntry
+    {
+        int32 Count;
+        double LastShown;
+    };
+
+    /*
+     * FLoggerState holds the queue, the logging thread, and the on-screen message state.
+     */
+    struct FLoggerState : public FRunnable
+    {
+        TMpscRingBuffer<FLogRecord, QueueCapacity> Queue;
+        TQueue<FOnScreenMessage, EQueueMode::Spsc> OnScreenQueue;
+
+        FRunnableThread* Thread{ nullptr };
+
+        // Kept for the process lifetime once created, so a producer racing Shutdown never wakes a released event.
+        FEvent* WakeEvent{ nullptr };
+        FTSTicker::FDelegateHandle OnScreenTickerHandle;
+        std::atomic<bool> bRunning{ false };
+        std::atomic<bool> bStopRequested{ false };
+
+        // Only accessed by the game thread.
+        TMap<uint64, FOnScreenEntry> RecentOnScreen;
+        float OnScreenTokens{ OnScreenMessagesPerSecond };
+        int32 SuppressedSinceNotice{ 0 };
+
+        std::atomic<uint64> Queued{ 0 };
+        std::atomic<uint64> Dropped{ 0 };
+        std::atomic<uint64> Written{ 0 };
+
+        // Producers between their check of bRunning and the end of their write. Shutdown waits for them before the final drain.
+        std::atomic<int32> NumProducers{ 0 };
+        uint64 OnScreenDeduplicated{ 0 };
+        uint64 OnScreenSuppressed{ 0 };
+
+        virtual uint32 Run() override
+        {
+            while (!bStopRequested.load(std::memory_order_acquire))
+            {
+                Drain();
+                WakeEvent->Wait(DrainIntervalMilliseconds);
+            }
+            Drain();
+            return 0;
+        }
+
+        // Drain formats and writes every queued record. On-screen output is handed to the game thread.
+        void Drain()
+        {
+            auto WriteRecord = [this](FLogRecord& Record)
+            {
+                FString Message = Record.Format();
+#if MULTIPLAYERSESSIONS_LOG_TO_FILE
+                WriteToFile(Message, Record.Level);
+#endif
+#if MULTIPLAYERSESSIONS_LOG_TO_TRACE
+                TRACE_BOOKMARK(TEXT("%s"), *Message);
+#endif
+#if MULTIPLAYERSESSIONS_LOG_TO_SCREEN
+                OnScreenQueue.Enqueue(FOnScreenMessage{ MoveTemp(Message), Record.Level });
+#endif
+                Record.Reset();
+                Written.fetch_add(1, std::memory_order_relaxed);
+            };
+
+            while (Queue.TryConsume(WriteRecord))
+            {
+            }
+        }
+
+        // TickOnScreen shows messages written by the logging thread, merging repeats and limiting the rate of new lines.
+        bool TickOnScreen(float DeltaTime)
+        {
+            const double Now = FPlatformTime::Seconds();
+            OnScreenTokens = FMath::Min(OnScreenTokens + DeltaTime * OnScreenMessagesPerSecond, OnScreenMessagesPerSecond);
+
+            FOnScreenMessage Message;
+            while (OnScreenQueue.Dequeue(Message))
+            {
+                if (!GEngine)
+                {
+                    continue;
+                }
+
+                // Repeats replace the displayed line, so they do not count against the rate limit.
+                const uint64 Key = GetTypeHash(Message.Text) | (1ull << 32);
+                const FColor Color = GetScreenColor(Message.Level);
+                FOnScreenEntry* Entry = RecentOnScreen.Find(Key);
+                if (Entry && Now - Entry->LastShown < OnScreenSeconds)
+                {
+                    Entry->Count++;
+                    Entry->LastShown = Now;
+                    OnScreenDeduplicated++;
+                    GEngine->AddOnScreenDebugMessage(Key, OnScreenSeconds, Color, FString::Printf(TEXT("%s (x%d)"), *Message.Text, Entry->Count));
+                    continue;
+                }
+
+                if (OnScreenTokens < 1.f)
+                {
+                    OnScreenSuppressed++;
+                    SuppressedSinceNotice++;
+                    continue;
+                }
+                OnScreenTokens -= 1.f;
+                RecentOnScreen.Add(Key, FOnScreenEntry{ 1, Now });
+                GEngine->AddOnScreenDebugMessage(Key, OnScreenSeconds, Color, Message.Text);
+            }
+
+            if (SuppressedSinceNotice > 0 && GEngine)
+            {
+                GEngine->AddOnScreenDebugMessage(
+                    SuppressedMessageKey,
+                    OnScreenSeconds,
+                    FColor::Yellow,
+                    FString::Printf(TEXT("%d log messages hidden, see the output log"), SuppressedSinceNotice)
+                );
+            }
+
+            for (auto It = RecentOnScreen.CreateIterator(); It; ++It)
+            {
+                if (Now - It.Value().LastShown >= OnScreenSeconds)
+                {
+                    It.RemoveCurrent();
+                }
+            }
+
+            // Once every displayed message has expired, the notice has expired too, so start a new count.
+            if (RecentOnScreen.Num() == 0)
+            {
+                SuppressedSinceNotice = 0;
+            }
+            return true;
+        }
+    };
+
+    FLoggerState& GetLoggerState()
+    {
+        static FLoggerState State;
+        return State;
+    }
+}
+
+/******************
+FLogPayload Methods
+******************/
+
+// FormatVarArgs formats into a stack buffer, which is large enough for any message the plugin writes.
+FString FLogPayload::FormatVarArgs(const TCHAR* Format, ...)
+{
+    TCHAR Buffer[2048];
+    va_list Args;
+    va_start(Args, Format);
+    const int32 Length = FCString::GetVarArgs(Buffer, UE_ARRAY_COUNT(Buffer), Format, Args);
+    va_end(Args);
+
+    // Truncated messages are still written, rather than being lost.
+    if (Length < 0)
+    {
+        Buffer[UE_ARRAY_COUNT(Buffer) - 1] = TEXT('\0');
+    }
+    return FString(Buffer);
+}
+
+// Reset destroys the record's payload.
+void FLogRecord::Reset()
+{
+    if (!Payload)
+    {
+        return;
+    }
+    if (bIsInline)
+    {
+        Payload->~FLogPayload();
+    }
+    else
+    {
+        delete Payload;
+    }
+    Payload = nullptr;
+}
+
+/*************
+Public Methods
+*************/
+
+Logger::Logger() {}
+
+Logger::~Logger() {}
+
+// SetRuntimeLevel clamps the level to the compiled level.
+void Logger::SetRuntimeLevel(EMultiplayerLogLevel Level)
+{
+    RuntimeLevel.store(FMath::Min(static_cast<uint8>(Level), static_cast<uint8>(MULTIPLAYERSESSIONS_LOG_LEVEL)), std::memory_order_relaxed);
+}
+
+// Log queues a preformatted message. The string is moved into the queue, so no copy is made.
+void Logger::Log(FString Message, bool bIsError)
+{
+    const EMultiplayerLogLevel Level = bIsError ? EMultiplayerLogLevel::Error : EMultiplayerLogLevel::Info;
+    if (IsCompiledIn(Level) && IsEnabled(Level))
+    {
+        Enqueue<FLogMessagePayload>(Level, MoveTemp(Message));
+    }
+}
+
+// Startup applies the configured level, then starts the logging thread and the on-screen ticker.
+// Nothing is started when logging is compiled out. Platforms without threads keep writing immediately.
+void Logger::Startup()
+{
+    SetRuntimeLevel(GetDefault<UMultiplayerSessionsSettings>()->LogLevel);
+
+    FLoggerState& State = GetLoggerState();
+    if (!IsCompiledIn(EMultiplayerLogLevel::Error) || State.bRunning.load() || !FPlatformProcess::SupportsMultithreading())
+    {
+        return;
+    }
+
+    State.bStopRequested.store(false);
+    if (!State.WakeEvent)
+    {
+        State.WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    }
+    State.Thread = FRunnableThread::Create(&State, TEXT("MultiplayerSessionsLogger"), 0, TPri_BelowNormal);
+    if (!State.Thread)
+    {
+        return;
+    }
+#if MULTIPLAYERSESSIONS_LOG_TO_SCREEN
+    State.OnScreenTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateRaw(&State, &FLoggerState::TickOnScreen));
+#endif
+    State.bRunning.store(true);
+}
+
+// Shutdown stops accepting messages, waits for producers which were already writing, then waits for the logging thread
+// to write everything queued. Records are drained once more after the join, in case a producer finished after the thread's last drain.
+void Logger::Shutdown()
+{
+    FLoggerState& State = GetLoggerState();
+    if (!State.bRunning.exchange(false))
+    {
+        return;
+    }
+    while (State.NumProducers.load() > 0)
+    {
+        FPlatformProcess::Yield();
+    }
+
+    if (State.OnScreenTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(State.OnScreenTickerHandle);
+        State.OnScreenTickerHandle.Reset();
+    }
+
+    State.bStopRequested.store(true, std::memory_order_release);
+    State.WakeEvent->Trigger();
+    State.Thread->WaitForCompletion();
+    delete State.Thread;
+    State.Thread = nullptr;
+    State.Drain();
+    State.OnScreenQueue.Empty();
+}
+
+// Flush wakes the logging thread, and waits until it has written as many records as had been queued.
+void Logger::Flush()
+{
+    FLoggerState& State = GetLoggerState();
+    const uint64 Queued = State.Queued.load();
+    while (State.bRunning.load() && State.Written.load() < Queued)
+    {
+        State.WakeEvent->Trigger();
+        FPlatformProcess::Sleep(0.001f);
+    }
+}
+
+// GetStats returns a snapshot of the logger's counters.
+FLoggerStats Logger::GetStats()
+{
+    const FLoggerState& State = GetLoggerState();
+
+    FLoggerStats Stats;
+    Stats.Queued = State.Queued.load(std::memory_order_relaxed);
+    Stats.Dropped = State.Dropped.load(std::memory_order_relaxed);
+    Stats.Written = State.Written.load(std::memory_order_relaxed);
+    Stats.OnScreenDeduplicated = State.OnScreenDeduplicated;
+    Stats.OnScreenSuppressed = State.OnScreenSuppressed;
+    return Stats;
+}
+
+// LogImmediate writes a log message to the screen via GEngine and to file log via ULOG.
+void Logger::LogImmediate(const FString& Message, EMultiplayerLogLevel Level)
+{
+#if MULTIPLAYERSESSIONS_LOG_TO_SCREEN
+    // Log the message to the screen if the engine is available.
+    if (GEngine)
+    {
+        GEngine->AddOnScreenDebugMessage(
+            -1, // Message index -1 avoids overwriting existing log messages.
+            15.f, // Show the message for 15 seconds.
+            GetScreenColor(Level),
+            Message
+        );
+    }
+#endif
+
+#if MULTIPLAYERSESSIONS_LOG_TO_FILE
+    // Log the message to file.
+    WriteToFile(Message, Level);
+#endif
+
+#if MULTIPLAYERSESSIONS_LOG_TO_TRACE
+    TRACE_BOOKMARK(TEXT("%s"), *Message);
+#endif
+}
+
+/**************
+Private Methods
+**************/
+
+// TryEnqueue writes a record into the next free cell, and wakes the logging thread early when the queue is half full.
+// The producer is counted before it checks bRunning, and both are sequentially consistent, so either Shutdown waits
+// for this write, or the write sees that the logger has stopped and the caller writes the message itself.
+bool Logger::TryEnqueue(EMultiplayerLogLevel Level, TFunctionRef<void(FLogRecord&)> Write)
+{
+    FLoggerState& State = GetLoggerState();
+    State.NumProducers.fetch_add(1);
+    if (!State.bRunning.load())
+    {
+        State.NumProducers.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    const bool bQueued = State.Queue.TryProduce([&](FLogRecord& Record)
+    {
+        Write(Record);
+        Record.Level = Level;
+        Record.Time = FPlatformTime::Seconds();
+    });
+    if (bQueued)
+    {
+        State.Queued.fetch_add(1, std::memory_order_relaxed);
+        if (State.Queue.Num() > QueueCapacity / 2)
+        {
+            State.WakeEvent->Trigger();
+        }
+    }
+    else
+    {
+        State.Dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    State.NumProducers.fetch_sub(1, std::memory_order_release);
+    return bQueued;
+}
+
+// IsRunning returns 'true' while the logging thread accepts messages.
+bool Logger::IsRunning()
+{
+    return GetLoggerState().bRunning.load(std::memory_order_relaxed);
+}
+
+/***************
+Console Commands
+***************/
+
+#if !UE_BUILD_SHIPPING
+// BenchmarkLogger compares the calling thread's cost of the immediate and queued logging paths.
+static void BenchmarkLogger(const TArray<FString>& Args)
+{
+    const int32 Count = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+
+    const double ImmediateStart = FPlatformTime::Seconds();
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        Logger::LogImmediate(FString::Printf(TEXT("BenchmarkLogger: Immediate message %d"), Index), EMultiplayerLogLevel::Info);
+    }
+    const double ImmediateSeconds = FPlatformTime::Seconds() - ImmediateStart;
+
+    const double QueuedStart = FPlatformTime::Seconds();
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        MULTIPLAYER_LOG(Info, TEXT("BenchmarkLogger: Queued message %d"), Index);
+    }
+    const double QueuedSeconds = FPlatformTime::Seconds() - QueuedStart;
+
+    UE_LOG(LogMultiplayerSessions, Display,
+        TEXT("BenchmarkLogger: %d messages, immediate %.1fns per call, queued %.1fns per call"),
+        Count,
+        ImmediateSeconds * 1e9 / Count,
+        QueuedSeconds * 1e9 / Count);
+}
+
+static FAutoConsoleCommand BenchmarkLoggerCommand(
+    TEXT("MultiplayerSessions.BenchmarkLogger"),
+    TEXT("Compares the per-call cost of immediate and queued logging. Usage: MultiplayerSessions.BenchmarkLogger [Count]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkLogger)
+);
+#endif
\ No newline at end of file
@@ -0,0 +1,156 @@
+// (c) 2023 Will Roberts
+
+#include "MapPreloader.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+#include "Logger.h"
+#include "MultiplayerSessionsTrace.h"
+
+/*************
+Public Methods
+*************/
+
+// FMapPreloader hooks the end of map loads, which ends the timed host flow.
+FMapPreloader::FMapPreloader()
+{
+    PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FMapPreloader::OnPostLoadMap);
+}
+
+// ~FMapPreloader removes the map load hook and releases the preloaded map.
+FMapPreloader::~FMapPreloader()
+{
+    FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+    Release();
+}
+
+// Begin finds the map's package, which must be given as a long package name, e.g. "/Game/Maps/Lobby".
+void FMapPreloader::Begin(const FString& MapURL, bool bPreload)
+{
+    MULTIPLAYER_TRACE_SCOPE("FMapPreloader::Begin");
+
+    const FString MapName = GetMapPackageName(MapURL);
+    if (MapName.IsEmpty())
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("PreloadMap: %s is not a long package name, so it cannot be preloaded"), *MapURL);
+        Release();
+        return;
+    }
+    if (MapName == PackageName && (bPreloading || !bPreload))
+    {
+        return;
+    }
+    Release();
+
+    PackageName = MapName;
+    BeginTime = FPlatformTime::Seconds();
+    Stats.LastPreloadSeconds = -1.0;
+    if (!bPreload)
+    {
+        return;
+    }
+
+    // The world asset shares its package's short name.
+    const FSoftObjectPath WorldPath(FString::Printf(TEXT("%s.%s"), *PackageName, *FPackageName::GetShortName(PackageName)));
+    Handle = StreamableManager.RequestAsyncLoad(
+        WorldPath,
+        FStreamableDelegate::CreateRaw(this, &FMapPreloader::OnPreloadComplete),
+        FStreamableManager::AsyncLoadHighPriority
+    );
+    bPreloading = Handle.IsValid();
+    if (bPreloading)
+    {
+        Stats.Preloads++;
+        MULTIPLAYER_LOG(Verbose, TEXT("PreloadMap: Loading %s"), *PackageName);
+    }
+}
+
+// GetMapPackageName strips everything from the first '?' onwards, which are the URL's options.
+FString FMapPreloader::GetMapPackageName(const FString& MapURL)
+{
+    FString MapName;
+    if (!MapURL.Split(TEXT("?"), &MapName, nullptr))
+    {
+        MapName = MapURL;
+    }
+    return FPackageName::IsValidLongPackageName(MapName) ? MapName : FString();
+}
+
+// Release cancels a preload which is still loading, or drops the reference to a loaded map.
+void FMapPreloader::Release()
+{
+    if (Handle.IsValid())
+    {
+        if (Handle->IsLoadingInProgress())
+        {
+            Handle->CancelHandle();
+        }
+        else
+        {
+            Handle->ReleaseHandle();
+        }
+        Handle.Reset();
+        Stats.Released++;
+        MULTIPLAYER_LOG(Verbose, TEXT("PreloadMap: Released %s"), *PackageName);
+    }
+    PackageName.Reset();
+    bPreloading = false;
+}
+
+// IsLoading returns 'true' while the preload is in progress.
+bool FMapPreloader::IsLoading() const
+{
+    return Handle.IsValid() && Handle->IsLoadingInProgress();
+}
+
+// IsLoaded returns 'true' when the preloaded map is in memory.
+bool FMapPreloader::IsLoaded() const
+{
+    return Handle.IsValid() && Handle->HasLoadCompleted();
+}
+
+/**************
+Private Methods
+**************/
+
+// OnPreloadComplete records how long the map took to load. Travel may not have started yet, so the map is kept loaded.
+void FMapPreloader::OnPreloadComplete()
+{
+    Stats.LastPreloadSeconds = FPlatformTime::Seconds() - BeginTime;
+    MULTIPLAYER_LOG(Info, TEXT("PreloadMap: Loaded %s in %.3fs"), *PackageName, Stats.LastPreloadSeconds);
+}
+
+// OnPostLoadMap records the time to the map when it is the timed flow's map, then drops the preload,
+// since the loaded world now keeps its packages alive.
+void FMapPreloader::OnPostLoadMap(UWorld* LoadedWorld)
+{
+    if (!LoadedWorld || PackageName.IsEmpty())
+    {
+        return;
+    }
+    const FString LoadedPackageName = UWorld::RemovePIEPrefix(LoadedWorld->GetOutermost()->GetName());
+    if (LoadedPackageName != PackageName)
+    {
+        return;
+    }
+
+    Stats.LastTimeToMapSeconds = FPlatformTime::Seconds() - BeginTime;
+    (bPreloading ? Stats.TimeToMapPreloaded : Stats.TimeToMapNotPreloaded).Record(Stats.LastTimeToMapSeconds);
+    MULTIPLAYER_LOG(
+        Info,
+        TEXT("PreloadMap: Reached %s %.3fs after hosting or joining (%s)"),
+        *PackageName,
+        Stats.LastTimeToMapSeconds,
+        bPreloading ? TEXT("preloaded") : TEXT("not preloaded")
+    );
+
+    if (Handle.IsValid())
+    {
+        Handle->ReleaseHandle();
+        Handle.Reset();
+    }
+    PackageName.Reset();
+    bPreloading = false;
+}
\ No newline at end of file
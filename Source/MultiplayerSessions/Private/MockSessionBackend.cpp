@@ -0,0 +1,384 @@
+// (c) 2023 Will Roberts
+
+#include "MockSessionBackend.h"
+#include "OnlineSessionSettings.h"
+#include "OnlineSubsystemTypes.h"
+
+namespace
+{
+    /*
+     * FMockSessionInfo identifies a mock session, so results can be told apart by session ID like real provider results.
+     */
+    class FMockSessionInfo final : public FOnlineSessionInfo
+    {
+    public:
+        explicit FMockSessionInfo(const FString& InSessionId):
+            SessionId(FUniqueNetIdString::Create(InSessionId, FName("Mock")))
+        {}
+
+        virtual const uint8* GetBytes() const override { return nullptr; }
+        virtual int32 GetSize() const override { return sizeof(FMockSessionInfo); }
+        virtual bool IsValid() const override { return true; }
+        virtual const FUniqueNetId& GetSessionId() const override { return *SessionId; }
+        virtual FString ToString() const override { return SessionId->ToString(); }
+        virtual FString ToDebugString() const override { return FString::Printf(TEXT("MockSession %s"), *SessionId->ToString()); }
+
+    private:
+        FUniqueNetIdRef SessionId;
+    };
+
+    // Join failures are drawn from the results a real provider reports for sessions which filled up or went away.
+    const EOnJoinSessionCompleteResult::Type JoinFailureResults[] = {
+        EOnJoinSessionCompleteResult::SessionIsFull,
+        EOnJoinSessionCompleteResult::SessionDoesNotExist,
+        EOnJoinSessionCompleteResult::CouldNotRetrieveAddress
+    };
+}
+
+/*************
+Public Methods
+*************/
+
+// FMockSessionBackend generates the remote sessions from the seed, and starts ticking unless the clock is manual.
+FMockSessionBackend::FMockSessionBackend(const FMultiplayerMockBackendSettings& InSettings, bool bInManualClock):
+    Settings(InSettings),
+    Random(InSettings.Seed),
+    bManualClock(bInManualClock)
+{
+    GenerateSessions();
+
+    if (!bManualClock)
+    {
+        TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FMockSessionBackend::Tick));
+    }
+}
+
+// ~FMockSessionBackend stops ticking. Pending completions are dropped without being delivered.
+FMockSessionBackend::~FMockSessionBackend()
+{
+    if (TickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+    }
+}
+
+// CreateSession registers the named session immediately, like a real provider, and removes it again if the creation fails.
+bool FMockSessionBackend::CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+    if (NamedSessions.Contains(SessionName))
+    {
+        Schedule(0.0, [this, SessionName]() { TriggerOnCreateSessionCompleteDelegates(SessionName, false); });
+        return false;
+    }
+
+    NamedSessions.Add(SessionName, TEXT("127.0.0.1:7777"));
+    const bool bFailed = DrawFailure(Settings.Create);
+    Schedule(DrawLatency(Settings.Create), [this, SessionName, bFailed]()
+    {
+        if (bFailed)
+        {
+            NamedSessions.Remove(SessionName);
+        }
+        TriggerOnCreateSessionCompleteDelegates(SessionName, !bFailed);
+    });
+    return true;
+}
+
+// FindSessions selects the sessions matching the query, which are then delivered gradually until the search completes.
+// Only one search runs at a time, as with real providers.
+bool FMockSessionBackend::FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    if (ActiveSearch.IsValid())
+    {
+        Schedule(0.0, [this]() { TriggerOnFindSessionsCompleteDelegates(false); });
+        return false;
+    }
+
+    ActiveSearch = SearchSettings;
+    ActiveSearchMatches.Reset();
+    ActiveSearchNumDelivered = 0;
+    for (int32 Index = 0; Index < Sessions.Num() && ActiveSearchMatches.Num() < SearchSettings->MaxSearchResults; ++Index)
+    {
+        if (MatchesQuery(Sessions[Index], *SearchSettings))
+        {
+            ActiveSearchMatches.Add(Index);
+        }
+    }
+    if (Settings.bShuffleResults)
+    {
+        for (int32 Index = ActiveSearchMatches.Num() - 1; Index > 0; --Index)
+        {
+            ActiveSearchMatches.Swap(Index, Random.RandRange(0, Index));
+        }
+    }
+
+    SearchSettings->SearchResults.Reset();
+    SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+    ActiveSearchStartTime = Now;
+    ActiveSearchLatency = DrawLatency(Settings.Find);
+
+    const bool bFailed = DrawFailure(Settings.Find);
+    FOnlineSessionSearch* Search = &SearchSettings.Get();
+    Schedule(ActiveSearchLatency, [this, Search, bFailed]()
+    {
+        // The search was cancelled, and possibly replaced, before it completed.
+        if (ActiveSearch.Get() != Search)
+        {
+            return;
+        }
+        if (!bFailed)
+        {
+            DeliverSearchResults(1.0);
+        }
+        Search->SearchState = bFailed ? EOnlineAsyncTaskState::Failed : EOnlineAsyncTaskState::Done;
+        ActiveSearch.Reset();
+        TriggerOnFindSessionsCompleteDelegates(!bFailed);
+    });
+    return true;
+}
+
+// CancelFindSessions stops the in-flight search. Its completion is never delivered.
+bool FMockSessionBackend::CancelFindSessions()
+{
+    if (!ActiveSearch.IsValid())
+    {
+        return false;
+    }
+    ActiveSearch->SearchState = EOnlineAsyncTaskState::Failed;
+    ActiveSearch.Reset();
+    return true;
+}
+
+// JoinSession registers the named session immediately, and removes it again if the join fails.
+// Full sessions always fail, and other joins fail at the configured rate with one of the usual failure results.
+bool FMockSessionBackend::JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+    if (NamedSessions.Contains(SessionName))
+    {
+        Schedule(0.0, [this, SessionName]() { TriggerOnJoinSessionCompleteDelegates(SessionName, EOnJoinSessionCompleteResult::AlreadyInSession); });
+        return false;
+    }
+
+    EOnJoinSessionCompleteResult::Type Result = EOnJoinSessionCompleteResult::Success;
+    if (DesiredSession.Session.NumOpenPublicConnections <= 0)
+    {
+        Result = EOnJoinSessionCompleteResult::SessionIsFull;
+    }
+    else if (DrawFailure(Settings.Join))
+    {
+        Result = JoinFailureResults[Random.RandRange(0, UE_ARRAY_COUNT(JoinFailureResults) - 1)];
+    }
+
+    const FString SessionId = DesiredSession.GetSessionIdStr();
+    NamedSessions.Add(SessionName, FString::Printf(TEXT("%s:7777"), *SessionId));
+    Schedule(DrawLatency(Settings.Join), [this, SessionName, Result]()
+    {
+        if (Result != EOnJoinSessionCompleteResult::Success)
+        {
+            NamedSessions.Remove(SessionName);
+        }
+        TriggerOnJoinSessionCompleteDelegates(SessionName, Result);
+    });
+    return true;
+}
+
+// DestroySession removes the named session when the destruction succeeds.
+bool FMockSessionBackend::DestroySession(FName SessionName)
+{
+    if (!NamedSessions.Contains(SessionName))
+    {
+        Schedule(0.0, [this, SessionName]() { TriggerOnDestroySessionCompleteDelegates(SessionName, false); });
+        return false;
+    }
+
+    const bool bFailed = DrawFailure(Settings.Destroy);
+    Schedule(DrawLatency(Settings.Destroy), [this, SessionName, bFailed]()
+    {
+        if (!bFailed)
+        {
+            NamedSessions.Remove(SessionName);
+        }
+        TriggerOnDestroySessionCompleteDelegates(SessionName, !bFailed);
+    });
+    return true;
+}
+
+// StartSession completes after the simulated latency. Starting a session which does not exist fails.
+bool FMockSessionBackend::StartSession(FName SessionName)
+{
+    const bool bFailed = !NamedSessions.Contains(SessionName) || DrawFailure(Settings.Start);
+    Schedule(DrawLatency(Settings.Start), [this, SessionName, bFailed]()
+    {
+        TriggerOnStartSessionCompleteDelegates(SessionName, !bFailed);
+    });
+    return true;
+}
+
+// UpdateSession completes after the simulated latency. The session stays registered whether or not the update succeeds.
+bool FMockSessionBackend::UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData)
+{
+    const bool bFailed = !NamedSessions.Contains(SessionName) || DrawFailure(Settings.Update);
+    Schedule(DrawLatency(Settings.Update), [this, SessionName, bFailed]()
+    {
+        TriggerOnUpdateSessionCompleteDelegates(SessionName, !bFailed);
+    });
+    return true;
+}
+
+// HasSession returns 'true' for sessions which have been created or joined, including those still in progress.
+bool FMockSessionBackend::HasSession(FName SessionName) const
+{
+    return NamedSessions.Contains(SessionName);
+}
+
+// GetResolvedConnectString returns a placeholder address for the named session.
+bool FMockSessionBackend::GetResolvedConnectString(FName SessionName, FString& ConnectInfo)
+{
+    const FString* Address = NamedSessions.Find(SessionName);
+    if (!Address)
+    {
+        return false;
+    }
+    ConnectInfo = *Address;
+    return true;
+}
+
+// GetDefaultPlayerId returns a fixed player ID, so the mock can run without a local player.
+FUniqueNetIdPtr FMockSessionBackend::GetDefaultPlayerId() const
+{
+    return FUniqueNetIdString::Create(TEXT("MockPlayer"), FName("Mock"));
+}
+
+// Advance delivers partial search results, then every completion which is due, in order.
+// Completions may start new operations, which are delivered in the same call when they are also due.
+void FMockSessionBackend::Advance(double DeltaSeconds)
+{
+    Now += FMath::Max(DeltaSeconds, 0.0);
+
+    if (ActiveSearch.IsValid() && ActiveSearchLatency > 0.0)
+    {
+        DeliverSearchResults(FMath::Min((Now - ActiveSearchStartTime) / ActiveSearchLatency, 1.0));
+    }
+
+    while (Pending.Num() > 0 && Pending[0].DueTime <= Now)
+    {
+        FPendingCompletion Completion = MoveTemp(Pending[0]);
+        Pending.RemoveAt(0);
+        Completion.Complete();
+    }
+}
+
+// AdvanceToNext is used to run the mock as fast as possible, e.g. by the benchmark.
+bool FMockSessionBackend::AdvanceToNext()
+{
+    if (Pending.Num() == 0)
+    {
+        return false;
+    }
+    Advance(Pending[0].DueTime - Now);
+    return true;
+}
+
+/**************
+Private Methods
+**************/
+
+// Tick advances the clock by the frame time.
+bool FMockSessionBackend::Tick(float DeltaTime)
+{
+    Advance(DeltaTime);
+    return true;
+}
+
+// DrawLatency returns a latency between the operation's minimum and maximum, or its tail latency.
+double FMockSessionBackend::DrawLatency(const FMultiplayerMockOperationSettings& Operation)
+{
+    if (Operation.TailChance > 0.f && Random.FRand() < Operation.TailChance)
+    {
+        return Operation.TailLatencySeconds;
+    }
+    return FMath::Lerp(Operation.MinLatencySeconds, FMath::Max(Operation.MinLatencySeconds, Operation.MaxLatencySeconds), Random.FRand());
+}
+
+// DrawFailure returns 'true' at the operation's failure rate.
+bool FMockSessionBackend::DrawFailure(const FMultiplayerMockOperationSettings& Operation)
+{
+    return Operation.FailureRate > 0.f && Random.FRand() < Operation.FailureRate;
+}
+
+// Schedule adds a completion, keeping the pending list ordered.
+// At the configured reorder rate, the completion is held back until after the latest pending completion.
+void FMockSessionBackend::Schedule(double Latency, TUniqueFunction<void()> Complete)
+{
+    double DueTime = Now + Latency;
+    if (Pending.Num() > 0 && Settings.ReorderChance > 0.f && Random.FRand() < Settings.ReorderChance)
+    {
+        DueTime = FMath::Max(DueTime, Pending.Last().DueTime);
+    }
+
+    const uint64 Sequence = NextSequence++;
+    int32 InsertIndex = Pending.Num();
+    while (InsertIndex > 0 && Pending[InsertIndex - 1].DueTime > DueTime)
+    {
+        --InsertIndex;
+    }
+    Pending.Insert(FPendingCompletion{ DueTime, Sequence, MoveTemp(Complete) }, InsertIndex);
+}
+
+// GenerateSessions creates the remote sessions. The same seed always produces the same sessions.
+void FMockSessionBackend::GenerateSessions()
+{
+    Sessions.Reset(Settings.NumSessions);
+    for (int32 Index = 0; Index < Settings.NumSessions; ++Index)
+    {
+        FOnlineSessionSearchResult& Result = Sessions.AddDefaulted_GetRef();
+        Result.PingInMs = Random.RandRange(5, FMath::Max(Settings.MaxPingMs, 5));
+
+        FOnlineSession& Session = Result.Session;
+        Session.OwningUserName = FString::Printf(TEXT("MockHost%d"), Index);
+        Session.SessionInfo = MakeShared<FMockSessionInfo>(FString::Printf(TEXT("Mock-%d-%d"), Settings.Seed, Index));
+        Session.SessionSettings.NumPublicConnections = Settings.MaxPlayersPerSession;
+        Session.SessionSettings.bShouldAdvertise = true;
+        Session.SessionSettings.bUsesPresence = true;
+        Session.SessionSettings.bAllowJoinInProgress = true;
+        Session.SessionSettings.BuildUniqueId = 1;
+        Session.NumOpenPublicConnections = Random.RandRange(0, Settings.MaxPlayersPerSession);
+
+        if (Settings.MatchTypes.Num() > 0)
+        {
+            const FString& MatchType = Settings.MatchTypes[Random.RandRange(0, Settings.MatchTypes.Num() - 1)];
+            Session.SessionSettings.Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+        if (Settings.Regions.Num() > 0)
+        {
+            const FString& Region = Settings.Regions[Random.RandRange(0, Settings.Regions.Num() - 1)];
+            Session.SessionSettings.Set(FName("Region"), Region, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+    }
+}
+
+// DeliverSearchResults appends matching sessions to the in-flight search, until Progress (0-1) of them have been delivered.
+void FMockSessionBackend::DeliverSearchResults(double Progress)
+{
+    TArray<FOnlineSessionSearchResult>& Results = ActiveSearch->SearchResults;
+    const int32 Target = FMath::Min(FMath::FloorToInt32(Progress * ActiveSearchMatches.Num()), ActiveSearchMatches.Num());
+    for (; ActiveSearchNumDelivered < Target; ++ActiveSearchNumDelivered)
+    {
+        Results.Add(Sessions[ActiveSearchMatches[ActiveSearchNumDelivered]]);
+    }
+}
+
+// MatchesQuery applies the search's equality query settings to a session, as providers with server-side filtering do.
+// Query settings which are not session settings, such as presence, are ignored.
+bool FMockSessionBackend::MatchesQuery(const FOnlineSessionSearchResult& Result, const FOnlineSessionSearch& Search) const
+{
+    for (const TPair<FName, FOnlineSessionSearchParam>& Param : Search.QuerySettings.SearchParams)
+    {
+        const FOnlineSessionSetting* Setting = Result.Session.SessionSettings.Settings.Find(Param.Key);
+        if (Setting && Param.Value.ComparisonOp == EOnlineComparisonOp::Equals && !(Setting->Data == Param.Value.Data))
+        {
+            return false;
+        }
+    }
+    return true;
+}
\ No newline at end of file
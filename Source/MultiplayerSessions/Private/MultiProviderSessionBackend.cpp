@@ -0,0 +1,549 @@
+// (c) 2023 Will Roberts
+
+#include "MultiProviderSessionBackend.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Interfaces/OnlineIdentityInterface.h"
+#include "OnlineSessionSettings.h"
+#include "OnlineSubsystem.h"
+
+#include "Logger.h"
+#include "DirectorySessionBackend.h"
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTrace.h"
+
+/*************
+Public Methods
+*************/
+
+// FMultiProviderSessionBackend binds forwarding delegates on each provider, and starts ticking unless it is driven manually.
+// Search completions are routed by provider, and other completions are forwarded as they are.
+FMultiProviderSessionBackend::FMultiProviderSessionBackend(
+    TArray<TSharedRef<IMultiplayerSessionBackend>> InProviders,
+    const FMultiplayerMultiProviderSettings& InSettings,
+    bool bInManualTick
+):
+    Settings(InSettings)
+{
+    check(InProviders.Num() > 0);
+    Providers.Reserve(InProviders.Num());
+    for (int32 ProviderIndex = 0; ProviderIndex < InProviders.Num(); ++ProviderIndex)
+    {
+        FProvider& Provider = Providers.Emplace_GetRef(InProviders[ProviderIndex]);
+        Provider.Stats.Name = Provider.Backend->GetSubsystemName();
+
+        IMultiplayerSessionBackend& Backend = *Provider.Backend;
+        Provider.CreateSessionCompleteHandle = Backend.AddOnCreateSessionCompleteDelegate_Handle(
+            FOnCreateSessionCompleteDelegate::CreateLambda([this](FName SessionName, bool bWasSuccessful)
+            {
+                TriggerOnCreateSessionCompleteDelegates(SessionName, bWasSuccessful);
+            }));
+        Provider.FindSessionsCompleteHandle = Backend.AddOnFindSessionsCompleteDelegate_Handle(
+            FOnFindSessionsCompleteDelegate::CreateLambda([this, ProviderIndex](bool bWasSuccessful)
+            {
+                OnProviderSearchComplete(ProviderIndex, bWasSuccessful);
+            }));
+        Provider.JoinSessionCompleteHandle = Backend.AddOnJoinSessionCompleteDelegate_Handle(
+            FOnJoinSessionCompleteDelegate::CreateLambda([this](FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+            {
+                TriggerOnJoinSessionCompleteDelegates(SessionName, Result);
+            }));
+        Provider.DestroySessionCompleteHandle = Backend.AddOnDestroySessionCompleteDelegate_Handle(
+            FOnDestroySessionCompleteDelegate::CreateLambda([this](FName SessionName, bool bWasSuccessful)
+            {
+                TriggerOnDestroySessionCompleteDelegates(SessionName, bWasSuccessful);
+            }));
+        Provider.StartSessionCompleteHandle = Backend.AddOnStartSessionCompleteDelegate_Handle(
+            FOnStartSessionCompleteDelegate::CreateLambda([this](FName SessionName, bool bWasSuccessful)
+            {
+                TriggerOnStartSessionCompleteDelegates(SessionName, bWasSuccessful);
+            }));
+        Provider.UpdateSessionCompleteHandle = Backend.AddOnUpdateSessionCompleteDelegate_Handle(
+            FOnUpdateSessionCompleteDelegate::CreateLambda([this](FName SessionName, bool bWasSuccessful)
+            {
+                TriggerOnUpdateSessionCompleteDelegates(SessionName, bWasSuccessful);
+            }));
+    }
+
+    if (!bInManualTick)
+    {
+        TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FMultiProviderSessionBackend::Tick));
+    }
+}
+
+// ~FMultiProviderSessionBackend stops ticking, and clears the forwarding delegates, so late responses are not delivered to a destroyed backend.
+FMultiProviderSessionBackend::~FMultiProviderSessionBackend()
+{
+    if (TickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+    }
+    for (FProvider& Provider : Providers)
+    {
+        IMultiplayerSessionBackend& Backend = *Provider.Backend;
+        Backend.ClearOnCreateSessionCompleteDelegate_Handle(Provider.CreateSessionCompleteHandle);
+        Backend.ClearOnFindSessionsCompleteDelegate_Handle(Provider.FindSessionsCompleteHandle);
+        Backend.ClearOnJoinSessionCompleteDelegate_Handle(Provider.JoinSessionCompleteHandle);
+        Backend.ClearOnDestroySessionCompleteDelegate_Handle(Provider.DestroySessionCompleteHandle);
+        Backend.ClearOnStartSessionCompleteDelegate_Handle(Provider.StartSessionCompleteHandle);
+        Backend.ClearOnUpdateSessionCompleteDelegate_Handle(Provider.UpdateSessionCompleteHandle);
+    }
+}
+
+// Create builds each provider from the plugin's settings. Additional mock providers are seeded one higher than the previous one,
+// so they simulate different sessions. Online Subsystems are only wrapped once, since wrappers of one session interface
+// would each receive every completion.
+TSharedPtr<FMultiProviderSessionBackend> FMultiProviderSessionBackend::Create(const FMultiplayerMultiProviderSettings& InSettings)
+{
+    const UMultiplayerSessionsSettings* PluginSettings = GetDefault<UMultiplayerSessionsSettings>();
+
+    TArray<TSharedRef<IMultiplayerSessionBackend>> Backends;
+    TSet<FName> ProviderNames;
+    int32 NumMockProviders = 0;
+    for (const FName ProviderName : InSettings.Providers)
+    {
+        TSharedPtr<IMultiplayerSessionBackend> Backend;
+        if (ProviderName == FName("Mock"))
+        {
+            FMultiplayerMockBackendSettings MockSettings = PluginSettings->MockBackend;
+            MockSettings.Seed += NumMockProviders++;
+            Backend = MakeShared<FMockSessionBackend>(MockSettings);
+        }
+        else if (ProviderNames.Contains(ProviderName))
+        {
+            MULTIPLAYER_LOG(Warning, TEXT("MultiProviderSessionBackend: %s is listed more than once"), *ProviderName.ToString());
+            continue;
+        }
+        else if (ProviderName == FName("Directory"))
+        {
+            Backend = MakeShared<FDirectorySessionBackend>(PluginSettings->DirectoryBackend);
+        }
+        else
+        {
+            Backend = FOnlineSessionBackend::Create(ProviderName);
+        }
+
+        if (!Backend.IsValid())
+        {
+            MULTIPLAYER_LOG(Warning, TEXT("MultiProviderSessionBackend: %s is not available"), *ProviderName.ToString());
+            continue;
+        }
+        ProviderNames.Add(ProviderName);
+        Backends.Add(Backend.ToSharedRef());
+    }
+
+    if (Backends.Num() == 0)
+    {
+        return nullptr;
+    }
+    return MakeShared<FMultiProviderSessionBackend>(MoveTemp(Backends), InSettings);
+}
+
+// CreateSession hosts on the first provider, unless the session already exists on another one, which then reports the failure.
+bool FMultiProviderSessionBackend::CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+    int32 ProviderIndex = GetSessionProvider(SessionName);
+    if (!Providers[ProviderIndex].Backend->HasSession(SessionName))
+    {
+        ProviderIndex = 0;
+        SessionProviders.Add(SessionName, ProviderIndex);
+    }
+
+    IMultiplayerSessionBackend& Backend = *Providers[ProviderIndex].Backend;
+    return Backend.CreateSession(*GetProviderPlayerId(Backend, HostingPlayerId), SessionName, NewSessionSettings);
+}
+
+// FindSessions sends a copy of the search to every provider, each as a LAN query or not to suit the provider.
+// Only one search runs at a time, as with real providers.
+bool FMultiProviderSessionBackend::FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    MULTIPLAYER_TRACE_SCOPE("FMultiProviderSessionBackend::FindSessions");
+
+    if (ActiveSearch.IsValid())
+    {
+        NumRejectedSearches++;
+        return false;
+    }
+
+    ActiveSearch = SearchSettings;
+    SearchSettings->SearchResults.Reset();
+    SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+    SearchStartTime = FPlatformTime::Seconds();
+    FirstCompletionTime = -1.0;
+    ResultProviders.Reset();
+    MergedOwners.Reset();
+    Searches++;
+    SearchSerial = FMath::Max(SearchSerial + 1, 1u);
+
+    bStartingSearch = true;
+    for (FProvider& Provider : Providers)
+    {
+        TSharedRef<FOnlineSessionSearch> Search = MakeShareable(new FOnlineSessionSearch());
+        Search->MaxSearchResults = SearchSettings->MaxSearchResults;
+        Search->bIsLanQuery = Provider.Backend->IsLANProvider();
+        Search->PingBucketSize = SearchSettings->PingBucketSize;
+        Search->TimeoutInSeconds = SearchSettings->TimeoutInSeconds;
+        Search->QuerySettings = SearchSettings->QuerySettings;
+
+        Provider.Search = Search;
+        Provider.NumMerged = 0;
+        Provider.SearchSerial = SearchSerial;
+        Provider.bSucceeded = false;
+        Provider.Stats.Searches++;
+
+        // Providers which reject the search may also deliver a failed completion, which is ignored once the provider is no longer searching.
+        if (!Provider.Backend->FindSessions(*GetProviderPlayerId(*Provider.Backend, SearchingPlayerId), Search) && Provider.IsSearching())
+        {
+            MULTIPLAYER_LOG(Warning, TEXT("FindSessions: %s failed to start searching"), *Provider.Stats.Name.ToString());
+            Provider.SearchSerial = 0;
+            Provider.Stats.Failures++;
+        }
+    }
+    bStartingSearch = false;
+    return true;
+}
+
+// CancelFindSessions stops every provider's search. Its completion is never delivered.
+bool FMultiProviderSessionBackend::CancelFindSessions()
+{
+    if (!ActiveSearch.IsValid())
+    {
+        return false;
+    }
+    for (FProvider& Provider : Providers)
+    {
+        if (Provider.IsSearching())
+        {
+            Provider.SearchSerial = 0;
+            Provider.Backend->CancelFindSessions();
+        }
+        Provider.Search.Reset();
+    }
+    ActiveSearch->SearchState = EOnlineAsyncTaskState::Failed;
+    ActiveSearch.Reset();
+    return true;
+}
+
+// JoinSession joins through the provider which found the session.
+// When the session already exists, the join goes to its provider, which then reports the failure.
+bool FMultiProviderSessionBackend::JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+    int32 ProviderIndex = GetSessionProvider(SessionName);
+    if (!Providers[ProviderIndex].Backend->HasSession(SessionName))
+    {
+        ProviderIndex = FindResultProvider(DesiredSession);
+        SessionProviders.Add(SessionName, ProviderIndex);
+    }
+
+    IMultiplayerSessionBackend& Backend = *Providers[ProviderIndex].Backend;
+    return Backend.JoinSession(*GetProviderPlayerId(Backend, PlayerId), SessionName, DesiredSession);
+}
+
+// DestroySession forwards a session destruction to the session's provider.
+bool FMultiProviderSessionBackend::DestroySession(FName SessionName)
+{
+    return Providers[GetSessionProvider(SessionName)].Backend->DestroySession(SessionName);
+}
+
+// StartSession forwards a session start to the session's provider.
+bool FMultiProviderSessionBackend::StartSession(FName SessionName)
+{
+    return Providers[GetSessionProvider(SessionName)].Backend->StartSession(SessionName);
+}
+
+// UpdateSession forwards a settings update to the session's provider.
+bool FMultiProviderSessionBackend::UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData)
+{
+    return Providers[GetSessionProvider(SessionName)].Backend->UpdateSession(SessionName, UpdatedSessionSettings, bShouldRefreshOnlineData);
+}
+
+// HasSession checks the session's provider for the named session.
+bool FMultiProviderSessionBackend::HasSession(FName SessionName) const
+{
+    return Providers[GetSessionProvider(SessionName)].Backend->HasSession(SessionName);
+}
+
+// GetResolvedConnectString asks the session's provider for the address of the joined session.
+bool FMultiProviderSessionBackend::GetResolvedConnectString(FName SessionName, FString& ConnectInfo)
+{
+    return Providers[GetSessionProvider(SessionName)].Backend->GetResolvedConnectString(SessionName, ConnectInfo);
+}
+
+// GetDefaultPlayerId returns the default ID of the first provider which has one.
+FUniqueNetIdPtr FMultiProviderSessionBackend::GetDefaultPlayerId() const
+{
+    for (const FProvider& Provider : Providers)
+    {
+        if (FUniqueNetIdPtr PlayerId = Provider.Backend->GetDefaultPlayerId())
+        {
+            return PlayerId;
+        }
+    }
+    return nullptr;
+}
+
+// ProcessPending completes the search once every provider has completed or the stragglers have timed out.
+void FMultiProviderSessionBackend::ProcessPending()
+{
+    MULTIPLAYER_TRACE_SCOPE("FMultiProviderSessionBackend::ProcessPending");
+
+    for (; NumRejectedSearches > 0; --NumRejectedSearches)
+    {
+        TriggerOnFindSessionsCompleteDelegates(false);
+    }
+    if (!ActiveSearch.IsValid())
+    {
+        return;
+    }
+
+    bool bAllComplete = true;
+    for (int32 ProviderIndex = 0; ProviderIndex < Providers.Num(); ++ProviderIndex)
+    {
+        if (Providers[ProviderIndex].IsSearching())
+        {
+            MergeResults(ProviderIndex);
+            bAllComplete = false;
+        }
+    }
+
+    if (!bAllComplete && FirstCompletionTime >= 0.0 && Settings.StragglerTimeoutSeconds > 0.f
+        && FPlatformTime::Seconds() - FirstCompletionTime >= Settings.StragglerTimeoutSeconds)
+    {
+        CancelStragglers();
+        bAllComplete = true;
+    }
+    if (bAllComplete)
+    {
+        CompleteSearch();
+    }
+}
+
+/**************
+Private Methods
+**************/
+
+// Tick does the pending work once per frame.
+bool FMultiProviderSessionBackend::Tick(float DeltaTime)
+{
+    ProcessPending();
+    return true;
+}
+
+// OnProviderSearchComplete records the provider's latency and merges its remaining results straight away,
+// so streaming searches see them without waiting for the slower providers.
+// Completions of searches which were cancelled, timed out, or rejected are ignored. Completion delegates do not say which search
+// they belong to, so a provider whose own search is still in progress is completing an earlier one, e.g. after a cancel it did not honour.
+void FMultiProviderSessionBackend::OnProviderSearchComplete(int32 ProviderIndex, bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("FMultiProviderSessionBackend::OnProviderSearchComplete");
+
+    FProvider& Provider = Providers[ProviderIndex];
+    if (!ActiveSearch.IsValid() || Provider.SearchSerial != SearchSerial || Provider.Search->SearchState == EOnlineAsyncTaskState::InProgress)
+    {
+        Provider.Stats.StaleCompletions++;
+        MULTIPLAYER_LOG(Verbose, TEXT("FindSessions: Ignored a stale completion from %s"), *Provider.Stats.Name.ToString());
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    Provider.SearchSerial = 0;
+    Provider.bSucceeded = bWasSuccessful;
+    Provider.Stats.SearchLatency.Record(Now - SearchStartTime);
+    if (bWasSuccessful)
+    {
+        MergeResults(ProviderIndex);
+    }
+    else
+    {
+        Provider.Stats.Failures++;
+    }
+    if (FirstCompletionTime < 0.0)
+    {
+        FirstCompletionTime = Now;
+    }
+    MULTIPLAYER_LOG(Verbose, TEXT("FindSessions: %s %s after %.3fs with %d results"),
+        *Provider.Stats.Name.ToString(), bWasSuccessful ? TEXT("completed") : TEXT("failed"), Now - SearchStartTime, Provider.Search->SearchResults.Num());
+
+    if (bStartingSearch)
+    {
+        return;
+    }
+    for (const FProvider& Other : Providers)
+    {
+        if (Other.IsSearching())
+        {
+            return;
+        }
+    }
+    CompleteSearch();
+}
+
+// MergeResults appends the provider's new results to the caller's search, skipping sessions another provider already returned.
+// Results are only appended, since the caller may filter the merged results in place while the search runs.
+void FMultiProviderSessionBackend::MergeResults(int32 ProviderIndex)
+{
+    FProvider& Provider = Providers[ProviderIndex];
+    const TArray<FOnlineSessionSearchResult>& Results = Provider.Search->SearchResults;
+    TArray<FOnlineSessionSearchResult>& Merged = ActiveSearch->SearchResults;
+    for (int32 Index = Provider.NumMerged; Index < Results.Num(); ++Index)
+    {
+        const FOnlineSessionSearchResult& Result = Results[Index];
+        const FString SessionId = Result.GetSessionIdStr();
+        const FString& OwnerName = Result.Session.OwningUserName;
+        const bool bMergeOwner = Settings.bMergeByOwnerName && !OwnerName.IsEmpty();
+        Provider.Stats.ResultsReceived++;
+
+        if (ResultProviders.Contains(SessionId) || (bMergeOwner && MergedOwners.Contains(OwnerName)))
+        {
+            Provider.Stats.DuplicatesDropped++;
+            continue;
+        }
+        if (Merged.Num() >= ActiveSearch->MaxSearchResults)
+        {
+            ResultsOverLimit++;
+            continue;
+        }
+
+        ResultProviders.Add(SessionId, ProviderIndex);
+        if (bMergeOwner)
+        {
+            MergedOwners.Add(OwnerName);
+        }
+        Merged.Add(Result);
+    }
+    Provider.NumMerged = Results.Num();
+}
+
+// CancelStragglers stops the searches of providers which exceeded the straggler timeout. Their results so far are kept.
+void FMultiProviderSessionBackend::CancelStragglers()
+{
+    for (FProvider& Provider : Providers)
+    {
+        if (!Provider.IsSearching())
+        {
+            continue;
+        }
+        MULTIPLAYER_LOG(Warning, TEXT("FindSessions: %s timed out after %.3fs with %d results"),
+            *Provider.Stats.Name.ToString(), FPlatformTime::Seconds() - SearchStartTime, Provider.NumMerged);
+        Provider.SearchSerial = 0;
+        Provider.Stats.TimedOut++;
+        Provider.Backend->CancelFindSessions();
+    }
+}
+
+// CompleteSearch completes the caller's search, which succeeds when any provider's search succeeded.
+void FMultiProviderSessionBackend::CompleteSearch()
+{
+    MULTIPLAYER_TRACE_SCOPE("FMultiProviderSessionBackend::CompleteSearch");
+
+    bool bWasSuccessful = false;
+    for (FProvider& Provider : Providers)
+    {
+        bWasSuccessful |= Provider.bSucceeded;
+        Provider.Search.Reset();
+    }
+
+    TSharedRef<FOnlineSessionSearch> Search = ActiveSearch.ToSharedRef();
+    ActiveSearch.Reset();
+    Search->SearchState = bWasSuccessful ? EOnlineAsyncTaskState::Done : EOnlineAsyncTaskState::Failed;
+    MULTIPLAYER_LOG(Verbose, TEXT("FindSessions: Merged %d results from %d providers in %.3fs"),
+        Search->SearchResults.Num(), Providers.Num(), FPlatformTime::Seconds() - SearchStartTime);
+    TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
+}
+
+// FindResultProvider returns the provider which found a result of the latest search.
+// Older results, e.g. served from the search cache, are matched to a provider by the type of their session ID.
+// Results no provider can be found for are joined through the first provider.
+int32 FMultiProviderSessionBackend::FindResultProvider(const FOnlineSessionSearchResult& Result) const
+{
+    if (const int32* ProviderIndex = ResultProviders.Find(Result.GetSessionIdStr()))
+    {
+        return *ProviderIndex;
+    }
+    if (Result.Session.SessionInfo.IsValid())
+    {
+        const FName IdType = Result.Session.SessionInfo->GetSessionId().GetType();
+        for (int32 ProviderIndex = 0; ProviderIndex < Providers.Num(); ++ProviderIndex)
+        {
+            if (Providers[ProviderIndex].Stats.Name == IdType)
+            {
+                return ProviderIndex;
+            }
+        }
+    }
+    return 0;
+}
+
+// GetSessionProvider returns the provider a named session was created or joined on, or the first provider for other sessions.
+int32 FMultiProviderSessionBackend::GetSessionProvider(FName SessionName) const
+{
+    const int32* ProviderIndex = SessionProviders.Find(SessionName);
+    return ProviderIndex ? *ProviderIndex : 0;
+}
+
+// GetProviderPlayerId returns the player's ID on a provider. The local player's ID comes from the default Online Subsystem,
+// which other providers do not understand, so their own ID for the first local user is used instead, where they have one.
+FUniqueNetIdRef FMultiProviderSessionBackend::GetProviderPlayerId(const IMultiplayerSessionBackend& Provider, const FUniqueNetId& PlayerId)
+{
+    const FName ProviderName = Provider.GetSubsystemName();
+    if (PlayerId.GetType() == ProviderName)
+    {
+        return PlayerId.AsShared();
+    }
+    if (FUniqueNetIdPtr DefaultPlayerId = Provider.GetDefaultPlayerId())
+    {
+        return DefaultPlayerId.ToSharedRef();
+    }
+
+    // Only look up Online Subsystems which are already loaded, since looking up an unknown name tries to load its module.
+    const IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::DoesInstanceExist(ProviderName) ? IOnlineSubsystem::Get(ProviderName) : nullptr;
+    const IOnlineIdentityPtr Identity = OnlineSubsystem ? OnlineSubsystem->GetIdentityInterface() : nullptr;
+    if (FUniqueNetIdPtr ProviderPlayerId = Identity.IsValid() ? Identity->GetUniquePlayerId(0) : nullptr)
+    {
+        return ProviderPlayerId.ToSharedRef();
+    }
+    return PlayerId.AsShared();
+}
+
+/***************
+Console Commands
+***************/
+
+// DumpProviderStats prints each provider's searches, results, duplicates and search latency.
+static void DumpProviderStats(const TArray<FString>& Args, UWorld* World)
+{
+    const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    const UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if (!Subsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("ProviderStats: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    const TSharedPtr<IMultiplayerSessionBackend> Backend = Subsystem->GetBackend();
+    if (!Backend.IsValid() || Backend->GetSubsystemName() != FName("MultiProvider"))
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("ProviderStats: The session backend does not search multiple providers"));
+        return;
+    }
+
+    const FMultiProviderSessionBackend& MultiProvider = static_cast<const FMultiProviderSessionBackend&>(*Backend);
+    MULTIPLAYER_LOG(Info, TEXT("ProviderStats: %d searches across %d providers, %lld results over MaxSearchResults"),
+        MultiProvider.GetSearches(), MultiProvider.NumProviders(), MultiProvider.GetResultsOverLimit());
+    for (int32 ProviderIndex = 0; ProviderIndex < MultiProvider.NumProviders(); ++ProviderIndex)
+    {
+        const FSearchProviderStats& Stats = MultiProvider.GetProviderStats(ProviderIndex);
+        MULTIPLAYER_LOG(Info, TEXT("ProviderStats: %s Searches=%d Failed=%d TimedOut=%d Stale=%d Results=%lld Duplicates=%lld p50=%.3fs p95=%.3fs max=%.3fs"),
+            *Stats.Name.ToString(), Stats.Searches, Stats.Failures, Stats.TimedOut, Stats.StaleCompletions, Stats.ResultsReceived, Stats.DuplicatesDropped,
+            Stats.SearchLatency.GetPercentile(50.0), Stats.SearchLatency.GetPercentile(95.0), Stats.SearchLatency.GetMaxSeconds());
+    }
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ProviderStatsCommand(
+    TEXT("MultiplayerSessions.ProviderStats"),
+    TEXT("Prints each search provider's searches, results, duplicates dropped, and search latency percentiles."),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&DumpProviderStats)
+);
\ No newline at end of file
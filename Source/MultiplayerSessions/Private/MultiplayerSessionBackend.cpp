@@ -0,0 +1,128 @@
+// (c) 2023 Will Roberts
+
+#include "MultiplayerSessionBackend.h"
+#include "OnlineSessionSettings.h"
+#include "OnlineSubsystem.h"
+
+/*************
+Public Methods
+*************/
+
+// FOnlineSessionBackend binds forwarding delegates on the session interface.
+FOnlineSessionBackend::FOnlineSessionBackend(FName InSubsystemName, IOnlineSessionPtr InSessionInterface):
+    SubsystemName(InSubsystemName),
+    SessionInterface(MoveTemp(InSessionInterface)),
+    bIsLANProvider(InSubsystemName == FName("NULL"))
+{
+    CreateSessionCompleteHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(
+        FOnCreateSessionCompleteDelegate::CreateLambda([this](FName SessionName, bool bWasSuccessful)
+        {
+            TriggerOnCreateSessionCompleteDelegates(SessionName, bWasSuccessful);
+        }));
+    FindSessionsCompleteHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(
+        FOnFindSessionsCompleteDelegate::CreateLambda([this](bool bWasSuccessful)
+        {
+            TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
+        }));
+    JoinSessionCompleteHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(
+        FOnJoinSessionCompleteDelegate::CreateLambda([this](FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+        {
+            TriggerOnJoinSessionCompleteDelegates(SessionName, Result);
+        }));
+    DestroySessionCompleteHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(
+        FOnDestroySessionCompleteDelegate::CreateLambda([this](FName SessionName, bool bWasSuccessful)
+        {
+            TriggerOnDestroySessionCompleteDelegates(SessionName, bWasSuccessful);
+        }));
+    StartSessionCompleteHandle = SessionInterface->AddOnStartSessionCompleteDelegate_Handle(
+        FOnStartSessionCompleteDelegate::CreateLambda([this](FName SessionName, bool bWasSuccessful)
+        {
+            TriggerOnStartSessionCompleteDelegates(SessionName, bWasSuccessful);
+        }));
+    UpdateSessionCompleteHandle = SessionInterface->AddOnUpdateSessionCompleteDelegate_Handle(
+        FOnUpdateSessionCompleteDelegate::CreateLambda([this](FName SessionName, bool bWasSuccessful)
+        {
+            TriggerOnUpdateSessionCompleteDelegates(SessionName, bWasSuccessful);
+        }));
+}
+
+// ~FOnlineSessionBackend clears the forwarding delegates, so late responses are not delivered to a destroyed backend.
+FOnlineSessionBackend::~FOnlineSessionBackend()
+{
+    SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteHandle);
+    SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteHandle);
+    SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteHandle);
+    SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteHandle);
+    SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteHandle);
+    SessionInterface->ClearOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteHandle);
+}
+
+// Create wraps an Online Subsystem's session interface, e.g. "NULL" for LAN sessions on loopback.
+TSharedPtr<IMultiplayerSessionBackend> FOnlineSessionBackend::Create(FName SubsystemName)
+{
+    IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get(SubsystemName);
+    if (!OnlineSubsystem)
+    {
+        return nullptr;
+    }
+    IOnlineSessionPtr SessionInterface = OnlineSubsystem->GetSessionInterface();
+    if (!SessionInterface.IsValid())
+    {
+        return nullptr;
+    }
+    return MakeShared<FOnlineSessionBackend>(OnlineSubsystem->GetSubsystemName(), SessionInterface);
+}
+
+// CreateSession forwards a session creation to the session interface.
+bool FOnlineSessionBackend::CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+    return SessionInterface->CreateSession(HostingPlayerId, SessionName, NewSessionSettings);
+}
+
+// FindSessions forwards a search to the session interface.
+bool FOnlineSessionBackend::FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    return SessionInterface->FindSessions(SearchingPlayerId, SearchSettings);
+}
+
+// CancelFindSessions forwards a search cancellation to the session interface.
+bool FOnlineSessionBackend::CancelFindSessions()
+{
+    return SessionInterface->CancelFindSessions();
+}
+
+// JoinSession forwards a join to the session interface.
+bool FOnlineSessionBackend::JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+    return SessionInterface->JoinSession(PlayerId, SessionName, DesiredSession);
+}
+
+// DestroySession forwards a session destruction to the session interface.
+bool FOnlineSessionBackend::DestroySession(FName SessionName)
+{
+    return SessionInterface->DestroySession(SessionName);
+}
+
+// StartSession forwards a session start to the session interface.
+bool FOnlineSessionBackend::StartSession(FName SessionName)
+{
+    return SessionInterface->StartSession(SessionName);
+}
+
+// UpdateSession forwards a settings update to the session interface.
+bool FOnlineSessionBackend::UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData)
+{
+    return SessionInterface->UpdateSession(SessionName, UpdatedSessionSettings, bShouldRefreshOnlineData);
+}
+
+// HasSession checks the session interface for a named session.
+bool FOnlineSessionBackend::HasSession(FName SessionName) const
+{
+    return SessionInterface->GetNamedSession(SessionName) != nullptr;
+}
+
+// GetResolvedConnectString asks the session interface for the address of a joined session.
+bool FOnlineSessionBackend::GetResolvedConnectString(FName SessionName, FString& ConnectInfo)
+{
+    return SessionInterface->GetResolvedConnectString(SessionName, ConnectInfo);
+}
\ No newline at end of file
@@ -1,20 +1,26 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#include "MultiplayerSessions.h"
-
-#define LOCTEXT_NAMESPACE "FMultiplayerSessionsModule"
-
-void FMultiplayerSessionsModule::StartupModule()
-{
-	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
-}
-
-void FMultiplayerSessionsModule::ShutdownModule()
-{
-	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
-	// we call this function before unloading the module.
-}
-
-#undef LOCTEXT_NAMESPACE
-	
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MultiplayerSessions.h"
+#include "Logger.h"
+#include "MultiplayerSessionsTrace.h"
+
+#define LOCTEXT_NAMESPACE "FMultiplayerSessionsModule"
+
+void FMultiplayerSessionsModule::StartupModule()
+{
+	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	Logger::Startup();
+	FMultiplayerSessionsTrace::Startup();
+}
+
+void FMultiplayerSessionsModule::ShutdownModule()
+{
+	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
+	// we call this function before unloading the module.
+	FMultiplayerSessionsTrace::Shutdown();
+	Logger::Shutdown();
+}
+
+#undef LOCTEXT_NAMESPACE
+	
 IMPLEMENT_MODULE(FMultiplayerSessionsModule, MultiplayerSessions)
\ No newline at end of file
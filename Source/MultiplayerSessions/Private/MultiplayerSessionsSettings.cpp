@@ -0,0 +1,25 @@
+// (c) 2023 Will Roberts
+
+#include "MultiplayerSessionsSettings.h"
+#include "Logger.h"
+
+// UMultiplayerSessionsSettings places the plugin's settings under Project Settings > Plugins.
+UMultiplayerSessionsSettings::UMultiplayerSessionsSettings()
+{
+    CategoryName = TEXT("Plugins");
+    SectionName = TEXT("MultiplayerSessions");
+}
+
+
+#if WITH_EDITOR
+// PostEditChangeProperty applies a new log level without restarting the editor.
+void UMultiplayerSessionsSettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(UMultiplayerSessionsSettings, LogLevel))
+    {
+        Logger::SetRuntimeLevel(LogLevel);
+    }
+}
+#endif
\ No newline at end of file
@@ -1,208 +1,2511 @@
-// (c) 2023 Will Roberts
-
-#include "MultiplayerSessionsSubsystem.h"
-#include "OnlineSessionSettings.h"
-#include "OnlineSubsystem.h"
-
-#include "Logger.h"
-
-/*************
-Public Methods
-*************/
-
-// UMultiplayerSessionsSubsystem constructs a new instance, binds delegates, and saves a pointer to the OnlineSubsystem's SessionInterface.
-UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem():
-    CreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),
-    FindSessionsCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnFindSessionsComplete)),
-    JoinSessionCompleteDelegate(FOnJoinSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnJoinSessionComplete)),
-    DestroySessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete)),
-    StartSessionCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartSessionComplete))
-{
-    IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get();
-    if (!OnlineSubsystem)
-    {
-        Logger::Log(FString(TEXT("MultiplayerSessionsSubsystem: Failed to get OnlineSubsystem")), true);
-        return;
-    }
-
-    SessionInterface = OnlineSubsystem->GetSessionInterface();
-}
-
-// CreateSession destroys any existing session before creating a new online session.
-void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FString MatchType)
-{
-    if (!SessionInterface.IsValid())
-    {
-        Logger::Log(FString(TEXT("CreateSession: Failed to get SessionInterface")), true);
-        return;
-    }
-
-    auto ExistingSession = SessionInterface->GetNamedSession(NAME_GameSession);
-    if (ExistingSession)
-    {
-        Logger::Log(FString(TEXT("CreateSession: Destroying existing session...")), false);
-        bCreateSessionOnDestroy = true;
-        LastNumPublicConnections = NumPublicConnections;
-        LastMatchType = MatchType;
-
-        DestroySession();
-    }
-
-    CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
-
-    LastSessionSettings = MakeShareable(new FOnlineSessionSettings());
-    LastSessionSettings->bAllowJoinInProgress = true;
-    LastSessionSettings->bAllowJoinViaPresence = true;
-    LastSessionSettings->bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false;
-    LastSessionSettings->bShouldAdvertise = true;
-    LastSessionSettings->bUseLobbiesIfAvailable = true; // Needed for UE 5.0+.
-    LastSessionSettings->bUsesPresence = true;
-    LastSessionSettings->BuildUniqueId = 1; // Share sessions across builds.
-    LastSessionSettings->NumPublicConnections = NumPublicConnections;
-    LastSessionSettings->Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
-
-    const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-    if (!LocalPlayer)
-    {
-        Logger::Log(FString(TEXT("CreateSession: Failed to get player's unique net ID")), true);
-        return;
-    }
-
-    SessionInterface->CreateSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, *LastSessionSettings);
-}
-
-// FindSessions searches for sessions and saves the results.
-void UMultiplayerSessionsSubsystem::FindSessions(int32 MaxSearchResults)
-{
-    if (!SessionInterface.IsValid())
-    {
-        Logger::Log(FString(TEXT("FindSessions: Failed to get SessionInterface")), true);
-        return;
-    }
-
-    // Configure search parameters.
-    FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
-    LastSessionSearch = MakeShareable(new FOnlineSessionSearch());
-    LastSessionSearch->MaxSearchResults = MaxSearchResults;
-    LastSessionSearch->bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false;
-    LastSessionSearch->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
-
-    // Use first local player's unique net ID to find sessions.
-    const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-    SessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(), LastSessionSearch.ToSharedRef());
-}
-
-// JoinSession joins the specified game session with a player's unique ID.
-void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult &SessionResult)
-{
-    if (!SessionInterface.IsValid())
-    {
-        MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
-        return;
-    }
-    JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
-    const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-    SessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, SessionResult);
-}
-
-// DestroySession destroys the current session.
-void UMultiplayerSessionsSubsystem::DestroySession()
-{
-    if (!SessionInterface.IsValid())
-    {
-        MultiplayerOnDestroySessionComplete.Broadcast(false);
-        return;
-    }
-    DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
-    SessionInterface->DestroySession(NAME_GameSession);
-}
-
-// StartSession marks the online session as in-progress.
-void UMultiplayerSessionsSubsystem::StartSession()
-{
-    if (!SessionInterface.IsValid())
-    {
-        MultiplayerOnStartSessionComplete.Broadcast(false);
-        return;
-    }
-    StartSessionCompleteDelegateHandle = SessionInterface->AddOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegate);
-    SessionInterface->StartSession(NAME_GameSession);
-}
-
-/****************
-Protected Methods
-****************/
-
-// OnCreateSessionComplete clears its delegate handle and broadcasts its result.
-void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
-{
-    if (!SessionInterface)
-    {
-        Logger::Log(FString(TEXT("OnCreateSessionComplete: Failed to get SessionInterface")), true);
-        return;
-    }
-    SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
-    MultiplayerOnCreateSessionComplete.Broadcast(bWasSuccessful);
-}
-
-// OnFindSessionsComplete clears its delegate handle and broadcasts its result.
-void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
-{
-    if (!SessionInterface)
-    {
-        Logger::Log(FString(TEXT("OnFindSessionsComplete: Failed to get SessionInterface")), true);
-        return;
-    }
-    SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
-
-    if (LastSessionSearch->SearchResults.Num() <= 0)
-    {
-        MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
-        return;
-    }
-    MultiplayerOnFindSessionsComplete.Broadcast(LastSessionSearch->SearchResults, bWasSuccessful);
-}
-
-// OnJoinSessionComplete clears its delegate handle and broadcasts its result.
-void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
-{
-    if (!SessionInterface)
-    {
-        Logger::Log(FString(TEXT("OnJoinSessionComplete: Failed to get SessionInterface")), true);
-        return;
-    }
-    SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
-    MultiplayerOnJoinSessionComplete.Broadcast(Result);
-}
-
-// OnDestroySessionComplete clears its delegate handle and broadcasts its result.
-// If `bCreateSessionOnDestroy` is true, this also creates a new online session.
-void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
-{
-    if (!SessionInterface)
-    {
-        Logger::Log(FString(TEXT("OnDestroySessionComplete: Failed to get SessionInterface")), true);
-        return;
-    }
-    SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
-    MultiplayerOnDestroySessionComplete.Broadcast(bWasSuccessful);
-
-    if (bWasSuccessful && bCreateSessionOnDestroy)
-    {
-        Logger::Log(FString(TEXT("OnDestroySessionComplete: Automatically creating new session")), false);
-        bCreateSessionOnDestroy = false;
-        CreateSession(LastNumPublicConnections, LastMatchType);
-    }
-}
-
-// OnStartSessionComplete clears its delegate handle and broadcasts its result.
-void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessful)
-{
-    if (!SessionInterface)
-    {
-        Logger::Log(FString(TEXT("OnStartSessionComplete: Failed to get SessionInterface")), true);
-        return;
-    }
-    SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);
-    MultiplayerOnStartSessionComplete.Broadcast(bWasSuccessful);
-}
\ No newline at end of file
+// (c) 2023 Will Roberts
+
+#include "MultiplayerSessionsSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "OnlineSessionSettings.h"
+
+#include "Logger.h"
+#include "DirectorySessionBackend.h"
+#include "MockSessionBackend.h"
+#include "MultiProviderSessionBackend.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsTrace.h"
+
+namespace
+{
+    // LexJoinResult returns the name of a join result, for metrics.
+    const TCHAR* LexJoinResult(EOnJoinSessionCompleteResult::Type Result)
+    {
+        switch (Result)
+        {
+        case EOnJoinSessionCompleteResult::Success: return TEXT("Success");
+        case EOnJoinSessionCompleteResult::SessionIsFull: return TEXT("SessionIsFull");
+        case EOnJoinSessionCompleteResult::SessionDoesNotExist: return TEXT("SessionDoesNotExist");
+        case EOnJoinSessionCompleteResult::CouldNotRetrieveAddress: return TEXT("CouldNotRetrieveAddress");
+        case EOnJoinSessionCompleteResult::AlreadyInSession: return TEXT("AlreadyInSession");
+        default: return TEXT("UnknownError");
+        }
+    }
+
+    const TCHAR* LexSuccess(bool bWasSuccessful)
+    {
+        return bWasSuccessful ? TEXT("Success") : TEXT("Failure");
+    }
+
+    // RequiresRecreate returns 'true' when settings which providers fix at creation differ, so the session cannot be updated in place.
+    // Advertised settings, such as the match type, map, and connection count, can be updated.
+    bool RequiresRecreate(const FOnlineSessionSettings& Current, const FOnlineSessionSettings& Requested)
+    {
+        return Current.bIsLANMatch != Requested.bIsLANMatch
+            || Current.bIsDedicated != Requested.bIsDedicated
+            || Current.bUsesPresence != Requested.bUsesPresence
+            || Current.bUseLobbiesIfAvailable != Requested.bUseLobbiesIfAvailable
+            || Current.bAllowJoinViaPresence != Requested.bAllowJoinViaPresence
+            || Current.BuildUniqueId != Requested.BuildUniqueId;
+    }
+}
+
+/*************
+Public Methods
+*************/
+
+// UMultiplayerSessionsSubsystem constructs a new instance and binds delegates.
+UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem():
+    CreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),
+    FindSessionsCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnBackendFindSessionsComplete)),
+    FindSessionsPageCompleteDelegate(FOnFindSessionsPageCompleteDelegate::CreateUObject(this, &ThisClass::OnBackendFindSessionsPageComplete)),
+    JoinSessionCompleteDelegate(FOnJoinSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnBackendJoinSessionComplete)),
+    DestroySessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete)),
+    StartSessionCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartSessionComplete)),
+    UpdateSessionCompleteDelegate(FOnUpdateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnUpdateSessionComplete))
+{}
+
+// Initialize selects the session backend and starts the ticker which enforces operation timeouts.
+// The mock backend is used when enabled in the settings or with the -MultiplayerSessionsMock switch,
+// then the directory backend when enabled or with the -MultiplayerSessionsDirectory switch,
+// then every provider searched together when two or more are listed in the settings or with -MultiplayerSessionsProviders=NULL,Steam,
+// otherwise the default Online Subsystem's SessionInterface is used.
+void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    FMultiplayerMultiProviderSettings MultiProvider = Settings->MultiProvider;
+    FString ProviderList;
+    if (FParse::Value(FCommandLine::Get(), TEXT("MultiplayerSessionsProviders="), ProviderList, false))
+    {
+        TArray<FString> ProviderNames;
+        ProviderList.ParseIntoArray(ProviderNames, TEXT(","));
+        MultiProvider.Providers.Reset();
+        for (const FString& ProviderName : ProviderNames)
+        {
+            MultiProvider.Providers.Add(FName(*ProviderName));
+        }
+    }
+
+    if (Settings->bUseMockBackend || FParse::Param(FCommandLine::Get(), TEXT("MultiplayerSessionsMock")))
+    {
+        MULTIPLAYER_LOG(Info, TEXT("MultiplayerSessionsSubsystem: Using mock session backend"));
+        SessionInterface = MakeShared<FMockSessionBackend>(Settings->MockBackend);
+    }
+    else if (Settings->bUseDirectoryBackend || FParse::Param(FCommandLine::Get(), TEXT("MultiplayerSessionsDirectory")))
+    {
+        MULTIPLAYER_LOG(Info, TEXT("MultiplayerSessionsSubsystem: Using session directory backend"));
+        SessionInterface = MakeShared<FDirectorySessionBackend>(Settings->DirectoryBackend);
+    }
+    else if (MultiProvider.Providers.Num() > 1)
+    {
+        MULTIPLAYER_LOG(Info, TEXT("MultiplayerSessionsSubsystem: Searching %d session providers together"), MultiProvider.Providers.Num());
+        SessionInterface = FMultiProviderSessionBackend::Create(MultiProvider);
+        if (!SessionInterface.IsValid())
+        {
+            MULTIPLAYER_LOG(Error, TEXT("MultiplayerSessionsSubsystem: None of the session providers are available"));
+        }
+    }
+    else
+    {
+        SessionInterface = FOnlineSessionBackend::Create();
+        if (!SessionInterface.IsValid())
+        {
+            MULTIPLAYER_LOG(Error, TEXT("MultiplayerSessionsSubsystem: Failed to get SessionInterface"));
+        }
+    }
+    BindBackendDelegates();
+
+    SearchQueue.OnTimedOut.BindUObject(this, &ThisClass::OnOperationTimedOut, FName(NAME_None));
+    OperationTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateUObject(this, &ThisClass::TickOperationQueue), 0.25f);
+}
+
+// Deinitialize stops any streaming search and drops queued operations before the subsystem is destroyed.
+void UMultiplayerSessionsSubsystem::Deinitialize()
+{
+    if (OperationTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(OperationTickerHandle);
+        OperationTickerHandle.Reset();
+    }
+    SearchQueue.CancelQueued();
+    SearchQueue.OnTimedOut.Unbind();
+    for (const TPair<FName, TUniquePtr<FNamedSession>>& Pair : NamedSessions)
+    {
+        Pair.Value->OperationQueue.CancelQueued();
+        Pair.Value->OperationQueue.OnTimedOut.Unbind();
+    }
+    FailAllPromises();
+
+    if (SearchStreamTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(SearchStreamTickerHandle);
+        SearchStreamTickerHandle.Reset();
+    }
+    if (SettingsUpdateTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(SettingsUpdateTickerHandle);
+        SettingsUpdateTickerHandle.Reset();
+    }
+    if (QuickPlayTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(QuickPlayTickerHandle);
+        QuickPlayTickerHandle.Reset();
+    }
+    QuickPlayPool.Stop();
+    bSearchIsStreaming = false;
+    UnbindBackendDelegates();
+    SessionInterface.Reset();
+    MapPreloader.Release();
+
+    Super::Deinitialize();
+}
+
+// CreateSession queues the creation of a new online session with the given name.
+// When a session exists or is being created, it is destroyed first, and the new session is created once the destroy completes.
+// Repeated calls before the creation starts are coalesced, and the newest parameters are used.
+void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FString MatchType, FName SessionName)
+{
+    RequestCreateSession(FindOrAddSession(SessionName), NumPublicConnections, MatchType, nullptr);
+}
+
+// FindSessions searches for sessions with the given MatchType.
+void UMultiplayerSessionsSubsystem::FindSessions(int32 MaxSearchResults, FString MatchType)
+{
+    FMultiplayerSessionSearchFilter Filter;
+    Filter.MatchType = MatchType;
+    FindSessions(MaxSearchResults, Filter);
+}
+
+// FindSessions searches for sessions matching the filter and saves the results.
+// Recent results for the same query are served from the search cache instead of running a new search.
+void UMultiplayerSessionsSubsystem::FindSessions(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter)
+{
+    RequestFindSessions(MaxSearchResults, Filter, nullptr);
+}
+
+// FindSessionsStreaming runs a search which broadcasts results in batches of at most BatchSize as they arrive.
+// Cached results are streamed immediately. Otherwise the in-flight search is polled every frame until it completes,
+// or until StopPredicate is satisfied, in which case the search is cancelled.
+void UMultiplayerSessionsSubsystem::FindSessionsStreaming(
+    int32 MaxSearchResults,
+    const FMultiplayerSessionSearchFilter& Filter,
+    int32 BatchSize,
+    FMultiplayerSessionSearchPredicate StopPredicate
+) {
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::FindSessionsStreaming");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    Metrics.NoteRequested(EMultiplayerSessionOperation::Find);
+    if (!SessionInterface.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("FindSessionsStreaming: Failed to get SessionInterface"));
+        Metrics.NoteResult(EMultiplayerSessionOperation::Find, false, TEXT("Rejected"));
+        return;
+    }
+
+    const FSessionSearchCacheKey SearchKey = MakeSearchKey(MaxSearchResults, Filter);
+
+    bSearchIsStreaming = true;
+    SearchStreamKey = SearchKey;
+    SearchStreamBatchSize = FMath::Max(BatchSize, 1);
+    SearchStreamNumEmitted = 0;
+    SearchStreamStartTime = FPlatformTime::Seconds();
+    SearchStreamStopPredicate = MoveTemp(StopPredicate);
+    LastSearchStreamStats = FMultiplayerSearchStreamStats();
+
+    // Cached results are already local, so stream all of them now.
+    TSharedPtr<FOnlineSessionSearch> CachedSearch;
+    if (LookupCachedSearch(SearchKey, CachedSearch))
+    {
+        Metrics.NoteResult(EMultiplayerSessionOperation::Find, true, TEXT("Cached"));
+        SetLastSessionSearch(CachedSearch.ToSharedRef());
+        const bool bExitedEarly = EmitSearchStreamBatches(CachedSearch->SearchResults, true);
+        FinishSearchStream(bExitedEarly);
+        return;
+    }
+
+    StartSessionSearch(SearchKey, false);
+
+    if (!SearchStreamTickerHandle.IsValid())
+    {
+        SearchStreamTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+            FTickerDelegate::CreateUObject(this, &ThisClass::TickSearchStream));
+    }
+}
+
+// CreateSessionAsync queues the creation of a new online session, like CreateSession, and returns a future for its result.
+TFuture<bool> UMultiplayerSessionsSubsystem::CreateSessionAsync(int32 NumPublicConnections, FString MatchType, FName SessionName)
+{
+    TFuture<bool> Future;
+    RequestCreateSession(FindOrAddSession(SessionName), NumPublicConnections, MatchType, &Future);
+    return Future;
+}
+
+// FindSessionsAsync searches for sessions, like FindSessions, and returns a future for the completed search.
+// Cached results fulfill the future immediately.
+TFuture<FMultiplayerFindSessionsResult> UMultiplayerSessionsSubsystem::FindSessionsAsync(
+    int32 MaxSearchResults,
+    const FMultiplayerSessionSearchFilter& Filter
+) {
+    TFuture<FMultiplayerFindSessionsResult> Future;
+    RequestFindSessions(MaxSearchResults, Filter, &Future);
+    return Future;
+}
+
+// JoinSessionAsync queues a join, like JoinSession, and returns a future for its result.
+TFuture<EOnJoinSessionCompleteResult::Type> UMultiplayerSessionsSubsystem::JoinSessionAsync(
+    const FOnlineSessionSearchResult& SessionResult,
+    FName SessionName
+) {
+    TSharedRef<FOnlineSessionSearch> SingleSessionSearch = MakeShared<FOnlineSessionSearch>();
+    SingleSessionSearch->SearchResults.Add(SessionResult);
+
+    TFuture<EOnJoinSessionCompleteResult::Type> Future;
+    RequestJoinSessions(FindOrAddSession(SessionName), SingleSessionSearch, { 0 }, &Future);
+    return Future;
+}
+
+// JoinRankedSessionsAsync queues a join pipeline, like JoinRankedSessions, and returns a future for its final result.
+TFuture<EOnJoinSessionCompleteResult::Type> UMultiplayerSessionsSubsystem::JoinRankedSessionsAsync(
+    const TArray<int32>& RankedIndices,
+    FName SessionName
+) {
+    TFuture<EOnJoinSessionCompleteResult::Type> Future;
+    RequestJoinSessions(FindOrAddSession(SessionName), LastSessionSearch, RankedIndices, &Future);
+    return Future;
+}
+
+// DestroySessionAsync queues the destruction of the current session, like DestroySession, and returns a future for its result.
+TFuture<bool> UMultiplayerSessionsSubsystem::DestroySessionAsync(FName SessionName)
+{
+    TFuture<bool> Future;
+    RequestDestroySession(FindOrAddSession(SessionName), &Future);
+    return Future;
+}
+
+// StartSessionAsync queues marking the session as in-progress, like StartSession, and returns a future for its result.
+TFuture<bool> UMultiplayerSessionsSubsystem::StartSessionAsync(FName SessionName)
+{
+    TFuture<bool> Future;
+    RequestStartSession(FindOrAddSession(SessionName), &Future);
+    return Future;
+}
+
+// FindSessionsPageAsync queues a request for one page of results, and returns a future for the page.
+// Each page is requested on its own, since requests for different cursors cannot be coalesced.
+TFuture<FMultiplayerSessionsPage> UMultiplayerSessionsSubsystem::FindSessionsPageAsync(
+    const FMultiplayerSessionSearchFilter& Filter,
+    int32 PageSize,
+    uint64 Cursor
+) {
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::FindSessionsPageAsync");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    Metrics.NoteRequested(EMultiplayerSessionOperation::FindPage);
+    if (!SessionInterface.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("FindSessionsPage: Failed to get SessionInterface"));
+        Metrics.NoteResult(EMultiplayerSessionOperation::FindPage, false, TEXT("Rejected"));
+        FMultiplayerSessionsPage Page;
+        Page.Cursor = Cursor;
+        return MakeFulfilledPromise<FMultiplayerSessionsPage>(MoveTemp(Page)).GetFuture();
+    }
+
+    FSearchPageRequest& Request = QueuedSearchPages.Emplace_GetRef();
+    Request.SearchKey = MakeSearchKey(FMath::Max(PageSize, 1), Filter);
+    Request.Cursor = Cursor;
+    TFuture<FMultiplayerSessionsPage> Future = Request.Promise.GetFuture();
+    SearchQueue.Enqueue(EMultiplayerSessionOperation::FindPage, [this]() { SendFindSessionsPage(); });
+    return Future;
+}
+
+// GetBestSessions ranks the most recent search results using the configured scoring weights.
+void UMultiplayerSessionsSubsystem::GetBestSessions(int32 Count, TArray<int32>& OutIndices, const TArray<int32>* Candidates)
+{
+    GetBestSessions(Count, GetDefault<UMultiplayerSessionsSettings>()->ScoringWeights, OutIndices, Candidates);
+}
+
+// GetBestSessions ranks the most recent search results by ping, fill level, region, and preferred settings.
+void UMultiplayerSessionsSubsystem::GetBestSessions(
+    int32 Count,
+    const FMultiplayerSessionScoringWeights& Weights,
+    TArray<int32>& OutIndices,
+    const TArray<int32>* Candidates
+) {
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::GetBestSessions");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    const double StartTime = FPlatformTime::Seconds();
+    FSessionScorer::RankBest(SearchIndex, Weights, Count, OutIndices, Candidates);
+    LastRankSeconds = FPlatformTime::Seconds() - StartTime;
+}
+
+// CancelPendingOperations removes queued operations and reports each of them as failed.
+void UMultiplayerSessionsSubsystem::CancelPendingOperations()
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::CancelPendingOperations");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    for (const TPair<FName, TUniquePtr<FNamedSession>>& Pair : NamedSessions)
+    {
+        for (const EMultiplayerSessionOperation Operation : Pair.Value->OperationQueue.CancelQueued())
+        {
+            MULTIPLAYER_LOG(Warning, TEXT("CancelPendingOperations: Cancelled queued %s operation on %s"), LexToString(Operation), *Pair.Key.ToString());
+            OnOperationCancelled(Operation, Pair.Value.Get());
+        }
+    }
+    for (const EMultiplayerSessionOperation Operation : SearchQueue.CancelQueued())
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("CancelPendingOperations: Cancelled queued %s operation"), LexToString(Operation));
+        OnOperationCancelled(Operation, nullptr);
+    }
+
+    if (SearchQueue.IsInFlight(EMultiplayerSessionOperation::Find))
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("CancelPendingOperations: Cancelling in-flight search"));
+        SessionInterface->CancelFindSessions();
+        OnFindSessionsComplete(false);
+    }
+    if (SearchQueue.IsInFlight(EMultiplayerSessionOperation::FindPage))
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("CancelPendingOperations: Cancelling in-flight search page"));
+        SessionInterface->CancelFindSessions();
+        OnFindSessionsPageComplete(false, 0);
+    }
+}
+
+// SetBackend cancels queued operations and fails in-flight ones, so no completion from the old backend is delivered after the swap.
+// Cached results came from the old backend, so they are dropped as well.
+void UMultiplayerSessionsSubsystem::SetBackend(TSharedPtr<IMultiplayerSessionBackend> InBackend)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SetBackend");
+
+    if (SessionInterface.IsValid())
+    {
+        CancelPendingOperations();
+        for (const TPair<FName, TUniquePtr<FNamedSession>>& Pair : NamedSessions)
+        {
+            FNamedSession& Session = *Pair.Value;
+            if (Session.OperationQueue.IsInFlight(EMultiplayerSessionOperation::Create))
+            {
+                OnCreateSessionComplete(Session.Name, false);
+            }
+            if (Session.OperationQueue.IsInFlight(EMultiplayerSessionOperation::Join))
+            {
+                Session.JoinCandidatePosition = Session.JoinCandidateIndices.Num();
+                OnJoinSessionComplete(Session.Name, EOnJoinSessionCompleteResult::UnknownError);
+            }
+            if (Session.OperationQueue.IsInFlight(EMultiplayerSessionOperation::Destroy))
+            {
+                OnDestroySessionComplete(Session.Name, false);
+            }
+            if (Session.OperationQueue.IsInFlight(EMultiplayerSessionOperation::Start))
+            {
+                OnStartSessionComplete(Session.Name, false);
+            }
+            if (Session.OperationQueue.IsInFlight(EMultiplayerSessionOperation::Update))
+            {
+                OnSettingsUpdateComplete(Session.Name, false);
+            }
+
+            // The old backend's outstanding joins will never be delivered.
+            Session.OutstandingJoinSerials.Reset();
+        }
+    }
+
+    UnbindBackendDelegates();
+    SessionInterface = MoveTemp(InBackend);
+    BindBackendDelegates();
+    SearchCache.Invalidate();
+    MULTIPLAYER_LOG(Info, TEXT("SetBackend: Using %s session backend"),
+        SessionInterface.IsValid() ? *SessionInterface->GetSubsystemName().ToString() : TEXT("no"));
+}
+
+// GetResolvedConnectString asks the backend for the address of the joined session.
+bool UMultiplayerSessionsSubsystem::GetResolvedConnectString(FString& OutAddress, FName SessionName) const
+{
+    return SessionInterface.IsValid() && SessionInterface->GetResolvedConnectString(SessionName, OutAddress);
+}
+
+// GetLastJoinPipelineStats returns the attempts of the session's most recent join pipeline, or no attempts for an unknown session.
+const FMultiplayerJoinPipelineStats& UMultiplayerSessionsSubsystem::GetLastJoinPipelineStats(FName SessionName) const
+{
+    static const FMultiplayerJoinPipelineStats NoAttempts;
+    const FNamedSession* Session = FindSession(SessionName);
+    return Session ? Session->LastJoinPipelineStats : NoAttempts;
+}
+
+// GetHostedPublicConnections reads the settings the hosted session was created or last updated with.
+int32 UMultiplayerSessionsSubsystem::GetHostedPublicConnections(FName SessionName) const
+{
+    const FNamedSession* Session = FindSession(SessionName);
+    if (!Session || !Session->bHostingSession || !Session->LastSessionSettings.IsValid())
+    {
+        return 0;
+    }
+    return Session->LastSessionSettings->NumPublicConnections;
+}
+
+// UpdateSessionSetting records the setting, which the next creation of the session advertises.
+// While the session is hosted or being created, the setting is also marked changed, so the next update sends it.
+void UMultiplayerSessionsSubsystem::UpdateSessionSetting(
+    FName Key,
+    const FVariantData& Value,
+    FName SessionName,
+    EOnlineDataAdvertisementType::Type AdvertisementType
+) {
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::UpdateSessionSetting");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    const double Now = FPlatformTime::Seconds();
+    SettingsUpdateStats.ChangesRequested++;
+    if (SettingsUpdateStats.FirstChangeTime < 0.0)
+    {
+        SettingsUpdateStats.FirstChangeTime = Now;
+    }
+
+    FNamedSession& Session = FindOrAddSession(SessionName);
+    Session.CustomSettings.Add(Key, FOnlineSessionSetting(Value, AdvertisementType));
+
+    // A queued creation has not read the settings yet, so it sends this one when it starts.
+    if (!Session.bHostingSession && !Session.OperationQueue.IsInFlight(EMultiplayerSessionOperation::Create))
+    {
+        return;
+    }
+    if (Session.DirtySettings.Contains(Key))
+    {
+        SettingsUpdateStats.ChangesCoalesced++;
+        return;
+    }
+    MarkSettingChanged(Session, Key, Now);
+}
+
+// FlushSessionSettings queues an update of the session's changed settings, unless one is already queued.
+// While the session is being created, the changes are sent once creation completes.
+void UMultiplayerSessionsSubsystem::FlushSessionSettings(FName SessionName)
+{
+    FNamedSession* Session = FindSession(SessionName);
+    if (!Session || !Session->bHostingSession || Session->DirtySettings.Num() == 0)
+    {
+        return;
+    }
+    const FSessionOperationQueue& Queue = Session->OperationQueue;
+    if (Queue.IsQueued(EMultiplayerSessionOperation::Update) || Queue.IsQueuedOrInFlight(EMultiplayerSessionOperation::Create))
+    {
+        return;
+    }
+    QueueSettingsUpdate(*Session);
+}
+
+// StartQuickPlay restarts the pool with the current settings, so the first refresh runs on the next tick. Without a backend it does nothing.
+void UMultiplayerSessionsSubsystem::StartQuickPlay(const FMultiplayerSessionSearchFilter& Filter)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::StartQuickPlay");
+
+    if (!SessionInterface.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("StartQuickPlay: Failed to get SessionInterface"));
+        return;
+    }
+
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    QuickPlaySearchKey = MakeSearchKey(Settings->QuickPlay.MaxSearchResults, Filter);
+    QuickPlayPool.Start(Settings->QuickPlay, Settings->ScoringWeights, FPlatformTime::Seconds());
+    if (!QuickPlayTickerHandle.IsValid())
+    {
+        QuickPlayTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+            FTickerDelegate::CreateUObject(this, &ThisClass::TickQuickPlay));
+    }
+}
+
+// StopQuickPlay stops refreshing the pool. A quick play request still waiting for candidates fails, and a join in progress continues.
+void UMultiplayerSessionsSubsystem::StopQuickPlay()
+{
+    QuickPlayPool.Stop();
+    if (QuickPlayRequestTime >= 0.0 && !bQuickPlayJoining)
+    {
+        StartQuickPlayJoin(false);
+    }
+}
+
+// QuickPlay queues a join of the best pooled sessions, and MultiplayerOnJoinSessionComplete reports its result.
+void UMultiplayerSessionsSubsystem::QuickPlay(FName SessionName)
+{
+    RequestQuickPlay(SessionName, nullptr);
+}
+
+// QuickPlayAsync queues a join of the best pooled sessions, like QuickPlay, and returns a future for its final result.
+TFuture<EOnJoinSessionCompleteResult::Type> UMultiplayerSessionsSubsystem::QuickPlayAsync(FName SessionName)
+{
+    TFuture<EOnJoinSessionCompleteResult::Type> Future;
+    RequestQuickPlay(SessionName, &Future);
+    return Future;
+}
+
+// GetOperationQueueStats adds up the stats of every queue.
+FSessionOperationQueueStats UMultiplayerSessionsSubsystem::GetOperationQueueStats() const
+{
+    FSessionOperationQueueStats Total;
+    for (const FSessionOperationQueue* Queue : GetOperationQueues())
+    {
+        Total.Started += Queue->Stats.Started;
+        Total.Coalesced += Queue->Stats.Coalesced;
+        Total.TimedOut += Queue->Stats.TimedOut;
+        Total.Cancelled += Queue->Stats.Cancelled;
+        Total.StaleCompletions += Queue->Stats.StaleCompletions;
+    }
+    return Total;
+}
+
+// PreloadMap starts timing the host flow to MapURL, and loads the map unless preloading is disabled.
+// The map is remembered, so the next session created advertises it.
+void UMultiplayerSessionsSubsystem::PreloadMap(const FString& MapURL)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::PreloadMap");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    AdvertisedMapName = FMapPreloader::GetMapPackageName(MapURL);
+    MapPreloader.Begin(MapURL, GetDefault<UMultiplayerSessionsSettings>()->bPreloadLobbyMap);
+}
+
+// InvalidateSearchCache drops all cached search results, forcing the next FindSessions call to run a full search.
+void UMultiplayerSessionsSubsystem::InvalidateSearchCache()
+{
+    SearchCache.Invalidate();
+}
+
+// ExportMetrics saves a timestamped file, so exports from different builds and runs can be compared.
+FString UMultiplayerSessionsSubsystem::ExportMetrics(bool bAsJson) const
+{
+    const FString Path = FPaths::Combine(
+        FPaths::ProjectSavedDir(),
+        TEXT("MultiplayerSessions"),
+        FString::Printf(TEXT("SessionMetrics-%s.%s"), *FDateTime::Now().ToString(), bAsJson ? TEXT("json") : TEXT("csv"))
+    );
+    const FString Contents = bAsJson ? Metrics.ToJson(GetOperationQueues()) : Metrics.ToCsv(GetOperationQueues());
+    if (!FFileHelper::SaveStringToFile(Contents, *Path))
+    {
+        MULTIPLAYER_LOG(Error, TEXT("ExportMetrics: Failed to write %s"), *Path);
+        return FString();
+    }
+    return Path;
+}
+
+// LogMetrics writes a summary of each operation's metrics.
+void UMultiplayerSessionsSubsystem::LogMetrics() const
+{
+    for (const FString& Line : Metrics.ToSummary(GetOperationQueues()))
+    {
+        MULTIPLAYER_LOG(Info, TEXT("%s"), *Line);
+    }
+}
+
+// JoinSession queues a join of the specified session with a player's unique ID, under the given session name.
+void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult &SessionResult, FName SessionName)
+{
+    // A single session is joined as a pipeline with one candidate, using a search which holds only that session.
+    TSharedRef<FOnlineSessionSearch> SingleSessionSearch = MakeShared<FOnlineSessionSearch>();
+    SingleSessionSearch->SearchResults.Add(SessionResult);
+    RequestJoinSessions(FindOrAddSession(SessionName), SingleSessionSearch, { 0 }, nullptr);
+}
+
+// JoinRankedSessions queues a join of the first of several candidate sessions, moving on to the next candidate when a join fails.
+// Indices refer to GetSearchIndex(), e.g. the output of GetBestSessions().
+// MultiplayerOnJoinSessionComplete is broadcast once, when a join succeeds or every candidate has failed.
+// A queued join which has not started is replaced by the newest request.
+void UMultiplayerSessionsSubsystem::JoinRankedSessions(const TArray<int32>& RankedIndices, FName SessionName)
+{
+    RequestJoinSessions(FindOrAddSession(SessionName), LastSessionSearch, RankedIndices, nullptr);
+}
+
+// DestroySession queues the destruction of the named session.
+// Calls made while a destroy is already queued or in flight are coalesced with it.
+void UMultiplayerSessionsSubsystem::DestroySession(FName SessionName)
+{
+    RequestDestroySession(FindOrAddSession(SessionName), nullptr);
+}
+
+// StartSession queues marking the named session as in-progress.
+// Calls made while a start is already queued or in flight are coalesced with it.
+void UMultiplayerSessionsSubsystem::StartSession(FName SessionName)
+{
+    RequestStartSession(FindOrAddSession(SessionName), nullptr);
+}
+
+/****************
+Protected Methods
+****************/
+
+// OnCreateSessionComplete broadcasts its result, and starts the session's next queued operation.
+// It also completes re-hosts, recording how long a recreated session was not advertised.
+// Completions for sessions which have no creation in flight are ignored.
+void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnCreateSessionComplete");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    FNamedSession* Session = FindSession(SessionName);
+    if (!Session || !Session->OperationQueue.IsInFlight(EMultiplayerSessionOperation::Create))
+    {
+        return;
+    }
+    Session->bHostingSession = bWasSuccessful;
+
+    const TCHAR* Result = LexSuccess(bWasSuccessful);
+    if (bWasSuccessful && Session->CreateMode == ECreateMode::Update)
+    {
+        Result = TEXT("Updated");
+    }
+    else if (bWasSuccessful && Session->CreateMode == ECreateMode::Recreate && Session->RehostDowntimeStartTime >= 0.0)
+    {
+        Result = TEXT("Recreated");
+        RehostStats.Recreates++;
+        RehostStats.LastDowntimeSeconds = FPlatformTime::Seconds() - Session->RehostDowntimeStartTime;
+        RehostStats.RecreateDowntime.Record(RehostStats.LastDowntimeSeconds);
+        MULTIPLAYER_LOG(Info, TEXT("CreateSession: Session recreated, not advertised for %.3fs"), RehostStats.LastDowntimeSeconds);
+    }
+    Session->RehostDowntimeStartTime = -1.0;
+    Session->CreateMode = ECreateMode::Create;
+
+    // The host will not travel, so the preloaded map is no longer needed.
+    if (!bWasSuccessful && SessionName == NAME_GameSession)
+    {
+        MapPreloader.Release();
+    }
+
+    RecordOperationResult(Session->OperationQueue, EMultiplayerSessionOperation::Create, bWasSuccessful, Result);
+    BroadcastSessionResult(*Session, EMultiplayerSessionOperation::Create, bWasSuccessful);
+    Session->CreatePromises.FulfillInFlight(bWasSuccessful);
+    Session->OperationQueue.Complete(EMultiplayerSessionOperation::Create);
+}
+
+// OnFindSessionsComplete caches successful results, and broadcasts its result.
+// Results of background refreshes are cached without being broadcast. The next queued search starts afterwards.
+void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnFindSessionsComplete");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    // Backends without cursors answer page requests with an ordinary search.
+    if (SearchQueue.IsInFlight(EMultiplayerSessionOperation::FindPage))
+    {
+        OnFindSessionsPageComplete(bWasSuccessful, 0);
+        return;
+    }
+    if (!SearchQueue.IsInFlight(EMultiplayerSessionOperation::Find))
+    {
+        return;
+    }
+    bSearchInProgress = false;
+
+    if (!PendingSessionSearch.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("OnFindSessionsComplete: No search in progress"));
+        RecordOperationResult(SearchQueue, EMultiplayerSessionOperation::Find, false, TEXT("Failure"));
+        FindPromises.FulfillInFlight(FMultiplayerFindSessionsResult());
+        SearchQueue.Complete(EMultiplayerSessionOperation::Find);
+        return;
+    }
+    FilterPendingResults();
+    TSharedRef<FOnlineSessionSearch> CompletedSearch = PendingSessionSearch.ToSharedRef();
+    PendingSessionSearch.Reset();
+    PendingSearchMatcher.Reset();
+    if (bWasSuccessful && CompletedSearch->SearchResults.Num() > 0)
+    {
+        SearchCache.Store(PendingSearchKey, CompletedSearch, FPlatformTime::Seconds());
+    }
+
+    const bool bFoundSessions = bWasSuccessful && CompletedSearch->SearchResults.Num() > 0;
+    RecordOperationResult(
+        SearchQueue,
+        EMultiplayerSessionOperation::Find,
+        bWasSuccessful,
+        bFoundSessions ? TEXT("Success") : (bWasSuccessful ? TEXT("NoResults") : TEXT("Failure"))
+    );
+    if (bSearchIsBackgroundRefresh)
+    {
+        bSearchIsBackgroundRefresh = false;
+        FindPromises.FulfillInFlight(FMultiplayerFindSessionsResult{ CompletedSearch, bFoundSessions });
+        SearchQueue.Complete(EMultiplayerSessionOperation::Find);
+        return;
+    }
+
+    SetLastSessionSearch(CompletedSearch);
+
+    // Streaming searches deliver the remaining results as a final batch instead of a single broadcast.
+    if (bSearchIsStreaming && PendingSearchKey == SearchStreamKey)
+    {
+        const bool bExitedEarly = EmitSearchStreamBatches(CompletedSearch->SearchResults, true);
+        FinishSearchStream(bExitedEarly);
+    }
+    else if (LastSessionSearch->SearchResults.Num() <= 0)
+    {
+        MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+    }
+    else
+    {
+        MultiplayerOnFindSessionsComplete.Broadcast(LastSessionSearch->SearchResults, bWasSuccessful);
+    }
+    FindPromises.FulfillInFlight(FMultiplayerFindSessionsResult{ CompletedSearch, bFoundSessions });
+    SearchQueue.Complete(EMultiplayerSessionOperation::Find);
+}
+
+// OnFindSessionsPageComplete filters the in-flight page locally, fulfills its request, and starts the next queued search.
+// Without cursors, the search started from the first result, so the results before the page are dropped,
+// and the next cursor counts the results received. The last page is the one which received fewer results than it asked for.
+void UMultiplayerSessionsSubsystem::OnFindSessionsPageComplete(bool bWasSuccessful, uint64 NextCursor)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnFindSessionsPageComplete");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    if (!SearchQueue.IsInFlight(EMultiplayerSessionOperation::FindPage) || !InFlightSearchPage.IsSet())
+    {
+        return;
+    }
+    FSearchPageRequest Request = MoveTemp(InFlightSearchPage.GetValue());
+    InFlightSearchPage.Reset();
+    TSharedPtr<FOnlineSessionSearch> Search = MoveTemp(PendingPageSearch);
+    PendingPageSearch.Reset();
+
+    FMultiplayerSessionsPage Page;
+    Page.Cursor = Request.Cursor;
+    Page.bWasSuccessful = bWasSuccessful && Search.IsValid();
+    if (Page.bWasSuccessful)
+    {
+        TArray<FOnlineSessionSearchResult>& Results = Search->SearchResults;
+        if (!Request.bUsesCursor)
+        {
+            const int32 NumReceived = Results.Num();
+            NextCursor = NumReceived < Search->MaxSearchResults ? 0 : NumReceived;
+            Results.RemoveAt(0, static_cast<int32>(FMath::Min<uint64>(Request.Cursor, NumReceived)));
+        }
+
+        const FSessionSearchFilterMatcher Matcher(Request.SearchKey.Filter);
+        SearchFilterStats.ResultsReceived += Results.Num();
+        SearchFilterStats.ResultsRejectedLocally += Matcher.RemoveNonMatching(Results, 0);
+        Results.Shrink();
+        Page.Search = Search;
+        Page.NextCursor = NextCursor;
+    }
+
+    RecordOperationResult(
+        SearchQueue,
+        EMultiplayerSessionOperation::FindPage,
+        Page.bWasSuccessful,
+        Page.bWasSuccessful ? (Search->SearchResults.Num() > 0 ? TEXT("Success") : TEXT("NoResults")) : TEXT("Failure")
+    );
+    Request.Promise.SetValue(MoveTemp(Page));
+    SearchQueue.Complete(EMultiplayerSessionOperation::FindPage);
+}
+
+// OnJoinSessionComplete broadcasts its result.
+// Failed joins invalidate the search cache, since the cached results may be full or no longer exist.
+// During a join pipeline, retryable failures move on to the next candidate instead of being broadcast.
+void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnJoinSessionComplete");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    FNamedSession* Session = FindSession(SessionName);
+    if (!Session || !Session->OperationQueue.IsInFlight(EMultiplayerSessionOperation::Join))
+    {
+        return;
+    }
+
+    if (Result != EOnJoinSessionCompleteResult::Success)
+    {
+        InvalidateSearchCache();
+    }
+
+    if (Session->JoinCandidatesSearch.IsValid())
+    {
+        TRACE_END_REGION(*Session->JoinAttemptRegionName);
+        const double Now = FPlatformTime::Seconds();
+        FMultiplayerJoinAttempt& Attempt = Session->LastJoinPipelineStats.Attempts.Last();
+        Attempt.Result = Result;
+        Attempt.Seconds = Now - Session->JoinAttemptStartTime;
+
+        // AlreadyInSession will not be fixed by trying another session.
+        const bool bCanRetry = Result != EOnJoinSessionCompleteResult::Success
+            && Result != EOnJoinSessionCompleteResult::AlreadyInSession
+            && Session->JoinCandidatePosition < Session->JoinCandidateIndices.Num();
+        if (bCanRetry)
+        {
+            MULTIPLAYER_LOG(
+                Info,
+                TEXT("OnJoinSessionComplete: Candidate %d failed after %.3fs, trying next candidate"),
+                Attempt.CandidateIndex,
+                Attempt.Seconds
+            );
+            Session->OperationQueue.RestartTimeout();
+            SendNextJoinCandidate(*Session);
+            return;
+        }
+
+        if (Result == EOnJoinSessionCompleteResult::Success)
+        {
+            Session->LastJoinPipelineStats.TimeToJoined = Now - Session->JoinPipelineStartTime;
+            MULTIPLAYER_LOG(
+                Info,
+                TEXT("OnJoinSessionComplete: Join pipeline finished after %d attempts in %.3fs"),
+                Session->LastJoinPipelineStats.Attempts.Num(),
+                Now - Session->JoinPipelineStartTime
+            );
+        }
+        else
+        {
+            MULTIPLAYER_LOG(
+                Warning,
+                TEXT("OnJoinSessionComplete: Join pipeline failed after %d attempts in %.3fs"),
+                Session->LastJoinPipelineStats.Attempts.Num(),
+                Now - Session->JoinPipelineStartTime
+            );
+        }
+
+        Session->JoinCandidatesSearch.Reset();
+        Session->JoinCandidateIndices.Reset();
+    }
+
+    if (Result == EOnJoinSessionCompleteResult::Success)
+    {
+        Session->bHostingSession = false;
+    }
+    else if (SessionName == NAME_GameSession)
+    {
+        // The client will not travel, so the prefetched map is no longer needed.
+        MapPreloader.Release();
+    }
+    const bool bJoined = Result == EOnJoinSessionCompleteResult::Success;
+    RecordOperationResult(Session->OperationQueue, EMultiplayerSessionOperation::Join, bJoined, LexJoinResult(Result));
+    if (SessionName == NAME_GameSession)
+    {
+        MultiplayerOnJoinSessionComplete.Broadcast(Result);
+    }
+    MultiplayerOnSessionOperationComplete.Broadcast(SessionName, EMultiplayerSessionOperation::Join, bJoined);
+    Session->JoinPromises.FulfillInFlight(Result);
+    Session->OperationQueue.Complete(EMultiplayerSessionOperation::Join);
+}
+
+// OnBackendFindSessionsComplete drops the completion of a search which timed out or was cancelled.
+// The completed search is no longer in progress, so a completion which arrives while the pending search still is belongs to an older one.
+void UMultiplayerSessionsSubsystem::OnBackendFindSessionsComplete(bool bWasSuccessful)
+{
+    const bool bIsPage = SearchQueue.IsInFlight(EMultiplayerSessionOperation::FindPage);
+    const TSharedPtr<FOnlineSessionSearch>& Search = bIsPage ? PendingPageSearch : PendingSessionSearch;
+    if (Search.IsValid() && Search->SearchState == EOnlineAsyncTaskState::InProgress)
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("OnFindSessionsComplete: Dropped the completion of an earlier search"));
+        SearchQueue.Stats.StaleCompletions++;
+        return;
+    }
+    OnFindSessionsComplete(bWasSuccessful);
+}
+
+// OnBackendFindSessionsPageComplete drops the completion of a page which timed out or was cancelled, like OnBackendFindSessionsComplete.
+void UMultiplayerSessionsSubsystem::OnBackendFindSessionsPageComplete(bool bWasSuccessful, uint64 NextCursor)
+{
+    if (PendingPageSearch.IsValid() && PendingPageSearch->SearchState == EOnlineAsyncTaskState::InProgress)
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("OnFindSessionsPageComplete: Dropped the completion of an earlier page"));
+        SearchQueue.Stats.StaleCompletions++;
+        return;
+    }
+    OnFindSessionsPageComplete(bWasSuccessful, NextCursor);
+}
+
+// OnBackendJoinSessionComplete matches the completion to one of the session's outstanding joins, and drops it unless it
+// belongs to the last join sent, since earlier joins timed out and the subsystem moved on. Joins complete in the order
+// they were sent, except that a backend rejects a join at once while an earlier join under the name is outstanding,
+// so AlreadyInSession answers the last join. Completions for a session without an outstanding join are passed on.
+void UMultiplayerSessionsSubsystem::OnBackendJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+{
+    FNamedSession* Session = FindSession(SessionName);
+    if (!Session || Session->OutstandingJoinSerials.Num() == 0)
+    {
+        OnJoinSessionComplete(SessionName, Result);
+        return;
+    }
+
+    const int32 Index = Result == EOnJoinSessionCompleteResult::AlreadyInSession ? Session->OutstandingJoinSerials.Num() - 1 : 0;
+    const uint32 Serial = Session->OutstandingJoinSerials[Index];
+    Session->OutstandingJoinSerials.RemoveAt(Index);
+    if (Serial != Session->JoinCallSerial)
+    {
+        MULTIPLAYER_LOG(
+            Warning,
+            TEXT("OnJoinSessionComplete: Dropped the %s completion of a join on %s which timed out"),
+            LexJoinResult(Result),
+            *SessionName.ToString()
+        );
+        Session->OperationQueue.Stats.StaleCompletions++;
+        return;
+    }
+    OnJoinSessionComplete(SessionName, Result);
+}
+
+// OnDestroySessionComplete broadcasts its result, and starts the session's next queued operation.
+// When the destroy is part of a recreate, the queued session creation starts next.
+// Destroys sent by a re-host are routed to OnRehostDestroyComplete instead.
+void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnDestroySessionComplete");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    FNamedSession* Session = FindSession(SessionName);
+    if (!Session)
+    {
+        return;
+    }
+    if (Session->OperationQueue.IsInFlight(EMultiplayerSessionOperation::Create) && Session->CreateMode == ECreateMode::Recreate)
+    {
+        OnRehostDestroyComplete(SessionName, bWasSuccessful);
+        return;
+    }
+    if (!Session->OperationQueue.IsInFlight(EMultiplayerSessionOperation::Destroy))
+    {
+        return;
+    }
+
+    if (bWasSuccessful)
+    {
+        Session->bHostingSession = false;
+
+        // Custom settings describe the destroyed session, unless it is being recreated.
+        if (Session->RehostDowntimeStartTime < 0.0)
+        {
+            Session->CustomSettings.Reset();
+            Session->DirtySettings.Reset();
+            Session->FirstDirtyTime = -1.0;
+        }
+    }
+    RecordOperationResult(Session->OperationQueue, EMultiplayerSessionOperation::Destroy, bWasSuccessful, LexSuccess(bWasSuccessful));
+    BroadcastSessionResult(*Session, EMultiplayerSessionOperation::Destroy, bWasSuccessful);
+    Session->DestroyPromises.FulfillInFlight(bWasSuccessful);
+    Session->OperationQueue.Complete(EMultiplayerSessionOperation::Destroy);
+}
+
+// OnStartSessionComplete broadcasts its result, and starts the session's next queued operation.
+void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnStartSessionComplete");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    FNamedSession* Session = FindSession(SessionName);
+    if (!Session || !Session->OperationQueue.IsInFlight(EMultiplayerSessionOperation::Start))
+    {
+        return;
+    }
+    RecordOperationResult(Session->OperationQueue, EMultiplayerSessionOperation::Start, bWasSuccessful, LexSuccess(bWasSuccessful));
+    BroadcastSessionResult(*Session, EMultiplayerSessionOperation::Start, bWasSuccessful);
+    Session->StartPromises.FulfillInFlight(bWasSuccessful);
+    Session->OperationQueue.Complete(EMultiplayerSessionOperation::Start);
+}
+
+// OnUpdateSessionComplete completes a settings update, or a warm re-host.
+// When the provider rejects a re-host's update, the session is recreated instead.
+void UMultiplayerSessionsSubsystem::OnUpdateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnUpdateSessionComplete");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    FNamedSession* Session = FindSession(SessionName);
+    if (Session && Session->OperationQueue.IsInFlight(EMultiplayerSessionOperation::Update))
+    {
+        OnSettingsUpdateComplete(SessionName, bWasSuccessful);
+        return;
+    }
+    if (!Session || !Session->OperationQueue.IsInFlight(EMultiplayerSessionOperation::Create) || Session->CreateMode != ECreateMode::Update)
+    {
+        return;
+    }
+    if (!bWasSuccessful)
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("CreateSession: Failed to update session, recreating it"));
+        RehostStats.UpdateFallbacks++;
+        SendRehostDestroy(*Session);
+        return;
+    }
+
+    RehostStats.Updates++;
+    RehostStats.UpdateLatency.Record(FPlatformTime::Seconds() - Session->CreateStartTime);
+    RehostStats.LastDowntimeSeconds = 0.0;
+    MULTIPLAYER_LOG(Info, TEXT("CreateSession: Session updated in place after %.3fs"), FPlatformTime::Seconds() - Session->CreateStartTime);
+    OnCreateSessionComplete(SessionName, true);
+}
+
+// OnRehostDestroyComplete creates the new session once the old one is gone.
+void UMultiplayerSessionsSubsystem::OnRehostDestroyComplete(FName SessionName, bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnRehostDestroyComplete");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    FNamedSession* Session = FindSession(SessionName);
+    if (!Session || !Session->OperationQueue.IsInFlight(EMultiplayerSessionOperation::Create))
+    {
+        return;
+    }
+    if (!bWasSuccessful)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("CreateSession: Failed to destroy the existing session"));
+        OnCreateSessionComplete(SessionName, false);
+        return;
+    }
+    Session->bHostingSession = false;
+    SendCreateNewSession(*Session);
+}
+
+// OnSettingsUpdateComplete advertises the sent settings once the backend accepts them.
+// Settings the backend rejected are marked changed again, so the next update retries them.
+void UMultiplayerSessionsSubsystem::OnSettingsUpdateComplete(FName SessionName, bool bWasSuccessful)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnSettingsUpdateComplete");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    FNamedSession* Session = FindSession(SessionName);
+    if (!Session || !Session->OperationQueue.IsInFlight(EMultiplayerSessionOperation::Update))
+    {
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    if (bWasSuccessful)
+    {
+        Session->LastSessionSettings = Session->PendingSettings;
+        SettingsUpdateStats.UpdateLatency.Record(Now - Session->SettingsUpdateStartTime);
+    }
+    else
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("UpdateSessionSetting: Failed to update the settings of %s"), *SessionName.ToString());
+        SettingsUpdateStats.UpdatesFailed++;
+        if (Session->bHostingSession)
+        {
+            for (const FName& Key : Session->PendingSettingsKeys)
+            {
+                MarkSettingChanged(*Session, Key, Now);
+            }
+        }
+    }
+    Session->PendingSettings.Reset();
+    Session->PendingSettingsKeys.Reset();
+
+    RecordOperationResult(Session->OperationQueue, EMultiplayerSessionOperation::Update, bWasSuccessful, LexSuccess(bWasSuccessful));
+    Session->OperationQueue.Complete(EMultiplayerSessionOperation::Update);
+}
+
+/**************
+Private Methods
+**************/
+
+// FindOrAddSession returns the state of the named session, allocating it and its queue the first time the name is used.
+UMultiplayerSessionsSubsystem::FNamedSession& UMultiplayerSessionsSubsystem::FindOrAddSession(FName SessionName)
+{
+    if (TUniquePtr<FNamedSession>* Existing = NamedSessions.Find(SessionName))
+    {
+        return **Existing;
+    }
+    FNamedSession& Session = *NamedSessions.Add(SessionName, MakeUnique<FNamedSession>(SessionName));
+    Session.OperationQueue.OnTimedOut.BindUObject(this, &ThisClass::OnOperationTimedOut, SessionName);
+    return Session;
+}
+
+// FindSession returns the state of the named session, or nullptr when the name has never been used.
+UMultiplayerSessionsSubsystem::FNamedSession* UMultiplayerSessionsSubsystem::FindSession(FName SessionName) const
+{
+    const TUniquePtr<FNamedSession>* Existing = NamedSessions.Find(SessionName);
+    return Existing ? Existing->Get() : nullptr;
+}
+
+// GetOperationQueues lists the search queue, followed by the queue of every named session.
+TArray<const FSessionOperationQueue*> UMultiplayerSessionsSubsystem::GetOperationQueues() const
+{
+    TArray<const FSessionOperationQueue*> Queues;
+    Queues.Reserve(NamedSessions.Num() + 1);
+    Queues.Add(&SearchQueue);
+    for (const TPair<FName, TUniquePtr<FNamedSession>>& Pair : NamedSessions)
+    {
+        Queues.Add(&Pair.Value->OperationQueue);
+    }
+    return Queues;
+}
+
+// BindBackendDelegates binds the completion delegates once per backend, rather than once per operation.
+// Completions are routed to the named session's in-flight operation, and ignored when it has none.
+void UMultiplayerSessionsSubsystem::BindBackendDelegates()
+{
+    if (!SessionInterface.IsValid())
+    {
+        return;
+    }
+    CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
+    FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
+    FindSessionsPageCompleteDelegateHandle = SessionInterface->AddOnFindSessionsPageCompleteDelegate_Handle(FindSessionsPageCompleteDelegate);
+    JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
+    DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+    StartSessionCompleteDelegateHandle = SessionInterface->AddOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegate);
+    UpdateSessionCompleteDelegateHandle = SessionInterface->AddOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteDelegate);
+}
+
+// UnbindBackendDelegates clears the completion delegates, so a replaced backend delivers nothing to the subsystem.
+void UMultiplayerSessionsSubsystem::UnbindBackendDelegates()
+{
+    if (!SessionInterface.IsValid())
+    {
+        return;
+    }
+    SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+    SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+    SessionInterface->ClearOnFindSessionsPageCompleteDelegate_Handle(FindSessionsPageCompleteDelegateHandle);
+    SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+    SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+    SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);
+    SessionInterface->ClearOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteDelegateHandle);
+}
+
+// BroadcastSessionResult reports a create, destroy or start result.
+// The single-session delegates only report the game session, so existing listeners never see party or spectator sessions.
+void UMultiplayerSessionsSubsystem::BroadcastSessionResult(
+    const FNamedSession& Session,
+    EMultiplayerSessionOperation Operation,
+    bool bWasSuccessful
+) {
+    if (Session.Name == NAME_GameSession)
+    {
+        switch (Operation)
+        {
+        case EMultiplayerSessionOperation::Create:
+            MultiplayerOnCreateSessionComplete.Broadcast(bWasSuccessful);
+            break;
+        case EMultiplayerSessionOperation::Destroy:
+            MultiplayerOnDestroySessionComplete.Broadcast(bWasSuccessful);
+            break;
+        case EMultiplayerSessionOperation::Start:
+            MultiplayerOnStartSessionComplete.Broadcast(bWasSuccessful);
+            break;
+        default:
+            break;
+        }
+    }
+    MultiplayerOnSessionOperationComplete.Broadcast(Session.Name, Operation, bWasSuccessful);
+}
+
+// RequestCreateSession queues a session creation, preceded by a destroy when a session exists.
+// With warm re-hosting, a session hosted by this player is not destroyed, since the creation can update it in place.
+// When OutFuture is set, it receives a future for the creation's result.
+void UMultiplayerSessionsSubsystem::RequestCreateSession(
+    FNamedSession& Session,
+    int32 NumPublicConnections,
+    const FString& MatchType,
+    TFuture<bool>* OutFuture
+) {
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::RequestCreateSession");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    Metrics.NoteRequested(EMultiplayerSessionOperation::Create);
+    if (!SessionInterface.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("CreateSession: Failed to get SessionInterface"));
+        Metrics.NoteResult(EMultiplayerSessionOperation::Create, false, TEXT("Rejected"));
+        if (OutFuture)
+        {
+            *OutFuture = MakeFulfilledPromise<bool>(false).GetFuture();
+        }
+        return;
+    }
+
+    Session.LastNumPublicConnections = NumPublicConnections;
+    Session.LastMatchType = MatchType;
+    if (OutFuture)
+    {
+        *OutFuture = Session.CreatePromises.Add(false);
+    }
+
+    FSessionOperationQueue& Queue = Session.OperationQueue;
+    if (Queue.IsQueued(EMultiplayerSessionOperation::Create))
+    {
+        MULTIPLAYER_LOG(Verbose, TEXT("CreateSession: Coalesced with queued creation of %s"), *Session.Name.ToString());
+        Queue.NoteCoalesced();
+        return;
+    }
+
+    const bool bSessionExists = SessionInterface->HasSession(Session.Name)
+        || Queue.IsInFlight(EMultiplayerSessionOperation::Create);
+    const bool bCanUpdate = GetDefault<UMultiplayerSessionsSettings>()->bWarmRehost
+        && (Session.bHostingSession || Queue.IsInFlight(EMultiplayerSessionOperation::Create))
+        && !Queue.IsQueuedOrInFlight(EMultiplayerSessionOperation::Join);
+    if (bSessionExists && !bCanUpdate && !Queue.IsQueuedOrInFlight(EMultiplayerSessionOperation::Destroy))
+    {
+        MULTIPLAYER_LOG(Info, TEXT("CreateSession: Destroying existing session %s..."), *Session.Name.ToString());
+        Queue.Enqueue(EMultiplayerSessionOperation::Destroy, [this, &Session]()
+        {
+            Session.RehostDowntimeStartTime = FPlatformTime::Seconds();
+            SendDestroySession(Session);
+        });
+    }
+    Queue.Enqueue(EMultiplayerSessionOperation::Create, [this, &Session]() { SendCreateSession(Session); });
+}
+
+// RequestFindSessions serves cached results when possible, and otherwise queues a search.
+// When OutFuture is set, it receives a future for the completed search.
+void UMultiplayerSessionsSubsystem::RequestFindSessions(
+    int32 MaxSearchResults,
+    const FMultiplayerSessionSearchFilter& Filter,
+    TFuture<FMultiplayerFindSessionsResult>* OutFuture
+) {
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::RequestFindSessions");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    Metrics.NoteRequested(EMultiplayerSessionOperation::Find);
+    if (!SessionInterface.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("FindSessions: Failed to get SessionInterface"));
+        Metrics.NoteResult(EMultiplayerSessionOperation::Find, false, TEXT("Rejected"));
+        if (OutFuture)
+        {
+            *OutFuture = MakeFulfilledPromise<FMultiplayerFindSessionsResult>().GetFuture();
+        }
+        return;
+    }
+
+    const FSessionSearchCacheKey SearchKey = MakeSearchKey(MaxSearchResults, Filter);
+
+    TSharedPtr<FOnlineSessionSearch> CachedSearch;
+    if (LookupCachedSearch(SearchKey, CachedSearch))
+    {
+        Metrics.NoteResult(EMultiplayerSessionOperation::Find, true, TEXT("Cached"));
+        SetLastSessionSearch(CachedSearch.ToSharedRef());
+        MultiplayerOnFindSessionsComplete.Broadcast(CachedSearch->SearchResults, true);
+        if (OutFuture)
+        {
+            *OutFuture = MakeFulfilledPromise<FMultiplayerFindSessionsResult>(FMultiplayerFindSessionsResult{ CachedSearch, true }).GetFuture();
+        }
+        return;
+    }
+
+    StartSessionSearch(SearchKey, false, OutFuture);
+}
+
+// RequestJoinSessions queues a join pipeline over candidates from Search, or replaces the candidates of a queued join.
+// When OutFuture is set, it receives a future for the pipeline's final result.
+void UMultiplayerSessionsSubsystem::RequestJoinSessions(
+    FNamedSession& Session,
+    const TSharedPtr<FOnlineSessionSearch>& Search,
+    const TArray<int32>& Indices,
+    TFuture<EOnJoinSessionCompleteResult::Type>* OutFuture
+) {
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::RequestJoinSessions");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    Metrics.NoteRequested(EMultiplayerSessionOperation::Join);
+    EOnJoinSessionCompleteResult::Type Rejection = EOnJoinSessionCompleteResult::Success;
+    if (!SessionInterface.IsValid())
+    {
+        Rejection = EOnJoinSessionCompleteResult::UnknownError;
+    }
+    else if (!Search.IsValid() || Indices.Num() == 0)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("JoinRankedSessions: No candidate sessions"));
+        Rejection = EOnJoinSessionCompleteResult::SessionDoesNotExist;
+    }
+    if (Rejection != EOnJoinSessionCompleteResult::Success)
+    {
+        Metrics.NoteResult(EMultiplayerSessionOperation::Join, false, TEXT("Rejected"));
+        if (Session.Name == NAME_GameSession)
+        {
+            MultiplayerOnJoinSessionComplete.Broadcast(Rejection);
+        }
+        MultiplayerOnSessionOperationComplete.Broadcast(Session.Name, EMultiplayerSessionOperation::Join, false);
+        if (OutFuture)
+        {
+            *OutFuture = MakeFulfilledPromise<EOnJoinSessionCompleteResult::Type>(Rejection).GetFuture();
+        }
+        return;
+    }
+
+    // Keep the search alive, so the candidates remain valid even if a new search completes.
+    Session.QueuedJoinSearch = Search;
+    Session.QueuedJoinIndices = Indices;
+    if (OutFuture)
+    {
+        *OutFuture = Session.JoinPromises.Add(false);
+    }
+
+    if (Session.OperationQueue.IsQueued(EMultiplayerSessionOperation::Join))
+    {
+        Session.OperationQueue.NoteCoalesced();
+        return;
+    }
+    Session.OperationQueue.Enqueue(EMultiplayerSessionOperation::Join, [this, &Session]() { SendJoinCandidates(Session); });
+}
+
+// RequestDestroySession queues a destroy, unless one is already queued or in flight.
+// When OutFuture is set, it receives a future for the destroy's result.
+void UMultiplayerSessionsSubsystem::RequestDestroySession(FNamedSession& Session, TFuture<bool>* OutFuture)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::RequestDestroySession");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    Metrics.NoteRequested(EMultiplayerSessionOperation::Destroy);
+    if (!SessionInterface.IsValid())
+    {
+        Metrics.NoteResult(EMultiplayerSessionOperation::Destroy, false, TEXT("Rejected"));
+        BroadcastSessionResult(Session, EMultiplayerSessionOperation::Destroy, false);
+        if (OutFuture)
+        {
+            *OutFuture = MakeFulfilledPromise<bool>(false).GetFuture();
+        }
+        return;
+    }
+
+    const bool bIsInFlight = Session.OperationQueue.IsInFlight(EMultiplayerSessionOperation::Destroy);
+    if (OutFuture)
+    {
+        *OutFuture = Session.DestroyPromises.Add(bIsInFlight);
+    }
+    if (Session.OperationQueue.IsQueuedOrInFlight(EMultiplayerSessionOperation::Destroy))
+    {
+        Session.OperationQueue.NoteCoalesced();
+        return;
+    }
+    Session.OperationQueue.Enqueue(EMultiplayerSessionOperation::Destroy, [this, &Session]() { SendDestroySession(Session); });
+}
+
+// RequestStartSession queues a start, unless one is already queued or in flight.
+// When OutFuture is set, it receives a future for the start's result.
+void UMultiplayerSessionsSubsystem::RequestStartSession(FNamedSession& Session, TFuture<bool>* OutFuture)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::RequestStartSession");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    Metrics.NoteRequested(EMultiplayerSessionOperation::Start);
+    if (!SessionInterface.IsValid())
+    {
+        Metrics.NoteResult(EMultiplayerSessionOperation::Start, false, TEXT("Rejected"));
+        BroadcastSessionResult(Session, EMultiplayerSessionOperation::Start, false);
+        if (OutFuture)
+        {
+            *OutFuture = MakeFulfilledPromise<bool>(false).GetFuture();
+        }
+        return;
+    }
+
+    const bool bIsInFlight = Session.OperationQueue.IsInFlight(EMultiplayerSessionOperation::Start);
+    if (OutFuture)
+    {
+        *OutFuture = Session.StartPromises.Add(bIsInFlight);
+    }
+    if (Session.OperationQueue.IsQueuedOrInFlight(EMultiplayerSessionOperation::Start))
+    {
+        Session.OperationQueue.NoteCoalesced();
+        return;
+    }
+    Session.OperationQueue.Enqueue(EMultiplayerSessionOperation::Start, [this, &Session]() { SendStartSession(Session); });
+}
+
+// RequestQuickPlay joins from the warm pool when it has candidates. Otherwise the next refresh is made due now, and the join waits for it.
+// When OutFuture is set, it receives a future for the join's final result.
+void UMultiplayerSessionsSubsystem::RequestQuickPlay(FName SessionName, TFuture<EOnJoinSessionCompleteResult::Type>* OutFuture)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::RequestQuickPlay");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    if (OutFuture)
+    {
+        *OutFuture = QuickPlayPromises.Emplace_GetRef().GetFuture();
+    }
+    if (QuickPlayRequestTime >= 0.0)
+    {
+        MULTIPLAYER_LOG(Verbose, TEXT("QuickPlay: Coalesced with the pending quick play"));
+        return;
+    }
+    if (!QuickPlayPool.IsActive())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("QuickPlay: StartQuickPlay has not been called"));
+    }
+
+    QuickPlaySessionName = SessionName;
+    QuickPlayRequestTime = FPlatformTime::Seconds();
+    if (QuickPlayPool.NumCandidates() > 0 || !QuickPlayPool.IsActive())
+    {
+        StartQuickPlayJoin(true);
+        return;
+    }
+    MULTIPLAYER_LOG(Info, TEXT("QuickPlay: No warm candidates, waiting for a refresh"));
+    QuickPlayPool.RefreshNow(QuickPlayRequestTime);
+}
+
+// FailAllPromises fulfills every outstanding promise with a failure, since the operations will never complete.
+void UMultiplayerSessionsSubsystem::FailAllPromises()
+{
+    FindPromises.FulfillQueued(FMultiplayerFindSessionsResult());
+    FindPromises.FulfillInFlight(FMultiplayerFindSessionsResult());
+
+    // Move the page requests out first, since continuations may request more pages.
+    TArray<FSearchPageRequest> PageRequests = MoveTemp(QueuedSearchPages);
+    QueuedSearchPages.Reset();
+    if (InFlightSearchPage.IsSet())
+    {
+        PageRequests.Insert(MoveTemp(InFlightSearchPage.GetValue()), 0);
+        InFlightSearchPage.Reset();
+    }
+    for (FSearchPageRequest& Request : PageRequests)
+    {
+        Request.Promise.SetValue(FMultiplayerSessionsPage());
+    }
+    for (const TPair<FName, TUniquePtr<FNamedSession>>& Pair : NamedSessions)
+    {
+        FNamedSession& Session = *Pair.Value;
+        Session.CreatePromises.FulfillQueued(false);
+        Session.CreatePromises.FulfillInFlight(false);
+        Session.JoinPromises.FulfillQueued(EOnJoinSessionCompleteResult::UnknownError);
+        Session.JoinPromises.FulfillInFlight(EOnJoinSessionCompleteResult::UnknownError);
+        Session.DestroyPromises.FulfillQueued(false);
+        Session.DestroyPromises.FulfillInFlight(false);
+        Session.StartPromises.FulfillQueued(false);
+        Session.StartPromises.FulfillInFlight(false);
+    }
+
+    // A quick play join was completed by its join promise above. One still waiting for candidates is failed here.
+    TArray<TPromise<EOnJoinSessionCompleteResult::Type>> QuickPlayFailed = MoveTemp(QuickPlayPromises);
+    QuickPlayPromises.Reset();
+    QuickPlayRequestTime = -1.0;
+    bQuickPlayJoining = false;
+    for (TPromise<EOnJoinSessionCompleteResult::Type>& Promise : QuickPlayFailed)
+    {
+        Promise.SetValue(EOnJoinSessionCompleteResult::UnknownError);
+    }
+}
+
+// SendCreateSession brings the session to the most recently requested parameters.
+// A session hosted by this player is updated in place when warm re-hosting is enabled and the provider allows it,
+// so it stays visible to searches. Otherwise an existing session is destroyed first, and a new session is created.
+void UMultiplayerSessionsSubsystem::SendCreateSession(FNamedSession& Session)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendCreateSession");
+
+    Session.CreatePromises.Start();
+    Session.CreateStartTime = FPlatformTime::Seconds();
+    Session.CreateMode = Session.RehostDowntimeStartTime >= 0.0 ? ECreateMode::Recreate : ECreateMode::Create;
+
+    const TSharedPtr<FOnlineSessionSettings> CurrentSettings = Session.LastSessionSettings;
+    Session.LastSessionSettings = MakeSessionSettings(Session);
+
+    // The new settings include every custom setting, so earlier changes no longer need an update.
+    Session.DirtySettings.Reset();
+    Session.FirstDirtyTime = -1.0;
+
+    if (!SessionInterface->HasSession(Session.Name))
+    {
+        SendCreateNewSession(Session);
+        return;
+    }
+
+    const bool bCanUpdate = Session.bHostingSession
+        && GetDefault<UMultiplayerSessionsSettings>()->bWarmRehost
+        && CurrentSettings.IsValid()
+        && !RequiresRecreate(*CurrentSettings, *Session.LastSessionSettings);
+    if (bCanUpdate)
+    {
+        SendUpdateSession(Session);
+        return;
+    }
+    SendRehostDestroy(Session);
+}
+
+// SendCreateNewSession asks the SessionInterface to create a session with the most recently requested parameters.
+void UMultiplayerSessionsSubsystem::SendCreateNewSession(FNamedSession& Session)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendCreateNewSession");
+
+    const FUniqueNetIdPtr LocalPlayerId = GetLocalPlayerId();
+    if (!LocalPlayerId.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("CreateSession: Failed to get player's unique net ID"));
+        OnCreateSessionComplete(Session.Name, false);
+        return;
+    }
+    SessionInterface->CreateSession(*LocalPlayerId, Session.Name, *Session.LastSessionSettings);
+}
+
+// SendUpdateSession asks the SessionInterface to apply the most recently requested parameters to the live session.
+void UMultiplayerSessionsSubsystem::SendUpdateSession(FNamedSession& Session)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendUpdateSession");
+
+    MULTIPLAYER_LOG(Info, TEXT("CreateSession: Updating existing session %s..."), *Session.Name.ToString());
+    Session.CreateMode = ECreateMode::Update;
+    SessionInterface->UpdateSession(Session.Name, *Session.LastSessionSettings);
+}
+
+// SendRehostDestroy asks the SessionInterface to destroy the existing session, so it can be recreated.
+// The session is not advertised from now until the new session has been created.
+void UMultiplayerSessionsSubsystem::SendRehostDestroy(FNamedSession& Session)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendRehostDestroy");
+
+    MULTIPLAYER_LOG(Info, TEXT("CreateSession: Destroying existing session %s..."), *Session.Name.ToString());
+    Session.CreateMode = ECreateMode::Recreate;
+    Session.RehostDowntimeStartTime = FPlatformTime::Seconds();
+    SessionInterface->DestroySession(Session.Name);
+}
+
+// MakeSessionSettings describes a session with the most recently requested parameters.
+// Only the game session advertises the map, since party and spectator sessions do not travel.
+TSharedRef<FOnlineSessionSettings> UMultiplayerSessionsSubsystem::MakeSessionSettings(const FNamedSession& Session) const
+{
+    TSharedRef<FOnlineSessionSettings> Settings = MakeShared<FOnlineSessionSettings>();
+    Settings->bAllowJoinInProgress = true;
+    Settings->bAllowJoinViaPresence = true;
+    Settings->bIsLANMatch = SessionInterface->IsLANProvider();
+    Settings->bShouldAdvertise = true;
+    Settings->bUseLobbiesIfAvailable = true; // Needed for UE 5.0+.
+    Settings->bUsesPresence = true;
+    Settings->BuildUniqueId = 1; // Share sessions across builds.
+    Settings->NumPublicConnections = Session.LastNumPublicConnections;
+    Settings->Set(FName("MatchType"), Session.LastMatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+
+    // Advertise the host's region so searches can filter on it.
+    const FString& Region = GetDefault<UMultiplayerSessionsSettings>()->Region;
+    if (!Region.IsEmpty())
+    {
+        Settings->Set(FName("Region"), Region, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+    }
+
+    // Advertise the map the host travels to, so joining clients can start loading it before their join completes.
+    if (Session.Name == NAME_GameSession && !AdvertisedMapName.IsEmpty())
+    {
+        Settings->Set(SETTING_MAPNAME, AdvertisedMapName, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+    }
+
+    // Settings from UpdateSessionSetting are applied last, so they can replace the settings above.
+    for (const TPair<FName, FOnlineSessionSetting>& Pair : Session.CustomSettings)
+    {
+        Settings->Set(Pair.Key, Pair.Value);
+    }
+    return Settings;
+}
+
+// SendFindSessions configures a new search for the queued query and sends it to the SessionInterface.
+void UMultiplayerSessionsSubsystem::SendFindSessions()
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendFindSessions");
+
+    FindPromises.Start();
+    const FSessionSearchCacheKey& SearchKey = QueuedSearchKey;
+    PendingSessionSearch = MakeSessionSearch(SearchKey, SearchKey.MaxSearchResults);
+    PendingSearchMatcher = MakeUnique<FSessionSearchFilterMatcher>(SearchKey.Filter);
+    PendingSearchNumFiltered = 0;
+
+    PendingSearchKey = SearchKey;
+    bSearchInProgress = true;
+    bSearchIsBackgroundRefresh = bQueuedSearchIsBackgroundRefresh;
+
+    // Use first local player's unique net ID to find sessions.
+    const FUniqueNetIdPtr LocalPlayerId = GetLocalPlayerId();
+    if (!LocalPlayerId.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("FindSessions: Failed to get player's unique net ID"));
+        OnFindSessionsComplete(false);
+        return;
+    }
+    SessionInterface->FindSessions(*LocalPlayerId, PendingSessionSearch.ToSharedRef());
+}
+
+// SendFindSessionsPage sends the oldest page request.
+// Backends without cursors search for every result up to the end of the page, and the earlier results are dropped on completion.
+void UMultiplayerSessionsSubsystem::SendFindSessionsPage()
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendFindSessionsPage");
+
+    InFlightSearchPage = MoveTemp(QueuedSearchPages[0]);
+    QueuedSearchPages.RemoveAt(0);
+    FSearchPageRequest& Request = InFlightSearchPage.GetValue();
+    Request.bUsesCursor = SessionInterface->SupportsSearchPages();
+
+    const int32 PageSize = Request.SearchKey.MaxSearchResults;
+    const int32 MaxSearchResults = Request.bUsesCursor
+        ? PageSize
+        : static_cast<int32>(FMath::Min<uint64>(Request.Cursor + PageSize, MAX_int32));
+    PendingPageSearch = MakeSessionSearch(Request.SearchKey, MaxSearchResults);
+
+    const FUniqueNetIdPtr LocalPlayerId = GetLocalPlayerId();
+    if (!LocalPlayerId.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("FindSessionsPage: Failed to get player's unique net ID"));
+        OnFindSessionsPageComplete(false, 0);
+        return;
+    }
+    if (Request.bUsesCursor)
+    {
+        SessionInterface->FindSessionsPage(*LocalPlayerId, PendingPageSearch.ToSharedRef(), Request.Cursor);
+    }
+    else
+    {
+        SessionInterface->FindSessions(*LocalPlayerId, PendingPageSearch.ToSharedRef());
+    }
+}
+
+// MakeSessionSearch configures a search for the query, and pushes its filter to the provider where supported.
+// Results are always checked locally as well.
+TSharedRef<FOnlineSessionSearch> UMultiplayerSessionsSubsystem::MakeSessionSearch(const FSessionSearchCacheKey& SearchKey, int32 MaxSearchResults)
+{
+    TSharedRef<FOnlineSessionSearch> Search = MakeShareable(new FOnlineSessionSearch());
+    Search->MaxSearchResults = MaxSearchResults;
+    Search->bIsLanQuery = SearchKey.bIsLanQuery;
+    Search->QuerySettings.Set(SEARCH_PRESENCE, SearchKey.bUsePresence, EOnlineComparisonOp::Equals);
+
+    if (FMultiplayerSessionSearchFilter::SupportsQueryFilters(SessionInterface->GetSubsystemName()))
+    {
+        SearchKey.Filter.ApplyToQuerySettings(Search->QuerySettings);
+        SearchFilterStats.SearchesFilteredServerSide++;
+    }
+    else
+    {
+        SearchFilterStats.SearchesFilteredLocally++;
+    }
+    return Search;
+}
+
+// SendJoinCandidates starts a join pipeline over the queued candidates.
+void UMultiplayerSessionsSubsystem::SendJoinCandidates(FNamedSession& Session)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendJoinCandidates");
+
+    Session.JoinPromises.Start();
+    Session.JoinCandidatesSearch = MoveTemp(Session.QueuedJoinSearch);
+    Session.JoinCandidateIndices = MoveTemp(Session.QueuedJoinIndices);
+    Session.JoinCandidatePosition = 0;
+
+    Session.LastJoinPipelineStats = FMultiplayerJoinPipelineStats();
+    Session.JoinPipelineStartTime = FPlatformTime::Seconds();
+    SendNextJoinCandidate(Session);
+}
+
+// SendDestroySession asks the SessionInterface to destroy the named session.
+// There may be nothing to destroy when the creation it was queued behind failed, in which case the operation completes immediately.
+void UMultiplayerSessionsSubsystem::SendDestroySession(FNamedSession& Session)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendDestroySession");
+
+    Session.DestroyPromises.Start();
+    if (!SessionInterface->HasSession(Session.Name))
+    {
+        MULTIPLAYER_LOG(Verbose, TEXT("DestroySession: No session %s to destroy"), *Session.Name.ToString());
+        RecordOperationResult(Session.OperationQueue, EMultiplayerSessionOperation::Destroy, false, TEXT("NoSession"));
+        Session.DestroyPromises.FulfillInFlight(false);
+        Session.OperationQueue.Complete(EMultiplayerSessionOperation::Destroy);
+        return;
+    }
+    SessionInterface->DestroySession(Session.Name);
+}
+
+// SendStartSession asks the SessionInterface to start the named session.
+void UMultiplayerSessionsSubsystem::SendStartSession(FNamedSession& Session)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendStartSession");
+
+    Session.StartPromises.Start();
+    SessionInterface->StartSession(Session.Name);
+}
+
+// MarkSettingChanged adds a setting to the session's next update, and starts the ticker which sends it.
+void UMultiplayerSessionsSubsystem::MarkSettingChanged(FNamedSession& Session, FName Key, double Now)
+{
+    Session.DirtySettings.Add(Key);
+    if (Session.FirstDirtyTime < 0.0)
+    {
+        Session.FirstDirtyTime = Now;
+    }
+    if (!SettingsUpdateTickerHandle.IsValid())
+    {
+        SettingsUpdateTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+            FTickerDelegate::CreateUObject(this, &ThisClass::TickSettingsUpdates), 0.1f);
+    }
+}
+
+// QueueSettingsUpdate queues an update of the session's settings. The update reads the changed settings when it starts,
+// so changes made while it is queued are sent with it.
+void UMultiplayerSessionsSubsystem::QueueSettingsUpdate(FNamedSession& Session)
+{
+    Metrics.NoteRequested(EMultiplayerSessionOperation::Update);
+    Session.OperationQueue.Enqueue(EMultiplayerSessionOperation::Update, [this, &Session]() { SendSettingsUpdate(Session); });
+}
+
+// SendSettingsUpdate compares the changed settings to the advertised settings, and asks the SessionInterface to apply those which differ.
+// The rest of the advertised settings are sent as they are. When nothing differs, the update completes without contacting the backend.
+void UMultiplayerSessionsSubsystem::SendSettingsUpdate(FNamedSession& Session)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendSettingsUpdate");
+
+    const TSharedPtr<FOnlineSessionSettings> Advertised = Session.LastSessionSettings;
+    if (!Session.bHostingSession || !Advertised.IsValid())
+    {
+        RecordOperationResult(Session.OperationQueue, EMultiplayerSessionOperation::Update, false, TEXT("NoSession"));
+        Session.OperationQueue.Complete(EMultiplayerSessionOperation::Update);
+        return;
+    }
+
+    Session.PendingSettingsKeys.Reset();
+    for (const FName& Key : Session.DirtySettings)
+    {
+        const FOnlineSessionSetting* Requested = Session.CustomSettings.Find(Key);
+        const FOnlineSessionSetting* Current = Advertised->Settings.Find(Key);
+        if (!Requested || (Current && Current->Data == Requested->Data && Current->AdvertisementType == Requested->AdvertisementType))
+        {
+            SettingsUpdateStats.ChangesUnchanged++;
+            continue;
+        }
+        Session.PendingSettingsKeys.Add(Key);
+    }
+    Session.DirtySettings.Reset();
+    Session.FirstDirtyTime = -1.0;
+
+    if (Session.PendingSettingsKeys.Num() == 0)
+    {
+        MULTIPLAYER_LOG(Verbose, TEXT("UpdateSessionSetting: Settings of %s are unchanged"), *Session.Name.ToString());
+        RecordOperationResult(Session.OperationQueue, EMultiplayerSessionOperation::Update, true, TEXT("Unchanged"));
+        Session.OperationQueue.Complete(EMultiplayerSessionOperation::Update);
+        return;
+    }
+
+    Session.PendingSettings = MakeShared<FOnlineSessionSettings>(*Advertised);
+    for (const FName& Key : Session.PendingSettingsKeys)
+    {
+        Session.PendingSettings->Set(Key, Session.CustomSettings[Key]);
+    }
+    Session.SettingsUpdateStartTime = FPlatformTime::Seconds();
+    Session.LastSettingsUpdateTime = Session.SettingsUpdateStartTime;
+    SettingsUpdateStats.UpdatesSent++;
+    SettingsUpdateStats.SettingsPushed += Session.PendingSettingsKeys.Num();
+
+    MULTIPLAYER_LOG(Verbose, TEXT("UpdateSessionSetting: Sending %d changed settings of %s"),
+        Session.PendingSettingsKeys.Num(), *Session.Name.ToString());
+    SessionInterface->UpdateSession(Session.Name, *Session.PendingSettings);
+}
+
+// TickSettingsUpdates queues an update for each session whose changed settings are due.
+// Changes to a session which is no longer hosted are dropped, since its next creation sends every custom setting.
+// Sessions are gathered first, since an update which completes at once starts the session's next operation.
+// Returns 'false' to remove the ticker once no session has changes waiting.
+bool UMultiplayerSessionsSubsystem::TickSettingsUpdates(float DeltaTime)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::TickSettingsUpdates");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    TArray<FNamedSession*, TInlineAllocator<4>> Sessions;
+    for (const TPair<FName, TUniquePtr<FNamedSession>>& Pair : NamedSessions)
+    {
+        FNamedSession& Session = *Pair.Value;
+        if (Session.DirtySettings.Num() == 0)
+        {
+            continue;
+        }
+        if (!Session.bHostingSession && !Session.OperationQueue.IsQueuedOrInFlight(EMultiplayerSessionOperation::Create))
+        {
+            Session.DirtySettings.Reset();
+            Session.FirstDirtyTime = -1.0;
+            continue;
+        }
+        Sessions.Add(&Session);
+    }
+    if (Sessions.Num() == 0)
+    {
+        SettingsUpdateTickerHandle.Reset();
+        return false;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    for (FNamedSession* Session : Sessions)
+    {
+        if (IsSettingsUpdateDue(*Session, Now))
+        {
+            QueueSettingsUpdate(*Session);
+        }
+    }
+    return true;
+}
+
+// TickQuickPlay applies refreshed candidates, serves a quick play request which was waiting for them,
+// and starts the next background search when it is due and the search queue is idle.
+// Returns 'false' to remove the ticker once quick play has stopped.
+bool UMultiplayerSessionsSubsystem::TickQuickPlay(float DeltaTime)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::TickQuickPlay");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    if (!QuickPlayPool.IsActive())
+    {
+        QuickPlayTickerHandle.Reset();
+        return false;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    if (QuickPlayPool.Tick(Now) && QuickPlayRequestTime >= 0.0 && !bQuickPlayJoining)
+    {
+        StartQuickPlayJoin(false);
+    }
+
+    // Background searches wait for the player's searches, and never replace a queued search's query.
+    const bool bSearchQueueIdle = !SearchQueue.IsQueuedOrInFlight(EMultiplayerSessionOperation::Find)
+        && !SearchQueue.IsQueuedOrInFlight(EMultiplayerSessionOperation::FindPage);
+    if (!QuickPlayPool.IsRefreshDue(Now) || !bSearchQueueIdle || !SessionInterface.IsValid())
+    {
+        return true;
+    }
+
+    const uint32 RefreshId = QuickPlayPool.BeginRefresh();
+    TFuture<FMultiplayerFindSessionsResult> Future;
+    StartSessionSearch(QuickPlaySearchKey, true, &Future);
+    TWeakObjectPtr<ThisClass> WeakThis(this);
+    Future.Next([WeakThis, RefreshId](const FMultiplayerFindSessionsResult& Result)
+    {
+        if (ThisClass* Subsystem = WeakThis.Get())
+        {
+            Subsystem->QuickPlayPool.ProcessResults(RefreshId, Result.Search, Result.bWasSuccessful, FPlatformTime::Seconds());
+        }
+    });
+    return true;
+}
+
+// StartQuickPlayJoin takes the pool's candidates and joins them through the join pipeline.
+// An empty pool is passed on as well, so the join is rejected and reported like any join without candidates.
+// bFromWarmPool is 'true' when the request was served without waiting for a refresh.
+void UMultiplayerSessionsSubsystem::StartQuickPlayJoin(bool bFromWarmPool)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::StartQuickPlayJoin");
+
+    TSharedPtr<FOnlineSessionSearch> Candidates;
+    TArray<int32> Indices;
+    if (QuickPlayPool.TakeCandidates(Candidates, Indices))
+    {
+        const double WaitSeconds = FPlatformTime::Seconds() - QuickPlayRequestTime;
+        QuickPlayPool.NoteJoin(WaitSeconds, bFromWarmPool);
+        MULTIPLAYER_LOG(Info, TEXT("QuickPlay: Joining the best of %d sessions after %.3fs"), Indices.Num(), WaitSeconds);
+    }
+
+    bQuickPlayJoining = true;
+    TFuture<EOnJoinSessionCompleteResult::Type> JoinFuture;
+    RequestJoinSessions(FindOrAddSession(QuickPlaySessionName), Candidates, Indices, &JoinFuture);
+    TWeakObjectPtr<ThisClass> WeakThis(this);
+    JoinFuture.Next([WeakThis](EOnJoinSessionCompleteResult::Type Result)
+    {
+        if (ThisClass* Subsystem = WeakThis.Get())
+        {
+            Subsystem->OnQuickPlayJoinComplete(Result);
+        }
+    });
+}
+
+// OnQuickPlayJoinComplete stops quick play once the player has joined a session.
+// After a failed join the candidates are used up, so the pool is refreshed immediately.
+void UMultiplayerSessionsSubsystem::OnQuickPlayJoinComplete(EOnJoinSessionCompleteResult::Type Result)
+{
+    QuickPlayRequestTime = -1.0;
+    bQuickPlayJoining = false;
+    if (Result == EOnJoinSessionCompleteResult::Success)
+    {
+        QuickPlayPool.Stop();
+    }
+    else
+    {
+        QuickPlayPool.RefreshNow(FPlatformTime::Seconds());
+    }
+
+    // Move the promises out first, since continuations may request another quick play.
+    TArray<TPromise<EOnJoinSessionCompleteResult::Type>> Completed = MoveTemp(QuickPlayPromises);
+    QuickPlayPromises.Reset();
+    for (TPromise<EOnJoinSessionCompleteResult::Type>& Promise : Completed)
+    {
+        Promise.SetValue(Result);
+    }
+}
+
+// IsSettingsUpdateDue returns 'true' when the session's changes have been collected for the window,
+// and the interval since its previous update has passed. Updates wait while a creation is queued or in flight,
+// and are not queued twice, since a queued update reads the changes when it starts.
+bool UMultiplayerSessionsSubsystem::IsSettingsUpdateDue(const FNamedSession& Session, double Now) const
+{
+    const FSessionOperationQueue& Queue = Session.OperationQueue;
+    if (!Session.bHostingSession
+        || Queue.IsQueued(EMultiplayerSessionOperation::Update)
+        || Queue.IsQueuedOrInFlight(EMultiplayerSessionOperation::Create))
+    {
+        return false;
+    }
+
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if (Now - Session.FirstDirtyTime < Settings->SettingsUpdateWindowSeconds)
+    {
+        return false;
+    }
+    return Session.LastSettingsUpdateTime < 0.0 || Now - Session.LastSettingsUpdateTime >= Settings->SettingsUpdateIntervalSeconds;
+}
+
+// TickOperationQueue fails each queue's in-flight operation once it exceeds the configured timeout.
+// Sessions are gathered first, since a timeout may complete an operation which queues work on a new session.
+bool UMultiplayerSessionsSubsystem::TickOperationQueue(float DeltaTime)
+{
+    const double Now = FPlatformTime::Seconds();
+    const float TimeoutSeconds = GetDefault<UMultiplayerSessionsSettings>()->OperationTimeoutSeconds;
+    SearchQueue.Tick(Now, TimeoutSeconds);
+
+    TArray<FNamedSession*, TInlineAllocator<16>> Sessions;
+    for (const TPair<FName, TUniquePtr<FNamedSession>>& Pair : NamedSessions)
+    {
+        Sessions.Add(Pair.Value.Get());
+    }
+    for (FNamedSession* Session : Sessions)
+    {
+        Session->OperationQueue.Tick(Now, TimeoutSeconds);
+    }
+    return true;
+}
+
+// OnOperationTimedOut stops waiting for the backend and completes the operation as a failure.
+// The backend may still respond later, after another operation of the same type has started. Searches and joins
+// are the operations which are retried or queued behind each other, so their late responses are dropped by
+// OnBackendFindSessionsComplete and OnBackendJoinSessionComplete rather than completing the newer operation.
+// A timed out join attempt moves on to the next candidate like any other failed attempt.
+void UMultiplayerSessionsSubsystem::OnOperationTimedOut(EMultiplayerSessionOperation Operation, FName SessionName)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::OnOperationTimedOut");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    MULTIPLAYER_LOG(Warning, TEXT("OnOperationTimedOut: %s operation on %s timed out"), LexToString(Operation), *SessionName.ToString());
+    TGuardValue<bool> TimingOutGuard(bOperationIsTimingOut, true);
+
+    switch (Operation)
+    {
+    case EMultiplayerSessionOperation::Create:
+        OnCreateSessionComplete(SessionName, false);
+        break;
+    case EMultiplayerSessionOperation::Find:
+        SessionInterface->CancelFindSessions();
+        OnFindSessionsComplete(false);
+        break;
+    case EMultiplayerSessionOperation::FindPage:
+        SessionInterface->CancelFindSessions();
+        OnFindSessionsPageComplete(false, 0);
+        break;
+    case EMultiplayerSessionOperation::Join:
+        OnJoinSessionComplete(SessionName, EOnJoinSessionCompleteResult::UnknownError);
+        break;
+    case EMultiplayerSessionOperation::Destroy:
+        OnDestroySessionComplete(SessionName, false);
+        break;
+    case EMultiplayerSessionOperation::Start:
+        OnStartSessionComplete(SessionName, false);
+        break;
+    case EMultiplayerSessionOperation::Update:
+        OnSettingsUpdateComplete(SessionName, false);
+        break;
+    }
+}
+
+// OnOperationCancelled reports a queued operation which will never start as a failure.
+// Session is the session the operation was queued on, or nullptr for searches.
+void UMultiplayerSessionsSubsystem::OnOperationCancelled(EMultiplayerSessionOperation Operation, FNamedSession* Session)
+{
+    Metrics.NoteResult(Operation, false, TEXT("Cancelled"));
+    if (Operation == EMultiplayerSessionOperation::FindPage)
+    {
+        // Page requests are cancelled in queue order, so this is the oldest one.
+        FSearchPageRequest Request = MoveTemp(QueuedSearchPages[0]);
+        QueuedSearchPages.RemoveAt(0);
+        FMultiplayerSessionsPage Page;
+        Page.Cursor = Request.Cursor;
+        Request.Promise.SetValue(MoveTemp(Page));
+        return;
+    }
+    if (Operation == EMultiplayerSessionOperation::Find)
+    {
+        FindPromises.FulfillQueued(FMultiplayerFindSessionsResult());
+        if (bQueuedSearchIsBackgroundRefresh)
+        {
+            return;
+        }
+        if (bSearchIsStreaming && QueuedSearchKey == SearchStreamKey)
+        {
+            EmitSearchStreamBatches(TArray<FOnlineSessionSearchResult>(), true);
+            FinishSearchStream(false);
+            return;
+        }
+        MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+        return;
+    }
+    if (!Session)
+    {
+        return;
+    }
+
+    switch (Operation)
+    {
+    case EMultiplayerSessionOperation::Create:
+        Session->RehostDowntimeStartTime = -1.0;
+        if (Session->Name == NAME_GameSession)
+        {
+            MapPreloader.Release();
+        }
+        BroadcastSessionResult(*Session, Operation, false);
+        Session->CreatePromises.FulfillQueued(false);
+        break;
+    case EMultiplayerSessionOperation::Join:
+        Session->QueuedJoinSearch.Reset();
+        Session->QueuedJoinIndices.Reset();
+        if (Session->Name == NAME_GameSession)
+        {
+            MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
+        }
+        MultiplayerOnSessionOperationComplete.Broadcast(Session->Name, Operation, false);
+        Session->JoinPromises.FulfillQueued(EOnJoinSessionCompleteResult::UnknownError);
+        break;
+    case EMultiplayerSessionOperation::Destroy:
+        BroadcastSessionResult(*Session, Operation, false);
+        Session->DestroyPromises.FulfillQueued(false);
+        break;
+    case EMultiplayerSessionOperation::Start:
+        BroadcastSessionResult(*Session, Operation, false);
+        Session->StartPromises.FulfillQueued(false);
+        break;
+    default:
+        break;
+    }
+}
+
+// RecordOperationResult records the latency of the queue's in-flight operation, from the call which queued it, and its result.
+void UMultiplayerSessionsSubsystem::RecordOperationResult(
+    const FSessionOperationQueue& Queue,
+    EMultiplayerSessionOperation Operation,
+    bool bSucceeded,
+    const TCHAR* Result
+) {
+    if (!Queue.IsInFlight(Operation))
+    {
+        return;
+    }
+    Metrics.NoteCompleted(
+        Operation,
+        FPlatformTime::Seconds() - Queue.GetInFlightRequestTime(),
+        bSucceeded,
+        bOperationIsTimingOut ? TEXT("TimedOut") : Result
+    );
+}
+
+// StartSessionSearch queues a search for the given query, unless an existing search can answer it.
+// An identical in-flight search is reused. A queued search has not started yet, so it is updated to the newest query.
+// Background refreshes never replace a queued foreground search.
+void UMultiplayerSessionsSubsystem::StartSessionSearch(
+    const FSessionSearchCacheKey& SearchKey,
+    bool bIsBackgroundRefresh,
+    TFuture<FMultiplayerFindSessionsResult>* OutFuture
+) {
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::StartSessionSearch");
+
+    if (bSearchInProgress && PendingSearchKey == SearchKey)
+    {
+        // Deliver the in-flight search's results when it completes, even if it started as a background refresh.
+        if (!bIsBackgroundRefresh)
+        {
+            bSearchIsBackgroundRefresh = false;
+        }
+        if (OutFuture)
+        {
+            *OutFuture = FindPromises.Add(true);
+        }
+        SearchQueue.NoteCoalesced();
+        return;
+    }
+
+    // A streaming search which is still waiting for its query to start is superseded by a newer query.
+    if (bSearchIsStreaming && !bIsBackgroundRefresh && !(SearchKey == SearchStreamKey))
+    {
+        EmitSearchStreamBatches(TArray<FOnlineSessionSearchResult>(), true);
+        FinishSearchStream(false);
+    }
+
+    const bool bIsQueued = SearchQueue.IsQueued(EMultiplayerSessionOperation::Find);
+    if (!bIsQueued || !bIsBackgroundRefresh)
+    {
+        // Callers waiting on a different queued query would otherwise receive results they did not ask for.
+        if (bIsQueued && !(QueuedSearchKey == SearchKey))
+        {
+            FindPromises.FulfillQueued(FMultiplayerFindSessionsResult());
+        }
+        QueuedSearchKey = SearchKey;
+        bQueuedSearchIsBackgroundRefresh = bIsBackgroundRefresh;
+    }
+    if (OutFuture)
+    {
+        *OutFuture = FindPromises.Add(false);
+    }
+    if (bIsQueued)
+    {
+        SearchQueue.NoteCoalesced();
+        return;
+    }
+    SearchQueue.Enqueue(EMultiplayerSessionOperation::Find, [this]() { SendFindSessions(); });
+}
+
+// SetLastSessionSearch saves the search whose results were most recently delivered, and indexes its results.
+void UMultiplayerSessionsSubsystem::SetLastSessionSearch(const TSharedRef<FOnlineSessionSearch>& Search)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SetLastSessionSearch");
+
+    LastSessionSearch = Search;
+    if (!SearchIndex.IsBuiltFrom(LastSessionSearch))
+    {
+        SearchIndex.Build(Search);
+    }
+}
+
+// TickSearchStream polls the in-flight search for new results while streaming.
+// While the stream's search is still queued behind other operations, there is nothing to poll yet.
+// Returns 'false' to remove the ticker once streaming has finished.
+bool UMultiplayerSessionsSubsystem::TickSearchStream(float DeltaTime)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::TickSearchStream");
+    FSessionMetrics::FGameThreadScope GameThreadScope(Metrics);
+
+    if (!bSearchIsStreaming)
+    {
+        SearchStreamTickerHandle.Reset();
+        return false;
+    }
+    if (!bSearchInProgress || !PendingSessionSearch.IsValid() || !(PendingSearchKey == SearchStreamKey))
+    {
+        return true;
+    }
+
+    FilterPendingResults();
+
+    // Hold a reference in case a listener starts a new search during the broadcast.
+    TSharedRef<FOnlineSessionSearch> Search = PendingSessionSearch.ToSharedRef();
+    if (!EmitSearchStreamBatches(Search->SearchResults, false))
+    {
+        return true;
+    }
+
+    // The stop predicate was satisfied, so the rest of the search is no longer needed.
+    SessionInterface->CancelFindSessions();
+    bSearchInProgress = false;
+    PendingSessionSearch.Reset();
+    PendingSearchMatcher.Reset();
+    SetLastSessionSearch(Search);
+
+    FinishSearchStream(true);
+    SearchStreamTickerHandle.Reset();
+    RecordOperationResult(SearchQueue, EMultiplayerSessionOperation::Find, true, TEXT("Success"));
+    FindPromises.FulfillInFlight(FMultiplayerFindSessionsResult{ Search, true });
+    SearchQueue.Complete(EMultiplayerSessionOperation::Find);
+    return false;
+}
+
+// EmitSearchStreamBatches broadcasts results which arrived since the previous batch, in batches of at most SearchStreamBatchSize.
+// A batch ends early at the first result satisfying the stop predicate, and that batch is final.
+// When a match occurs, MultiplayerOnFindSessionsMatch is broadcast before the final batch.
+// When bIsComplete is 'true', the last batch is final even if it is empty.
+// Returns 'true' when the stop predicate was satisfied.
+bool UMultiplayerSessionsSubsystem::EmitSearchStreamBatches(const TArray<FOnlineSessionSearchResult>& Results, bool bIsComplete)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::EmitSearchStreamBatches");
+
+    const double Elapsed = FPlatformTime::Seconds() - SearchStreamStartTime;
+
+    if (bIsComplete && SearchStreamNumEmitted >= Results.Num())
+    {
+        MultiplayerOnFindSessionsBatch.Broadcast(TArrayView<const FOnlineSessionSearchResult>(), true);
+        return false;
+    }
+
+    while (SearchStreamNumEmitted < Results.Num())
+    {
+        const int32 BatchStart = SearchStreamNumEmitted;
+        int32 BatchEnd = FMath::Min(BatchStart + SearchStreamBatchSize, Results.Num());
+
+        bool bMatched = false;
+        if (SearchStreamStopPredicate)
+        {
+            for (int32 Index = BatchStart; Index < BatchEnd; ++Index)
+            {
+                if (SearchStreamStopPredicate(Results[Index]))
+                {
+                    BatchEnd = Index + 1;
+                    bMatched = true;
+                    break;
+                }
+            }
+        }
+
+        if (LastSearchStreamStats.ResultsEmitted == 0)
+        {
+            LastSearchStreamStats.TimeToFirstResult = Elapsed;
+        }
+        LastSearchStreamStats.BatchesEmitted++;
+        LastSearchStreamStats.ResultsEmitted += BatchEnd - BatchStart;
+        SearchStreamNumEmitted = BatchEnd;
+
+        // The match is broadcast before its batch, so listeners know the final batch ended with a match.
+        if (bMatched)
+        {
+            LastSearchStreamStats.TimeToFirstJoinableSession = Elapsed;
+            MultiplayerOnFindSessionsMatch.Broadcast(Results[BatchEnd - 1]);
+        }
+
+        const bool bIsFinalBatch = bMatched || (bIsComplete && BatchEnd == Results.Num());
+        MultiplayerOnFindSessionsBatch.Broadcast(MakeArrayView(Results.GetData() + BatchStart, BatchEnd - BatchStart), bIsFinalBatch);
+
+        if (bMatched)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// FinishSearchStream records the stream's completion time and stops streaming.
+void UMultiplayerSessionsSubsystem::FinishSearchStream(bool bExitedEarly)
+{
+    bSearchIsStreaming = false;
+    SearchStreamStopPredicate = nullptr;
+
+    LastSearchStreamStats.bExitedEarly = bExitedEarly;
+    LastSearchStreamStats.TimeToComplete = FPlatformTime::Seconds() - SearchStreamStartTime;
+
+    MULTIPLAYER_LOG(
+        Info,
+        TEXT("FindSessionsStreaming: %d results in %d batches, first joinable after %.3fs, finished after %.3fs"),
+        LastSearchStreamStats.ResultsEmitted,
+        LastSearchStreamStats.BatchesEmitted,
+        LastSearchStreamStats.TimeToFirstJoinableSession,
+        LastSearchStreamStats.TimeToComplete
+    );
+}
+
+// MakeSearchKey describes a search with the current provider's settings.
+FSessionSearchCacheKey UMultiplayerSessionsSubsystem::MakeSearchKey(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter) const
+{
+    FSessionSearchCacheKey SearchKey;
+    SearchKey.bIsLanQuery = SessionInterface->IsLANProvider();
+    SearchKey.bUsePresence = true;
+    SearchKey.Filter = Filter;
+    SearchKey.MaxSearchResults = MaxSearchResults;
+    return SearchKey;
+}
+
+// LookupCachedSearch returns 'true' and sets OutSearch when cached results can be served for the key.
+// Serving stale results starts a background refresh, unless a search is already queued or in flight.
+bool UMultiplayerSessionsSubsystem::LookupCachedSearch(const FSessionSearchCacheKey& SearchKey, TSharedPtr<FOnlineSessionSearch>& OutSearch)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::LookupCachedSearch");
+
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if (!Settings->bEnableSearchCache)
+    {
+        return false;
+    }
+    SearchCache.SetLifetimes(Settings->SearchCacheTTLSeconds, Settings->SearchCacheMaxStaleSeconds, Settings->bStaleWhileRevalidate);
+
+    const FSessionSearchCache::ELookupResult LookupResult = SearchCache.Lookup(SearchKey, FPlatformTime::Seconds(), OutSearch);
+    if (LookupResult == FSessionSearchCache::ELookupResult::Miss)
+    {
+        return false;
+    }
+
+    const bool bIsStale = LookupResult == FSessionSearchCache::ELookupResult::Stale;
+    MULTIPLAYER_LOG(
+        Verbose,
+        TEXT("LookupCachedSearch: Serving %d %s cached results"),
+        OutSearch->SearchResults.Num(),
+        bIsStale ? TEXT("stale") : TEXT("fresh")
+    );
+
+    if (bIsStale && !SearchQueue.IsQueuedOrInFlight(EMultiplayerSessionOperation::Find))
+    {
+        SearchCache.Stats.Refreshes++;
+        StartSessionSearch(SearchKey, true);
+    }
+    return true;
+}
+
+// FilterPendingResults removes results rejected by the local filter from the in-flight search.
+// Only results which arrived since the previous call are checked, so earlier indices stay stable while streaming.
+void UMultiplayerSessionsSubsystem::FilterPendingResults()
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::FilterPendingResults");
+
+    if (!PendingSessionSearch.IsValid() || !PendingSearchMatcher.IsValid())
+    {
+        return;
+    }
+
+    TArray<FOnlineSessionSearchResult>& Results = PendingSessionSearch->SearchResults;
+    const int32 NumNew = Results.Num() - PendingSearchNumFiltered;
+    if (NumNew <= 0)
+    {
+        return;
+    }
+
+    // Measure rejected results before they are overwritten by compaction.
+    for (int32 Index = PendingSearchNumFiltered; Index < Results.Num(); ++Index)
+    {
+        if (!PendingSearchMatcher->Matches(Results[Index]))
+        {
+            SearchFilterStats.BytesRejectedLocally += FSessionSearchFilterMatcher::EstimateResultBytes(Results[Index]);
+        }
+    }
+
+    SearchFilterStats.ResultsReceived += NumNew;
+    SearchFilterStats.ResultsRejectedLocally += PendingSearchMatcher->RemoveNonMatching(Results, PendingSearchNumFiltered);
+    PendingSearchNumFiltered = Results.Num();
+}
+
+// SendJoinSession asks the SessionInterface to join a session under the session's name.
+// When the game session advertises its map, the map is prefetched while the join is in flight, so client travel finds it in memory.
+void UMultiplayerSessionsSubsystem::SendJoinSession(FNamedSession& Session, const FOnlineSessionSearchResult& SessionResult)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendJoinSession");
+
+    FString MapName;
+    if (Session.Name == NAME_GameSession && SessionResult.Session.SessionSettings.Get(SETTING_MAPNAME, MapName) && !MapName.IsEmpty())
+    {
+        MapPreloader.Begin(MapName, GetDefault<UMultiplayerSessionsSettings>()->bPreloadLobbyMap);
+    }
+
+    const FUniqueNetIdPtr LocalPlayerId = GetLocalPlayerId();
+    if (!LocalPlayerId.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("JoinSession: Failed to get player's unique net ID"));
+        Session.JoinCandidatePosition = Session.JoinCandidateIndices.Num();
+        OnJoinSessionComplete(Session.Name, EOnJoinSessionCompleteResult::UnknownError);
+        return;
+    }
+    Session.OutstandingJoinSerials.Add(++Session.JoinCallSerial);
+    SessionInterface->JoinSession(*LocalPlayerId, Session.Name, SessionResult);
+}
+
+// GetLocalPlayerId returns the first local player's unique net ID, or the backend's default ID when there is no local player.
+FUniqueNetIdPtr UMultiplayerSessionsSubsystem::GetLocalPlayerId() const
+{
+    const UWorld* World = GetWorld();
+    const ULocalPlayer* LocalPlayer = World ? World->GetFirstLocalPlayerFromController() : nullptr;
+    if (LocalPlayer && LocalPlayer->GetPreferredUniqueNetId().IsValid())
+    {
+        return LocalPlayer->GetPreferredUniqueNetId().GetUniqueNetId();
+    }
+    return SessionInterface->GetDefaultPlayerId();
+}
+
+// SendNextJoinCandidate starts a join attempt with the next candidate in the session's join pipeline.
+void UMultiplayerSessionsSubsystem::SendNextJoinCandidate(FNamedSession& Session)
+{
+    MULTIPLAYER_TRACE_SCOPE("UMultiplayerSessionsSubsystem::SendNextJoinCandidate");
+
+    const int32 CandidateIndex = Session.JoinCandidateIndices[Session.JoinCandidatePosition++];
+
+    FMultiplayerJoinAttempt& Attempt = Session.LastJoinPipelineStats.Attempts.AddDefaulted_GetRef();
+    Attempt.CandidateIndex = CandidateIndex;
+    Session.JoinAttemptStartTime = FPlatformTime::Seconds();
+    Session.JoinAttemptRegionName = FString::Printf(TEXT("MultiplayerSessions Join Attempt %s #%u"), *Session.Name.ToString(), ++Session.NumJoinAttempts);
+    TRACE_BEGIN_REGION(*Session.JoinAttemptRegionName);
+
+    SendJoinSession(Session, Session.JoinCandidatesSearch->SearchResults[CandidateIndex]);
+}
+
+/***************
+Console Commands
+***************/
+
+// DumpSessionMetrics prints, exports or resets the metrics of each game instance's subsystem.
+static void DumpSessionMetrics(const TArray<FString>& Args, UWorld* World)
+{
+    const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if (!Subsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Metrics: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    const FString Mode = Args.Num() > 0 ? Args[0] : TEXT("print");
+    if (Mode == TEXT("reset"))
+    {
+        Subsystem->ResetMetrics();
+        MULTIPLAYER_LOG(Info, TEXT("Metrics: Reset"));
+        return;
+    }
+    if (Mode == TEXT("csv") || Mode == TEXT("json"))
+    {
+        const FString Path = Subsystem->ExportMetrics(Mode == TEXT("json"));
+        if (!Path.IsEmpty())
+        {
+            MULTIPLAYER_LOG(Info, TEXT("Metrics: Wrote %s"), *Path);
+        }
+        return;
+    }
+    Subsystem->LogMetrics();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SessionMetricsCommand(
+    TEXT("MultiplayerSessions.Metrics"),
+    TEXT("Prints or exports session operation latencies and result counts. Usage: MultiplayerSessions.Metrics [print|csv|json|reset]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&DumpSessionMetrics)
+);
+
+// DumpSettingsUpdateStats prints how many settings changes were requested and sent, and the backend update rate that coalescing saved.
+static void DumpSettingsUpdateStats(const TArray<FString>& Args, UWorld* World)
+{
+    const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    const UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if (!Subsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("SettingsUpdateStats: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    const FMultiplayerSettingsUpdateStats& Stats = Subsystem->GetSettingsUpdateStats();
+    const double Elapsed = Stats.FirstChangeTime >= 0.0 ? FPlatformTime::Seconds() - Stats.FirstChangeTime : 0.0;
+    const double RequestedRate = Elapsed > 0.0 ? Stats.ChangesRequested / Elapsed : 0.0;
+    const double SentRate = Elapsed > 0.0 ? Stats.UpdatesSent / Elapsed : 0.0;
+    MULTIPLAYER_LOG(Info, TEXT("SettingsUpdateStats: Changes=%lld Coalesced=%lld Unchanged=%lld Updates=%lld SettingsPushed=%lld Failed=%lld Saved=%lld"),
+        Stats.ChangesRequested, Stats.ChangesCoalesced, Stats.ChangesUnchanged, Stats.UpdatesSent, Stats.SettingsPushed, Stats.UpdatesFailed,
+        Stats.GetUpdatesSaved());
+    MULTIPLAYER_LOG(Info, TEXT("SettingsUpdateStats: %.2f changes/s sent as %.2f updates/s over %.1fs, update p50=%.3fs p99=%.3fs"),
+        RequestedRate, SentRate, Elapsed, Stats.UpdateLatency.GetPercentile(50.0), Stats.UpdateLatency.GetPercentile(99.0));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SettingsUpdateStatsCommand(
+    TEXT("MultiplayerSessions.SettingsUpdateStats"),
+    TEXT("Prints the session settings changes requested, the updates sent for them, and the update rate saved by coalescing."),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&DumpSettingsUpdateStats)
+);
+
+// DumpQuickPlayStats prints the quick play pool's refreshes, worker time, and how quickly quick play joins started.
+static void DumpQuickPlayStats(const TArray<FString>& Args, UWorld* World)
+{
+    const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    const UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if (!Subsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("QuickPlayStats: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    const FQuickPlayStats& Stats = Subsystem->GetQuickPlayStats();
+    MULTIPLAYER_LOG(Info, TEXT("QuickPlayStats: Active=%d Candidates=%d Refreshes=%d Empty=%d Results=%lld Duplicates=%lld"),
+        Subsystem->IsQuickPlayActive() ? 1 : 0, Subsystem->GetNumQuickPlayCandidates(), Stats.Refreshes, Stats.EmptyRefreshes,
+        Stats.ResultsProcessed, Stats.DuplicatesDropped);
+    MULTIPLAYER_LOG(Info, TEXT("QuickPlayStats: Process p50=%.3fms p99=%.3fms (worker), apply p99=%.3fms (game thread)"),
+        Stats.ProcessTime.GetPercentile(50.0) * 1000.0, Stats.ProcessTime.GetPercentile(99.0) * 1000.0, Stats.ApplyTime.GetPercentile(99.0) * 1000.0);
+    MULTIPLAYER_LOG(Info, TEXT("QuickPlayStats: Joins=%d FromWarmPool=%d TimeToJoin p50=%.3fs p99=%.3fs"),
+        Stats.Joins, Stats.JoinsFromWarmPool, Stats.TimeToJoin.GetPercentile(50.0), Stats.TimeToJoin.GetPercentile(99.0));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs QuickPlayStatsCommand(
+    TEXT("MultiplayerSessions.QuickPlayStats"),
+    TEXT("Prints the quick play pool's refreshes and worker time, and how many quick play joins started from the warm pool."),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&DumpQuickPlayStats)
+);
\ No newline at end of file
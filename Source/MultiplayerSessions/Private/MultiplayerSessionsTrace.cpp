@@ -0,0 +1,59 @@
+// (c) 2023 Will Roberts
+
+#include "MultiplayerSessionsTrace.h"
+
+#include "UObject/UObjectGlobals.h"
+
+UE_TRACE_CHANNEL_DEFINE(MultiplayerSessionsChannel);
+
+namespace
+{
+    const TCHAR* TravelRegionName = TEXT("MultiplayerSessions Travel");
+}
+
+bool FMultiplayerSessionsTrace::bIsTraveling = false;
+FDelegateHandle FMultiplayerSessionsTrace::PostLoadMapHandle;
+
+/*************
+Public Methods
+*************/
+
+// BeginTravel opens the travel region, unless an earlier travel is still loading.
+void FMultiplayerSessionsTrace::BeginTravel()
+{
+    if (bIsTraveling)
+    {
+        return;
+    }
+    bIsTraveling = true;
+    TRACE_BEGIN_REGION(TravelRegionName);
+}
+
+// Startup hooks the end of map loads.
+void FMultiplayerSessionsTrace::Startup()
+{
+    PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddStatic(&FMultiplayerSessionsTrace::EndTravel);
+}
+
+// Shutdown removes the map load hook, and closes a travel region which never finished.
+void FMultiplayerSessionsTrace::Shutdown()
+{
+    FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+    PostLoadMapHandle.Reset();
+    EndTravel(nullptr);
+}
+
+/**************
+Private Methods
+**************/
+
+// EndTravel closes the travel region after the destination map has loaded.
+void FMultiplayerSessionsTrace::EndTravel(UWorld* LoadedWorld)
+{
+    if (!bIsTraveling)
+    {
+        return;
+    }
+    bIsTraveling = false;
+    TRACE_END_REGION(TravelRegionName);
+}
\ No newline at end of file
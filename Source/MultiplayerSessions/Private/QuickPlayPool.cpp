@@ -0,0 +1,218 @@
+// (c) 2023 Will Roberts
+
+#include "QuickPlayPool.h"
+#include "Async/Async.h"
+#include "OnlineSessionSettings.h"
+
+#include "MultiplayerSessionsTrace.h"
+#include "SessionSearchIndex.h"
+
+/*************
+Public Methods
+*************/
+
+// Start keeps the stats, so they cover every start.
+void FQuickPlayPool::Start(const FMultiplayerQuickPlaySettings& InSettings, const FMultiplayerSessionScoringWeights& InWeights, double Now)
+{
+    Stop();
+    Settings = InSettings;
+    Weights = InWeights;
+    bActive = true;
+    RefreshInterval = Settings.MinRefreshIntervalSeconds;
+    NextRefreshTime = Now;
+}
+
+// Stop drops the in-flight refresh by changing the refresh ID, and releases the future of any processing still running.
+void FQuickPlayPool::Stop()
+{
+    bActive = false;
+    bRefreshing = false;
+    bRefreshFinished = false;
+    RefreshId++;
+    Candidates.Reset();
+    Processing = TFuture<FProcessedResults>();
+}
+
+// IsRefreshDue waits for the in-flight refresh, so a slow search is never repeated before it completes.
+bool FQuickPlayPool::IsRefreshDue(double Now) const
+{
+    return bActive && !bRefreshing && Now >= NextRefreshTime;
+}
+
+// RefreshNow only moves the next refresh forward. A refresh which is already running is not repeated.
+void FQuickPlayPool::RefreshNow(double Now)
+{
+    if (bActive)
+    {
+        RefreshInterval = Settings.MinRefreshIntervalSeconds;
+        NextRefreshTime = FMath::Min(NextRefreshTime, Now);
+    }
+}
+
+// BeginRefresh counts the refresh and returns a new ID, so results of earlier refreshes are ignored.
+uint32 FQuickPlayPool::BeginRefresh()
+{
+    bRefreshing = true;
+    Stats.Refreshes++;
+    return ++RefreshId;
+}
+
+// ProcessResults copies the settings it needs into the worker task, so the pool may be changed while the task runs.
+void FQuickPlayPool::ProcessResults(uint32 InRefreshId, const TSharedPtr<FOnlineSessionSearch>& Search, bool bWasSuccessful, double Now)
+{
+    MULTIPLAYER_TRACE_SCOPE("FQuickPlayPool::ProcessResults");
+
+    if (!bActive || !bRefreshing || InRefreshId != RefreshId)
+    {
+        return;
+    }
+    if (!bWasSuccessful || !Search.IsValid() || Search->SearchResults.Num() == 0)
+    {
+        Stats.EmptyRefreshes++;
+        Candidates.Reset();
+        FinishRefresh(Now);
+        return;
+    }
+
+    Processing = Async(
+        EAsyncExecution::ThreadPool,
+        [Search = Search.ToSharedRef(), Weights = Weights, MaxCandidates = Settings.MaxCandidates, ProcessedRefreshId = RefreshId]()
+        {
+            FProcessedResults Processed = Process(Search, Weights, MaxCandidates);
+            Processed.RefreshId = ProcessedRefreshId;
+            return Processed;
+        });
+}
+
+// Tick reports a finished refresh once, so the owner can serve a quick play request which was waiting for it.
+bool FQuickPlayPool::Tick(double Now)
+{
+    if (Processing.IsValid() && Processing.IsReady())
+    {
+        MULTIPLAYER_TRACE_SCOPE("FQuickPlayPool::Tick");
+
+        const double StartTime = FPlatformTime::Seconds();
+        FProcessedResults Processed = Processing.Consume();
+        if (bActive && Processed.RefreshId == RefreshId)
+        {
+            Candidates = Processed.Candidates;
+            Stats.ResultsProcessed += Processed.NumResults;
+            Stats.DuplicatesDropped += Processed.NumDuplicates;
+            Stats.ProcessTime.Record(Processed.Seconds);
+            if (NumCandidates() == 0)
+            {
+                Stats.EmptyRefreshes++;
+            }
+            FinishRefresh(Now);
+            Stats.ApplyTime.Record(FPlatformTime::Seconds() - StartTime);
+        }
+    }
+
+    const bool bFinished = bRefreshFinished;
+    bRefreshFinished = false;
+    return bFinished;
+}
+
+// TakeCandidates empties the pool, since candidates which fail to join should not be tried again.
+bool FQuickPlayPool::TakeCandidates(TSharedPtr<FOnlineSessionSearch>& OutSearch, TArray<int32>& OutIndices)
+{
+    if (NumCandidates() == 0)
+    {
+        return false;
+    }
+    OutSearch = MoveTemp(Candidates);
+    OutIndices.Reset(OutSearch->SearchResults.Num());
+    for (int32 Index = 0; Index < OutSearch->SearchResults.Num(); ++Index)
+    {
+        OutIndices.Add(Index);
+    }
+    return true;
+}
+
+// NoteJoin counts the join, and records how long the player waited before it started.
+void FQuickPlayPool::NoteJoin(double WaitSeconds, bool bFromWarmPool)
+{
+    Stats.Joins++;
+    if (bFromWarmPool)
+    {
+        Stats.JoinsFromWarmPool++;
+    }
+    Stats.TimeToJoin.Record(WaitSeconds);
+}
+
+// NumCandidates returns the number of ranked sessions in the pool.
+int32 FQuickPlayPool::NumCandidates() const
+{
+    return Candidates.IsValid() ? Candidates->SearchResults.Num() : 0;
+}
+
+/**************
+Private Methods
+**************/
+
+// Process runs on a worker thread. It keeps one copy of each session, ranks the joinable sessions,
+// and copies the best of them into a search of their own, so the pool does not hold the full search.
+FQuickPlayPool::FProcessedResults FQuickPlayPool::Process(
+    const TSharedRef<FOnlineSessionSearch>& Search,
+    const FMultiplayerSessionScoringWeights& Weights,
+    int32 MaxCandidates
+) {
+    MULTIPLAYER_TRACE_SCOPE("FQuickPlayPool::Process");
+
+    const double StartTime = FPlatformTime::Seconds();
+    const TArray<FOnlineSessionSearchResult>& Results = Search->SearchResults;
+    FProcessedResults Processed;
+    Processed.NumResults = Results.Num();
+
+    // Providers can return a session more than once, e.g. when it is found over LAN and online. Keep the copy with the lowest ping.
+    TMap<FString, int32> BestBySessionId;
+    BestBySessionId.Reserve(Results.Num());
+    for (int32 Index = 0; Index < Results.Num(); ++Index)
+    {
+        const FString SessionId = Results[Index].GetSessionIdStr();
+        if (int32* Best = BestBySessionId.Find(SessionId))
+        {
+            Processed.NumDuplicates++;
+            if (Results[Index].PingInMs < Results[*Best].PingInMs)
+            {
+                *Best = Index;
+            }
+            continue;
+        }
+        BestBySessionId.Add(SessionId, Index);
+    }
+
+    // RankBest breaks cost ties by index, so sessions with equal costs keep the order the provider returned them in.
+    TArray<int32> Unique;
+    BestBySessionId.GenerateValueArray(Unique);
+
+    FSessionSearchIndex Index;
+    Index.Build(Search);
+    TArray<int32> Ranked;
+    FSessionScorer::RankBest(Index, Weights, MaxCandidates, Ranked, &Unique);
+
+    Processed.Candidates = MakeShared<FOnlineSessionSearch>();
+    Processed.Candidates->SearchResults.Reserve(Ranked.Num());
+    for (const int32 RankedIndex : Ranked)
+    {
+        Processed.Candidates->SearchResults.Add(Results[RankedIndex]);
+    }
+    Processed.Seconds = FPlatformTime::Seconds() - StartTime;
+    return Processed;
+}
+
+// FinishRefresh schedules the next refresh. Healthy pools back off exponentially, and other pools are refreshed at the shortest interval.
+void FQuickPlayPool::FinishRefresh(double Now)
+{
+    bRefreshing = false;
+    bRefreshFinished = true;
+    if (NumCandidates() >= Settings.HealthyPoolSize)
+    {
+        RefreshInterval = FMath::Min(RefreshInterval * Settings.BackoffMultiplier, (double)Settings.MaxRefreshIntervalSeconds);
+    }
+    else
+    {
+        RefreshInterval = Settings.MinRefreshIntervalSeconds;
+    }
+    NextRefreshTime = Now + RefreshInterval;
+}
\ No newline at end of file
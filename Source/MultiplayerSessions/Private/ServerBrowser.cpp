@@ -0,0 +1,351 @@
+// (c) 2023 Will Roberts
+
+#include "ServerBrowser.h"
+#include "Logger.h"
+
+#include "Components/Button.h"
+#include "Components/EditableTextBox.h"
+#include "Components/ListView.h"
+#include "Components/TextBlock.h"
+#include "OnlineSessionSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTrace.h"
+#include "SessionSearchIndex.h"
+
+/*************************
+UServerBrowserItem Methods
+*************************/
+
+// GetOwnerName returns the name of the session's host.
+FString UServerBrowserItem::GetOwnerName() const
+{
+    const FServerBrowserRow* Row = GetRow();
+    return Row ? Row->OwnerName : FString();
+}
+
+// GetMapName returns the short name of the session's map, or an empty string when it is not advertised.
+FString UServerBrowserItem::GetMapName() const
+{
+    const FServerBrowserRow* Row = GetRow();
+    return Row ? Row->MapName : FString();
+}
+
+// GetPingMs returns the session's ping in milliseconds.
+int32 UServerBrowserItem::GetPingMs() const
+{
+    const FServerBrowserRow* Row = GetRow();
+    return Row ? Row->PingMs : 0;
+}
+
+// GetNumPlayers returns the number of occupied public connections.
+int32 UServerBrowserItem::GetNumPlayers() const
+{
+    const FServerBrowserRow* Row = GetRow();
+    return Row ? Row->NumPlayers : 0;
+}
+
+// GetMaxPlayers returns the number of public connections.
+int32 UServerBrowserItem::GetMaxPlayers() const
+{
+    const FServerBrowserRow* Row = GetRow();
+    return Row ? Row->MaxPlayers : 0;
+}
+
+// Join asks the browser to join the item's row.
+bool UServerBrowserItem::Join()
+{
+    UServerBrowser* ServerBrowser = Browser.Get();
+    return ServerBrowser && ServerBrowser->JoinRow(RowIndex);
+}
+
+// GetRow reads the item's row from the browser's model.
+const FServerBrowserRow* UServerBrowserItem::GetRow() const
+{
+    const UServerBrowser* ServerBrowser = Browser.Get();
+    if (!ServerBrowser || RowIndex < 0 || RowIndex >= ServerBrowser->GetModel().NumRows())
+    {
+        return nullptr;
+    }
+    return &ServerBrowser->GetModel().GetRow(RowIndex);
+}
+
+/**************************
+UServerBrowserEntry Methods
+**************************/
+
+// Initialize adds a click handler to the Join button, if the entry has one.
+bool UServerBrowserEntry::Initialize()
+{
+    if (!Super::Initialize())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Initialize: Failed to initialize ServerBrowserEntry"));
+        return false;
+    }
+
+    if (JoinButton)
+    {
+        JoinButton->OnClicked.AddDynamic(this, &UServerBrowserEntry::JoinButtonClicked);
+    }
+    return true;
+}
+
+// NativeOnListItemObjectSet fills the entry's text blocks when the list view assigns it a row, including when it is recycled.
+void UServerBrowserEntry::NativeOnListItemObjectSet(UObject* ListItemObject)
+{
+    MULTIPLAYER_TRACE_SCOPE("UServerBrowserEntry::NativeOnListItemObjectSet");
+
+    Item = Cast<UServerBrowserItem>(ListItemObject);
+    const FServerBrowserRow* Row = Item ? Item->GetRow() : nullptr;
+    if (!Row)
+    {
+        return;
+    }
+
+    if (NameText)
+    {
+        NameText->SetText(FText::FromString(Row->OwnerName));
+    }
+    if (MapText)
+    {
+        MapText->SetText(FText::FromString(Row->MapName));
+    }
+    if (PlayersText)
+    {
+        PlayersText->SetText(FText::Format(FText::FromString(TEXT("{0}/{1}")), Row->NumPlayers, Row->MaxPlayers));
+    }
+    if (PingText)
+    {
+        PingText->SetText(FText::AsNumber(Row->PingMs));
+    }
+    if (JoinButton)
+    {
+        JoinButton->SetIsEnabled(Row->NumPlayers < Row->MaxPlayers);
+    }
+}
+
+// JoinButtonClicked joins the entry's session.
+void UServerBrowserEntry::JoinButtonClicked()
+{
+    if (!Item || !Item->Join())
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("JoinButtonClicked: Failed to join session"));
+    }
+}
+
+/*********************
+UServerBrowser Methods
+*********************/
+
+// RefreshSessions streams every session of the menu's match type, including full sessions, which the filter can hide.
+void UServerBrowser::RefreshSessions()
+{
+    MULTIPLAYER_TRACE_SCOPE("UServerBrowser::RefreshSessions");
+
+    if (!MultiplayerSessionsSubsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("RefreshSessions: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    // Entries keep their item while it is listed, so clear the list before the items are reused by the new rows.
+    SessionList->ClearListItems();
+    VisibleItems.Reset();
+    Model.Reset();
+    NumResultsReceived = 0;
+    bSearchComplete = false;
+    JoinButton->SetIsEnabled(false);
+
+    FMultiplayerSessionSearchFilter Filter;
+    Filter.MatchType = MatchType;
+    MultiplayerSessionsSubsystem->FindSessionsStreaming(SessionSearchLimit, Filter, SessionSearchBatchSize);
+}
+
+// SetSort sorts the rows on a worker thread. The list keeps its order until the sort is applied by NativeTick.
+void UServerBrowser::SetSort(EServerBrowserSortKey SortKey, bool bAscending)
+{
+    Model.SetSort(SortKey, bAscending);
+}
+
+// SetFilter filters the rows on a worker thread, like SetSort.
+void UServerBrowser::SetFilter(const FServerBrowserFilter& Filter)
+{
+    Model.SetFilter(Filter);
+}
+
+// JoinRow resolves a row to the subsystem's indexed results, and joins it through JoinRankedSessions.
+// The session ID is compared, since another search may have replaced the results since the browser's search.
+bool UServerBrowser::JoinRow(int32 RowIndex)
+{
+    if (!MultiplayerSessionsSubsystem || RowIndex < 0 || RowIndex >= Model.NumRows())
+    {
+        return false;
+    }
+    if (!bSearchComplete)
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("JoinRow: The search has not finished"));
+        return false;
+    }
+
+    const FServerBrowserRow& Row = Model.GetRow(RowIndex);
+    const FSessionSearchIndex& SearchIndex = MultiplayerSessionsSubsystem->GetSearchIndex();
+    if (Row.ResultIndex >= SearchIndex.Num() || SearchIndex.GetResult(Row.ResultIndex).GetSessionIdStr() != Row.SessionId)
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("JoinRow: Session %s is no longer in the search results"), *Row.SessionId);
+        return false;
+    }
+
+    MULTIPLAYER_LOG(Info, TEXT("JoinRow: Joining %s's session"), *Row.OwnerName);
+    JoinButton->SetIsEnabled(false);
+    MultiplayerSessionsSubsystem->JoinRankedSessions({ Row.ResultIndex });
+    return true;
+}
+
+// Initialize adds handlers to the optional filter and sort widgets.
+bool UServerBrowser::Initialize()
+{
+    if (!Super::Initialize())
+    {
+        return false;
+    }
+
+    if (!SessionList)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Initialize: SessionList not found"));
+        return false;
+    }
+    if (FilterTextBox)
+    {
+        FilterTextBox->OnTextChanged.AddDynamic(this, &UServerBrowser::FilterTextChanged);
+    }
+    if (SortByNameButton)
+    {
+        SortByNameButton->OnClicked.AddDynamic(this, &UServerBrowser::SortByNameClicked);
+    }
+    if (SortByMapButton)
+    {
+        SortByMapButton->OnClicked.AddDynamic(this, &UServerBrowser::SortByMapClicked);
+    }
+    if (SortByPlayersButton)
+    {
+        SortByPlayersButton->OnClicked.AddDynamic(this, &UServerBrowser::SortByPlayersClicked);
+    }
+    if (SortByPingButton)
+    {
+        SortByPingButton->OnClicked.AddDynamic(this, &UServerBrowser::SortByPingClicked);
+    }
+    return true;
+}
+
+// NativeTick applies completed sorts, and updates the list view once for every change made this frame.
+void UServerBrowser::NativeTick(const FGeometry& MyGeometry, float InDeltaTime)
+{
+    Super::NativeTick(MyGeometry, InDeltaTime);
+
+    if (Model.Tick())
+    {
+        RefreshList();
+    }
+}
+
+// JoinButtonClicked lists sessions instead of joining the first match.
+void UServerBrowser::JoinButtonClicked()
+{
+    RefreshSessions();
+}
+
+// OnFindSessions ignores completed searches which were not streamed, e.g. those made by other callers,
+// since the debug menu's handler would join one of them.
+void UServerBrowser::OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful)
+{
+}
+
+// OnFindSessionsBatch adds streamed results to the rows. The list view is updated by the next NativeTick.
+void UServerBrowser::OnFindSessionsBatch(TArrayView<const FOnlineSessionSearchResult> SessionResults, bool bIsFinalBatch)
+{
+    MULTIPLAYER_TRACE_SCOPE("UServerBrowser::OnFindSessionsBatch");
+
+    Model.AddResults(SessionResults, NumResultsReceived);
+    NumResultsReceived += SessionResults.Num();
+
+    if (bIsFinalBatch)
+    {
+        bSearchComplete = true;
+        JoinButton->SetIsEnabled(true);
+        MULTIPLAYER_LOG(Info, TEXT("OnFindSessionsBatch: Found %d sessions"), NumResultsReceived);
+    }
+}
+
+// OnFindSessionsMatch ignores matches, since the browser's searches have no stop predicate.
+void UServerBrowser::OnFindSessionsMatch(const FOnlineSessionSearchResult& SessionResult)
+{
+}
+
+// RefreshList creates items for new rows, and passes the visible rows' items to the list view.
+// The list view only regenerates the entries on screen, so this costs one pointer copy per visible row.
+void UServerBrowser::RefreshList()
+{
+    MULTIPLAYER_TRACE_SCOPE("UServerBrowser::RefreshList");
+
+    for (int32 RowIndex = Items.Num(); RowIndex < Model.NumRows(); ++RowIndex)
+    {
+        UServerBrowserItem* Item = NewObject<UServerBrowserItem>(this);
+        Item->Browser = this;
+        Item->RowIndex = RowIndex;
+        Items.Add(Item);
+    }
+
+    const TConstArrayView<int32> View = Model.GetView();
+    VisibleItems.Reset(View.Num());
+    for (const int32 RowIndex : View)
+    {
+        VisibleItems.Add(Items[RowIndex]);
+    }
+    SessionList->SetListItems(VisibleItems);
+
+    if (StatusText)
+    {
+        StatusText->SetText(FText::Format(
+            FText::FromString(bSearchComplete ? TEXT("{0} of {1} sessions") : TEXT("{0} of {1} sessions, searching...")),
+            View.Num(),
+            Model.NumRows()
+        ));
+    }
+}
+
+// ToggleSort sorts by a column, and reverses the order when it is already sorted by that column.
+void UServerBrowser::ToggleSort(EServerBrowserSortKey SortKey)
+{
+    SetSort(SortKey, Model.GetSortKey() == SortKey ? !Model.IsAscending() : true);
+}
+
+// FilterTextChanged filters the rows by host and map name.
+void UServerBrowser::FilterTextChanged(const FText& Text)
+{
+    FServerBrowserFilter Filter = Model.GetFilter();
+    Filter.Text = Text.ToString();
+    SetFilter(Filter);
+}
+
+// SortByNameClicked sorts the rows by host name.
+void UServerBrowser::SortByNameClicked()
+{
+    ToggleSort(EServerBrowserSortKey::Name);
+}
+
+// SortByMapClicked sorts the rows by map name.
+void UServerBrowser::SortByMapClicked()
+{
+    ToggleSort(EServerBrowserSortKey::Map);
+}
+
+// SortByPlayersClicked sorts the rows by player count.
+void UServerBrowser::SortByPlayersClicked()
+{
+    ToggleSort(EServerBrowserSortKey::Players);
+}
+
+// SortByPingClicked sorts the rows by ping.
+void UServerBrowser::SortByPingClicked()
+{
+    ToggleSort(EServerBrowserSortKey::Ping);
+}
\ No newline at end of file
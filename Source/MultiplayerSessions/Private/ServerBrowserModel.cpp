@@ -0,0 +1,545 @@
+// (c) 2023 Will Roberts
+
+#include "ServerBrowserModel.h"
+#include "Algo/Sort.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "OnlineSessionSettings.h"
+
+#include "Logger.h"
+#include "MultiplayerSessionsTrace.h"
+
+/*************
+Public Methods
+*************/
+
+// Reset keeps the stats, so they cover every search made by the browser.
+void FServerBrowserModel::Reset()
+{
+    Blocks.Reset();
+    Rows.Reset();
+    View.Reset();
+    bSortRequested = false;
+    ResetCount++;
+    bViewChanged = true;
+}
+
+// AddResults sorts the new rows which pass the filter, and merges them into the visible rows in place.
+// The merge uses the applied order, since that is the order of the visible rows while a sort is running.
+void FServerBrowserModel::AddResults(TConstArrayView<FOnlineSessionSearchResult> Results, int32 FirstResultIndex)
+{
+    MULTIPLAYER_TRACE_SCOPE("FServerBrowserModel::AddResults");
+
+    if (Results.Num() == 0)
+    {
+        return;
+    }
+    const double StartTime = FPlatformTime::Seconds();
+
+    TSharedRef<FRowBlock, ESPMode::ThreadSafe> Block = MakeShared<FRowBlock, ESPMode::ThreadSafe>();
+    Block->SetNum(Results.Num());
+    for (int32 Index = 0; Index < Results.Num(); ++Index)
+    {
+        const FOnlineSessionSearchResult& Result = Results[Index];
+        FServerBrowserRow& Row = (*Block)[Index];
+        Row.SessionId = Result.GetSessionIdStr();
+        Row.OwnerName = Result.Session.OwningUserName;
+        Row.ResultIndex = FirstResultIndex + Index;
+        Row.PingMs = Result.PingInMs;
+        Row.MaxPlayers = Result.Session.SessionSettings.NumPublicConnections;
+        Row.NumPlayers = FMath::Max(Row.MaxPlayers - Result.Session.NumOpenPublicConnections, 0);
+
+        FString MapName;
+        if (Result.Session.SessionSettings.Get(SETTING_MAPNAME, MapName))
+        {
+            Row.MapName = FPackageName::GetShortName(MapName);
+        }
+    }
+
+    const int32 FirstRowIndex = Rows.Num();
+    for (const FServerBrowserRow& Row : *Block)
+    {
+        Rows.Add(&Row);
+    }
+    Blocks.Add(MoveTemp(Block));
+
+    MergeRows(FirstRowIndex);
+    Stats.InsertTime.Record(FPlatformTime::Seconds() - StartTime);
+}
+
+// SetSort starts a sort, unless the rows are already in the requested order.
+void FServerBrowserModel::SetSort(EServerBrowserSortKey InSortKey, bool bInAscending)
+{
+    if (RequestedOrder.SortKey == InSortKey && RequestedOrder.bAscending == bInAscending)
+    {
+        return;
+    }
+    RequestedOrder.SortKey = InSortKey;
+    RequestedOrder.bAscending = bInAscending;
+    StartSort();
+}
+
+// SetFilter starts a sort, which also filters the rows. Every change is sorted again, since the text filter can match any row.
+void FServerBrowserModel::SetFilter(const FServerBrowserFilter& InFilter)
+{
+    RequestedOrder.Filter = InFilter;
+    StartSort();
+}
+
+// Tick applies a completed sort, then merges in the rows added while it ran, which the sort did not see.
+// A sort started before a Reset is discarded, since its row indices refer to the previous rows.
+bool FServerBrowserModel::Tick()
+{
+    MULTIPLAYER_TRACE_SCOPE("FServerBrowserModel::Tick");
+
+    if (Sort.IsValid() && Sort.IsReady())
+    {
+        const double StartTime = FPlatformTime::Seconds();
+        FSortResult Result = Sort.Consume();
+        Sort.Reset();
+
+        if (Result.ResetCount != ResetCount)
+        {
+            Stats.SortsDiscarded++;
+        }
+        else
+        {
+            View = MoveTemp(Result.View);
+            AppliedOrder = MoveTemp(Result.Order);
+            MergeRows(Result.NumRows);
+            bViewChanged = true;
+
+            Stats.SortsApplied++;
+            Stats.ApplyTime.Record(FPlatformTime::Seconds() - StartTime);
+            Stats.SortLatency.Record(FPlatformTime::Seconds() - SortRequestTime);
+        }
+
+        if (bSortRequested)
+        {
+            bSortRequested = false;
+            StartSort();
+        }
+    }
+
+    const bool bChanged = bViewChanged;
+    bViewChanged = false;
+    return bChanged;
+}
+
+/**************
+Private Methods
+**************/
+
+// StartSort filters and sorts a snapshot of the blocks on a worker thread. The snapshot only copies block references,
+// so starting a sort costs the game thread almost nothing however many rows there are.
+// When a sort is already running, another one starts after it completes.
+void FServerBrowserModel::StartSort()
+{
+    if (Sort.IsValid())
+    {
+        bSortRequested = true;
+        return;
+    }
+    SortRequestTime = FPlatformTime::Seconds();
+
+    Sort = Async(EAsyncExecution::ThreadPool, [Snapshot = Blocks, Order = RequestedOrder, SnapshotResetCount = ResetCount]()
+    {
+        MULTIPLAYER_TRACE_SCOPE("FServerBrowserModel::Sort");
+
+        TArray<const FServerBrowserRow*> SnapshotRows;
+        for (const TSharedRef<const FRowBlock, ESPMode::ThreadSafe>& Block : Snapshot)
+        {
+            for (const FServerBrowserRow& Row : *Block)
+            {
+                SnapshotRows.Add(&Row);
+            }
+        }
+
+        FSortResult Result;
+        Result.NumRows = SnapshotRows.Num();
+        Result.ResetCount = SnapshotResetCount;
+        Result.View.Reserve(SnapshotRows.Num());
+        for (int32 RowIndex = 0; RowIndex < SnapshotRows.Num(); ++RowIndex)
+        {
+            if (Matches(*SnapshotRows[RowIndex], Order.Filter))
+            {
+                Result.View.Add(RowIndex);
+            }
+        }
+        Algo::Sort(Result.View, [&SnapshotRows, &Order](int32 A, int32 B)
+        {
+            return IsBefore(*SnapshotRows[A], A, *SnapshotRows[B], B, Order);
+        });
+        Result.Order = Order;
+        return Result;
+    });
+}
+
+// MergeRows sorts the rows from FirstRowIndex onwards which pass the applied filter, and merges them into View from the back,
+// so a batch costs one pass over the visible rows, without allocating.
+void FServerBrowserModel::MergeRows(int32 FirstRowIndex)
+{
+    TArray<int32, TInlineAllocator<64>> NewRows;
+    for (int32 RowIndex = FirstRowIndex; RowIndex < Rows.Num(); ++RowIndex)
+    {
+        if (Matches(*Rows[RowIndex], AppliedOrder.Filter))
+        {
+            NewRows.Add(RowIndex);
+        }
+    }
+    if (NewRows.Num() == 0)
+    {
+        return;
+    }
+
+    auto Less = [this](int32 A, int32 B)
+    {
+        return IsBefore(*Rows[A], A, *Rows[B], B, AppliedOrder);
+    };
+    Algo::Sort(NewRows, Less);
+
+    int32 Read = View.Num() - 1;
+    int32 New = NewRows.Num() - 1;
+    View.AddUninitialized(NewRows.Num());
+    for (int32 Write = View.Num() - 1; New >= 0; --Write)
+    {
+        if (Read >= 0 && Less(NewRows[New], View[Read]))
+        {
+            View[Write] = View[Read--];
+        }
+        else
+        {
+            View[Write] = NewRows[New--];
+        }
+    }
+
+    Stats.RowsInserted += NewRows.Num();
+    bViewChanged = true;
+}
+
+// Matches applies a filter to a row.
+bool FServerBrowserModel::Matches(const FServerBrowserRow& Row, const FServerBrowserFilter& Filter)
+{
+    if (Filter.bHideFullSessions && Row.NumPlayers >= Row.MaxPlayers)
+    {
+        return false;
+    }
+    if (Filter.MaxPingMs > 0 && Row.PingMs > Filter.MaxPingMs)
+    {
+        return false;
+    }
+    if (!Filter.Text.IsEmpty() && !Row.OwnerName.Contains(Filter.Text) && !Row.MapName.Contains(Filter.Text))
+    {
+        return false;
+    }
+    return true;
+}
+
+// IsBefore compares names without case, so hosts named "alice" and "Alice" sort together.
+bool FServerBrowserModel::IsBefore(const FServerBrowserRow& A, int32 AIndex, const FServerBrowserRow& B, int32 BIndex, const FOrder& Order)
+{
+    int32 Comparison = 0;
+    switch (Order.SortKey)
+    {
+    case EServerBrowserSortKey::Ping:
+        Comparison = A.PingMs < B.PingMs ? -1 : (A.PingMs > B.PingMs ? 1 : 0);
+        break;
+    case EServerBrowserSortKey::Players:
+        Comparison = A.NumPlayers < B.NumPlayers ? -1 : (A.NumPlayers > B.NumPlayers ? 1 : 0);
+        break;
+    case EServerBrowserSortKey::Name:
+        Comparison = A.OwnerName.Compare(B.OwnerName, ESearchCase::IgnoreCase);
+        break;
+    case EServerBrowserSortKey::Map:
+        Comparison = A.MapName.Compare(B.MapName, ESearchCase::IgnoreCase);
+        break;
+    }
+
+    if (Comparison != 0)
+    {
+        return Order.bAscending ? Comparison < 0 : Comparison > 0;
+    }
+    return AIndex < BIndex;
+}
+
+/***************
+Console Commands
+***************/
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+    /*
+     * FServerBrowserBenchmark streams synthetic results into a server browser model, one batch per frame,
+     * changes the sort halfway through, then cycles through each sort key and a text filter.
+     * It records the game thread time of each frame, including the copy of the visible rows which the list view makes.
+     */
+    class FServerBrowserBenchmark : public TSharedFromThis<FServerBrowserBenchmark>
+    {
+    public:
+        FServerBrowserBenchmark(TArray<int32> InRowCounts, int32 InBatchSize):
+            RowCounts(MoveTemp(InRowCounts)),
+            BatchSize(InBatchSize)
+        {}
+
+        void Start()
+        {
+            bRunning = true;
+            TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FServerBrowserBenchmark::Tick));
+            StartScenario();
+        }
+
+        bool IsRunning() const { return bRunning; }
+
+    private:
+        /*
+         * FResult is the outcome of one row count.
+         */
+        struct FResult
+        {
+            int32 NumRows{ 0 };
+            FLatencyHistogram StreamFrames;
+            FLatencyHistogram SortFrames;
+            FServerBrowserModelStats ModelStats;
+        };
+
+        // StartScenario generates the results, so their construction is not measured.
+        void StartScenario()
+        {
+            const int32 NumRows = RowCounts[Results.Num()];
+            Results.AddDefaulted_GetRef().NumRows = NumRows;
+
+            FRandomStream Random(NumRows);
+            SearchResults.Reset(NumRows);
+            for (int32 Index = 0; Index < NumRows; ++Index)
+            {
+                FOnlineSessionSearchResult& Result = SearchResults.AddDefaulted_GetRef();
+                Result.PingInMs = Random.RandRange(5, 300);
+                Result.Session.OwningUserName = FString::Printf(TEXT("Host%d"), Random.RandRange(0, NumRows));
+                Result.Session.SessionSettings.NumPublicConnections = 8;
+                Result.Session.NumOpenPublicConnections = Random.RandRange(0, 8);
+                Result.Session.SessionSettings.Set(
+                    SETTING_MAPNAME,
+                    FString::Printf(TEXT("/Game/Maps/Map%d"), Random.RandRange(0, 9)),
+                    EOnlineDataAdvertisementType::ViaOnlineServiceAndPing
+                );
+            }
+
+            Model = FServerBrowserModel();
+            NumStreamed = 0;
+            NumSortSteps = 0;
+        }
+
+        // Tick does one frame of browser work, as UServerBrowser::NativeTick would.
+        bool Tick(float DeltaTime)
+        {
+            if (!bRunning)
+            {
+                return false;
+            }
+
+            FResult& Result = Results.Last();
+            const bool bStreaming = NumStreamed < SearchResults.Num();
+            const double StartTime = FPlatformTime::Seconds();
+
+            if (bStreaming)
+            {
+                const int32 Count = FMath::Min(BatchSize, SearchResults.Num() - NumStreamed);
+                Model.AddResults(MakeArrayView(SearchResults.GetData() + NumStreamed, Count), NumStreamed);
+                NumStreamed += Count;
+
+                // Change the sort mid-stream, so batches are merged while a sort runs.
+                if (NumStreamed >= SearchResults.Num() / 2 && Model.GetSortKey() == EServerBrowserSortKey::Ping)
+                {
+                    Model.SetSort(EServerBrowserSortKey::Name, true);
+                }
+            }
+            else if (!Model.IsSorting())
+            {
+                if (!StartSortStep())
+                {
+                    Result.ModelStats = Model.GetStats();
+                    FinishScenario();
+                    return bRunning;
+                }
+            }
+
+            if (Model.Tick())
+            {
+                VisibleRows.Reset(Model.GetView().Num());
+                for (const int32 RowIndex : Model.GetView())
+                {
+                    VisibleRows.Add(&Model.GetRow(RowIndex));
+                }
+            }
+
+            (bStreaming ? Result.StreamFrames : Result.SortFrames).Record(FPlatformTime::Seconds() - StartTime);
+            return true;
+        }
+
+        // StartSortStep changes the sort or filter once the previous change has been applied. Returns 'false' after the last step.
+        bool StartSortStep()
+        {
+            switch (NumSortSteps++)
+            {
+            case 0:
+                Model.SetSort(EServerBrowserSortKey::Ping, true);
+                return true;
+            case 1:
+                Model.SetSort(EServerBrowserSortKey::Players, false);
+                return true;
+            case 2:
+                Model.SetSort(EServerBrowserSortKey::Map, true);
+                return true;
+            case 3:
+            {
+                FServerBrowserFilter Filter;
+                Filter.Text = TEXT("Host1");
+                Filter.bHideFullSessions = true;
+                Model.SetFilter(Filter);
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        void FinishScenario()
+        {
+            const FResult& Result = Results.Last();
+            MULTIPLAYER_LOG(Info, TEXT("ServerBrowserBenchmark: %d rows: streaming frames p50 %.3fms p95 %.3fms max %.3fms, sort frames max %.3fms, sort latency p50 %.3fms max %.3fms"),
+                Result.NumRows,
+                Result.StreamFrames.GetPercentile(50.0) * 1000.0,
+                Result.StreamFrames.GetPercentile(95.0) * 1000.0,
+                Result.StreamFrames.GetMaxSeconds() * 1000.0,
+                Result.SortFrames.GetMaxSeconds() * 1000.0,
+                Result.ModelStats.SortLatency.GetPercentile(50.0) * 1000.0,
+                Result.ModelStats.SortLatency.GetMaxSeconds() * 1000.0);
+
+            if (Results.Num() < RowCounts.Num())
+            {
+                StartScenario();
+                return;
+            }
+            Finish();
+        }
+
+        // Finish writes the results to Saved/MultiplayerSessions.
+        void Finish()
+        {
+            bRunning = false;
+            if (TickerHandle.IsValid())
+            {
+                FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+                TickerHandle.Reset();
+            }
+            SearchResults.Empty();
+            VisibleRows.Empty();
+
+            FString Csv = TEXT("Rows,BatchSize,StreamFrameP50Ms,StreamFrameP95Ms,StreamFrameMaxMs,SortFrameP95Ms,SortFrameMaxMs,SortLatencyP50Ms,SortLatencyMaxMs,SortsApplied,RowsInserted\n");
+            for (const FResult& Result : Results)
+            {
+                Csv += FString::Printf(TEXT("%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%d,%lld\n"),
+                    Result.NumRows,
+                    BatchSize,
+                    Result.StreamFrames.GetPercentile(50.0) * 1000.0,
+                    Result.StreamFrames.GetPercentile(95.0) * 1000.0,
+                    Result.StreamFrames.GetMaxSeconds() * 1000.0,
+                    Result.SortFrames.GetPercentile(95.0) * 1000.0,
+                    Result.SortFrames.GetMaxSeconds() * 1000.0,
+                    Result.ModelStats.SortLatency.GetPercentile(50.0) * 1000.0,
+                    Result.ModelStats.SortLatency.GetMaxSeconds() * 1000.0,
+                    Result.ModelStats.SortsApplied,
+                    Result.ModelStats.RowsInserted);
+            }
+            const FString Path = FPaths::Combine(
+                FPaths::ProjectSavedDir(),
+                TEXT("MultiplayerSessions"),
+                FString::Printf(TEXT("ServerBrowserBenchmark-%s.csv"), *FDateTime::Now().ToString())
+            );
+            if (FFileHelper::SaveStringToFile(Csv, *Path))
+            {
+                MULTIPLAYER_LOG(Info, TEXT("ServerBrowserBenchmark: Wrote %s"), *Path);
+            }
+            else
+            {
+                MULTIPLAYER_LOG(Error, TEXT("ServerBrowserBenchmark: Failed to write %s"), *Path);
+            }
+        }
+
+        TArray<int32> RowCounts;
+        int32 BatchSize{ 64 };
+
+        FTSTicker::FDelegateHandle TickerHandle;
+        bool bRunning{ false };
+
+        FServerBrowserModel Model;
+        TArray<FOnlineSessionSearchResult> SearchResults;
+        TArray<const FServerBrowserRow*> VisibleRows;
+        int32 NumStreamed{ 0 };
+        int32 NumSortSteps{ 0 };
+        TArray<FResult> Results;
+    };
+
+    TSharedPtr<FServerBrowserBenchmark> ActiveServerBrowserBenchmark;
+}
+
+// RunServerBrowserBenchmark parses the row counts and batch size, and starts a run.
+static void RunServerBrowserBenchmark(const TArray<FString>& Args)
+{
+    if (ActiveServerBrowserBenchmark.IsValid() && ActiveServerBrowserBenchmark->IsRunning())
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("ServerBrowserBenchmark: A run is already in progress"));
+        return;
+    }
+
+    TArray<int32> RowCounts{ 100, 1000, 10000 };
+    int32 BatchSize = 64;
+    for (const FString& Arg : Args)
+    {
+        FString Key;
+        FString Value;
+        if (!Arg.Split(TEXT("="), &Key, &Value))
+        {
+            continue;
+        }
+        if (Key == TEXT("Rows"))
+        {
+            TArray<FString> Parts;
+            Value.ParseIntoArray(Parts, TEXT(","));
+            TArray<int32> Counts;
+            for (const FString& Part : Parts)
+            {
+                if (FCString::Atoi(*Part) > 0)
+                {
+                    Counts.Add(FCString::Atoi(*Part));
+                }
+            }
+            if (Counts.Num() > 0)
+            {
+                RowCounts = MoveTemp(Counts);
+            }
+        }
+        else if (Key == TEXT("BatchSize"))
+        {
+            BatchSize = FMath::Max(FCString::Atoi(*Value), 1);
+        }
+    }
+
+    ActiveServerBrowserBenchmark = MakeShared<FServerBrowserBenchmark>(MoveTemp(RowCounts), BatchSize);
+    ActiveServerBrowserBenchmark->Start();
+}
+
+static FAutoConsoleCommand ServerBrowserBenchmarkCommand(
+    TEXT("MultiplayerSessions.ServerBrowserBenchmark"),
+    TEXT("Streams synthetic results into a server browser, then sorts and filters them, and reports game thread time per frame. ")
+    TEXT("Usage: MultiplayerSessions.ServerBrowserBenchmark [Rows=100,1000,10000] [BatchSize=64]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunServerBrowserBenchmark)
+);
+#endif
\ No newline at end of file
@@ -0,0 +1,939 @@
+// (c) 2023 Will Roberts
+
+#include "SessionBenchmark.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "OnlineSessionSettings.h"
+
+#include "Logger.h"
+#include "DirectorySessionBackend.h"
+#include "MockSessionBackend.h"
+#include "MultiProviderSessionBackend.h"
+#include "MultiplayerSessionBackend.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTrace.h"
+#include "SessionScorer.h"
+#include "SessionSearchFilter.h"
+#include "SessionSearchIndex.h"
+
+namespace
+{
+    // Wall time spent fast-forwarding the mock backend each tick, so the game stays responsive during long runs.
+    constexpr double MockTickBudgetSeconds = 0.1;
+
+    // ParseCounts reads a comma-separated list of positive integers, keeping the defaults when none are given.
+    void ParseCounts(const FString& Value, TArray<int32>& OutCounts)
+    {
+        TArray<FString> Parts;
+        Value.ParseIntoArray(Parts, TEXT(","));
+
+        TArray<int32> Counts;
+        for (const FString& Part : Parts)
+        {
+            const int32 Count = FCString::Atoi(*Part);
+            if (Count > 0)
+            {
+                Counts.Add(Count);
+            }
+        }
+        if (Counts.Num() > 0)
+        {
+            OutCounts = MoveTemp(Counts);
+        }
+    }
+
+    // FindMockSessions runs Search against a manual mock backend, and returns once its results have all arrived.
+    void FindMockSessions(const FMultiplayerMockBackendSettings& Settings, const TSharedRef<FOnlineSessionSearch>& Search)
+    {
+        FMockSessionBackend Backend(Settings, true);
+        Backend.FindSessions(*Backend.GetDefaultPlayerId(), Search);
+        while (Backend.AdvanceToNext())
+        {
+        }
+    }
+
+    // EstimateSearchBytes adds up the estimated size of every result of Search.
+    int64 EstimateSearchBytes(const FOnlineSessionSearch& Search)
+    {
+        int64 Bytes = 0;
+        for (const FOnlineSessionSearchResult& Result : Search.SearchResults)
+        {
+            Bytes += FSessionSearchFilterMatcher::EstimateResultBytes(Result);
+        }
+        return Bytes;
+    }
+}
+
+// LexToString returns the name of a benchmark step, as used in logs and CSV headers.
+const TCHAR* LexToString(ESessionBenchmarkStep Step)
+{
+    switch (Step)
+    {
+    case ESessionBenchmarkStep::Create: return TEXT("Create");
+    case ESessionBenchmarkStep::Start: return TEXT("Start");
+    case ESessionBenchmarkStep::Find: return TEXT("Find");
+    case ESessionBenchmarkStep::DestroyHost: return TEXT("DestroyHost");
+    case ESessionBenchmarkStep::Join: return TEXT("Join");
+    case ESessionBenchmarkStep::Destroy: return TEXT("Destroy");
+    default: return TEXT("Unknown");
+    }
+}
+
+// Parse ignores unknown keys and invalid values, so defaults apply.
+FSessionBenchmarkConfig FSessionBenchmarkConfig::Parse(const TArray<FString>& Args)
+{
+    FSessionBenchmarkConfig Config;
+    for (const FString& Arg : Args)
+    {
+        FString Key;
+        FString Value;
+        if (!Arg.Split(TEXT("="), &Key, &Value))
+        {
+            continue;
+        }
+
+        if (Key == TEXT("Backend"))
+        {
+            Config.Backend = FName(*Value);
+        }
+        else if (Key == TEXT("Cycles"))
+        {
+            Config.Cycles = FMath::Max(FCString::Atoi(*Value), 1);
+        }
+        else if (Key == TEXT("MaxResults"))
+        {
+            ParseCounts(Value, Config.MaxSearchResults);
+        }
+        else if (Key == TEXT("Concurrency"))
+        {
+            ParseCounts(Value, Config.Concurrency);
+        }
+        else if (Key == TEXT("Sessions"))
+        {
+            ParseCounts(Value, Config.Sessions);
+        }
+        else if (Key == TEXT("MaxP95Ms"))
+        {
+            Config.MaxCycleP95Ms = FCString::Atod(*Value);
+        }
+        else if (Key == TEXT("MinOpsPerSec"))
+        {
+            Config.MinOperationsPerSecond = FCString::Atod(*Value);
+        }
+        else if (Key == TEXT("MaxGameThreadMs"))
+        {
+            Config.MaxGameThreadMsPerCycle = FCString::Atod(*Value);
+        }
+    }
+    return Config;
+}
+
+/*************
+Public Methods
+*************/
+
+// FSessionBenchmark prepares a run. Nothing happens until Start is called.
+FSessionBenchmark::FSessionBenchmark(UMultiplayerSessionsSubsystem* InSubsystem, const FSessionBenchmarkConfig& InConfig):
+    Subsystem(InSubsystem),
+    Config(InConfig)
+{}
+
+// ~FSessionBenchmark abandons a run in progress.
+FSessionBenchmark::~FSessionBenchmark()
+{
+    Stop();
+}
+
+// Start creates a scenario for each scale point and runs the first one.
+void FSessionBenchmark::Start(TUniqueFunction<void(bool)> InOnFinished)
+{
+    UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get();
+    if (bRunning || !Sessions)
+    {
+        return;
+    }
+
+    OnFinished = MoveTemp(InOnFinished);
+    Results.Reset();
+    for (const int32 MaxSearchResults : Config.MaxSearchResults)
+    {
+        for (const int32 Concurrency : Config.Concurrency)
+        {
+            for (const int32 NumSessions : Config.Sessions)
+            {
+                FSessionBenchmarkScenarioResult& Scenario = Results.AddDefaulted_GetRef();
+                Scenario.MaxSearchResults = MaxSearchResults;
+                Scenario.Concurrency = Concurrency;
+                Scenario.NumSessions = NumSessions;
+            }
+        }
+    }
+
+    bRunning = true;
+    OriginalBackend = Sessions->GetBackend();
+    TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FSessionBenchmark::Tick));
+
+    ScenarioIndex = 0;
+    StartScenario();
+}
+
+// Stop ignores every outstanding request, since they complete through the subsystem once its backend is restored.
+void FSessionBenchmark::Stop()
+{
+    if (!bRunning)
+    {
+        return;
+    }
+    bRunning = false;
+    FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+    TickerHandle.Reset();
+    RestoreBackend();
+}
+
+// ToCsv includes each step's p50 and p95, so regressions can be traced to a single operation.
+FString FSessionBenchmark::ToCsv() const
+{
+    FString Csv = TEXT("Backend,MaxSearchResults,Concurrency,Sessions,Cycles,Operations,Failures,ResultsFound,OpsPerSec,GameThreadMsPerCycle,CycleP50Ms,CycleP95Ms,CycleP99Ms");
+    for (int32 Step = 0; Step < NumSessionBenchmarkSteps; ++Step)
+    {
+        const TCHAR* StepName = LexToString(static_cast<ESessionBenchmarkStep>(Step));
+        Csv += FString::Printf(TEXT(",%sP50Ms,%sP95Ms"), StepName, StepName);
+    }
+    Csv += TEXT(",Regressions\n");
+
+    for (const FSessionBenchmarkScenarioResult& Scenario : Results)
+    {
+        Csv += FString::Printf(
+            TEXT("%s,%d,%d,%d,%d,%lld,%lld,%d,%.1f,%.3f,%.3f,%.3f,%.3f"),
+            *Config.Backend.ToString(),
+            Scenario.MaxSearchResults,
+            Scenario.Concurrency,
+            Scenario.NumSessions,
+            Scenario.CyclesCompleted,
+            Scenario.Operations,
+            Scenario.Failures,
+            Scenario.ResultsFound,
+            Scenario.GetOperationsPerSecond(),
+            Scenario.GetGameThreadMsPerCycle(),
+            Scenario.CycleLatency.GetPercentile(50.0) * 1e3,
+            Scenario.CycleLatency.GetPercentile(95.0) * 1e3,
+            Scenario.CycleLatency.GetPercentile(99.0) * 1e3
+        );
+        for (const FLatencyHistogram& StepLatency : Scenario.StepLatency)
+        {
+            Csv += FString::Printf(TEXT(",%.3f,%.3f"), StepLatency.GetPercentile(50.0) * 1e3, StepLatency.GetPercentile(95.0) * 1e3);
+        }
+        Csv += FString::Printf(TEXT(",%s\n"), *FString::Join(Scenario.Regressions, TEXT(";")));
+    }
+    return Csv;
+}
+
+/**************
+Private Methods
+**************/
+
+// Tick fast-forwards the mock backend, and moves to the next scenario once the current one has finished.
+// Scenarios are switched here rather than in a completion, since completions run inside the mock backend's Advance.
+bool FSessionBenchmark::Tick(float DeltaTime)
+{
+    if (!bRunning)
+    {
+        return false;
+    }
+    if (Results[ScenarioIndex].CyclesCompleted >= Config.Cycles)
+    {
+        FinishScenario();
+        return bRunning;
+    }
+    if (MockBackend.IsValid())
+    {
+        MULTIPLAYER_TRACE_SCOPE("FSessionBenchmark::AdvanceMockBackend");
+        const double EndTime = FPlatformTime::Seconds() + MockTickBudgetSeconds;
+        while (Results[ScenarioIndex].CyclesCompleted < Config.Cycles && FPlatformTime::Seconds() < EndTime && MockBackend->AdvanceToNext())
+        {
+        }
+    }
+    else if (DirectoryBackend.IsValid())
+    {
+        MULTIPLAYER_TRACE_SCOPE("FSessionBenchmark::AdvanceDirectoryBackend");
+        const double EndTime = FPlatformTime::Seconds() + MockTickBudgetSeconds;
+        while (Results[ScenarioIndex].CyclesCompleted < Config.Cycles && FPlatformTime::Seconds() < EndTime && DirectoryBackend->ProcessPending())
+        {
+        }
+    }
+    return true;
+}
+
+// StartScenario points the subsystem at a fresh backend and starts the first cycle.
+// The mock backend generates, and the directory is populated with, as many sessions as the scenario's MaxSearchResults,
+// so searches return full result sets.
+void FSessionBenchmark::StartScenario()
+{
+    UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get();
+    if (!Sessions)
+    {
+        Finish(false);
+        return;
+    }
+
+    const FSessionBenchmarkScenarioResult& Scenario = Results[ScenarioIndex];
+    TSharedPtr<IMultiplayerSessionBackend> Backend;
+    if (Config.Backend == FName("Mock"))
+    {
+        FMultiplayerMockBackendSettings MockSettings = GetDefault<UMultiplayerSessionsSettings>()->MockBackend;
+        MockSettings.NumSessions = Scenario.MaxSearchResults;
+        MockBackend = MakeShared<FMockSessionBackend>(MockSettings, true);
+        DirectoryBackend.Reset();
+        Backend = MockBackend;
+    }
+    else if (Config.Backend == FName("Directory"))
+    {
+        TSharedRef<FSessionDirectory> Directory = MakeShared<FSessionDirectory>();
+        TArray<FSessionDirectoryEntry> Entries;
+        Entries.SetNum(Scenario.MaxSearchResults);
+        for (int32 Index = 0; Index < Entries.Num(); ++Index)
+        {
+            FSessionDirectoryEntry& Entry = Entries[Index];
+            Entry.SessionId = FString::Printf(TEXT("BenchmarkDirectory%d"), Index);
+            Entry.OwnerName = Entry.SessionId;
+            Entry.HostAddress = TEXT("127.0.0.1:7777");
+            Entry.MatchType = TEXT("Benchmark");
+            Entry.NumPublicConnections = 4;
+            Entry.NumOpenPublicConnections = 4;
+        }
+        Directory->Register(MoveTemp(Entries), FPlatformTime::Seconds());
+
+        MockBackend.Reset();
+        DirectoryBackend = MakeShared<FDirectorySessionBackend>(GetDefault<UMultiplayerSessionsSettings>()->DirectoryBackend, Directory, true);
+        Backend = DirectoryBackend;
+    }
+    else if (Config.Backend.ToString().Contains(TEXT("+")))
+    {
+        FMultiplayerMultiProviderSettings MultiProvider = GetDefault<UMultiplayerSessionsSettings>()->MultiProvider;
+        TArray<FString> ProviderNames;
+        Config.Backend.ToString().ParseIntoArray(ProviderNames, TEXT("+"));
+        MultiProvider.Providers.Reset();
+        for (const FString& ProviderName : ProviderNames)
+        {
+            MultiProvider.Providers.Add(FName(*ProviderName));
+        }
+
+        MockBackend.Reset();
+        DirectoryBackend.Reset();
+        Backend = FMultiProviderSessionBackend::Create(MultiProvider);
+    }
+    else
+    {
+        MockBackend.Reset();
+        DirectoryBackend.Reset();
+        Backend = FOnlineSessionBackend::Create(Config.Backend);
+    }
+    if (!Backend.IsValid())
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Benchmark: Failed to create %s backend"), *Config.Backend.ToString());
+        Finish(false);
+        return;
+    }
+    Sessions->SetBackend(Backend);
+
+    SessionNames.Reset(Scenario.NumSessions);
+    SessionNames.Add(NAME_GameSession);
+    for (int32 Index = 1; Index < Scenario.NumSessions; ++Index)
+    {
+        SessionNames.Add(FName(TEXT("BenchmarkSession"), Index));
+    }
+
+    MULTIPLAYER_LOG(Info, TEXT("Benchmark: Running %d cycles against %s, MaxSearchResults %d, concurrency %d, %d sessions"),
+        Config.Cycles, *Config.Backend.ToString(), Scenario.MaxSearchResults, Scenario.Concurrency, Scenario.NumSessions);
+    ScenarioStartTime = FPlatformTime::Seconds();
+    ScenarioStartGameThreadSeconds = Sessions->GetMetrics().GetGameThreadSeconds();
+    StartCycle();
+}
+
+// FinishScenario checks the thresholds and logs the scenario's results, then runs the next scenario or ends the run.
+void FSessionBenchmark::FinishScenario()
+{
+    UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get();
+    if (!Sessions)
+    {
+        Finish(false);
+        return;
+    }
+
+    FSessionBenchmarkScenarioResult& Scenario = Results[ScenarioIndex];
+    Scenario.WallSeconds = FPlatformTime::Seconds() - ScenarioStartTime;
+    Scenario.GameThreadSeconds = Sessions->GetMetrics().GetGameThreadSeconds() - ScenarioStartGameThreadSeconds;
+
+    const double CycleP95Ms = Scenario.CycleLatency.GetPercentile(95.0) * 1e3;
+    if (Config.MaxCycleP95Ms > 0.0 && CycleP95Ms > Config.MaxCycleP95Ms)
+    {
+        Scenario.Regressions.Add(FString::Printf(TEXT("cycle p95 %.3fms exceeds %.3fms"), CycleP95Ms, Config.MaxCycleP95Ms));
+    }
+    if (Config.MinOperationsPerSecond > 0.0 && Scenario.GetOperationsPerSecond() < Config.MinOperationsPerSecond)
+    {
+        Scenario.Regressions.Add(FString::Printf(TEXT("%.1f ops/s is below %.1f ops/s"), Scenario.GetOperationsPerSecond(), Config.MinOperationsPerSecond));
+    }
+    if (Config.MaxGameThreadMsPerCycle > 0.0 && Scenario.GetGameThreadMsPerCycle() > Config.MaxGameThreadMsPerCycle)
+    {
+        Scenario.Regressions.Add(FString::Printf(TEXT("game thread %.3fms per cycle exceeds %.3fms"), Scenario.GetGameThreadMsPerCycle(), Config.MaxGameThreadMsPerCycle));
+    }
+
+    MULTIPLAYER_LOG(Info, TEXT("Benchmark: MaxSearchResults %d, concurrency %d, %d sessions: %.1f ops/s, %lld failed, %d results, cycle p50 %.3fms p95 %.3fms p99 %.3fms, game thread %.3fms per cycle"),
+        Scenario.MaxSearchResults,
+        Scenario.Concurrency,
+        Scenario.NumSessions,
+        Scenario.GetOperationsPerSecond(),
+        Scenario.Failures,
+        Scenario.ResultsFound,
+        Scenario.CycleLatency.GetPercentile(50.0) * 1e3,
+        CycleP95Ms,
+        Scenario.CycleLatency.GetPercentile(99.0) * 1e3,
+        Scenario.GetGameThreadMsPerCycle());
+    for (int32 Step = 0; Step < NumSessionBenchmarkSteps; ++Step)
+    {
+        const FLatencyHistogram& StepLatency = Scenario.StepLatency[Step];
+        MULTIPLAYER_LOG(Verbose, TEXT("Benchmark:   %s: %lld requests, p50 %.3fms, p95 %.3fms, p99 %.3fms"),
+            LexToString(static_cast<ESessionBenchmarkStep>(Step)),
+            StepLatency.GetCount(),
+            StepLatency.GetPercentile(50.0) * 1e3,
+            StepLatency.GetPercentile(95.0) * 1e3,
+            StepLatency.GetPercentile(99.0) * 1e3);
+    }
+    for (const FString& Regression : Scenario.Regressions)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Benchmark: Regression: %s"), *Regression);
+    }
+
+    if (++ScenarioIndex < Results.Num())
+    {
+        StartScenario();
+        return;
+    }
+    Finish(!Results.ContainsByPredicate([](const FSessionBenchmarkScenarioResult& Result) { return Result.Regressions.Num() > 0; }));
+}
+
+// StartCycle hosts a new session.
+void FSessionBenchmark::StartCycle()
+{
+    CycleStartTime = FPlatformTime::Seconds();
+    bCycleHosted = false;
+    RunStep(ESessionBenchmarkStep::Create);
+}
+
+// FinishCycle records the cycle's latency. The next cycle is started here, but the next scenario is started by Tick.
+void FSessionBenchmark::FinishCycle()
+{
+    FSessionBenchmarkScenarioResult& Scenario = Results[ScenarioIndex];
+    Scenario.CycleLatency.Record(FPlatformTime::Seconds() - CycleStartTime);
+    if (++Scenario.CyclesCompleted < Config.Cycles)
+    {
+        StartCycle();
+    }
+}
+
+// RunStep makes the step's requests at once, and moves on when all of them have completed.
+// Searches bypass the search cache, so every cycle reaches the backend.
+void FSessionBenchmark::RunStep(ESessionBenchmarkStep Step)
+{
+    MULTIPLAYER_TRACE_SCOPE("FSessionBenchmark::RunStep");
+
+    UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get();
+    if (!Sessions)
+    {
+        Finish(false);
+        return;
+    }
+
+    FSessionBenchmarkScenarioResult& Scenario = Results[ScenarioIndex];
+    CurrentStep = Step;
+    StepSerial++;
+    bStepSucceeded = false;
+
+    TArray<int32> Candidates;
+    if (Step == ESessionBenchmarkStep::Find)
+    {
+        Sessions->InvalidateSearchCache();
+    }
+    else if (Step == ESessionBenchmarkStep::Join)
+    {
+        Scenario.ResultsFound = Sessions->GetSearchIndex().Num();
+        Sessions->GetBestSessions(GetDefault<UMultiplayerSessionsSettings>()->MaxJoinAttempts, Candidates);
+        if (Candidates.Num() == 0)
+        {
+            Scenario.Failures++;
+            OnStepDone();
+            return;
+        }
+    }
+
+    // Hold the step open until every request has been made, in case some complete immediately.
+    // Searches are not tied to a session, so only session steps are repeated for each named session.
+    const int32 NumSessions = Step == ESessionBenchmarkStep::Find ? 1 : SessionNames.Num();
+    OutstandingRequests = 1;
+    for (int32 SessionIndex = 0; SessionIndex < NumSessions && bRunning; ++SessionIndex)
+    {
+        const FName SessionName = SessionNames[SessionIndex];
+        for (int32 Index = 0; Index < Scenario.Concurrency && bRunning; ++Index)
+        {
+            OutstandingRequests++;
+            TWeakPtr<FSessionBenchmark> WeakThis = AsShared();
+            auto Done = [WeakThis, Serial = StepSerial, RequestTime = FPlatformTime::Seconds()](bool bSucceeded)
+            {
+                if (TSharedPtr<FSessionBenchmark> Benchmark = WeakThis.Pin())
+                {
+                    Benchmark->OnRequestDone(Serial, RequestTime, bSucceeded);
+                }
+            };
+
+            switch (Step)
+            {
+            case ESessionBenchmarkStep::Create:
+                Sessions->CreateSessionAsync(4, TEXT("Benchmark"), SessionName).Next(Done);
+                break;
+            case ESessionBenchmarkStep::Start:
+                Sessions->StartSessionAsync(SessionName).Next(Done);
+                break;
+            case ESessionBenchmarkStep::Find:
+                Sessions->FindSessionsAsync(Scenario.MaxSearchResults, FMultiplayerSessionSearchFilter()).Next(
+                    [Done](const FMultiplayerFindSessionsResult& Result) { Done(Result.bWasSuccessful); });
+                break;
+            case ESessionBenchmarkStep::Join:
+                Sessions->JoinRankedSessionsAsync(Candidates, SessionName).Next(
+                    [Done](EOnJoinSessionCompleteResult::Type Result) { Done(Result == EOnJoinSessionCompleteResult::Success); });
+                break;
+            case ESessionBenchmarkStep::DestroyHost:
+            case ESessionBenchmarkStep::Destroy:
+                Sessions->DestroySessionAsync(SessionName).Next(Done);
+                break;
+            }
+        }
+    }
+
+    if (bRunning && --OutstandingRequests == 0)
+    {
+        OnStepDone();
+    }
+}
+
+// OnRequestDone records a request's latency, and completes the step after its last request.
+void FSessionBenchmark::OnRequestDone(uint32 Serial, double RequestTime, bool bSucceeded)
+{
+    if (!bRunning || Serial != StepSerial)
+    {
+        return;
+    }
+
+    FSessionBenchmarkScenarioResult& Scenario = Results[ScenarioIndex];
+    Scenario.StepLatency[static_cast<int32>(CurrentStep)].Record(FPlatformTime::Seconds() - RequestTime);
+    Scenario.Operations++;
+    if (!bSucceeded)
+    {
+        Scenario.Failures++;
+    }
+    bStepSucceeded |= bSucceeded;
+
+    if (--OutstandingRequests == 0)
+    {
+        OnStepDone();
+    }
+}
+
+// OnStepDone runs the next step. Steps which depend on a failed step are skipped, and their failure ends the cycle early.
+void FSessionBenchmark::OnStepDone()
+{
+    switch (CurrentStep)
+    {
+    case ESessionBenchmarkStep::Create:
+        bCycleHosted = bStepSucceeded;
+        RunStep(bCycleHosted ? ESessionBenchmarkStep::Start : ESessionBenchmarkStep::Find);
+        break;
+    case ESessionBenchmarkStep::Start:
+        RunStep(ESessionBenchmarkStep::Find);
+        break;
+    case ESessionBenchmarkStep::Find:
+        RunStep(bCycleHosted ? ESessionBenchmarkStep::DestroyHost : ESessionBenchmarkStep::Join);
+        break;
+    case ESessionBenchmarkStep::DestroyHost:
+        RunStep(ESessionBenchmarkStep::Join);
+        break;
+    case ESessionBenchmarkStep::Join:
+        if (bStepSucceeded)
+        {
+            RunStep(ESessionBenchmarkStep::Destroy);
+            break;
+        }
+        FinishCycle();
+        break;
+    case ESessionBenchmarkStep::Destroy:
+        FinishCycle();
+        break;
+    }
+}
+
+// Finish restores the backend, writes the results to Saved/MultiplayerSessions as CSV, and reports whether the run passed.
+void FSessionBenchmark::Finish(bool bPassed)
+{
+    if (!bRunning)
+    {
+        return;
+    }
+    Stop();
+
+    const FString Path = FPaths::Combine(
+        FPaths::ProjectSavedDir(),
+        TEXT("MultiplayerSessions"),
+        FString::Printf(TEXT("SessionBenchmark-%s.csv"), *FDateTime::Now().ToString())
+    );
+    if (FFileHelper::SaveStringToFile(ToCsv(), *Path))
+    {
+        MULTIPLAYER_LOG(Info, TEXT("Benchmark: Wrote %s"), *Path);
+    }
+    else
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Benchmark: Failed to write %s"), *Path);
+    }
+
+    if (OnFinished)
+    {
+        OnFinished(bPassed);
+    }
+}
+
+// RestoreBackend gives the subsystem back the backend it had before the run.
+void FSessionBenchmark::RestoreBackend()
+{
+    if (UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get())
+    {
+        Sessions->SetBackend(OriginalBackend);
+    }
+    OriginalBackend.Reset();
+    MockBackend.Reset();
+    DirectoryBackend.Reset();
+}
+
+/******************************
+FSessionScorerBenchmark Methods
+******************************/
+
+// Run scores with a preferred region, so the region comparison is part of the measured cost.
+// RankBest scores the results again before ranking them, so RankLatency includes a full scoring pass.
+FSessionScorerBenchmarkResult FSessionScorerBenchmark::Run(int32 NumSessions, int32 Iterations, int32 Count)
+{
+    FSessionScorerBenchmarkResult Result;
+    Result.NumSessions = NumSessions;
+    Result.Count = Count;
+
+    FMultiplayerMockBackendSettings MockSettings;
+    MockSettings.NumSessions = NumSessions;
+    const TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+    Search->MaxSearchResults = NumSessions;
+    FindMockSessions(MockSettings, Search);
+
+    FMultiplayerSessionScoringWeights Weights;
+    Weights.PreferredRegion = TEXT("eu-west");
+
+    FSessionSearchIndex Index;
+    TArray<float> Costs;
+    TArray<int32> Best;
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        double StartTime = FPlatformTime::Seconds();
+        Index.Build(Search);
+        Result.IndexLatency.Record(FPlatformTime::Seconds() - StartTime);
+
+        StartTime = FPlatformTime::Seconds();
+        FSessionScorer::Score(Index, Weights, Costs);
+        Result.ScoreLatency.Record(FPlatformTime::Seconds() - StartTime);
+
+        StartTime = FPlatformTime::Seconds();
+        FSessionScorer::RankBest(Index, Weights, Count, Best);
+        Result.RankLatency.Record(FPlatformTime::Seconds() - StartTime);
+    }
+    return Result;
+}
+
+// ToCsv includes the p50, p95 and maximum of each phase.
+FString FSessionScorerBenchmark::ToCsv(const TArray<FSessionScorerBenchmarkResult>& Results)
+{
+    FString Csv = TEXT("Sessions,Count,Iterations,IndexP50Ms,IndexP95Ms,IndexMaxMs,ScoreP50Ms,ScoreP95Ms,ScoreMaxMs,RankP50Ms,RankP95Ms,RankMaxMs\n");
+    for (const FSessionScorerBenchmarkResult& Result : Results)
+    {
+        Csv += FString::Printf(TEXT("%d,%d,%lld"), Result.NumSessions, Result.Count, Result.RankLatency.GetCount());
+        for (const FLatencyHistogram* Latency : { &Result.IndexLatency, &Result.ScoreLatency, &Result.RankLatency })
+        {
+            Csv += FString::Printf(
+                TEXT(",%.4f,%.4f,%.4f"),
+                Latency->GetPercentile(50.0) * 1e3,
+                Latency->GetPercentile(95.0) * 1e3,
+                Latency->GetMaxSeconds() * 1e3
+            );
+        }
+        Csv += TEXT("\n");
+    }
+    return Csv;
+}
+
+/*****************************
+FSearchFilterBenchmark Methods
+*****************************/
+
+// Run uses a mock with several match types, so a match type filter rejects most sessions.
+// Both searches use the same seed, so they see the same sessions.
+FSearchFilterBenchmarkResult FSearchFilterBenchmark::Run(int32 NumSessions, const FMultiplayerSessionSearchFilter& Filter)
+{
+    FSearchFilterBenchmarkResult Result;
+    Result.NumSessions = NumSessions;
+
+    FMultiplayerMockBackendSettings MockSettings;
+    MockSettings.NumSessions = NumSessions;
+    MockSettings.MatchTypes = { TEXT("FreeForAll"), TEXT("TeamDeathmatch"), TEXT("CaptureTheFlag") };
+
+    const TSharedRef<FOnlineSessionSearch> ServerSideSearch = MakeShared<FOnlineSessionSearch>();
+    ServerSideSearch->MaxSearchResults = NumSessions;
+    Filter.ApplyToQuerySettings(ServerSideSearch->QuerySettings);
+    FindMockSessions(MockSettings, ServerSideSearch);
+    Result.ServerSideResults = ServerSideSearch->SearchResults.Num();
+    Result.ServerSideBytes = EstimateSearchBytes(*ServerSideSearch);
+
+    const TSharedRef<FOnlineSessionSearch> LocalSearch = MakeShared<FOnlineSessionSearch>();
+    LocalSearch->MaxSearchResults = NumSessions;
+    FindMockSessions(MockSettings, LocalSearch);
+    Result.LocalResults = LocalSearch->SearchResults.Num();
+    Result.LocalBytes = EstimateSearchBytes(*LocalSearch);
+
+    const double StartTime = FPlatformTime::Seconds();
+    const FSessionSearchFilterMatcher Matcher(Filter);
+    Matcher.RemoveNonMatching(LocalSearch->SearchResults, 0);
+    Result.LocalFilterSeconds = FPlatformTime::Seconds() - StartTime;
+    Result.MatchingResults = LocalSearch->SearchResults.Num();
+    return Result;
+}
+
+// ToCsv includes the bytes saved, so runs can be compared without recomputing it.
+FString FSearchFilterBenchmark::ToCsv(const TArray<FSearchFilterBenchmarkResult>& Results)
+{
+    FString Csv = TEXT("Sessions,ServerSideResults,ServerSideBytes,LocalResults,LocalBytes,MatchingResults,BytesSaved,LocalFilterMs\n");
+    for (const FSearchFilterBenchmarkResult& Result : Results)
+    {
+        Csv += FString::Printf(
+            TEXT("%d,%d,%lld,%d,%lld,%d,%lld,%.4f\n"),
+            Result.NumSessions,
+            Result.ServerSideResults,
+            Result.ServerSideBytes,
+            Result.LocalResults,
+            Result.LocalBytes,
+            Result.MatchingResults,
+            Result.GetBytesSaved(),
+            Result.LocalFilterSeconds * 1e3
+        );
+    }
+    return Csv;
+}
+
+/***************
+Console Commands
+***************/
+
+#if !UE_BUILD_SHIPPING
+static TSharedPtr<FSessionBenchmark> ActiveSessionBenchmark;
+
+// RunSessionBenchmark starts or stops a benchmark run against the subsystem of the world's game instance.
+// With -exit, the process exits when the run finishes, with exit code 1 if any threshold was exceeded.
+static void RunSessionBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+    if (Args.Contains(TEXT("stop")))
+    {
+        if (ActiveSessionBenchmark.IsValid() && ActiveSessionBenchmark->IsRunning())
+        {
+            ActiveSessionBenchmark->Stop();
+            MULTIPLAYER_LOG(Info, TEXT("Benchmark: Stopped"));
+        }
+        return;
+    }
+    if (ActiveSessionBenchmark.IsValid() && ActiveSessionBenchmark->IsRunning())
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("Benchmark: A run is already in progress"));
+        return;
+    }
+
+    const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if (!Subsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("Benchmark: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    const bool bExitWhenFinished = Args.Contains(TEXT("-exit"));
+    ActiveSessionBenchmark = MakeShared<FSessionBenchmark>(Subsystem, FSessionBenchmarkConfig::Parse(Args));
+    ActiveSessionBenchmark->Start([bExitWhenFinished](bool bPassed)
+    {
+        if (bPassed)
+        {
+            MULTIPLAYER_LOG(Info, TEXT("Benchmark: Passed"));
+        }
+        else
+        {
+            MULTIPLAYER_LOG(Error, TEXT("Benchmark: Failed"));
+        }
+        if (bExitWhenFinished)
+        {
+            FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+        }
+    });
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SessionBenchmarkCommand(
+    TEXT("MultiplayerSessions.Benchmark"),
+    TEXT("Runs create, start, find, join and destroy cycles and reports throughput and latency. ")
+    TEXT("Usage: MultiplayerSessions.Benchmark [stop] [Backend=Mock|Directory|NULL|NULL+Mock] [Cycles=20] [MaxResults=10,1000,100000] [Concurrency=1,8] [Sessions=1] ")
+    TEXT("[MaxP95Ms=N] [MinOpsPerSec=N] [MaxGameThreadMs=N] [-exit]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunSessionBenchmark)
+);
+
+// RunScorerBenchmark runs the scorer benchmark at each session count, then logs the results and writes them to CSV.
+static void RunScorerBenchmark(const TArray<FString>& Args)
+{
+    TArray<int32> SessionCounts{ 10000, 100000 };
+    int32 Iterations = 20;
+    int32 Count = 8;
+    for (const FString& Arg : Args)
+    {
+        FString Key;
+        FString Value;
+        if (!Arg.Split(TEXT("="), &Key, &Value))
+        {
+            continue;
+        }
+        if (Key == TEXT("Sessions"))
+        {
+            ParseCounts(Value, SessionCounts);
+        }
+        else if (Key == TEXT("Iterations"))
+        {
+            Iterations = FMath::Max(FCString::Atoi(*Value), 1);
+        }
+        else if (Key == TEXT("Count"))
+        {
+            Count = FMath::Max(FCString::Atoi(*Value), 1);
+        }
+    }
+
+    TArray<FSessionScorerBenchmarkResult> Results;
+    for (const int32 NumSessions : SessionCounts)
+    {
+        const FSessionScorerBenchmarkResult& Result = Results.Add_GetRef(FSessionScorerBenchmark::Run(NumSessions, Iterations, Count));
+        MULTIPLAYER_LOG(
+            Info,
+            TEXT("ScorerBenchmark: %d sessions, index p50 %.3fms, score p50 %.3fms p95 %.3fms, rank best %d p50 %.3fms p95 %.3fms"),
+            NumSessions,
+            Result.IndexLatency.GetPercentile(50.0) * 1e3,
+            Result.ScoreLatency.GetPercentile(50.0) * 1e3,
+            Result.ScoreLatency.GetPercentile(95.0) * 1e3,
+            Count,
+            Result.RankLatency.GetPercentile(50.0) * 1e3,
+            Result.RankLatency.GetPercentile(95.0) * 1e3
+        );
+    }
+
+    const FString Path = FPaths::Combine(
+        FPaths::ProjectSavedDir(),
+        TEXT("MultiplayerSessions"),
+        FString::Printf(TEXT("ScorerBenchmark-%s.csv"), *FDateTime::Now().ToString())
+    );
+    if (FFileHelper::SaveStringToFile(FSessionScorerBenchmark::ToCsv(Results), *Path))
+    {
+        MULTIPLAYER_LOG(Info, TEXT("ScorerBenchmark: Wrote %s"), *Path);
+    }
+    else
+    {
+        MULTIPLAYER_LOG(Error, TEXT("ScorerBenchmark: Failed to write %s"), *Path);
+    }
+}
+
+static FAutoConsoleCommand ScorerBenchmarkCommand(
+    TEXT("MultiplayerSessions.ScorerBenchmark"),
+    TEXT("Indexes, scores and ranks mock search results, and reports the latency of each phase. ")
+    TEXT("Usage: MultiplayerSessions.ScorerBenchmark [Sessions=10000,100000] [Iterations=20] [Count=8]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunScorerBenchmark)
+);
+
+// RunFilterBenchmark runs the filter benchmark at each session count, then logs the results and writes them to CSV.
+static void RunFilterBenchmark(const TArray<FString>& Args)
+{
+    TArray<int32> SessionCounts{ 1000, 10000 };
+    FMultiplayerSessionSearchFilter Filter;
+    Filter.MatchType = TEXT("FreeForAll");
+    Filter.Region = TEXT("eu-west");
+    Filter.MinOpenSlots = 1;
+    for (const FString& Arg : Args)
+    {
+        FString Key;
+        FString Value;
+        if (!Arg.Split(TEXT("="), &Key, &Value))
+        {
+            continue;
+        }
+        if (Key == TEXT("Sessions"))
+        {
+            ParseCounts(Value, SessionCounts);
+        }
+        else if (Key == TEXT("MatchType"))
+        {
+            Filter.MatchType = Value;
+        }
+        else if (Key == TEXT("Region"))
+        {
+            Filter.Region = Value;
+        }
+        else if (Key == TEXT("MinOpenSlots"))
+        {
+            Filter.MinOpenSlots = FMath::Max(FCString::Atoi(*Value), 0);
+        }
+    }
+
+    TArray<FSearchFilterBenchmarkResult> Results;
+    for (const int32 NumSessions : SessionCounts)
+    {
+        const FSearchFilterBenchmarkResult& Result = Results.Add_GetRef(FSearchFilterBenchmark::Run(NumSessions, Filter));
+        MULTIPLAYER_LOG(
+            Info,
+            TEXT("FilterBenchmark: %d sessions, %d results (%lld bytes) filtered server-side, %d results (%lld bytes) filtered locally to %d in %.3fms, %lld bytes saved"),
+            NumSessions,
+            Result.ServerSideResults,
+            Result.ServerSideBytes,
+            Result.LocalResults,
+            Result.LocalBytes,
+            Result.MatchingResults,
+            Result.LocalFilterSeconds * 1e3,
+            Result.GetBytesSaved()
+        );
+    }
+
+    const FString Path = FPaths::Combine(
+        FPaths::ProjectSavedDir(),
+        TEXT("MultiplayerSessions"),
+        FString::Printf(TEXT("FilterBenchmark-%s.csv"), *FDateTime::Now().ToString())
+    );
+    if (FFileHelper::SaveStringToFile(FSearchFilterBenchmark::ToCsv(Results), *Path))
+    {
+        MULTIPLAYER_LOG(Info, TEXT("FilterBenchmark: Wrote %s"), *Path);
+    }
+    else
+    {
+        MULTIPLAYER_LOG(Error, TEXT("FilterBenchmark: Failed to write %s"), *Path);
+    }
+}
+
+static FAutoConsoleCommand FilterBenchmarkCommand(
+    TEXT("MultiplayerSessions.FilterBenchmark"),
+    TEXT("Searches mock sessions with a filter pushed to the provider and with local filtering, and reports the bytes saved. ")
+    TEXT("Usage: MultiplayerSessions.FilterBenchmark [Sessions=1000,10000] [MatchType=FreeForAll] [Region=eu-west] [MinOpenSlots=1]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunFilterBenchmark)
+);
+#endif
\ No newline at end of file
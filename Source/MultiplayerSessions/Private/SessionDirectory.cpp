@@ -0,0 +1,504 @@
+// (c) 2023 Will Roberts
+
+#include "SessionDirectory.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/Sort.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/ScopeRWLock.h"
+
+#include "Logger.h"
+#include "MultiplayerSessionsTrace.h"
+#include "SessionMetrics.h"
+
+/*************
+Public Methods
+*************/
+
+// FSessionDirectory allocates its shards up front. Shards are never added or removed, so they can be read without a global lock.
+FSessionDirectory::FSessionDirectory(int32 InNumShards)
+{
+    const int32 NumShards = FMath::Max(InNumShards, 1);
+    Shards.Reserve(NumShards);
+    for (int32 Index = 0; Index < NumShards; ++Index)
+    {
+        Shards.Add(MakeUnique<FShard>());
+    }
+}
+
+// GetShared creates the process-wide directory the first time it is used.
+TSharedRef<FSessionDirectory> FSessionDirectory::GetShared()
+{
+    static const TSharedRef<FSessionDirectory> SharedDirectory = MakeShared<FSessionDirectory>();
+    return SharedDirectory;
+}
+
+// Register assigns sequences and locations for the whole batch, then locks each affected shard once to apply it.
+// Only the last registration of a session in the batch is applied. Sessions whose match type or region changed move to their new shard.
+void FSessionDirectory::Register(TArray<FSessionDirectoryEntry> Entries, double Now)
+{
+    MULTIPLAYER_TRACE_SCOPE("FSessionDirectory::Register");
+
+    if (Entries.Num() == 0)
+    {
+        return;
+    }
+
+    TMap<FString, int32> LastIndices;
+    LastIndices.Reserve(Entries.Num());
+    for (int32 Index = 0; Index < Entries.Num(); ++Index)
+    {
+        LastIndices.Add(Entries[Index].SessionId, Index);
+    }
+
+    FRWScopeLock LocationsScope(LocationsLock, SLT_Write);
+
+    TArray<TArray<uint64>> RemovalsByShard;
+    TArray<TArray<int32>> InsertsByShard;
+    RemovalsByShard.SetNum(Shards.Num());
+    InsertsByShard.SetNum(Shards.Num());
+    for (int32 Index = 0; Index < Entries.Num(); ++Index)
+    {
+        FSessionDirectoryEntry& Entry = Entries[Index];
+        if (LastIndices.FindChecked(Entry.SessionId) != Index)
+        {
+            continue;
+        }
+
+        const int32 ShardIndex = GetShardIndex(Entry.MatchType, Entry.Region);
+        FLocation* Location = Locations.Find(Entry.SessionId);
+        if (Location)
+        {
+            if (Location->ShardIndex != ShardIndex)
+            {
+                RemovalsByShard[Location->ShardIndex].Add(Location->Sequence);
+            }
+            Updated++;
+        }
+        else
+        {
+            Location = &Locations.Add(Entry.SessionId, FLocation{ ShardIndex, NextSequence++, Now });
+            Registered++;
+        }
+        Location->ShardIndex = ShardIndex;
+        Location->LastHeartbeatTime = Now;
+        Entry.Sequence = Location->Sequence;
+        InsertsByShard[ShardIndex].Add(Index);
+    }
+
+    RemoveFromShards(RemovalsByShard);
+    for (int32 ShardIndex = 0; ShardIndex < Shards.Num(); ++ShardIndex)
+    {
+        if (InsertsByShard[ShardIndex].Num() == 0)
+        {
+            continue;
+        }
+
+        FShard& Shard = *Shards[ShardIndex];
+        FRWScopeLock ShardScope(Shard.Lock, SLT_Write);
+        for (const int32 Index : InsertsByShard[ShardIndex])
+        {
+            // New sessions have the highest sequence so far, so they are appended. Moved sessions keep their place in the order.
+            FSessionDirectoryEntry& Entry = Entries[Index];
+            const int32 Position = Algo::LowerBoundBy(Shard.Entries, Entry.Sequence, &FSessionDirectoryEntry::Sequence);
+            if (Shard.Entries.IsValidIndex(Position) && Shard.Entries[Position].Sequence == Entry.Sequence)
+            {
+                Shard.Entries[Position] = MoveTemp(Entry);
+            }
+            else
+            {
+                Shard.Entries.Insert(MoveTemp(Entry), Position);
+            }
+        }
+    }
+    Batches++;
+}
+
+// Remove forgets the sessions' locations, then locks each affected shard once.
+int32 FSessionDirectory::Remove(const TArray<FString>& SessionIds)
+{
+    MULTIPLAYER_TRACE_SCOPE("FSessionDirectory::Remove");
+
+    FRWScopeLock LocationsScope(LocationsLock, SLT_Write);
+
+    TArray<TArray<uint64>> RemovalsByShard;
+    RemovalsByShard.SetNum(Shards.Num());
+    int32 NumRemoved = 0;
+    for (const FString& SessionId : SessionIds)
+    {
+        FLocation Location;
+        if (Locations.RemoveAndCopyValue(SessionId, Location))
+        {
+            RemovalsByShard[Location.ShardIndex].Add(Location.Sequence);
+            NumRemoved++;
+        }
+    }
+    RemoveFromShards(RemovalsByShard);
+    Removed += NumRemoved;
+    return NumRemoved;
+}
+
+// Heartbeat only touches the locations, so it never blocks queries.
+int32 FSessionDirectory::Heartbeat(const TArray<FString>& SessionIds, double Now)
+{
+    FRWScopeLock LocationsScope(LocationsLock, SLT_Write);
+
+    int32 NumAlive = 0;
+    for (const FString& SessionId : SessionIds)
+    {
+        if (FLocation* Location = Locations.Find(SessionId))
+        {
+            Location->LastHeartbeatTime = Now;
+            NumAlive++;
+        }
+    }
+    Heartbeats += NumAlive;
+    return NumAlive;
+}
+
+// ExpireStale removes sessions whose hosts stopped sending heartbeats, e.g. because they crashed or lost their connection.
+int32 FSessionDirectory::ExpireStale(double Now, double ExpirySeconds)
+{
+    MULTIPLAYER_TRACE_SCOPE("FSessionDirectory::ExpireStale");
+
+    FRWScopeLock LocationsScope(LocationsLock, SLT_Write);
+
+    TArray<TArray<uint64>> RemovalsByShard;
+    RemovalsByShard.SetNum(Shards.Num());
+    int32 NumExpired = 0;
+    for (auto It = Locations.CreateIterator(); It; ++It)
+    {
+        if (Now - It.Value().LastHeartbeatTime > ExpirySeconds)
+        {
+            RemovalsByShard[It.Value().ShardIndex].Add(It.Value().Sequence);
+            It.RemoveCurrent();
+            NumExpired++;
+        }
+    }
+    if (NumExpired > 0)
+    {
+        RemoveFromShards(RemovalsByShard);
+        Expired += NumExpired;
+        MULTIPLAYER_LOG(Verbose, TEXT("SessionDirectory: Expired %d sessions"), NumExpired);
+    }
+    return NumExpired;
+}
+
+// Query reads the first PageSize + 1 matches after the cursor from each shard, which include the first PageSize + 1 matches overall,
+// and returns the first PageSize of them in sequence order. The extra match only tells whether another page exists.
+// The shards are read-locked together, so the page is consistent. Writers lock one shard at a time, so this cannot deadlock.
+FSessionDirectoryPage FSessionDirectory::Query(const FSessionDirectoryQuery& Query) const
+{
+    MULTIPLAYER_TRACE_SCOPE("FSessionDirectory::Query");
+
+    const int32 PageSize = FMath::Max(Query.PageSize, 1);
+
+    // A query for both a match type and a region can only match sessions in one shard.
+    TArray<int32, TInlineAllocator<64>> ShardIndices;
+    if (!Query.MatchType.IsEmpty() && !Query.Region.IsEmpty())
+    {
+        ShardIndices.Add(GetShardIndex(Query.MatchType, Query.Region));
+    }
+    else
+    {
+        for (int32 Index = 0; Index < Shards.Num(); ++Index)
+        {
+            ShardIndices.Add(Index);
+        }
+    }
+
+    for (const int32 ShardIndex : ShardIndices)
+    {
+        Shards[ShardIndex]->Lock.ReadLock();
+    }
+
+    TArray<const FSessionDirectoryEntry*> Candidates;
+    int64 NumScanned = 0;
+    for (const int32 ShardIndex : ShardIndices)
+    {
+        const TArray<FSessionDirectoryEntry>& Entries = Shards[ShardIndex]->Entries;
+        int32 NumFound = 0;
+        for (int32 Index = Algo::UpperBoundBy(Entries, Query.Cursor, &FSessionDirectoryEntry::Sequence); Index < Entries.Num() && NumFound <= PageSize; ++Index)
+        {
+            const FSessionDirectoryEntry& Entry = Entries[Index];
+            NumScanned++;
+            if ((Query.MatchType.IsEmpty() || Entry.MatchType == Query.MatchType)
+                && (Query.Region.IsEmpty() || Entry.Region == Query.Region)
+                && Entry.NumOpenPublicConnections >= Query.MinOpenSlots)
+            {
+                Candidates.Add(&Entry);
+                NumFound++;
+            }
+        }
+    }
+    Algo::SortBy(Candidates, [](const FSessionDirectoryEntry* Entry) { return Entry->Sequence; });
+
+    FSessionDirectoryPage Page;
+    const int32 NumEntries = FMath::Min(Candidates.Num(), PageSize);
+    Page.Entries.Reserve(NumEntries);
+    for (int32 Index = 0; Index < NumEntries; ++Index)
+    {
+        Page.Entries.Add(*Candidates[Index]);
+    }
+    if (Candidates.Num() > PageSize)
+    {
+        Page.NextCursor = Page.Entries.Last().Sequence;
+    }
+
+    for (const int32 ShardIndex : ShardIndices)
+    {
+        Shards[ShardIndex]->Lock.ReadUnlock();
+    }
+
+    Queries++;
+    EntriesScanned += NumScanned;
+    return Page;
+}
+
+// Find looks up the session's location, then copies it from its shard.
+bool FSessionDirectory::Find(const FString& SessionId, FSessionDirectoryEntry& OutEntry) const
+{
+    FRWScopeLock LocationsScope(LocationsLock, SLT_ReadOnly);
+
+    const FLocation* Location = Locations.Find(SessionId);
+    if (!Location)
+    {
+        return false;
+    }
+
+    const FShard& Shard = *Shards[Location->ShardIndex];
+    FRWScopeLock ShardScope(Shard.Lock, SLT_ReadOnly);
+    const int32 Index = Shard.IndexOf(Location->Sequence);
+    if (Index == INDEX_NONE)
+    {
+        return false;
+    }
+    OutEntry = Shard.Entries[Index];
+    return true;
+}
+
+// Num returns the number of registered sessions.
+int32 FSessionDirectory::Num() const
+{
+    FRWScopeLock LocationsScope(LocationsLock, SLT_ReadOnly);
+    return Locations.Num();
+}
+
+// GetStats copies the counters. Counters updated by other threads during the copy may be one batch apart.
+FSessionDirectoryStats FSessionDirectory::GetStats() const
+{
+    FSessionDirectoryStats Stats;
+    Stats.NumSessions = Num();
+    Stats.Registered = Registered;
+    Stats.Updated = Updated;
+    Stats.Removed = Removed;
+    Stats.Expired = Expired;
+    Stats.Heartbeats = Heartbeats;
+    Stats.Batches = Batches;
+    Stats.Queries = Queries;
+    Stats.EntriesScanned = EntriesScanned;
+    return Stats;
+}
+
+/**************
+Private Methods
+**************/
+
+// IndexOf finds a session in the shard by its sequence, or returns INDEX_NONE.
+int32 FSessionDirectory::FShard::IndexOf(uint64 Sequence) const
+{
+    return Algo::BinarySearchBy(Entries, Sequence, &FSessionDirectoryEntry::Sequence);
+}
+
+// GetShardIndex maps a match type and region pair to its shard.
+int32 FSessionDirectory::GetShardIndex(const FString& MatchType, const FString& Region) const
+{
+    return HashCombine(GetTypeHash(MatchType), GetTypeHash(Region)) % static_cast<uint32>(Shards.Num());
+}
+
+// RemoveFromShards deletes sessions by sequence, locking each affected shard once. Called with the locations lock held for writing.
+void FSessionDirectory::RemoveFromShards(const TArray<TArray<uint64>>& SequencesByShard)
+{
+    for (int32 ShardIndex = 0; ShardIndex < Shards.Num(); ++ShardIndex)
+    {
+        if (SequencesByShard[ShardIndex].Num() == 0)
+        {
+            continue;
+        }
+
+        FShard& Shard = *Shards[ShardIndex];
+        FRWScopeLock ShardScope(Shard.Lock, SLT_Write);
+        for (const uint64 Sequence : SequencesByShard[ShardIndex])
+        {
+            const int32 Index = Shard.IndexOf(Sequence);
+            if (Index != INDEX_NONE)
+            {
+                Shard.Entries.RemoveAt(Index, 1, false);
+            }
+        }
+    }
+}
+
+/***************
+Console Commands
+***************/
+
+#if !UE_BUILD_SHIPPING
+// RunDirectoryLoadTest registers sessions with a private directory in batches, then queries it from several threads for a while,
+// following cursors like players scrolling a server browser, while another thread re-registers sessions like live hosts.
+// The game thread waits for the run to finish.
+static void RunDirectoryLoadTest(const TArray<FString>& Args)
+{
+    int32 NumSessions = 5000;
+    int32 NumShards = 16;
+    int32 NumThreads = 4;
+    int32 PageSize = 100;
+    int32 BatchSize = 100;
+    double DurationSeconds = 5.0;
+    for (const FString& Arg : Args)
+    {
+        FString Key;
+        FString Value;
+        if (!Arg.Split(TEXT("="), &Key, &Value))
+        {
+            continue;
+        }
+
+        const int32 Count = FMath::Max(FCString::Atoi(*Value), 1);
+        if (Key == TEXT("Sessions"))
+        {
+            NumSessions = Count;
+        }
+        else if (Key == TEXT("Shards"))
+        {
+            NumShards = Count;
+        }
+        else if (Key == TEXT("Threads"))
+        {
+            NumThreads = Count;
+        }
+        else if (Key == TEXT("PageSize"))
+        {
+            PageSize = Count;
+        }
+        else if (Key == TEXT("BatchSize"))
+        {
+            BatchSize = Count;
+        }
+        else if (Key == TEXT("Seconds"))
+        {
+            DurationSeconds = FMath::Max(FCString::Atod(*Value), 0.1);
+        }
+    }
+
+    const TArray<FString> MatchTypes{ TEXT("FreeForAll"), TEXT("TeamDeathmatch"), TEXT("CaptureTheFlag") };
+    const TArray<FString> Regions{ TEXT("us-east"), TEXT("us-west"), TEXT("eu-west"), TEXT("ap-south") };
+
+    FRandomStream Random(1);
+    TArray<FSessionDirectoryEntry> Entries;
+    Entries.Reserve(NumSessions);
+    for (int32 Index = 0; Index < NumSessions; ++Index)
+    {
+        FSessionDirectoryEntry& Entry = Entries.AddDefaulted_GetRef();
+        Entry.SessionId = FString::Printf(TEXT("LoadTest-%d"), Index);
+        Entry.OwnerName = FString::Printf(TEXT("LoadTestHost%d"), Index);
+        Entry.HostAddress = TEXT("127.0.0.1:7777");
+        Entry.MatchType = MatchTypes[Random.RandRange(0, MatchTypes.Num() - 1)];
+        Entry.Region = Regions[Random.RandRange(0, Regions.Num() - 1)];
+        Entry.NumPublicConnections = 8;
+        Entry.NumOpenPublicConnections = Random.RandRange(0, 8);
+        Entry.BuildUniqueId = 1;
+    }
+
+    FSessionDirectory Directory(NumShards);
+    const double RegisterStartTime = FPlatformTime::Seconds();
+    for (int32 Start = 0; Start < NumSessions; Start += BatchSize)
+    {
+        Directory.Register(TArray<FSessionDirectoryEntry>(Entries.GetData() + Start, FMath::Min(BatchSize, NumSessions - Start)), FPlatformTime::Seconds());
+    }
+    const double RegisterSeconds = FPlatformTime::Seconds() - RegisterStartTime;
+
+    TArray<FLatencyHistogram> Latencies;
+    Latencies.SetNum(NumThreads);
+    std::atomic<int64> NumReregistered{ 0 };
+    const double EndTime = FPlatformTime::Seconds() + DurationSeconds;
+
+    TArray<TFuture<void>> Threads;
+    for (int32 ThreadIndex = 0; ThreadIndex < NumThreads; ++ThreadIndex)
+    {
+        Threads.Add(Async(EAsyncExecution::Thread, [&, ThreadIndex]()
+        {
+            FRandomStream ThreadRandom(ThreadIndex + 1);
+            while (FPlatformTime::Seconds() < EndTime)
+            {
+                // A quarter of queries leave each field unset, so queries spanning every shard are measured too.
+                FSessionDirectoryQuery Query;
+                Query.MatchType = ThreadRandom.RandRange(0, 3) > 0 ? MatchTypes[ThreadRandom.RandRange(0, MatchTypes.Num() - 1)] : FString();
+                Query.Region = ThreadRandom.RandRange(0, 3) > 0 ? Regions[ThreadRandom.RandRange(0, Regions.Num() - 1)] : FString();
+                Query.MinOpenSlots = ThreadRandom.RandRange(0, 2);
+                Query.PageSize = PageSize;
+                for (int32 PageIndex = 0; PageIndex < 3; ++PageIndex)
+                {
+                    const double QueryStartTime = FPlatformTime::Seconds();
+                    const FSessionDirectoryPage Page = Directory.Query(Query);
+                    Latencies[ThreadIndex].Record(FPlatformTime::Seconds() - QueryStartTime);
+                    if (Page.NextCursor == 0)
+                    {
+                        break;
+                    }
+                    Query.Cursor = Page.NextCursor;
+                }
+            }
+        }));
+    }
+    Threads.Add(Async(EAsyncExecution::Thread, [&]()
+    {
+        FRandomStream ThreadRandom(0);
+        while (FPlatformTime::Seconds() < EndTime)
+        {
+            const int32 Start = ThreadRandom.RandRange(0, FMath::Max(NumSessions - BatchSize, 0));
+            TArray<FSessionDirectoryEntry> Batch(Entries.GetData() + Start, FMath::Min(BatchSize, NumSessions - Start));
+            for (FSessionDirectoryEntry& Entry : Batch)
+            {
+                Entry.NumOpenPublicConnections = ThreadRandom.RandRange(0, Entry.NumPublicConnections);
+            }
+            NumReregistered += Batch.Num();
+            Directory.Register(MoveTemp(Batch), FPlatformTime::Seconds());
+            FPlatformProcess::Sleep(0.001f);
+        }
+    }));
+    for (const TFuture<void>& Thread : Threads)
+    {
+        Thread.Wait();
+    }
+
+    FLatencyHistogram Latency;
+    for (const FLatencyHistogram& ThreadLatency : Latencies)
+    {
+        Latency.Merge(ThreadLatency);
+    }
+    const FSessionDirectoryStats Stats = Directory.GetStats();
+    MULTIPLAYER_LOG(Info, TEXT("DirectoryLoadTest: Registered %d sessions in %d shards in %.3fms, in batches of %d"),
+        NumSessions, NumShards, RegisterSeconds * 1e3, BatchSize);
+    MULTIPLAYER_LOG(Info, TEXT("DirectoryLoadTest: %lld queries from %d threads in %.1fs (%.0f queries/s), p50 %.3fms, p95 %.3fms, p99 %.3fms, max %.3fms"),
+        Latency.GetCount(),
+        NumThreads,
+        DurationSeconds,
+        Latency.GetCount() / DurationSeconds,
+        Latency.GetPercentile(50.0) * 1e3,
+        Latency.GetPercentile(95.0) * 1e3,
+        Latency.GetPercentile(99.0) * 1e3,
+        Latency.GetMaxSeconds() * 1e3);
+    MULTIPLAYER_LOG(Info, TEXT("DirectoryLoadTest: %.1f sessions scanned per query, %lld sessions re-registered during the run"),
+        Stats.Queries > 0 ? static_cast<double>(Stats.EntriesScanned) / Stats.Queries : 0.0,
+        NumReregistered.load());
+}
+
+static FAutoConsoleCommand DirectoryLoadTestCommand(
+    TEXT("MultiplayerSessions.DirectoryLoadTest"),
+    TEXT("Measures session directory query throughput and latency under concurrent registration. ")
+    TEXT("Usage: MultiplayerSessions.DirectoryLoadTest [Sessions=5000] [Shards=16] [Threads=4] [PageSize=100] [BatchSize=100] [Seconds=5]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunDirectoryLoadTest)
+);
+#endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+// (c) 2023 Will Roberts
+
+#include "SessionMetrics.h"
+
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+
+/****************
+Latency Histogram
+****************/
+
+// Record converts the duration to microseconds and counts it in its bucket.
+void FLatencyHistogram::Record(double Seconds)
+{
+    const uint64 Microseconds = static_cast<uint64>(FMath::Max(Seconds, 0.0) * 1e6);
+    Buckets[GetBucketIndex(Microseconds)]++;
+    Count++;
+    MinMicroseconds = FMath::Min(MinMicroseconds, Microseconds);
+    MaxMicroseconds = FMath::Max(MaxMicroseconds, Microseconds);
+    TotalMicroseconds += Microseconds;
+}
+
+// Reset discards every sample.
+void FLatencyHistogram::Reset()
+{
+    *this = FLatencyHistogram();
+}
+
+// Merge adds the other histogram's buckets to this one's. Both use the same buckets, so no precision is lost.
+void FLatencyHistogram::Merge(const FLatencyHistogram& Other)
+{
+    for (uint32 Index = 0; Index < NumBuckets; ++Index)
+    {
+        Buckets[Index] += Other.Buckets[Index];
+    }
+    Count += Other.Count;
+    MinMicroseconds = FMath::Min(MinMicroseconds, Other.MinMicroseconds);
+    MaxMicroseconds = FMath::Max(MaxMicroseconds, Other.MaxMicroseconds);
+    TotalMicroseconds += Other.TotalMicroseconds;
+}
+
+// GetPercentile walks the buckets until the requested rank is reached, and returns the midpoint of that bucket.
+// The result is clamped to the recorded range, so p0 and p100 are exact.
+double FLatencyHistogram::GetPercentile(double Percentile) const
+{
+    if (Count == 0)
+    {
+        return 0.0;
+    }
+
+    const int64 Rank = FMath::Clamp<int64>(FMath::CeilToInt64(FMath::Clamp(Percentile, 0.0, 100.0) / 100.0 * Count), 1, Count);
+    int64 Cumulative = 0;
+    for (uint32 Index = 0; Index < NumBuckets; ++Index)
+    {
+        Cumulative += Buckets[Index];
+        if (Cumulative >= Rank)
+        {
+            const uint64 Midpoint = GetBucketLowerBound(Index) + GetBucketWidth(Index) / 2;
+            return FMath::Clamp(Midpoint, MinMicroseconds, MaxMicroseconds) * 1e-6;
+        }
+    }
+    return GetMaxSeconds();
+}
+
+// GetBucketIndex maps small values to their own bucket, and larger values to one of 16 buckets within their power of two.
+uint32 FLatencyHistogram::GetBucketIndex(uint64 Microseconds)
+{
+    Microseconds = FMath::Min(Microseconds, (uint64(1) << MaxExponent) - 1);
+    if (Microseconds < 2 * SubBucketCount)
+    {
+        return static_cast<uint32>(Microseconds);
+    }
+
+    const uint32 Exponent = FPlatformMath::FloorLog2_64(Microseconds);
+    const uint32 Shift = Exponent - SubBucketBits;
+    return Shift * SubBucketCount + static_cast<uint32>(Microseconds >> Shift);
+}
+
+// GetBucketLowerBound returns the smallest value counted in a bucket.
+uint64 FLatencyHistogram::GetBucketLowerBound(uint32 Index)
+{
+    if (Index < 2 * SubBucketCount)
+    {
+        return Index;
+    }
+    const uint32 Shift = Index / SubBucketCount - 1;
+    return static_cast<uint64>(Index % SubBucketCount + SubBucketCount) << Shift;
+}
+
+// GetBucketWidth returns the number of distinct values counted in a bucket.
+uint64 FLatencyHistogram::GetBucketWidth(uint32 Index)
+{
+    if (Index < 2 * SubBucketCount)
+    {
+        return 1;
+    }
+    return uint64(1) << (Index / SubBucketCount - 1);
+}
+
+/*************
+Public Methods
+*************/
+
+// NoteRequested counts a call to the subsystem.
+void FSessionMetrics::NoteRequested(EMultiplayerSessionOperation Operation)
+{
+    Operations[static_cast<int32>(Operation)].Requests++;
+}
+
+// NoteCompleted records the latency of an operation which ran, and counts its result.
+void FSessionMetrics::NoteCompleted(EMultiplayerSessionOperation Operation, double LatencySeconds, bool bSucceeded, const TCHAR* Result)
+{
+    Operations[static_cast<int32>(Operation)].Latency.Record(LatencySeconds);
+    NoteResult(Operation, bSucceeded, Result);
+}
+
+// NoteResult counts a result code.
+void FSessionMetrics::NoteResult(EMultiplayerSessionOperation Operation, bool bSucceeded, const TCHAR* Result)
+{
+    FSessionOperationMetrics& Metrics = Operations[static_cast<int32>(Operation)];
+    (bSucceeded ? Metrics.Succeeded : Metrics.Failed)++;
+    Metrics.Results.FindOrAdd(Result)++;
+}
+
+// Reset discards every count and sample.
+void FSessionMetrics::Reset()
+{
+    for (FSessionOperationMetrics& Metrics : Operations)
+    {
+        Metrics = FSessionOperationMetrics();
+    }
+    GameThreadSeconds = 0.0;
+}
+
+// CountInFlight returns the number of queues running the operation.
+static int32 CountInFlight(const TArray<const FSessionOperationQueue*>& Queues, EMultiplayerSessionOperation Operation)
+{
+    int32 Count = 0;
+    for (const FSessionOperationQueue* Queue : Queues)
+    {
+        Count += Queue->IsInFlight(Operation) ? 1 : 0;
+    }
+    return Count;
+}
+
+// CountQueued returns the number of times the operation waits in any of the queues.
+static int32 CountQueued(const TArray<const FSessionOperationQueue*>& Queues, EMultiplayerSessionOperation Operation)
+{
+    int32 Count = 0;
+    for (const FSessionOperationQueue* Queue : Queues)
+    {
+        Count += Queue->NumQueued(Operation);
+    }
+    return Count;
+}
+
+// ToCsv writes a header row and one row per operation. Result counts are written as "Result=Count" pairs separated by semicolons.
+FString FSessionMetrics::ToCsv(const TArray<const FSessionOperationQueue*>& Queues) const
+{
+    const FString BuildVersion = FApp::GetBuildVersion();
+    const TCHAR* BuildConfiguration = LexToString(FApp::GetBuildConfiguration());
+
+    FString Csv = TEXT("Build,Configuration,Operation,Requests,Succeeded,Failed,InFlight,Queued,Samples,MinMs,MeanMs,P50Ms,P95Ms,P99Ms,MaxMs,Results\n");
+    for (int32 Index = 0; Index < NumMultiplayerSessionOperations; ++Index)
+    {
+        const EMultiplayerSessionOperation Operation = static_cast<EMultiplayerSessionOperation>(Index);
+        const FSessionOperationMetrics& Metrics = Operations[Index];
+
+        TArray<FString> Results;
+        for (const TPair<FString, int64>& Result : Metrics.Results)
+        {
+            Results.Add(FString::Printf(TEXT("%s=%lld"), *Result.Key, Result.Value));
+        }
+
+        Csv += FString::Printf(
+            TEXT("%s,%s,%s,%lld,%lld,%lld,%d,%d,%lld,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%s\n"),
+            *BuildVersion,
+            BuildConfiguration,
+            LexToString(Operation),
+            Metrics.Requests,
+            Metrics.Succeeded,
+            Metrics.Failed,
+            CountInFlight(Queues, Operation),
+            CountQueued(Queues, Operation),
+            Metrics.Latency.GetCount(),
+            Metrics.Latency.GetMinSeconds() * 1e3,
+            Metrics.Latency.GetMeanSeconds() * 1e3,
+            Metrics.Latency.GetPercentile(50.0) * 1e3,
+            Metrics.Latency.GetPercentile(95.0) * 1e3,
+            Metrics.Latency.GetPercentile(99.0) * 1e3,
+            Metrics.Latency.GetMaxSeconds() * 1e3,
+            *FString::Join(Results, TEXT(";"))
+        );
+    }
+    return Csv;
+}
+
+// ToJson writes the build, a timestamp, and an object per operation. Latencies are in milliseconds.
+FString FSessionMetrics::ToJson(const TArray<const FSessionOperationQueue*>& Queues) const
+{
+    FString Json = FString::Printf(
+        TEXT("{\n  \"build\": \"%s\",\n  \"configuration\": \"%s\",\n  \"timestamp\": \"%s\",\n  \"operations\": {\n"),
+        *FString(FApp::GetBuildVersion()).ReplaceCharWithEscapedChar(),
+        LexToString(FApp::GetBuildConfiguration()),
+        *FDateTime::UtcNow().ToIso8601()
+    );
+    for (int32 Index = 0; Index < NumMultiplayerSessionOperations; ++Index)
+    {
+        const EMultiplayerSessionOperation Operation = static_cast<EMultiplayerSessionOperation>(Index);
+        const FSessionOperationMetrics& Metrics = Operations[Index];
+
+        TArray<FString> Results;
+        for (const TPair<FString, int64>& Result : Metrics.Results)
+        {
+            Results.Add(FString::Printf(TEXT("\"%s\": %lld"), *Result.Key, Result.Value));
+        }
+
+        Json += FString::Printf(
+            TEXT("    \"%s\": { \"requests\": %lld, \"succeeded\": %lld, \"failed\": %lld, \"inFlight\": %d, \"queued\": %d, ")
+            TEXT("\"latencyMs\": { \"samples\": %lld, \"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f }, ")
+            TEXT("\"results\": { %s } }%s\n"),
+            LexToString(Operation),
+            Metrics.Requests,
+            Metrics.Succeeded,
+            Metrics.Failed,
+            CountInFlight(Queues, Operation),
+            CountQueued(Queues, Operation),
+            Metrics.Latency.GetCount(),
+            Metrics.Latency.GetMinSeconds() * 1e3,
+            Metrics.Latency.GetMeanSeconds() * 1e3,
+            Metrics.Latency.GetPercentile(50.0) * 1e3,
+            Metrics.Latency.GetPercentile(95.0) * 1e3,
+            Metrics.Latency.GetPercentile(99.0) * 1e3,
+            Metrics.Latency.GetMaxSeconds() * 1e3,
+            *FString::Join(Results, TEXT(", ")),
+            Index + 1 < NumMultiplayerSessionOperations ? TEXT(",") : TEXT("")
+        );
+    }
+    Json += FString::Printf(TEXT("  },\n  \"gameThreadMs\": %.3f\n}\n"), GameThreadSeconds * 1e3);
+    return Json;
+}
+
+// ToSummary writes each operation's counts, gauges and latency percentiles on one line.
+TArray<FString> FSessionMetrics::ToSummary(const TArray<const FSessionOperationQueue*>& Queues) const
+{
+    TArray<FString> Lines;
+    for (int32 Index = 0; Index < NumMultiplayerSessionOperations; ++Index)
+    {
+        const EMultiplayerSessionOperation Operation = static_cast<EMultiplayerSessionOperation>(Index);
+        const FSessionOperationMetrics& Metrics = Operations[Index];
+
+        TArray<FString> Results;
+        for (const TPair<FString, int64>& Result : Metrics.Results)
+        {
+            Results.Add(FString::Printf(TEXT("%s=%lld"), *Result.Key, Result.Value));
+        }
+
+        Lines.Add(FString::Printf(
+            TEXT("%s: %lld requests, %lld succeeded, %lld failed, %d in flight, %d queued, p50 %.1fms, p95 %.1fms, p99 %.1fms [%s]"),
+            LexToString(Operation),
+            Metrics.Requests,
+            Metrics.Succeeded,
+            Metrics.Failed,
+            CountInFlight(Queues, Operation),
+            CountQueued(Queues, Operation),
+            Metrics.Latency.GetPercentile(50.0) * 1e3,
+            Metrics.Latency.GetPercentile(95.0) * 1e3,
+            Metrics.Latency.GetPercentile(99.0) * 1e3,
+            *FString::Join(Results, TEXT(", "))
+        ));
+    }
+    Lines.Add(FString::Printf(TEXT("Game thread: %.3fms inside the subsystem"), GameThreadSeconds * 1e3));
+    return Lines;
+}
+
+/*****************
+Game Thread Scopes
+*****************/
+
+// FGameThreadScope starts timing when it is the outermost scope.
+FSessionMetrics::FGameThreadScope::FGameThreadScope(FSessionMetrics& InMetrics):
+    Metrics(InMetrics)
+{
+    if (Metrics.GameThreadScopeDepth++ == 0)
+    {
+        StartTime = FPlatformTime::Seconds();
+    }
+}
+
+// ~FGameThreadScope adds the elapsed time when it is the outermost scope.
+FSessionMetrics::FGameThreadScope::~FGameThreadScope()
+{
+    if (--Metrics.GameThreadScopeDepth == 0)
+    {
+        Metrics.GameThreadSeconds += FPlatformTime::Seconds() - StartTime;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+// (c) 2023 Will Roberts
+
+#include "SessionOperationQueue.h"
+#include "MultiplayerSessionsTrace.h"
+
+// LexToString returns the name of an operation, for logging.
+const TCHAR* LexToString(EMultiplayerSessionOperation Operation)
+{
+    switch (Operation)
+    {
+    case EMultiplayerSessionOperation::Create: return TEXT("Create");
+    case EMultiplayerSessionOperation::Find: return TEXT("Find");
+    case EMultiplayerSessionOperation::Join: return TEXT("Join");
+    case EMultiplayerSessionOperation::Destroy: return TEXT("Destroy");
+    case EMultiplayerSessionOperation::Start: return TEXT("Start");
+    case EMultiplayerSessionOperation::FindPage: return TEXT("FindPage");
+    case EMultiplayerSessionOperation::Update: return TEXT("Update");
+    default: return TEXT("Unknown");
+    }
+}
+
+/*************
+Public Methods
+*************/
+
+// Enqueue appends an operation to the queue, and opens its queued region.
+void FSessionOperationQueue::Enqueue(EMultiplayerSessionOperation Operation, TUniqueFunction<void()> Execute)
+{
+    const uint32 Serial = ++NextSerial;
+    FString RegionName = GetTraceRegionName(Operation, Serial, true);
+    TRACE_BEGIN_REGION(*RegionName);
+    Queued.Add(FQueuedOperation{ Operation, MoveTemp(Execute), FPlatformTime::Seconds(), Serial, MoveTemp(RegionName) });
+    StartNext();
+}
+
+// Complete clears the in-flight operation if it matches, and closes its region.
+void FSessionOperationQueue::Complete(EMultiplayerSessionOperation Operation)
+{
+    if (!IsInFlight(Operation))
+    {
+        return;
+    }
+    TRACE_END_REGION(*InFlightRegionName);
+    InFlight.Reset();
+    InFlightRegionName.Reset();
+    StartNext();
+}
+
+// CancelQueued empties the queue. The in-flight operation is not affected.
+TArray<EMultiplayerSessionOperation> FSessionOperationQueue::CancelQueued()
+{
+    TArray<EMultiplayerSessionOperation> Cancelled;
+    for (const FQueuedOperation& QueuedOperation : Queued)
+    {
+        TRACE_END_REGION(*QueuedOperation.RegionName);
+        Cancelled.Add(QueuedOperation.Operation);
+    }
+    Stats.Cancelled += Queued.Num();
+    Queued.Reset();
+    return Cancelled;
+}
+
+// Tick checks the in-flight operation against the timeout.
+void FSessionOperationQueue::Tick(double Now, double TimeoutSeconds)
+{
+    if (!InFlight.IsSet() || TimeoutSeconds <= 0.0 || Now - InFlightStartTime < TimeoutSeconds)
+    {
+        return;
+    }
+
+    // The handler is expected to complete the operation, or to restart its timeout if it moves on to another attempt.
+    Stats.TimedOut++;
+    const EMultiplayerSessionOperation TimedOutOperation = InFlight.GetValue();
+    if (OnTimedOut.IsBound())
+    {
+        OnTimedOut.Execute(TimedOutOperation);
+        return;
+    }
+    Complete(TimedOutOperation);
+}
+
+// RestartTimeout resets the in-flight operation's start time.
+void FSessionOperationQueue::RestartTimeout()
+{
+    InFlightStartTime = FPlatformTime::Seconds();
+}
+
+// IsQueued returns 'true' if an operation of this type is waiting to start.
+bool FSessionOperationQueue::IsQueued(EMultiplayerSessionOperation Operation) const
+{
+    return Queued.ContainsByPredicate([Operation](const FQueuedOperation& QueuedOperation) { return QueuedOperation.Operation == Operation; });
+}
+
+// NumQueued returns the number of operations of this type waiting to start.
+int32 FSessionOperationQueue::NumQueued(EMultiplayerSessionOperation Operation) const
+{
+    int32 Num = 0;
+    for (const FQueuedOperation& QueuedOperation : Queued)
+    {
+        Num += QueuedOperation.Operation == Operation ? 1 : 0;
+    }
+    return Num;
+}
+
+// IsInFlight returns 'true' if an operation of this type has started and not completed.
+bool FSessionOperationQueue::IsInFlight(EMultiplayerSessionOperation Operation) const
+{
+    return InFlight.IsSet() && InFlight.GetValue() == Operation;
+}
+
+/**************
+Private Methods
+**************/
+
+// StartNext starts queued operations until one is left in flight.
+// Operations which complete synchronously are handled by the loop, rather than by recursion.
+void FSessionOperationQueue::StartNext()
+{
+    if (bIsStartingNext)
+    {
+        return;
+    }
+    TGuardValue<bool> StartingGuard(bIsStartingNext, true);
+
+    while (!InFlight.IsSet() && Queued.Num() > 0)
+    {
+        FQueuedOperation Next = MoveTemp(Queued[0]);
+        Queued.RemoveAt(0);
+
+        TRACE_END_REGION(*Next.RegionName);
+        InFlightRegionName = GetTraceRegionName(Next.Operation, Next.Serial, false);
+        TRACE_BEGIN_REGION(*InFlightRegionName);
+
+        InFlight = Next.Operation;
+        InFlightStartTime = FPlatformTime::Seconds();
+        InFlightRequestTime = Next.RequestTime;
+        Stats.Started++;
+        Next.Execute();
+    }
+}
+
+// GetTraceRegionName returns the Insights region which spans an operation while it waits in the queue, or while it runs.
+// Regions are matched by name, and several sessions and queued pages can be open at once,
+// so names include the queue's name and the operation's serial to keep them unique.
+FString FSessionOperationQueue::GetTraceRegionName(EMultiplayerSessionOperation Operation, uint32 Serial, bool bQueued) const
+{
+    return FString::Printf(TEXT("MultiplayerSessions %s%s %s #%u"), LexToString(Operation), bQueued ? TEXT(" (Queued)") : TEXT(""), *Name, Serial);
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+// (c) 2023 Will Roberts
+
+#include "SessionScorer.h"
+#include "OnlineSessionSettings.h"
+#include "SessionSearchIndex.h"
+
+#include "Async/ParallelFor.h"
+
+/*************
+Public Methods
+*************/
+
+// Score computes each result's cost in two passes over contiguous chunks.
+// The first pass reads only the index's integer arrays, and is simple enough for the compiler to vectorize.
+// The second pass looks up preferred settings on the results themselves, and only runs when preferred settings are set.
+void FSessionScorer::Score(const FSessionSearchIndex& Index, const FMultiplayerSessionScoringWeights& Weights, TArray<float>& OutCosts)
+{
+    const int32 NumResults = Index.Num();
+    OutCosts.SetNumUninitialized(NumResults);
+
+    const int32* Pings = Index.GetPings().GetData();
+    const int32* OpenSlots = Index.GetOpenSlots().GetData();
+    const int32* TotalSlots = Index.GetTotalSlots().GetData();
+    const int32* RegionIds = Index.GetRegionIds().GetData();
+    float* Costs = OutCosts.GetData();
+
+    // A preferred region which no result advertises is a mismatch for every result.
+    const bool bUseRegion = !Weights.PreferredRegion.IsEmpty();
+    const int32 PreferredRegionId = bUseRegion ? Index.FindRegionId(Weights.PreferredRegion) : INDEX_NONE;
+
+    TArray<TPair<FName, FVariantData>> PreferredSettings;
+    PreferredSettings.Reserve(Weights.PreferredSettings.Num());
+    for (const TPair<FName, FString>& Setting : Weights.PreferredSettings)
+    {
+        PreferredSettings.Emplace(Setting.Key, FVariantData(Setting.Value));
+    }
+
+    auto ScoreChunk = [&](int32 ChunkIndex)
+    {
+        const int32 Start = ChunkIndex * ChunkSize;
+        const int32 End = FMath::Min(Start + ChunkSize, NumResults);
+
+        for (int32 I = Start; I < End; ++I)
+        {
+            const float Emptiness = static_cast<float>(OpenSlots[I]) / static_cast<float>(FMath::Max(TotalSlots[I], 1));
+            const float RegionCost = (bUseRegion && RegionIds[I] != PreferredRegionId) ? Weights.RegionMismatchCost : 0.f;
+            const float Cost = Weights.PingWeight * static_cast<float>(Pings[I]) + Weights.EmptinessWeight * Emptiness + RegionCost;
+            Costs[I] = OpenSlots[I] > 0 ? Cost : MAX_flt;
+        }
+
+        for (int32 I = Start; I < End && PreferredSettings.Num() > 0; ++I)
+        {
+            if (Costs[I] == MAX_flt)
+            {
+                continue;
+            }
+            const FSessionSettings& Settings = Index.GetResult(I).Session.SessionSettings.Settings;
+            for (const TPair<FName, FVariantData>& Preferred : PreferredSettings)
+            {
+                const FOnlineSessionSetting* Setting = Settings.Find(Preferred.Key);
+                if (!Setting || !(Setting->Data == Preferred.Value))
+                {
+                    Costs[I] += Weights.PreferredSettingMismatchCost;
+                }
+            }
+        }
+    };
+
+    const int32 NumChunks = FMath::DivideAndRoundUp(NumResults, ChunkSize);
+    ParallelFor(NumChunks, ScoreChunk, NumResults < ParallelThreshold ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+// RankBest selects the cheapest results with a bounded max-heap, so only Count indices are ever kept.
+// Equal costs are ordered by index, so ties keep the order of the search results whatever order the candidates are in.
+void FSessionScorer::RankBest(
+    const FSessionSearchIndex& Index,
+    const FMultiplayerSessionScoringWeights& Weights,
+    int32 Count,
+    TArray<int32>& OutIndices,
+    const TArray<int32>* Candidates
+) {
+    OutIndices.Reset();
+    if (Count <= 0 || Index.Num() == 0)
+    {
+        return;
+    }
+
+    TArray<float> Costs;
+    Score(Index, Weights, Costs);
+
+    // The heap's root is the most expensive of the kept results, so it is the one to replace.
+    auto Cheaper = [&Costs](int32 A, int32 B) { return Costs[A] < Costs[B] || (Costs[A] == Costs[B] && A < B); };
+    auto MoreExpensive = [&Cheaper](int32 A, int32 B) { return Cheaper(B, A); };
+    auto Consider = [&](int32 I)
+    {
+        if (Costs[I] == MAX_flt)
+        {
+            return;
+        }
+        if (OutIndices.Num() < Count)
+        {
+            OutIndices.HeapPush(I, MoreExpensive);
+        }
+        else if (Cheaper(I, OutIndices.HeapTop()))
+        {
+            OutIndices.HeapPopDiscard(MoreExpensive, false);
+            OutIndices.HeapPush(I, MoreExpensive);
+        }
+    };
+
+    OutIndices.Reserve(Count);
+    if (Candidates)
+    {
+        for (const int32 I : *Candidates)
+        {
+            Consider(I);
+        }
+    }
+    else
+    {
+        for (int32 I = 0; I < Costs.Num(); ++I)
+        {
+            Consider(I);
+        }
+    }
+
+    OutIndices.Sort(Cheaper);
+}
@@ -0,0 +1,94 @@
+// (c) 2023 Will Roberts
+
+#include "SessionSearchCache.h"
+#include "OnlineSessionSettings.h"
+
+/*************
+Public Methods
+*************/
+
+// Lookup returns Fresh for entries within the TTL, Stale for expired entries which may still be served, and Miss otherwise.
+// An entry which can no longer be served is removed. Counters are updated for every lookup.
+FSessionSearchCache::ELookupResult FSessionSearchCache::Lookup(
+    const FSessionSearchCacheKey& Key,
+    double Now,
+    TSharedPtr<FOnlineSessionSearch>& OutSearch
+)
+{
+    const FEntry* Entry = Entries.Find(Key);
+    if (!Entry || !Entry->Search.IsValid())
+    {
+        Stats.Misses++;
+        return ELookupResult::Miss;
+    }
+
+    const double Age = Now - Entry->StoredAt;
+    if (Age <= TTLSeconds)
+    {
+        Stats.Hits++;
+        OutSearch = Entry->Search;
+        return ELookupResult::Fresh;
+    }
+
+    if (bStaleWhileRevalidate && Age <= MaxStaleSeconds)
+    {
+        Stats.StaleHits++;
+        OutSearch = Entry->Search;
+        return ELookupResult::Stale;
+    }
+
+    Entries.Remove(Key);
+    Stats.Evictions++;
+    Stats.Misses++;
+    return ELookupResult::Miss;
+}
+
+// Store saves a completed search under its key. The cache holds few entries, so expired ones are swept on every store,
+// and the oldest entry is found by a linear scan when a new key would exceed MaxEntries.
+void FSessionSearchCache::Store(const FSessionSearchCacheKey& Key, const TSharedRef<FOnlineSessionSearch>& Search, double Now)
+{
+    const double MaxAge = GetMaxAge();
+    for (auto It = Entries.CreateIterator(); It; ++It)
+    {
+        if (Now - It.Value().StoredAt > MaxAge)
+        {
+            It.RemoveCurrent();
+            Stats.Evictions++;
+        }
+    }
+
+    if (Entries.Num() >= MaxEntries && !Entries.Contains(Key))
+    {
+        FSessionSearchCacheKey OldestKey;
+        double OldestStoredAt = TNumericLimits<double>::Max();
+        for (const TPair<FSessionSearchCacheKey, FEntry>& Pair : Entries)
+        {
+            if (Pair.Value.StoredAt < OldestStoredAt)
+            {
+                OldestKey = Pair.Key;
+                OldestStoredAt = Pair.Value.StoredAt;
+            }
+        }
+        Entries.Remove(OldestKey);
+        Stats.Evictions++;
+    }
+
+    FEntry& Entry = Entries.FindOrAdd(Key);
+    Entry.Search = Search;
+    Entry.StoredAt = Now;
+}
+
+// Invalidate drops every saved search. Counters are preserved.
+void FSessionSearchCache::Invalidate()
+{
+    Entries.Reset();
+}
+
+// SetLifetimes applies the TTL settings. Entries are fresh for the TTL, and with stale-while-revalidate they are served stale
+// until MaxStaleSeconds after they were stored. MaxStaleSeconds is raised to the TTL when it is shorter.
+void FSessionSearchCache::SetLifetimes(double InTTLSeconds, double InMaxStaleSeconds, bool bInStaleWhileRevalidate)
+{
+    TTLSeconds = FMath::Max(InTTLSeconds, 0.0);
+    MaxStaleSeconds = FMath::Max(InMaxStaleSeconds, TTLSeconds);
+    bStaleWhileRevalidate = bInStaleWhileRevalidate;
+}
@@ -0,0 +1,121 @@
+// (c) 2023 Will Roberts
+
+#include "SessionSearchFilter.h"
+#include "OnlineSessionSettings.h"
+
+/**************************************
+FMultiplayerSessionSearchFilter Methods
+**************************************/
+
+// ApplyToQuerySettings maps each set field onto a query setting.
+// BuildId is not pushed, since providers filter builds using their own app or bucket IDs.
+void FMultiplayerSessionSearchFilter::ApplyToQuerySettings(FOnlineSearchSettings& QuerySettings) const
+{
+    if (!MatchType.IsEmpty())
+    {
+        QuerySettings.Set(FName("MatchType"), MatchType, EOnlineComparisonOp::Equals);
+    }
+    if (!Region.IsEmpty())
+    {
+        QuerySettings.Set(FName("Region"), Region, EOnlineComparisonOp::Equals);
+    }
+    if (MinOpenSlots > 0)
+    {
+        QuerySettings.Set(SEARCH_MINSLOTSAVAILABLE, MinOpenSlots, EOnlineComparisonOp::GreaterThanEquals);
+    }
+    for (const TPair<FName, FString>& Setting : CustomSettings)
+    {
+        QuerySettings.Set(Setting.Key, Setting.Value, EOnlineComparisonOp::Equals);
+    }
+}
+
+// SupportsQueryFilters reports whether a provider applies query settings to its results.
+// The NULL subsystem answers LAN beacons from every host, so its results must be filtered locally.
+bool FMultiplayerSessionSearchFilter::SupportsQueryFilters(FName SubsystemName)
+{
+    return SubsystemName != FName("NULL");
+}
+
+/**********************************
+FSessionSearchFilterMatcher Methods
+**********************************/
+
+// FSessionSearchFilterMatcher prepares the filter's values for comparison against advertised settings.
+FSessionSearchFilterMatcher::FSessionSearchFilterMatcher(const FMultiplayerSessionSearchFilter& Filter):
+    MinOpenSlots(Filter.MinOpenSlots),
+    BuildId(Filter.BuildId)
+{
+    if (!Filter.MatchType.IsEmpty())
+    {
+        RequiredSettings.Emplace(FName("MatchType"), FVariantData(Filter.MatchType));
+    }
+    if (!Filter.Region.IsEmpty())
+    {
+        RequiredSettings.Emplace(FName("Region"), FVariantData(Filter.Region));
+    }
+    for (const TPair<FName, FString>& Setting : Filter.CustomSettings)
+    {
+        RequiredSettings.Emplace(Setting.Key, FVariantData(Setting.Value));
+    }
+}
+
+// Matches returns 'true' when a result satisfies every field of the filter.
+bool FSessionSearchFilterMatcher::Matches(const FOnlineSessionSearchResult& Result) const
+{
+    const FOnlineSessionSettings& Settings = Result.Session.SessionSettings;
+    if (Result.Session.NumOpenPublicConnections < MinOpenSlots)
+    {
+        return false;
+    }
+    if (BuildId != INDEX_NONE && Settings.BuildUniqueId != BuildId)
+    {
+        return false;
+    }
+
+    for (const TPair<FName, FVariantData>& Required : RequiredSettings)
+    {
+        const FOnlineSessionSetting* Setting = Settings.Settings.Find(Required.Key);
+        if (!Setting || !(Setting->Data == Required.Value))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// RemoveNonMatching moves matching results down over rejected ones, then truncates the array.
+int32 FSessionSearchFilterMatcher::RemoveNonMatching(TArray<FOnlineSessionSearchResult>& Results, int32 StartIndex) const
+{
+    int32 WriteIndex = StartIndex;
+    for (int32 ReadIndex = StartIndex; ReadIndex < Results.Num(); ++ReadIndex)
+    {
+        if (!Matches(Results[ReadIndex]))
+        {
+            continue;
+        }
+        if (WriteIndex != ReadIndex)
+        {
+            Results[WriteIndex] = MoveTemp(Results[ReadIndex]);
+        }
+        WriteIndex++;
+    }
+
+    const int32 NumRemoved = Results.Num() - WriteIndex;
+    Results.SetNum(WriteIndex, false);
+    return NumRemoved;
+}
+
+// EstimateResultBytes adds the size of each advertised setting to the size of the result itself.
+int64 FSessionSearchFilterMatcher::EstimateResultBytes(const FOnlineSessionSearchResult& Result)
+{
+    int64 Bytes = sizeof(FOnlineSessionSearchResult);
+    for (const TPair<FName, FOnlineSessionSetting>& Setting : Result.Session.SessionSettings.Settings)
+    {
+        Bytes += sizeof(Setting);
+        if (Setting.Value.Data.GetType() == EOnlineKeyValuePairDataType::String)
+        {
+            Bytes += Setting.Value.Data.ToString().Len() * sizeof(TCHAR);
+        }
+    }
+    return Bytes;
+}
@@ -0,0 +1,129 @@
+// (c) 2023 Will Roberts
+
+#include "SessionSearchIndex.h"
+#include "OnlineSessionSettings.h"
+
+/*************
+Public Methods
+*************/
+
+// Build fills the per-result field arrays from a search's results.
+// Results without a MatchType or Region setting are given the ID INDEX_NONE.
+void FSessionSearchIndex::Build(const TSharedRef<FOnlineSessionSearch>& InSearch)
+{
+    Reset();
+    Search = InSearch;
+
+    const TArray<FOnlineSessionSearchResult>& Results = InSearch->SearchResults;
+    MatchTypeIds.Reserve(Results.Num());
+    RegionIds.Reserve(Results.Num());
+    OpenSlots.Reserve(Results.Num());
+    TotalSlots.Reserve(Results.Num());
+    Pings.Reserve(Results.Num());
+    BuildIds.Reserve(Results.Num());
+
+    for (const FOnlineSessionSearchResult& Result : Results)
+    {
+        MatchTypeIds.Add(InternValue(MatchTypeValues, Result, FName("MatchType")));
+        RegionIds.Add(InternValue(RegionValues, Result, FName("Region")));
+        OpenSlots.Add(Result.Session.NumOpenPublicConnections);
+        TotalSlots.Add(Result.Session.SessionSettings.NumPublicConnections);
+        Pings.Add(Result.PingInMs);
+        BuildIds.Add(Result.Session.SessionSettings.BuildUniqueId);
+    }
+}
+
+// Reset empties the index and releases its reference to the indexed search.
+// Array allocations are kept so the next Build does not need to reallocate.
+void FSessionSearchIndex::Reset()
+{
+    Search.Reset();
+    MatchTypeValues.Reset();
+    RegionValues.Reset();
+    MatchTypeIds.Reset();
+    RegionIds.Reset();
+    OpenSlots.Reset();
+    TotalSlots.Reset();
+    Pings.Reset();
+    BuildIds.Reset();
+}
+
+// GetResult returns the indexed search result at Index.
+const FOnlineSessionSearchResult& FSessionSearchIndex::GetResult(int32 Index) const
+{
+    check(Search.IsValid());
+    return Search->SearchResults[Index];
+}
+
+// FindMatchTypeId looks up a MatchType among the distinct values seen while building.
+int32 FSessionSearchIndex::FindMatchTypeId(const FString& MatchType) const
+{
+    return FindValueId(MatchTypeValues, MatchType);
+}
+
+// FindRegionId looks up a Region among the distinct values seen while building.
+int32 FSessionSearchIndex::FindRegionId(const FString& Region) const
+{
+    return FindValueId(RegionValues, Region);
+}
+
+// FindFirst scans the field arrays for the first matching result.
+int32 FSessionSearchIndex::FindFirst(int32 MatchTypeId, int32 MinOpenSlots) const
+{
+    for (int32 Index = 0; Index < MatchTypeIds.Num(); ++Index)
+    {
+        if ((MatchTypeId == INDEX_NONE || MatchTypeIds[Index] == MatchTypeId) && OpenSlots[Index] >= MinOpenSlots)
+        {
+            return Index;
+        }
+    }
+    return INDEX_NONE;
+}
+
+// FindAll scans the field arrays for every matching result.
+void FSessionSearchIndex::FindAll(int32 MatchTypeId, int32 MinOpenSlots, TArray<int32>& OutIndices) const
+{
+    for (int32 Index = 0; Index < MatchTypeIds.Num(); ++Index)
+    {
+        if ((MatchTypeId == INDEX_NONE || MatchTypeIds[Index] == MatchTypeId) && OpenSlots[Index] >= MinOpenSlots)
+        {
+            OutIndices.Add(Index);
+        }
+    }
+}
+
+// ResultHasMatchType compares variant data directly, which avoids copying the setting into a new FString.
+bool FSessionSearchIndex::ResultHasMatchType(const FOnlineSessionSearchResult& Result, const FVariantData& MatchType)
+{
+    const FOnlineSessionSetting* MatchTypeSetting = Result.Session.SessionSettings.Settings.Find(FName("MatchType"));
+    return MatchTypeSetting && MatchTypeSetting->Data == MatchType;
+}
+
+/**************
+Private Methods
+**************/
+
+// InternValue returns the ID of a result's setting, adding the setting's value to the table if it has not been seen.
+// Searches return few distinct values, so a linear scan is cheaper than hashing each value.
+int32 FSessionSearchIndex::InternValue(TArray<FVariantData>& Values, const FOnlineSessionSearchResult& Result, FName Key)
+{
+    const FOnlineSessionSetting* Setting = Result.Session.SessionSettings.Settings.Find(Key);
+    if (!Setting)
+    {
+        return INDEX_NONE;
+    }
+
+    const int32 ExistingId = Values.IndexOfByPredicate([Setting](const FVariantData& Value) { return Value == Setting->Data; });
+    if (ExistingId != INDEX_NONE)
+    {
+        return ExistingId;
+    }
+    return Values.Add(Setting->Data);
+}
+
+// FindValueId returns the position of a string value in a table, or INDEX_NONE.
+int32 FSessionSearchIndex::FindValueId(const TArray<FVariantData>& Values, const FString& Value)
+{
+    const FVariantData Wanted(Value);
+    return Values.IndexOfByPredicate([&Wanted](const FVariantData& Existing) { return Existing == Wanted; });
+}
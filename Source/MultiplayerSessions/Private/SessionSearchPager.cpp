@@ -0,0 +1,565 @@
+// (c) 2023 Will Roberts
+
+#include "SessionSearchPager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "OnlineSessionSettings.h"
+
+#include "Logger.h"
+#include "DirectorySessionBackend.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTrace.h"
+
+/*************
+Public Methods
+*************/
+
+// FSessionSearchPager starts with the first page's cursor, which is always zero.
+FSessionSearchPager::FSessionSearchPager(
+    UMultiplayerSessionsSubsystem* InSubsystem,
+    const FMultiplayerSessionSearchFilter& InFilter,
+    int32 InPageSize,
+    int64 InMaxRetainedBytes
+):
+    Subsystem(InSubsystem),
+    Filter(InFilter)
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    PageSize = InPageSize > 0 ? InPageSize : FMath::Max(Settings->SearchPageSize, 1);
+    MaxRetainedBytes = InMaxRetainedBytes > 0 ? InMaxRetainedBytes : static_cast<int64>(FMath::Max(Settings->SearchPageMaxRetainedKB, 1)) * 1024;
+    PageCursors.Add(0);
+}
+
+// ~FSessionSearchPager fulfills pending requests, since their fetches will complete after the pager is gone.
+FSessionSearchPager::~FSessionSearchPager()
+{
+    FailPendingRequests();
+}
+
+// GetPageAsync serves retained pages immediately, and otherwise fetches the page from its cursor.
+// Requests for a page which is already being fetched wait for that fetch.
+TFuture<TSharedPtr<FOnlineSessionSearch>> FSessionSearchPager::GetPageAsync(int32 PageIndex)
+{
+    MULTIPLAYER_TRACE_SCOPE("FSessionSearchPager::GetPageAsync");
+
+    if (TSharedPtr<FOnlineSessionSearch> Retained = GetRetainedPage(PageIndex))
+    {
+        Stats.PagesServedFromMemory++;
+        return MakeFulfilledPromise<TSharedPtr<FOnlineSessionSearch>>(MoveTemp(Retained)).GetFuture();
+    }
+
+    UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get();
+    if (!Sessions || !PageCursors.IsValidIndex(PageIndex))
+    {
+        return MakeFulfilledPromise<TSharedPtr<FOnlineSessionSearch>>(nullptr).GetFuture();
+    }
+
+    const bool bIsFetching = PendingRequests.Contains(PageIndex);
+    TFuture<TSharedPtr<FOnlineSessionSearch>> Future = PendingRequests.FindOrAdd(PageIndex).Emplace_GetRef().GetFuture();
+    if (!bIsFetching)
+    {
+        TWeakPtr<FSessionSearchPager> WeakThis = AsShared();
+        Sessions->FindSessionsPageAsync(Filter, PageSize, PageCursors[PageIndex]).Next(
+            [WeakThis, PageIndex, FetchGeneration = Generation](const FMultiplayerSessionsPage& Page)
+            {
+                if (TSharedPtr<FSessionSearchPager> Pager = WeakThis.Pin())
+                {
+                    Pager->OnPageFetched(PageIndex, FetchGeneration, Page);
+                }
+            });
+    }
+    return Future;
+}
+
+// GetRetainedPage marks a retained page as used, so it is evicted last.
+TSharedPtr<FOnlineSessionSearch> FSessionSearchPager::GetRetainedPage(int32 PageIndex)
+{
+    FRetainedPage* Retained = RetainedPages.Find(PageIndex);
+    if (!Retained)
+    {
+        return nullptr;
+    }
+    Retained->LastUsed = ++UseCount;
+    return Retained->Search;
+}
+
+// Reset keeps the fetch and eviction counts, so they cover every refresh.
+void FSessionSearchPager::Reset()
+{
+    Generation++;
+    FailPendingRequests();
+    RetainedPages.Reset();
+    PageCursors.Reset();
+    PageCursors.Add(0);
+    FetchedPages.Reset();
+    bReachedLastPage = false;
+    Stats.RetainedBytes = 0;
+    Stats.RetainedResults = 0;
+}
+
+/**************
+Private Methods
+**************/
+
+// OnPageFetched retains a fetched page, learns the next page's cursor, and fulfills the requests waiting for it.
+// Pages fetched before a Reset are dropped, since their cursors may no longer be valid.
+void FSessionSearchPager::OnPageFetched(int32 PageIndex, uint32 FetchGeneration, const FMultiplayerSessionsPage& Page)
+{
+    MULTIPLAYER_TRACE_SCOPE("FSessionSearchPager::OnPageFetched");
+
+    if (FetchGeneration != Generation)
+    {
+        return;
+    }
+
+    TArray<TPromise<TSharedPtr<FOnlineSessionSearch>>> Waiting;
+    if (TArray<TPromise<TSharedPtr<FOnlineSessionSearch>>>* Found = PendingRequests.Find(PageIndex))
+    {
+        Waiting = MoveTemp(*Found);
+        PendingRequests.Remove(PageIndex);
+    }
+
+    TSharedPtr<FOnlineSessionSearch> Search;
+    if (Page.bWasSuccessful && Page.Search.IsValid())
+    {
+        Search = Page.Search;
+        Stats.PagesFetched++;
+        if (PageIndex >= FetchedPages.Num())
+        {
+            FetchedPages.Add(false, PageIndex + 1 - FetchedPages.Num());
+        }
+        if (FetchedPages[PageIndex])
+        {
+            Stats.PagesRefetched++;
+        }
+        FetchedPages[PageIndex] = true;
+
+        if (PageIndex + 1 == PageCursors.Num())
+        {
+            if (Page.NextCursor != 0)
+            {
+                PageCursors.Add(Page.NextCursor);
+            }
+            else
+            {
+                bReachedLastPage = true;
+            }
+        }
+        Retain(PageIndex, Search);
+    }
+
+    for (TPromise<TSharedPtr<FOnlineSessionSearch>>& Promise : Waiting)
+    {
+        Promise.SetValue(Search);
+    }
+}
+
+// Retain holds a page and evicts other pages until the retained pages fit under the cap.
+// The peak is recorded before eviction, so it includes the page which pushed the pager over the cap.
+void FSessionSearchPager::Retain(int32 PageIndex, const TSharedPtr<FOnlineSessionSearch>& Search)
+{
+    int64 Bytes = sizeof(FOnlineSessionSearch);
+    for (const FOnlineSessionSearchResult& Result : Search->SearchResults)
+    {
+        Bytes += FSessionSearchFilterMatcher::EstimateResultBytes(Result);
+    }
+
+    FRetainedPage& Retained = RetainedPages.FindOrAdd(PageIndex);
+    Stats.RetainedBytes += Bytes - Retained.Bytes;
+    Stats.RetainedResults += Search->SearchResults.Num() - (Retained.Search.IsValid() ? Retained.Search->SearchResults.Num() : 0);
+    Retained.Search = Search;
+    Retained.Bytes = Bytes;
+    Retained.LastUsed = ++UseCount;
+
+    Stats.PeakRetainedBytes = FMath::Max(Stats.PeakRetainedBytes, Stats.RetainedBytes);
+    Stats.PeakRetainedResults = FMath::Max(Stats.PeakRetainedResults, Stats.RetainedResults);
+    EvictBeyondCap(PageIndex);
+}
+
+// EvictBeyondCap drops the least recently used pages other than KeepPageIndex while the cap is exceeded.
+// A single page larger than the cap is still retained, since it is the page being viewed.
+void FSessionSearchPager::EvictBeyondCap(int32 KeepPageIndex)
+{
+    while (Stats.RetainedBytes > MaxRetainedBytes && RetainedPages.Num() > 1)
+    {
+        int32 OldestPageIndex = INDEX_NONE;
+        uint64 OldestUse = MAX_uint64;
+        for (const TPair<int32, FRetainedPage>& Pair : RetainedPages)
+        {
+            if (Pair.Key != KeepPageIndex && Pair.Value.LastUsed < OldestUse)
+            {
+                OldestPageIndex = Pair.Key;
+                OldestUse = Pair.Value.LastUsed;
+            }
+        }
+
+        const FRetainedPage Evicted = RetainedPages.FindAndRemoveChecked(OldestPageIndex);
+        Stats.RetainedBytes -= Evicted.Bytes;
+        Stats.RetainedResults -= Evicted.Search->SearchResults.Num();
+        Stats.PagesEvicted++;
+    }
+}
+
+// FailPendingRequests fulfills every waiting request with nullptr. The requests are moved out first,
+// since continuations may request pages again.
+void FSessionSearchPager::FailPendingRequests()
+{
+    TMap<int32, TArray<TPromise<TSharedPtr<FOnlineSessionSearch>>>> Failed = MoveTemp(PendingRequests);
+    PendingRequests.Reset();
+    for (TPair<int32, TArray<TPromise<TSharedPtr<FOnlineSessionSearch>>>>& Pair : Failed)
+    {
+        for (TPromise<TSharedPtr<FOnlineSessionSearch>>& Promise : Pair.Value)
+        {
+            Promise.SetValue(nullptr);
+        }
+    }
+}
+
+/***************
+Console Commands
+***************/
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+    // Wall time spent answering page requests each tick, so the game stays responsive during long runs.
+    constexpr double PagedSearchTickBudgetSeconds = 0.1;
+
+    /*
+     * FPagedSearchBenchmark scrolls through a private session directory with a pager at each page size, then scrolls back
+     * to the first page, and compares the pager's peak memory with a single search which holds every session.
+     */
+    class FPagedSearchBenchmark : public TSharedFromThis<FPagedSearchBenchmark>
+    {
+    public:
+        FPagedSearchBenchmark(UMultiplayerSessionsSubsystem* InSubsystem, int32 InNumSessions, TArray<int32> InPageSizes, int64 InMaxRetainedBytes):
+            Subsystem(InSubsystem),
+            NumSessions(InNumSessions),
+            PageSizes(MoveTemp(InPageSizes)),
+            MaxRetainedBytes(InMaxRetainedBytes)
+        {}
+
+        // Start swaps in the directory backend, and restores the subsystem's backend when the run finishes.
+        void Start()
+        {
+            OriginalBackend = Subsystem->GetBackend();
+            bRunning = true;
+            TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FPagedSearchBenchmark::Tick));
+            StartScenario();
+        }
+
+        bool IsRunning() const { return bRunning; }
+
+    private:
+        /*
+         * FResult is the outcome of scrolling through every session at one page size.
+         */
+        struct FResult
+        {
+            int32 PageSize{ 0 };
+            int32 Pages{ 0 };
+            double Seconds{ 0.0 };
+            FSessionSearchPagerStats Stats;
+            int64 FullSearchBytes{ 0 };
+            int32 FullSearchResults{ 0 };
+        };
+
+        // Tick answers page requests within the budget. Requests made by completions are answered in the same loop.
+        bool Tick(float DeltaTime)
+        {
+            if (!bRunning)
+            {
+                return false;
+            }
+            const double EndTime = FPlatformTime::Seconds() + PagedSearchTickBudgetSeconds;
+            while (bRunning && FPlatformTime::Seconds() < EndTime && Backend.IsValid() && Backend->ProcessPending())
+            {
+            }
+            return true;
+        }
+
+        // StartScenario registers the sessions in a fresh directory, so every page size scrolls through the same list.
+        void StartScenario()
+        {
+            UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get();
+            if (!Sessions)
+            {
+                Finish();
+                return;
+            }
+
+            TSharedRef<FSessionDirectory> Directory = MakeShared<FSessionDirectory>();
+            TArray<FSessionDirectoryEntry> Entries;
+            Entries.SetNum(NumSessions);
+            for (int32 Index = 0; Index < NumSessions; ++Index)
+            {
+                FSessionDirectoryEntry& Entry = Entries[Index];
+                Entry.SessionId = FString::Printf(TEXT("PagedSearchBenchmark%d"), Index);
+                Entry.OwnerName = Entry.SessionId;
+                Entry.HostAddress = TEXT("127.0.0.1:7777");
+                Entry.MatchType = TEXT("Benchmark");
+                Entry.NumPublicConnections = 4;
+                Entry.NumOpenPublicConnections = 1 + Index % 4;
+                Entry.Attributes.Add(SETTING_MAPNAME, TEXT("/Game/Maps/Lobby"));
+            }
+            Directory->Register(MoveTemp(Entries), FPlatformTime::Seconds());
+
+            Backend = MakeShared<FDirectorySessionBackend>(GetDefault<UMultiplayerSessionsSettings>()->DirectoryBackend, Directory, true);
+            Sessions->SetBackend(Backend);
+
+            FResult& Result = Results.AddDefaulted_GetRef();
+            Result.PageSize = PageSizes[Results.Num() - 1];
+            Pager = MakeShared<FSessionSearchPager>(Sessions, FMultiplayerSessionSearchFilter(), Result.PageSize, MaxRetainedBytes);
+            bRevisiting = false;
+            StartTime = FPlatformTime::Seconds();
+            RequestPage(0);
+        }
+
+        void RequestPage(int32 PageIndex)
+        {
+            TWeakPtr<FPagedSearchBenchmark> WeakThis = AsShared();
+            Pager->GetPageAsync(PageIndex).Next([WeakThis, PageIndex](TSharedPtr<FOnlineSessionSearch> Search)
+            {
+                if (TSharedPtr<FPagedSearchBenchmark> Benchmark = WeakThis.Pin())
+                {
+                    Benchmark->OnPage(PageIndex, Search.IsValid());
+                }
+            });
+        }
+
+        // OnPage moves on to the next page, like a list scrolled to the end, then returns to the first page once.
+        // Pages are not held, so the pager's retained pages are the only ones in memory.
+        void OnPage(int32 PageIndex, bool bWasFetched)
+        {
+            if (!bRunning)
+            {
+                return;
+            }
+            FResult& Result = Results.Last();
+            if (!bWasFetched)
+            {
+                MULTIPLAYER_LOG(Error, TEXT("PagedSearchBenchmark: Failed to fetch page %d"), PageIndex);
+                RunFullSearch();
+                return;
+            }
+            Result.Pages++;
+
+            if (bRevisiting)
+            {
+                Result.Seconds = FPlatformTime::Seconds() - StartTime;
+                RunFullSearch();
+            }
+            else if (PageIndex + 1 < Pager->GetNumKnownPages())
+            {
+                RequestPage(PageIndex + 1);
+            }
+            else
+            {
+                bRevisiting = true;
+                RequestPage(0);
+            }
+        }
+
+        // RunFullSearch finds every session with one search, which is what the pager avoids holding.
+        void RunFullSearch()
+        {
+            UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get();
+            if (!Sessions)
+            {
+                Finish();
+                return;
+            }
+            Results.Last().Stats = Pager->GetStats();
+            Pager.Reset();
+
+            Sessions->InvalidateSearchCache();
+            TWeakPtr<FPagedSearchBenchmark> WeakThis = AsShared();
+            Sessions->FindSessionsAsync(NumSessions, FMultiplayerSessionSearchFilter()).Next(
+                [WeakThis](const FMultiplayerFindSessionsResult& FindResult)
+                {
+                    if (TSharedPtr<FPagedSearchBenchmark> Benchmark = WeakThis.Pin())
+                    {
+                        Benchmark->OnFullSearch(FindResult);
+                    }
+                });
+        }
+
+        void OnFullSearch(const FMultiplayerFindSessionsResult& FindResult)
+        {
+            if (!bRunning)
+            {
+                return;
+            }
+            FResult& Result = Results.Last();
+            if (FindResult.Search.IsValid())
+            {
+                Result.FullSearchResults = FindResult.Search->SearchResults.Num();
+                Result.FullSearchBytes = sizeof(FOnlineSessionSearch);
+                for (const FOnlineSessionSearchResult& SearchResult : FindResult.Search->SearchResults)
+                {
+                    Result.FullSearchBytes += FSessionSearchFilterMatcher::EstimateResultBytes(SearchResult);
+                }
+            }
+            if (UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get())
+            {
+                Sessions->InvalidateSearchCache();
+            }
+
+            MULTIPLAYER_LOG(Info, TEXT("PagedSearchBenchmark: Page size %d: %d pages in %.3fs, peak %lld bytes (%d results), %d fetched, %d refetched, %d evicted; full search %lld bytes (%d results)"),
+                Result.PageSize,
+                Result.Pages,
+                Result.Seconds,
+                Result.Stats.PeakRetainedBytes,
+                Result.Stats.PeakRetainedResults,
+                Result.Stats.PagesFetched,
+                Result.Stats.PagesRefetched,
+                Result.Stats.PagesEvicted,
+                Result.FullSearchBytes,
+                Result.FullSearchResults);
+
+            if (Results.Num() < PageSizes.Num())
+            {
+                StartScenario();
+                return;
+            }
+            Finish();
+        }
+
+        // Finish restores the backend and writes the results to Saved/MultiplayerSessions.
+        void Finish()
+        {
+            bRunning = false;
+            Pager.Reset();
+            if (UMultiplayerSessionsSubsystem* Sessions = Subsystem.Get())
+            {
+                Sessions->SetBackend(OriginalBackend);
+            }
+            OriginalBackend.Reset();
+            Backend.Reset();
+            if (TickerHandle.IsValid())
+            {
+                FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+                TickerHandle.Reset();
+            }
+
+            FString Csv = TEXT("Sessions,PageSize,Pages,Seconds,PagesFetched,PagesRefetched,PagesEvicted,PeakRetainedBytes,PeakRetainedResults,FullSearchBytes,FullSearchResults\n");
+            for (const FResult& Result : Results)
+            {
+                Csv += FString::Printf(TEXT("%d,%d,%d,%.6f,%d,%d,%d,%lld,%d,%lld,%d\n"),
+                    NumSessions,
+                    Result.PageSize,
+                    Result.Pages,
+                    Result.Seconds,
+                    Result.Stats.PagesFetched,
+                    Result.Stats.PagesRefetched,
+                    Result.Stats.PagesEvicted,
+                    Result.Stats.PeakRetainedBytes,
+                    Result.Stats.PeakRetainedResults,
+                    Result.FullSearchBytes,
+                    Result.FullSearchResults);
+            }
+            const FString Path = FPaths::Combine(
+                FPaths::ProjectSavedDir(),
+                TEXT("MultiplayerSessions"),
+                FString::Printf(TEXT("PagedSearchBenchmark-%s.csv"), *FDateTime::Now().ToString())
+            );
+            if (FFileHelper::SaveStringToFile(Csv, *Path))
+            {
+                MULTIPLAYER_LOG(Info, TEXT("PagedSearchBenchmark: Wrote %s"), *Path);
+            }
+            else
+            {
+                MULTIPLAYER_LOG(Error, TEXT("PagedSearchBenchmark: Failed to write %s"), *Path);
+            }
+        }
+
+        TWeakObjectPtr<UMultiplayerSessionsSubsystem> Subsystem;
+        int32 NumSessions{ 0 };
+        TArray<int32> PageSizes;
+        int64 MaxRetainedBytes{ 0 };
+
+        TSharedPtr<IMultiplayerSessionBackend> OriginalBackend;
+        TSharedPtr<FDirectorySessionBackend> Backend;
+        TSharedPtr<FSessionSearchPager> Pager;
+        FTSTicker::FDelegateHandle TickerHandle;
+        bool bRunning{ false };
+        bool bRevisiting{ false };
+        double StartTime{ 0.0 };
+        TArray<FResult> Results;
+    };
+
+    TSharedPtr<FPagedSearchBenchmark> ActivePagedSearchBenchmark;
+}
+
+// RunPagedSearchBenchmark starts a run against the subsystem of the world's game instance.
+static void RunPagedSearchBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+    if (ActivePagedSearchBenchmark.IsValid() && ActivePagedSearchBenchmark->IsRunning())
+    {
+        MULTIPLAYER_LOG(Warning, TEXT("PagedSearchBenchmark: A run is already in progress"));
+        return;
+    }
+
+    const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if (!Subsystem)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("PagedSearchBenchmark: Failed to get MultiplayerSessionsSubsystem"));
+        return;
+    }
+
+    int32 NumSessions = 20000;
+    TArray<int32> PageSizes{ 25, 100, 500 };
+    int64 MaxRetainedKB = GetDefault<UMultiplayerSessionsSettings>()->SearchPageMaxRetainedKB;
+    for (const FString& Arg : Args)
+    {
+        FString Key;
+        FString Value;
+        if (!Arg.Split(TEXT("="), &Key, &Value))
+        {
+            continue;
+        }
+        if (Key == TEXT("Sessions"))
+        {
+            NumSessions = FMath::Max(FCString::Atoi(*Value), 1);
+        }
+        else if (Key == TEXT("PageSizes"))
+        {
+            TArray<FString> Parts;
+            Value.ParseIntoArray(Parts, TEXT(","));
+            TArray<int32> Sizes;
+            for (const FString& Part : Parts)
+            {
+                if (FCString::Atoi(*Part) > 0)
+                {
+                    Sizes.Add(FCString::Atoi(*Part));
+                }
+            }
+            if (Sizes.Num() > 0)
+            {
+                PageSizes = MoveTemp(Sizes);
+            }
+        }
+        else if (Key == TEXT("MaxRetainedKB"))
+        {
+            MaxRetainedKB = FMath::Max(FCString::Atoi64(*Value), 1ll);
+        }
+    }
+
+    MULTIPLAYER_LOG(Info, TEXT("PagedSearchBenchmark: Scrolling through %d sessions, retaining at most %lld KB"), NumSessions, MaxRetainedKB);
+    ActivePagedSearchBenchmark = MakeShared<FPagedSearchBenchmark>(Subsystem, NumSessions, MoveTemp(PageSizes), MaxRetainedKB * 1024);
+    ActivePagedSearchBenchmark->Start();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PagedSearchBenchmarkCommand(
+    TEXT("MultiplayerSessions.PagedSearchBenchmark"),
+    TEXT("Scrolls through a private session directory with a search pager at each page size, and reports peak retained memory. ")
+    TEXT("Usage: MultiplayerSessions.PagedSearchBenchmark [Sessions=20000] [PageSizes=25,100,500] [MaxRetainedKB=256]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunPagedSearchBenchmark)
+);
+#endi
\ No newline at end of file
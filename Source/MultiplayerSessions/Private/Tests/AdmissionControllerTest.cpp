@@ -0,0 +1,172 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+
+#include "AdmissionController.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAdmissionControllerQueueTest, "MultiplayerSessions.Admission.Queue",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest admits a burst, queues the clients after it, and admits them in order as tokens refill.
+bool FAdmissionControllerQueueTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerAdmissionSettings Settings;
+    Settings.LoginsPerSecond = 1.f;
+    Settings.LoginBurst = 2;
+    Settings.MaxQueueLength = 2;
+
+    FAdmissionController Controller(Settings);
+    Controller.UpdateCapacity(0, 3);
+
+    TestTrue(TEXT("The first client is admitted"), Controller.PreLogin(TEXT("A"), 0.0).Decision == EAdmissionDecision::Admitted);
+    TestTrue(TEXT("The burst admits a second client"), Controller.PreLogin(TEXT("B"), 0.0).Decision == EAdmissionDecision::Admitted);
+    const FAdmissionResult Queued = Controller.PreLogin(TEXT("C"), 0.0);
+    TestTrue(TEXT("Clients after the burst are queued"), Queued.Decision == EAdmissionDecision::Queued);
+    TestEqual(TEXT("The first queued client is at the front"), Queued.QueuePosition, 1);
+    TestEqual(TEXT("The second queued client is behind it"), Controller.PreLogin(TEXT("D"), 0.0).QueuePosition, 2);
+    TestTrue(TEXT("Clients beyond the queue are rejected"), Controller.PreLogin(TEXT("E"), 0.0).Decision == EAdmissionDecision::Rejected);
+
+    // An admitted client which retries keeps its reservation.
+    TestTrue(TEXT("A retry is admitted"), Controller.PreLogin(TEXT("A"), 0.1).Decision == EAdmissionDecision::Admitted);
+    TestEqual(TEXT("A retry does not reserve another slot"), Controller.NumReserved(), 2);
+
+    // A refilled token reserves the last slot for the front of the queue, which claims it by retrying.
+    Controller.Tick(1.0);
+    TestEqual(TEXT("The front of the queue holds a reservation"), Controller.NumReserved(), 3);
+    TestTrue(TEXT("The second queued client waits, since no slot is free"), Controller.PreLogin(TEXT("D"), 1.5).Decision == EAdmissionDecision::Queued);
+    TestTrue(TEXT("The front of the queue is admitted"), Controller.PreLogin(TEXT("C"), 1.5).Decision == EAdmissionDecision::Admitted);
+    TestEqual(TEXT("The admitted client leaves the queue"), Controller.NumQueued(), 1);
+
+    // Logged in clients count as players rather than reservations.
+    Controller.PostLogin(TEXT("A"));
+    Controller.UpdateCapacity(1, 3);
+    TestEqual(TEXT("PostLogin releases the reservation"), Controller.NumReserved(), 2);
+
+    const FAdmissionStats& Stats = Controller.GetStats();
+    TestEqual(TEXT("Three clients are accepted"), Stats.Accepted, int64(3));
+    TestEqual(TEXT("One of them waited in the queue"), Stats.AcceptedFromQueue, int64(1));
+    TestEqual(TEXT("One client is rejected"), Stats.Rejected, int64(1));
+    TestTrue(TEXT("Slots are never overcommitted"), Stats.PeakUsedSlots <= 3);
+
+    // Errors sent to queued clients carry their retry delay and position.
+    float RetryAfterSeconds = 0.f;
+    int32 QueuePosition = 0;
+    TestTrue(TEXT("Queued errors are parsed"), FAdmissionController::ParseErrorMessage(Queued.ToErrorMessage(), RetryAfterSeconds, QueuePosition));
+    TestEqual(TEXT("The queue position is parsed"), QueuePosition, 1);
+    TestFalse(TEXT("Other errors are ignored"), FAdmissionController::ParseErrorMessage(TEXT("Server full"), RetryAfterSeconds, QueuePosition));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAdmissionControllerExpiryTest, "MultiplayerSessions.Admission.Expiry",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that reservations which are not used or claimed in time free their slot for the next client in the queue.
+bool FAdmissionControllerExpiryTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerAdmissionSettings Settings;
+    Settings.LoginsPerSecond = 1.f;
+    Settings.LoginBurst = 1;
+    Settings.QueueTicketTimeoutSeconds = 60.f;
+    Settings.ReservationTimeoutSeconds = 5.f;
+
+    FAdmissionController Controller(Settings);
+    Controller.UpdateCapacity(0, 1);
+    TestTrue(TEXT("The first client is admitted"), Controller.PreLogin(TEXT("A"), 0.0).Decision == EAdmissionDecision::Admitted);
+    TestTrue(TEXT("The second client is queued"), Controller.PreLogin(TEXT("B"), 0.0).Decision == EAdmissionDecision::Queued);
+    TestTrue(TEXT("The third client is queued"), Controller.PreLogin(TEXT("C"), 0.0).Decision == EAdmissionDecision::Queued);
+
+    // The admitted client never logs in, so its slot is reserved for the front of the queue.
+    Controller.Tick(6.0);
+    TestEqual(TEXT("The unused reservation expires"), Controller.GetStats().ReservationsExpired, int64(1));
+    TestEqual(TEXT("The slot is reserved for the front of the queue"), Controller.NumReserved(), 1);
+
+    // The front of the queue never claims its slot, so it loses its place, and the slot passes to the next client.
+    Controller.Tick(12.0);
+    TestEqual(TEXT("The unclaimed reservation expires"), Controller.GetStats().ReservationsExpired, int64(2));
+    TestEqual(TEXT("The client which did not claim its slot leaves the queue"), Controller.NumQueued(), 1);
+    TestEqual(TEXT("Its ticket did not time out"), Controller.GetStats().TicketsExpired, int64(0));
+    TestEqual(TEXT("The slot is reserved for the next client"), Controller.NumReserved(), 1);
+    TestTrue(TEXT("A late retry queues again"), Controller.PreLogin(TEXT("B"), 12.5).Decision == EAdmissionDecision::Queued);
+    TestTrue(TEXT("The next client claims the slot"), Controller.PreLogin(TEXT("C"), 12.5).Decision == EAdmissionDecision::Admitted);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAdmissionControllerAddressKeyTest, "MultiplayerSessions.Admission.AddressKeys",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that clients which share an address, e.g. behind one NAT, cannot log in on each other's reservation.
+bool FAdmissionControllerAddressKeyTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerAdmissionSettings Settings;
+    Settings.LoginBurst = 4;
+
+    FAdmissionController Controller(Settings);
+    Controller.UpdateCapacity(0, 2);
+    const FString Address(TEXT("203.0.113.7"));
+
+    TestTrue(TEXT("The first client at the address is admitted"), Controller.PreLogin(Address, 0.0, false).Decision == EAdmissionDecision::Admitted);
+    TestTrue(TEXT("The second client at the address is admitted"), Controller.PreLogin(Address, 0.0, false).Decision == EAdmissionDecision::Admitted);
+    TestEqual(TEXT("Each client at the address reserves a slot"), Controller.NumReserved(), 2);
+    TestTrue(TEXT("A third client at the address is told to retry"), Controller.PreLogin(Address, 0.0, false).Decision == EAdmissionDecision::Rejected);
+    TestEqual(TEXT("It does not take a place in the queue"), Controller.NumQueued(), 0);
+
+    Controller.PostLogin(Address);
+    Controller.UpdateCapacity(1, 2);
+    TestEqual(TEXT("PostLogin releases one of the address's reservations"), Controller.NumReserved(), 1);
+    TestEqual(TEXT("Slots are never overcommitted"), Controller.GetStats().PeakUsedSlots, 2);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAdmissionControllerSharedAddressTest, "MultiplayerSessions.Admission.SharedAddress",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that two clients behind one address cannot take, or log in on, a place in a full queue,
+// and are each admitted on their own reservation once the queue has drained.
+bool FAdmissionControllerSharedAddressTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerAdmissionSettings Settings;
+    Settings.LoginsPerSecond = 1.f;
+    Settings.LoginBurst = 1;
+    Settings.MaxQueueLength = 2;
+    Settings.QueueTicketTimeoutSeconds = 60.f;
+    Settings.ReservationTimeoutSeconds = 30.f;
+
+    FAdmissionController Controller(Settings);
+    Controller.UpdateCapacity(0, 8);
+    const FString Address(TEXT("203.0.113.7"));
+
+    TestTrue(TEXT("The first client is admitted"), Controller.PreLogin(TEXT("A"), 0.0).Decision == EAdmissionDecision::Admitted);
+    TestTrue(TEXT("The second client is queued"), Controller.PreLogin(TEXT("B"), 0.0).Decision == EAdmissionDecision::Queued);
+    TestTrue(TEXT("The third client is queued"), Controller.PreLogin(TEXT("C"), 0.0).Decision == EAdmissionDecision::Queued);
+
+    const FAdmissionResult First = Controller.PreLogin(Address, 0.0, false);
+    TestTrue(TEXT("The first client at the address is rejected by the full queue"), First.Decision == EAdmissionDecision::Rejected);
+    TestTrue(TEXT("It is told when to retry"), First.RetryAfterSeconds > 0.f);
+    TestEqual(TEXT("The queue stays full"), Controller.NumQueued(), 2);
+
+    // The front of the queue is reserved a slot, which neither client at the address can claim.
+    Controller.Tick(1.0);
+    TestEqual(TEXT("The slot is reserved for the front of the queue"), Controller.NumReserved(), 2);
+    TestTrue(TEXT("The first client at the address cannot claim it"), Controller.PreLogin(Address, 1.5, false).Decision == EAdmissionDecision::Rejected);
+    TestTrue(TEXT("Nor can the second"), Controller.PreLogin(Address, 1.5, false).Decision == EAdmissionDecision::Rejected);
+    TestEqual(TEXT("The clients at the address are never queued"), Controller.NumQueued(), 2);
+    TestTrue(TEXT("The front of the queue claims its slot"), Controller.PreLogin(TEXT("B"), 1.5).Decision == EAdmissionDecision::Admitted);
+
+    Controller.Tick(2.0);
+    TestTrue(TEXT("The next client claims its slot"), Controller.PreLogin(TEXT("C"), 2.5).Decision == EAdmissionDecision::Admitted);
+    TestEqual(TEXT("The queue has drained"), Controller.NumQueued(), 0);
+
+    // Once the queue is empty, each client at the address is admitted on its own token and reservation.
+    Controller.Tick(3.0);
+    TestTrue(TEXT("The first client at the address is admitted"), Controller.PreLogin(Address, 3.0, false).Decision == EAdmissionDecision::Admitted);
+    TestTrue(TEXT("The second client at the address waits for its own token"), Controller.PreLogin(Address, 3.0, false).Decision == EAdmissionDecision::Rejected);
+    Controller.Tick(4.0);
+    TestTrue(TEXT("The second client at the address is admitted"), Controller.PreLogin(Address, 4.0, false).Decision == EAdmissionDecision::Admitted);
+    TestEqual(TEXT("Every admitted client holds its own reservation"), Controller.NumReserved(), 5);
+    TestEqual(TEXT("Only the clients with unique keys were queued"), Controller.GetStats().Queued, int64(2));
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+#include "SessionSearchFilter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsyncApiTest, "MultiplayerSessions.Subsystem.AsyncApi",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest hosts, searches and destroys through the async API with a manual-clock mock, and checks that futures are fulfilled
+// only when their operation completes, that continuations run with the result, and that coalesced searches share one result.
+bool FAsyncApiTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    FMultiplayerMockBackendSettings Settings;
+    Settings.NumSessions = 20;
+    const TSharedRef<FMockSessionBackend> Backend = MakeShared<FMockSessionBackend>(Settings, true);
+    Sessions->SetBackend(Backend);
+
+    // A continuation runs as soon as the creation completes, and the start queued behind it waits for it.
+    const FName PartySession(TEXT("Party"));
+    bool bCreateContinued = false;
+    bool bCreated = false;
+    TFuture<void> Created = Sessions->CreateSessionAsync(4, TEXT("FreeForAll"), PartySession).Next([&bCreateContinued, &bCreated](bool bWasSuccessful)
+    {
+        bCreateContinued = true;
+        bCreated = bWasSuccessful;
+    });
+    TFuture<bool> Started = Sessions->StartSessionAsync(PartySession);
+    TestFalse(TEXT("The creation's future waits for the backend"), Created.IsReady());
+    TestFalse(TEXT("The start's future waits for the creation"), Started.IsReady());
+
+    while (Backend->AdvanceToNext())
+    {
+    }
+    TestTrue(TEXT("The continuation runs with the creation's result"), bCreateContinued && bCreated);
+    TestTrue(TEXT("The start succeeds"), Started.IsReady() && Started.Get());
+
+    // A search requested while an identical one is in flight is coalesced into it.
+    TFuture<FMultiplayerFindSessionsResult> FirstFind = Sessions->FindSessionsAsync(10, FMultiplayerSessionSearchFilter());
+    TFuture<FMultiplayerFindSessionsResult> SecondFind = Sessions->FindSessionsAsync(10, FMultiplayerSessionSearchFilter());
+    TestFalse(TEXT("The search's future waits for the backend"), FirstFind.IsReady());
+    while (Backend->AdvanceToNext())
+    {
+    }
+    if (TestTrue(TEXT("Both searches are fulfilled"), FirstFind.IsReady() && SecondFind.IsReady()))
+    {
+        const FMultiplayerFindSessionsResult& First = FirstFind.Get();
+        TestTrue(TEXT("The search succeeds"), First.bWasSuccessful && First.Search.IsValid() && First.Search->SearchResults.Num() == 10);
+        TestTrue(TEXT("Coalesced searches share the result"), SecondFind.Get().Search == First.Search);
+    }
+
+    // Destroying a session which no longer exists completes immediately.
+    TFuture<bool> Destroyed = Sessions->DestroySessionAsync(PartySession);
+    while (Backend->AdvanceToNext())
+    {
+    }
+    TestTrue(TEXT("The session is destroyed"), Destroyed.IsReady() && Destroyed.Get());
+    TFuture<bool> DestroyedAgain = Sessions->DestroySessionAsync(PartySession);
+    TestTrue(TEXT("There is nothing left to destroy"), DestroyedAgain.IsReady() && !DestroyedAgain.Get());
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,95 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+#include "SessionSearchFilter.h"
+#include "SessionSearchIndex.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJoinPipelineTest, "MultiplayerSessions.Subsystem.JoinPipeline",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest joins ranked candidates through a manual-clock mock, where full sessions always fail, and checks that the pipeline
+// falls back to the next candidate, records each attempt, stops when every candidate fails, and does not retry AlreadyInSession.
+bool FJoinPipelineTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    FMultiplayerMockBackendSettings Settings;
+    Settings.NumSessions = 100;
+    const TSharedRef<FMockSessionBackend> Backend = MakeShared<FMockSessionBackend>(Settings, true);
+    Sessions->SetBackend(Backend);
+
+    TFuture<FMultiplayerFindSessionsResult> Find = Sessions->FindSessionsAsync(Settings.NumSessions, FMultiplayerSessionSearchFilter());
+    while (Backend->AdvanceToNext())
+    {
+    }
+    if (!TestTrue(TEXT("The search completes"), Find.IsReady() && Find.Get().bWasSuccessful))
+    {
+        return false;
+    }
+
+    TArray<int32> Full;
+    TArray<int32> Open;
+    const TConstArrayView<int32> OpenSlots = Sessions->GetSearchIndex().GetOpenSlots();
+    for (int32 Index = 0; Index < OpenSlots.Num(); ++Index)
+    {
+        (OpenSlots[Index] > 0 ? Open : Full).Add(Index);
+    }
+    if (!TestTrue(TEXT("The mock returns full and open sessions"), Full.Num() >= 2 && Open.Num() >= 2))
+    {
+        return false;
+    }
+
+    // The pipeline falls back past full sessions, and stops at the first success.
+    const FName PartySession(TEXT("Party"));
+    TFuture<EOnJoinSessionCompleteResult::Type> Join = Sessions->JoinRankedSessionsAsync({ Full[0], Full[1], Open[0], Open[1] }, PartySession);
+    while (Backend->AdvanceToNext())
+    {
+    }
+    TestTrue(TEXT("The join succeeds"), Join.IsReady() && Join.Get() == EOnJoinSessionCompleteResult::Success);
+    TestTrue(TEXT("The session is joined"), Backend->HasSession(PartySession));
+
+    const FMultiplayerJoinPipelineStats& Stats = Sessions->GetLastJoinPipelineStats(PartySession);
+    if (TestEqual(TEXT("Each candidate up to the first success is attempted"), Stats.Attempts.Num(), 3))
+    {
+        TestTrue(TEXT("Candidates are attempted in rank order"),
+            Stats.Attempts[0].CandidateIndex == Full[0] && Stats.Attempts[1].CandidateIndex == Full[1] && Stats.Attempts[2].CandidateIndex == Open[0]);
+        TestTrue(TEXT("Full sessions fail"),
+            Stats.Attempts[0].Result == EOnJoinSessionCompleteResult::SessionIsFull && Stats.Attempts[1].Result == EOnJoinSessionCompleteResult::SessionIsFull);
+        TestTrue(TEXT("The last attempt succeeds"), Stats.Attempts[2].Result == EOnJoinSessionCompleteResult::Success);
+    }
+    TestTrue(TEXT("The time to join is recorded"), Stats.TimeToJoined >= 0.0);
+
+    // A pipeline whose candidates all fail reports the last failure.
+    const FName SpectatorSession(TEXT("Spectator"));
+    Join = Sessions->JoinRankedSessionsAsync({ Full[0], Full[1] }, SpectatorSession);
+    while (Backend->AdvanceToNext())
+    {
+    }
+    TestTrue(TEXT("The join fails"), Join.IsReady() && Join.Get() == EOnJoinSessionCompleteResult::SessionIsFull);
+    TestEqual(TEXT("Every candidate is attempted"), Sessions->GetLastJoinPipelineStats(SpectatorSession).Attempts.Num(), 2);
+    TestTrue(TEXT("No join time is recorded"), Sessions->GetLastJoinPipelineStats(SpectatorSession).TimeToJoined < 0.0);
+    TestFalse(TEXT("No session is left behind"), Backend->HasSession(SpectatorSession));
+
+    // Trying another session will not help a player who is already in one.
+    Join = Sessions->JoinRankedSessionsAsync({ Open[0], Open[1] }, PartySession);
+    while (Backend->AdvanceToNext())
+    {
+    }
+    TestTrue(TEXT("The join reports the existing session"), Join.IsReady() && Join.Get() == EOnJoinSessionCompleteResult::AlreadyInSession);
+    TestEqual(TEXT("AlreadyInSession is not retried"), Sessions->GetLastJoinPipelineStats(PartySession).Attempts.Num(), 1);
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "Misc/ScopeExit.h"
+#include "OnlineSessionSettings.h"
+
+#include "DebugGameMode.h"
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // MakeResult returns a search result with the given open slots, which advertises MapName when it is not empty.
+    FOnlineSessionSearchResult MakeResult(int32 OpenSlots, const FString& MapName)
+    {
+        FOnlineSessionSearchResult Result;
+        Result.Session.NumOpenPublicConnections = OpenSlots;
+        Result.Session.SessionSettings.NumPublicConnections = 4;
+        if (!MapName.IsEmpty())
+        {
+            Result.Session.SessionSettings.Set(SETTING_MAPNAME, MapName, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+        return Result;
+    }
+
+    // JoinAndComplete joins Result under SessionName, and delivers every completion of the manual-clock mock.
+    EOnJoinSessionCompleteResult::Type JoinAndComplete(UMultiplayerSessionsSubsystem& Sessions, FMockSessionBackend& Backend, const FOnlineSessionSearchResult& Result, FName SessionName)
+    {
+        TFuture<EOnJoinSessionCompleteResult::Type> Join = Sessions.JoinSessionAsync(Result, SessionName);
+        while (Backend.AdvanceToNext())
+        {
+        }
+        return Join.IsReady() ? Join.Get() : EOnJoinSessionCompleteResult::UnknownError;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJoinPrefetchTest, "MultiplayerSessions.Subsystem.JoinPrefetch",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest joins sessions which advertise their map, and checks that the game session's map is prefetched while the join is in flight,
+// released when the join fails, and kept when it succeeds, while other sessions and sessions without a map prefetch nothing.
+// It also checks that the debug game mode travels seamlessly.
+bool FJoinPrefetchTest::RunTest(const FString& Parameters)
+{
+    TestTrue(TEXT("The debug game mode travels seamlessly"), GetDefault<ADebugGameMode>()->bUseSeamlessTravel);
+
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    TGuardValue<bool> PreloadGuard(GetMutableDefault<UMultiplayerSessionsSettings>()->bPreloadLobbyMap, true);
+    const TSharedRef<FMockSessionBackend> Backend = MakeShared<FMockSessionBackend>(FMultiplayerMockBackendSettings(), true);
+    Sessions->SetBackend(Backend);
+    ON_SCOPE_EXIT
+    {
+        Sessions->ReleasePreloadedMap();
+    };
+
+    // The engine's entry map exists in every project.
+    const FString MapName(TEXT("/Engine/Maps/Entry"));
+    const FMapPreloadStats& Stats = Sessions->GetMapPreloadStats();
+
+    // Party sessions do not travel, so their map is not prefetched.
+    TestTrue(TEXT("The party session is joined"), JoinAndComplete(*Sessions, *Backend, MakeResult(1, MapName), FName(TEXT("Party"))) == EOnJoinSessionCompleteResult::Success);
+    TestEqual(TEXT("A party session's map is not prefetched"), Stats.Preloads, 0);
+
+    // A failed join releases the prefetched map, since the client will not travel.
+    TestTrue(TEXT("A full session is not joined"), JoinAndComplete(*Sessions, *Backend, MakeResult(0, MapName), NAME_GameSession) == EOnJoinSessionCompleteResult::SessionIsFull);
+    TestEqual(TEXT("The game session's map is prefetched"), Stats.Preloads, 1);
+    TestEqual(TEXT("The prefetch is released when the join fails"), Stats.Released, 1);
+
+    // A session which does not advertise its map prefetches nothing.
+    TestTrue(TEXT("A full session without a map is not joined"), JoinAndComplete(*Sessions, *Backend, MakeResult(0, FString()), NAME_GameSession) == EOnJoinSessionCompleteResult::SessionIsFull);
+    TestEqual(TEXT("Nothing is prefetched without a map"), Stats.Preloads, 1);
+
+    // A successful join keeps the prefetched map for client travel.
+    TestTrue(TEXT("The game session is joined"), JoinAndComplete(*Sessions, *Backend, MakeResult(1, MapName), NAME_GameSession) == EOnJoinSessionCompleteResult::Success);
+    TestEqual(TEXT("The map is prefetched again"), Stats.Preloads, 2);
+    TestEqual(TEXT("The prefetch is kept when the join succeeds"), Stats.Released, 1);
+    return true;
+}
+
+#endif
\ No newline at end of file
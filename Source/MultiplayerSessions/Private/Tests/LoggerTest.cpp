@@ -0,0 +1,143 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeExit.h"
+
+#include "Logger.h"
+#include "LogRingBuffer.h"
+
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLogRingBufferTest, "MultiplayerSessions.Logger.RingBuffer",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest fills a small ring buffer past capacity, then has several threads produce into a large one at once,
+// and checks that every element is consumed exactly once and in order per producer.
+bool FLogRingBufferTest::RunTest(const FString& Parameters)
+{
+    TMpscRingBuffer<int32, 8> Small;
+    for (int32 Value = 0; Value < 8; ++Value)
+    {
+        TestTrue(TEXT("Producing into a free cell succeeds"), Small.TryProduce([Value](int32& Element) { Element = Value; }));
+    }
+    TestFalse(TEXT("Producing into a full buffer fails without waiting"), Small.TryProduce([](int32& Element) { Element = -1; }));
+    TestEqual(TEXT("The buffer is full"), (int32)Small.Num(), 8);
+
+    TArray<int32> Consumed;
+    while (Small.TryConsume([&Consumed](int32& Element) { Consumed.Add(Element); }))
+    {
+    }
+    TestTrue(TEXT("Elements are consumed in order"), Consumed == TArray<int32>{ 0, 1, 2, 3, 4, 5, 6, 7 });
+    TestTrue(TEXT("A consumed cell can be produced into again"), Small.TryProduce([](int32& Element) { Element = 8; }));
+
+    constexpr int32 NumProducers = 4;
+    constexpr int32 PerProducer = 1000;
+    TMpscRingBuffer<int32, 4096> Large;
+    std::atomic<int32> Failed{ 0 };
+    ParallelFor(NumProducers, [&Large, &Failed](int32 Producer)
+    {
+        for (int32 Index = 0; Index < PerProducer; ++Index)
+        {
+            if (!Large.TryProduce([Producer, Index](int32& Element) { Element = Producer * PerProducer + Index; }))
+            {
+                Failed++;
+            }
+        }
+    });
+    TestEqual(TEXT("Every concurrent write fits"), Failed.load(), 0);
+
+    TArray<int32> LastByProducer;
+    LastByProducer.Init(-1, NumProducers);
+    int32 NumConsumed = 0;
+    bool bInOrder = true;
+    while (Large.TryConsume([&](int32& Element)
+    {
+        const int32 Producer = Element / PerProducer;
+        bInOrder &= Element % PerProducer == LastByProducer[Producer] + 1;
+        LastByProducer[Producer] = Element % PerProducer;
+        NumConsumed++;
+    }))
+    {
+    }
+    TestEqual(TEXT("Every element is consumed once"), NumConsumed, NumProducers * PerProducer);
+    TestTrue(TEXT("Each producer's elements are consumed in the order they were produced"), bInOrder);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLoggerFlushTest, "MultiplayerSessions.Logger.Flush",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest queues messages from the game thread and checks that Flush returns once the logging thread has written them.
+bool FLoggerFlushTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumMessages = 10;
+    AddExpectedError(TEXT("LoggerTest: Message"), EAutomationExpectedErrorFlags::Contains, NumMessages);
+    const FLoggerStats Before = Logger::GetStats();
+    for (int32 Index = 0; Index < NumMessages; ++Index)
+    {
+        MULTIPLAYER_LOG(Error, TEXT("LoggerTest: Message %d of %s"), Index, TEXT("the flush test"));
+    }
+    Logger::Flush();
+
+    const FLoggerStats After = Logger::GetStats();
+    if (After.Queued == Before.Queued)
+    {
+        // The logging thread is not running, e.g. on platforms without threads, so the messages were written immediately.
+        return true;
+    }
+    TestTrue(TEXT("Every message is queued"), After.Queued - Before.Queued >= NumMessages);
+    TestTrue(TEXT("Every message is written by the time Flush returns"), After.Written >= Before.Queued + NumMessages);
+    TestTrue(TEXT("Nothing is dropped"), After.Dropped == Before.Dropped);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLoggerLevelsTest, "MultiplayerSessions.Logger.Levels",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that levels above the compiled level stay disabled whatever the runtime level is,
+// and that a disabled message neither evaluates its arguments nor reaches the queue.
+bool FLoggerLevelsTest::RunTest(const FString& Parameters)
+{
+    static_assert(!Logger::IsCompiledIn(EMultiplayerLogLevel::Off), "Off is never a message level");
+    for (const EMultiplayerLogLevel Level : { EMultiplayerLogLevel::Error, EMultiplayerLogLevel::Warning, EMultiplayerLogLevel::Info, EMultiplayerLogLevel::Verbose })
+    {
+        TestTrue(
+            FString::Printf(TEXT("Level %d is compiled in up to the compiled level"), static_cast<int32>(Level)),
+            Logger::IsCompiledIn(Level) == (static_cast<int32>(Level) <= MULTIPLAYERSESSIONS_LOG_LEVEL)
+        );
+    }
+
+    Logger::Flush();
+    const EMultiplayerLogLevel PreviousLevel = Logger::GetRuntimeLevel();
+    ON_SCOPE_EXIT
+    {
+        Logger::SetRuntimeLevel(PreviousLevel);
+    };
+
+    Logger::SetRuntimeLevel(EMultiplayerLogLevel::Verbose);
+    TestEqual(
+        TEXT("The runtime level is clamped to the compiled level"),
+        static_cast<int32>(Logger::GetRuntimeLevel()),
+        FMath::Min(static_cast<int32>(EMultiplayerLogLevel::Verbose), MULTIPLAYERSESSIONS_LOG_LEVEL)
+    );
+
+    Logger::SetRuntimeLevel(EMultiplayerLogLevel::Warning);
+    TestTrue(TEXT("Errors are enabled below the runtime level"), Logger::IsEnabled(EMultiplayerLogLevel::Error) == Logger::IsCompiledIn(EMultiplayerLogLevel::Error));
+    TestFalse(TEXT("Info is disabled above the runtime level"), Logger::IsEnabled(EMultiplayerLogLevel::Info));
+
+    Logger::SetRuntimeLevel(EMultiplayerLogLevel::Off);
+    TestFalse(TEXT("Nothing is enabled when the runtime level is Off"), Logger::IsEnabled(EMultiplayerLogLevel::Error));
+
+    const FLoggerStats Before = Logger::GetStats();
+    int32 NumEvaluated = 0;
+    MULTIPLAYER_LOG(Error, TEXT("LoggerTest: Disabled message %d"), ++NumEvaluated);
+    MULTIPLAYER_LOG(Verbose, TEXT("LoggerTest: Disabled message %d"), ++NumEvaluated);
+    TestEqual(TEXT("Arguments of disabled messages are not evaluated"), NumEvaluated, 0);
+    TestTrue(TEXT("Disabled messages are not queued"), Logger::GetStats().Queued == Before.Queued);
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+
+#include "MapPreloader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMapPreloaderPackageNameTest, "MultiplayerSessions.MapPreloader.PackageName",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that travel URLs are reduced to their map's long package name.
+bool FMapPreloaderPackageNameTest::RunTest(const FString& Parameters)
+{
+    TestEqual(TEXT("Options are stripped"), FMapPreloader::GetMapPackageName(TEXT("/Game/Maps/Lobby?listen")), FString(TEXT("/Game/Maps/Lobby")));
+    TestEqual(TEXT("Every option is stripped"), FMapPreloader::GetMapPackageName(TEXT("/Game/Maps/Lobby?listen?game=FFA")), FString(TEXT("/Game/Maps/Lobby")));
+    TestEqual(TEXT("URLs without options are kept"), FMapPreloader::GetMapPackageName(TEXT("/Game/Maps/Lobby")), FString(TEXT("/Game/Maps/Lobby")));
+    TestTrue(TEXT("Short names are rejected"), FMapPreloader::GetMapPackageName(TEXT("Lobby?listen")).IsEmpty());
+    TestTrue(TEXT("Addresses are rejected"), FMapPreloader::GetMapPackageName(TEXT("127.0.0.1:7777")).IsEmpty());
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMapPreloaderReleaseTest, "MultiplayerSessions.MapPreloader.Release",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that a flow to the same map keeps its preload, and that other maps and Release drop it.
+bool FMapPreloaderReleaseTest::RunTest(const FString& Parameters)
+{
+    // The engine's entry map exists in every project.
+    const FString MapURL(TEXT("/Engine/Maps/Entry?listen"));
+
+    FMapPreloader Preloader;
+    Preloader.Begin(MapURL, true);
+    TestEqual(TEXT("The map starts preloading"), Preloader.GetStats().Preloads, 1);
+    TestTrue(TEXT("The map is loading or loaded"), Preloader.IsLoading() || Preloader.IsLoaded());
+
+    Preloader.Begin(MapURL, true);
+    Preloader.Begin(MapURL, false);
+    TestEqual(TEXT("Flows to the same map keep the preload"), Preloader.GetStats().Preloads, 1);
+    TestEqual(TEXT("Flows to the same map do not release the preload"), Preloader.GetStats().Released, 0);
+
+    Preloader.Begin(TEXT("/Game/Maps/Other"), false);
+    TestEqual(TEXT("A flow to another map releases the preload"), Preloader.GetStats().Released, 1);
+    TestFalse(TEXT("The released map is no longer held"), Preloader.IsLoading() || Preloader.IsLoaded());
+
+    Preloader.Release();
+    TestEqual(TEXT("Release without a preload releases nothing"), Preloader.GetStats().Released, 1);
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#include "MockSessionBackend.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // MakeTestSettings returns mock settings with fixed latencies and no failures, so every run takes the same steps.
+    FMultiplayerMockBackendSettings MakeTestSettings()
+    {
+        FMultiplayerMockBackendSettings Settings;
+        Settings.NumSessions = 20;
+        for (FMultiplayerMockOperationSettings* Operation : { &Settings.Create, &Settings.Find, &Settings.Join, &Settings.Destroy })
+        {
+            Operation->MinLatencySeconds = 1.f;
+            Operation->MaxLatencySeconds = 1.f;
+        }
+        return Settings;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMockSessionBackendLifecycleTest, "MultiplayerSessions.MockBackend.Lifecycle",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest creates a session, finds remote sessions, joins one and destroys both, advancing the manual clock between steps.
+bool FMockSessionBackendLifecycleTest::RunTest(const FString& Parameters)
+{
+    FMockSessionBackend Backend(MakeTestSettings(), true);
+    const FUniqueNetIdPtr PlayerId = Backend.GetDefaultPlayerId();
+    const FName HostSession(TEXT("HostSession"));
+    const FName JoinedSession(TEXT("JoinedSession"));
+
+    TArray<FName> Created;
+    TArray<bool> Found;
+    TArray<EOnJoinSessionCompleteResult::Type> Joined;
+    TArray<FName> Destroyed;
+    Backend.AddOnCreateSessionCompleteDelegate_Handle(FOnCreateSessionCompleteDelegate::CreateLambda([&Created](FName Name, bool bWasSuccessful)
+    {
+        if (bWasSuccessful)
+        {
+            Created.Add(Name);
+        }
+    }));
+    Backend.AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateLambda([&Found](bool bWasSuccessful) { Found.Add(bWasSuccessful); }));
+    Backend.AddOnJoinSessionCompleteDelegate_Handle(FOnJoinSessionCompleteDelegate::CreateLambda([&Joined](FName Name, EOnJoinSessionCompleteResult::Type Result) { Joined.Add(Result); }));
+    Backend.AddOnDestroySessionCompleteDelegate_Handle(FOnDestroySessionCompleteDelegate::CreateLambda([&Destroyed](FName Name, bool bWasSuccessful)
+    {
+        if (bWasSuccessful)
+        {
+            Destroyed.Add(Name);
+        }
+    }));
+
+    // Create. Nothing completes until the clock reaches the operation's latency.
+    FOnlineSessionSettings SessionSettings;
+    SessionSettings.NumPublicConnections = 4;
+    TestTrue(TEXT("CreateSession starts"), Backend.CreateSession(*PlayerId, HostSession, SessionSettings));
+    Backend.Advance(0.5);
+    TestEqual(TEXT("Create has not completed halfway through its latency"), Created.Num(), 0);
+    Backend.Advance(0.5);
+    TestTrue(TEXT("Create completes after its latency"), Created == TArray<FName>{ HostSession });
+    TestTrue(TEXT("Created session is registered"), Backend.HasSession(HostSession));
+
+    // Find. Results are delivered gradually, and every session is delivered exactly once.
+    const TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+    Search->MaxSearchResults = 100;
+    TestTrue(TEXT("FindSessions starts"), Backend.FindSessions(*PlayerId, Search));
+    Backend.Advance(0.5);
+    TestEqual(TEXT("Half of the results arrive halfway through the search"), Search->SearchResults.Num(), 10);
+    Search->SearchResults.RemoveAt(0, 5);
+    Backend.Advance(0.5);
+    TestTrue(TEXT("Find completes successfully"), Found == TArray<bool>{ true });
+    TestEqual(TEXT("Results filtered by the caller are not delivered again"), Search->SearchResults.Num(), 15);
+    TestTrue(TEXT("Search is done"), Search->SearchState == EOnlineAsyncTaskState::Done);
+
+    TSet<FString> SessionIds;
+    for (const FOnlineSessionSearchResult& Result : Search->SearchResults)
+    {
+        bool bAlreadyDelivered = false;
+        SessionIds.Add(Result.GetSessionIdStr(), &bAlreadyDelivered);
+        TestFalse(TEXT("Each session is delivered once"), bAlreadyDelivered);
+    }
+
+    // Join the first session with open slots.
+    const FOnlineSessionSearchResult* Candidate = Search->SearchResults.FindByPredicate([](const FOnlineSessionSearchResult& Result)
+    {
+        return Result.Session.NumOpenPublicConnections > 0;
+    });
+    if (!TestNotNull(TEXT("A session with open slots is found"), Candidate))
+    {
+        return false;
+    }
+    TestTrue(TEXT("JoinSession starts"), Backend.JoinSession(*PlayerId, JoinedSession, *Candidate));
+    TestTrue(TEXT("AdvanceToNext delivers the join"), Backend.AdvanceToNext());
+    TestTrue(TEXT("Join succeeds"), Joined == TArray<EOnJoinSessionCompleteResult::Type>{ EOnJoinSessionCompleteResult::Success });
+
+    FString ConnectInfo;
+    TestTrue(TEXT("Joined session has an address"), Backend.GetResolvedConnectString(JoinedSession, ConnectInfo));
+    TestEqual(TEXT("Address is the joined session's"), ConnectInfo, FString::Printf(TEXT("%s:7777"), *Candidate->GetSessionIdStr()));
+
+    // Destroy both sessions.
+    TestTrue(TEXT("DestroySession starts for the hosted session"), Backend.DestroySession(HostSession));
+    TestTrue(TEXT("DestroySession starts for the joined session"), Backend.DestroySession(JoinedSession));
+    while (Backend.AdvanceToNext())
+    {
+    }
+    TestTrue(TEXT("Both sessions are destroyed in order"), Destroyed == TArray<FName>{ HostSession, JoinedSession });
+    TestFalse(TEXT("Hosted session is removed"), Backend.HasSession(HostSession));
+    TestFalse(TEXT("Joined session is removed"), Backend.HasSession(JoinedSession));
+    TestEqual(TEXT("Nothing is pending"), Backend.NumPending(), 0);
+    return true;
+}
+
+#endif
\ No newline at end of file
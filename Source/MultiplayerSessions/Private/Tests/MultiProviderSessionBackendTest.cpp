@@ -0,0 +1,204 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformProcess.h"
+#include "OnlineSessionSettings.h"
+
+#include "MockSessionBackend.h"
+#include "MultiProviderSessionBackend.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // MakeMock returns a manual-clock mock with NumSessions sessions, whose searches take FindSeconds and never fail.
+    TSharedRef<FMockSessionBackend> MakeMock(int32 Seed, int32 NumSessions, float FindSeconds)
+    {
+        FMultiplayerMockBackendSettings Settings;
+        Settings.Seed = Seed;
+        Settings.NumSessions = NumSessions;
+        Settings.Find.MinLatencySeconds = FindSeconds;
+        Settings.Find.MaxLatencySeconds = FindSeconds;
+        Settings.Find.FailureRate = 0.f;
+        return MakeShared<FMockSessionBackend>(Settings, true);
+    }
+
+    /*
+     * FManualSearchBackend is a provider whose searches only complete when the test completes them, in any order.
+     * Cancelled searches are kept, like a provider which still completes a search it was asked to cancel.
+     */
+    class FManualSearchBackend final : public IMultiplayerSessionBackend
+    {
+    public:
+        virtual FName GetSubsystemName() const override { return FName("Manual"); }
+        virtual bool CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override { return false; }
+        virtual bool CancelFindSessions() override { return true; }
+        virtual bool JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override { return false; }
+        virtual bool DestroySession(FName SessionName) override { return false; }
+        virtual bool StartSession(FName SessionName) override { return false; }
+        virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData = true) override { return false; }
+        virtual bool HasSession(FName SessionName) const override { return false; }
+        virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo) override { return false; }
+
+        // FindSessions keeps every search it is sent.
+        virtual bool FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override
+        {
+            SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+            Searches.Add(SearchSettings);
+            return true;
+        }
+
+        // Complete finishes the search sent SearchIndex-th, and delivers its completion.
+        void Complete(int32 SearchIndex, bool bWasSuccessful)
+        {
+            Searches[SearchIndex]->SearchState = bWasSuccessful ? EOnlineAsyncTaskState::Done : EOnlineAsyncTaskState::Failed;
+            TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
+        }
+
+        TArray<TSharedRef<FOnlineSessionSearch>> Searches;
+    };
+
+    // HasUniqueSessionIds returns 'true' when no session appears twice in the search.
+    bool HasUniqueSessionIds(const FOnlineSessionSearch& Search)
+    {
+        TSet<FString> SessionIds;
+        for (const FOnlineSessionSearchResult& Result : Search.SearchResults)
+        {
+            bool bAlreadyMerged = false;
+            SessionIds.Add(Result.GetSessionIdStr(), &bAlreadyMerged);
+            if (bAlreadyMerged)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiProviderMergeTest, "MultiplayerSessions.MultiProvider.Merge",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest searches two mocks with different seeds, and checks that results are merged as each provider streams them,
+// that hosts found by both are merged by owner name, and that a straggler is cancelled with its results so far kept.
+bool FMultiProviderMergeTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumSessions = 10;
+    const TSharedRef<FMockSessionBackend> Fast = MakeMock(1, NumSessions, 1.f);
+    const TSharedRef<FMockSessionBackend> Slow = MakeMock(2, NumSessions, 2.f);
+
+    FMultiplayerMultiProviderSettings Settings;
+    Settings.StragglerTimeoutSeconds = 0.f;
+    FMultiProviderSessionBackend Backend({ Fast, Slow }, Settings, true);
+    const FUniqueNetIdPtr PlayerId = Backend.GetDefaultPlayerId();
+
+    TArray<bool> Completed;
+    Backend.AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateLambda([&Completed](bool bWasSuccessful) { Completed.Add(bWasSuccessful); }));
+
+    // The fast provider's results are merged when it completes, and the slow provider's as it streams them.
+    TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+    Search->MaxSearchResults = 100;
+    TestTrue(TEXT("FindSessions starts"), Backend.FindSessions(*PlayerId, Search));
+    Fast->Advance(1.0);
+    Slow->Advance(1.0);
+    Backend.ProcessPending();
+    TestEqual(TEXT("The fast provider's results and half of the slow provider's are merged"), Search->SearchResults.Num(), NumSessions + NumSessions / 2);
+    TestEqual(TEXT("The search waits for the slow provider"), Completed.Num(), 0);
+    Slow->Advance(1.0);
+    TestTrue(TEXT("The search completes with the slow provider"), Completed == TArray<bool>{ true });
+    TestEqual(TEXT("Sessions with different IDs are all merged"), Search->SearchResults.Num(), 2 * NumSessions);
+    TestTrue(TEXT("Each session is merged once"), HasUniqueSessionIds(*Search));
+    TestTrue(TEXT("The merged search is done"), Search->SearchState == EOnlineAsyncTaskState::Done);
+    TestEqual(TEXT("The slow provider's results are counted"), Backend.GetProviderStats(1).ResultsReceived, (int64)NumSessions);
+
+    // Both mocks name their hosts alike, so merging by owner name keeps only the first provider's copy of each host.
+    Settings.bMergeByOwnerName = true;
+    FMultiProviderSessionBackend OwnerBackend({ MakeMock(1, NumSessions, 1.f), MakeMock(2, NumSessions, 1.f) }, Settings, true);
+    TArray<bool> OwnerCompleted;
+    OwnerBackend.AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateLambda([&OwnerCompleted](bool bWasSuccessful) { OwnerCompleted.Add(bWasSuccessful); }));
+    Search = MakeShared<FOnlineSessionSearch>();
+    Search->MaxSearchResults = 100;
+    TestTrue(TEXT("FindSessions starts when merging by owner name"), OwnerBackend.FindSessions(*PlayerId, Search));
+    static_cast<FMockSessionBackend&>(OwnerBackend.GetProvider(0)).Advance(1.0);
+    static_cast<FMockSessionBackend&>(OwnerBackend.GetProvider(1)).Advance(1.0);
+    TestTrue(TEXT("The search merged by owner name completes"), OwnerCompleted == TArray<bool>{ true });
+    TestEqual(TEXT("Each host is merged once"), Search->SearchResults.Num(), NumSessions);
+    TestEqual(TEXT("The second provider's copies are dropped"), OwnerBackend.GetProviderStats(1).DuplicatesDropped, (int64)NumSessions);
+
+    // A provider still searching after the straggler timeout is cancelled, and the results it streamed so far are kept.
+    Settings.bMergeByOwnerName = false;
+    Settings.StragglerTimeoutSeconds = 0.01f;
+    FMultiProviderSessionBackend StragglerBackend({ MakeMock(1, NumSessions, 1.f), MakeMock(2, NumSessions, 2.f) }, Settings, true);
+    TArray<bool> StragglerCompleted;
+    StragglerBackend.AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateLambda([&StragglerCompleted](bool bWasSuccessful) { StragglerCompleted.Add(bWasSuccessful); }));
+    Search = MakeShared<FOnlineSessionSearch>();
+    Search->MaxSearchResults = 100;
+    TestTrue(TEXT("FindSessions starts with a straggler timeout"), StragglerBackend.FindSessions(*PlayerId, Search));
+    FMockSessionBackend& Straggler = static_cast<FMockSessionBackend&>(StragglerBackend.GetProvider(1));
+    static_cast<FMockSessionBackend&>(StragglerBackend.GetProvider(0)).Advance(1.0);
+    Straggler.Advance(1.0);
+    FPlatformProcess::Sleep(0.05f);
+    StragglerBackend.ProcessPending();
+    TestTrue(TEXT("The search completes without the straggler"), StragglerCompleted == TArray<bool>{ true });
+    TestEqual(TEXT("The straggler's results so far are kept"), Search->SearchResults.Num(), NumSessions + NumSessions / 2);
+    TestEqual(TEXT("The straggler is counted as timed out"), StragglerBackend.GetProviderStats(1).TimedOut, 1);
+    Straggler.Advance(1.0);
+    StragglerBackend.ProcessPending();
+    TestEqual(TEXT("The cancelled straggler delivers nothing more"), StragglerCompleted.Num(), 1);
+    TestEqual(TEXT("The merged search is unchanged"), Search->SearchResults.Num(), NumSessions + NumSessions / 2);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiProviderStaleCompletionTest, "MultiplayerSessions.MultiProvider.StaleCompletion",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest cancels a search, starts another one, and has a provider complete the cancelled search first.
+// The late completion must not complete the provider's part of the new search.
+bool FMultiProviderStaleCompletionTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumSessions = 10;
+    const TSharedRef<FMockSessionBackend> Mock = MakeMock(1, NumSessions, 1.f);
+    const TSharedRef<FManualSearchBackend> Manual = MakeShared<FManualSearchBackend>();
+
+    FMultiplayerMultiProviderSettings Settings;
+    Settings.StragglerTimeoutSeconds = 0.f;
+    FMultiProviderSessionBackend Backend({ Mock, Manual }, Settings, true);
+    const FUniqueNetIdPtr PlayerId = Backend.GetDefaultPlayerId();
+
+    TArray<bool> Completed;
+    Backend.AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateLambda([&Completed](bool bWasSuccessful) { Completed.Add(bWasSuccessful); }));
+
+    const TSharedRef<FOnlineSessionSearch> Cancelled = MakeShared<FOnlineSessionSearch>();
+    Cancelled->MaxSearchResults = 100;
+    TestTrue(TEXT("The first search starts"), Backend.FindSessions(*PlayerId, Cancelled));
+    TestTrue(TEXT("The first search is cancelled"), Backend.CancelFindSessions());
+
+    const TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+    Search->MaxSearchResults = 100;
+    TestTrue(TEXT("The second search starts"), Backend.FindSessions(*PlayerId, Search));
+    if (!TestEqual(TEXT("The manual provider received both searches"), Manual->Searches.Num(), 2))
+    {
+        return false;
+    }
+
+    // The manual provider completes the cancelled search while the new one is in flight.
+    Manual->Complete(0, true);
+    TestEqual(TEXT("The stale completion is counted"), Backend.GetProviderStats(1).StaleCompletions, 1);
+    Mock->Advance(1.0);
+    Backend.ProcessPending();
+    TestEqual(TEXT("The search waits for the manual provider's own completion"), Completed.Num(), 0);
+    TestEqual(TEXT("The mock's results are merged"), Search->SearchResults.Num(), NumSessions);
+    TestTrue(TEXT("The merged search is in progress"), Search->SearchState == EOnlineAsyncTaskState::InProgress);
+
+    Manual->Complete(1, false);
+    TestTrue(TEXT("The search completes with the manual provider, and succeeds through the mock"), Completed == TArray<bool>{ true });
+    TestEqual(TEXT("The manual provider's own failure is counted"), Backend.GetProviderStats(1).Failures, 1);
+    TestTrue(TEXT("The cancelled search stays failed"), Cancelled->SearchState == EOnlineAsyncTaskState::Failed);
+
+    // Completions after the search completed are stale too.
+    Manual->Complete(1, true);
+    TestEqual(TEXT("A repeated completion is ignored"), Completed.Num(), 1);
+    TestEqual(TEXT("Both stale completions are counted"), Backend.GetProviderStats(1).StaleCompletions, 2);
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+#include "MultiplayerSessionsSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+ * FMultiplayerSessionsTestInstance creates a standalone game instance for a test, so the subsystem is initialized as it is in a game.
+ * The instance has no local players, so sessions are created and joined with the backend's default player ID.
+ */
+class FMultiplayerSessionsTestInstance
+{
+public:
+	FMultiplayerSessionsTestInstance()
+	{
+		GameInstance = NewObject<UGameInstance>(GEngine);
+		GameInstance->AddToRoot();
+		GameInstance->InitializeStandalone();
+	}
+
+	// ~FMultiplayerSessionsTestInstance deinitializes the subsystem and destroys the instance's world.
+	~FMultiplayerSessionsTestInstance()
+	{
+		UWorld* World = GameInstance->GetWorld();
+		GameInstance->Shutdown();
+		if (World)
+		{
+			World->DestroyWorld(false);
+		}
+		GameInstance->RemoveFromRoot();
+	}
+
+	FMultiplayerSessionsTestInstance(const FMultiplayerSessionsTestInstance&) = delete;
+	FMultiplayerSessionsTestInstance& operator=(const FMultiplayerSessionsTestInstance&) = delete;
+
+	UMultiplayerSessionsSubsystem* GetSubsystem() const { return GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>(); }
+
+private:
+	UGameInstance* GameInstance{ nullptr };
+};
+
+#endif
@@ -0,0 +1,44 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+
+#include "MultiplayerSessionsTrace.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionsTraceTest, "MultiplayerSessions.Trace.Regions",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that the channel can be toggled by name, that only one travel region is open at a time,
+// and that shutting down closes a travel region which never finished.
+bool FMultiplayerSessionsTraceTest::RunTest(const FString& Parameters)
+{
+#if UE_TRACE_ENABLED
+    const bool bWasEnabled = MultiplayerSessionsChannel.IsEnabled();
+    UE::Trace::ToggleChannel(TEXT("MultiplayerSessions"), true);
+    TestTrue(TEXT("The channel is enabled by name"), MultiplayerSessionsChannel.IsEnabled());
+    {
+        MULTIPLAYER_TRACE_SCOPE("FMultiplayerSessionsTraceTest");
+    }
+    UE::Trace::ToggleChannel(TEXT("MultiplayerSessions"), bWasEnabled);
+#endif
+
+    if (FMultiplayerSessionsTrace::IsTraveling())
+    {
+        AddInfo(TEXT("A travel is already in progress, so the travel region is not tested"));
+        return true;
+    }
+
+    FMultiplayerSessionsTrace::BeginTravel();
+    TestTrue(TEXT("BeginTravel opens the travel region"), FMultiplayerSessionsTrace::IsTraveling());
+    FMultiplayerSessionsTrace::BeginTravel();
+    TestTrue(TEXT("A second travel keeps the region open"), FMultiplayerSessionsTrace::IsTraveling());
+
+    // The region would otherwise stay open until a map loads. Startup restores the module's map load hook.
+    FMultiplayerSessionsTrace::Shutdown();
+    TestFalse(TEXT("Shutdown closes the travel region"), FMultiplayerSessionsTrace::IsTraveling());
+    FMultiplayerSessionsTrace::Startup();
+    return true;
+}
+
+#endif
\ No newline at end of file
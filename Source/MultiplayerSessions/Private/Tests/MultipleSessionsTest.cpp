@@ -0,0 +1,74 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultipleSessionsTest, "MultiplayerSessions.Subsystem.MultipleSessions",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest hosts many named sessions side by side through a manual-clock mock, and checks that operations on different sessions
+// are sent together, while operations on the same session wait for each other.
+bool FMultipleSessionsTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumSessions = 16;
+
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    FMultiplayerMockBackendSettings Settings;
+    Settings.NumSessions = 0;
+    const TSharedRef<FMockSessionBackend> Backend = MakeShared<FMockSessionBackend>(Settings, true);
+    Sessions->SetBackend(Backend);
+
+    TArray<FName> SessionNames;
+    TArray<TFuture<bool>> Creates;
+    TArray<TFuture<bool>> Starts;
+    for (int32 Index = 0; Index < NumSessions; ++Index)
+    {
+        const FName SessionName(*FString::Printf(TEXT("Party%d"), Index));
+        SessionNames.Add(SessionName);
+        Creates.Add(Sessions->CreateSessionAsync(4, TEXT("FreeForAll"), SessionName));
+        Starts.Add(Sessions->StartSessionAsync(SessionName));
+    }
+    TestEqual(TEXT("Every session's creation is sent at once, and starts wait for them"), Backend->NumPending(), NumSessions);
+
+    while (Backend->AdvanceToNext())
+    {
+    }
+    for (int32 Index = 0; Index < NumSessions; ++Index)
+    {
+        TestTrue(FString::Printf(TEXT("%s is created"), *SessionNames[Index].ToString()), Creates[Index].IsReady() && Creates[Index].Get());
+        TestTrue(FString::Printf(TEXT("%s is started"), *SessionNames[Index].ToString()), Starts[Index].IsReady() && Starts[Index].Get());
+        TestTrue(FString::Printf(TEXT("%s is hosted"), *SessionNames[Index].ToString()), Backend->HasSession(SessionNames[Index]));
+        TestEqual(FString::Printf(TEXT("%s hosts its own connections"), *SessionNames[Index].ToString()), Sessions->GetHostedPublicConnections(SessionNames[Index]), 4);
+    }
+    TestFalse(TEXT("The game session is untouched"), Backend->HasSession(NAME_GameSession));
+
+    TArray<TFuture<bool>> Destroys;
+    for (const FName SessionName : SessionNames)
+    {
+        Destroys.Add(Sessions->DestroySessionAsync(SessionName));
+    }
+    TestEqual(TEXT("Every session's destruction is sent at once"), Backend->NumPending(), NumSessions);
+
+    while (Backend->AdvanceToNext())
+    {
+    }
+    for (int32 Index = 0; Index < NumSessions; ++Index)
+    {
+        TestTrue(FString::Printf(TEXT("%s is destroyed"), *SessionNames[Index].ToString()), Destroys[Index].IsReady() && Destroys[Index].Get());
+        TestFalse(FString::Printf(TEXT("%s is no longer hosted"), *SessionNames[Index].ToString()), Backend->HasSession(SessionNames[Index]));
+    }
+    return true;
+}
+
+#endif
\ No newline at end of file
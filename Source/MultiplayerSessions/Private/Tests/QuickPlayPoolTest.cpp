@@ -0,0 +1,193 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeExit.h"
+#include "OnlineSessionSettings.h"
+
+#include "Logger.h"
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+#include "QuickPlayPool.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // FindMockSessions returns a finished search of NumSessions mock sessions, each with an open slot,
+    // followed by a slower copy of each of the first NumDuplicates sessions.
+    TSharedRef<FOnlineSessionSearch> FindMockSessions(int32 NumSessions, int32 NumDuplicates)
+    {
+        FMultiplayerMockBackendSettings Settings;
+        Settings.NumSessions = NumSessions;
+        FMockSessionBackend Backend(Settings, true);
+
+        const TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+        Search->MaxSearchResults = NumSessions;
+        Backend.FindSessions(*Backend.GetDefaultPlayerId(), Search);
+        while (Backend.AdvanceToNext())
+        {
+        }
+
+        for (FOnlineSessionSearchResult& Result : Search->SearchResults)
+        {
+            Result.Session.NumOpenPublicConnections = FMath::Max(Result.Session.NumOpenPublicConnections, 1);
+        }
+        for (int32 Index = 0; Index < NumDuplicates && Index < NumSessions; ++Index)
+        {
+            FOnlineSessionSearchResult Duplicate = Search->SearchResults[Index];
+            Duplicate.PingInMs += 100;
+            Search->SearchResults.Add(MoveTemp(Duplicate));
+        }
+        return Search;
+    }
+
+    // WaitForRefresh ticks the pool at Now until a refresh finishes, since results are processed on a worker thread.
+    bool WaitForRefresh(FQuickPlayPool& Pool, double Now)
+    {
+        const double Deadline = FPlatformTime::Seconds() + 10.0;
+        while (FPlatformTime::Seconds() < Deadline)
+        {
+            if (Pool.Tick(Now))
+            {
+                return true;
+            }
+            FPlatformProcess::Sleep(0.001f);
+        }
+        return false;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuickPlayPoolTest, "MultiplayerSessions.QuickPlay.Pool",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest drives a pool with a simulated clock, and checks deduplication, ranking into the pool,
+// backoff while the pool is healthy, the reset after an empty refresh, and that stale refreshes are ignored.
+bool FQuickPlayPoolTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerQuickPlaySettings Settings;
+    Settings.MaxCandidates = 5;
+    Settings.HealthyPoolSize = 3;
+    Settings.MinRefreshIntervalSeconds = 3.f;
+    Settings.MaxRefreshIntervalSeconds = 20.f;
+    Settings.BackoffMultiplier = 2.f;
+
+    constexpr int32 NumSessions = 20;
+    constexpr int32 NumDuplicates = 5;
+    const TSharedRef<FOnlineSessionSearch> Search = FindMockSessions(NumSessions, NumDuplicates);
+
+    FQuickPlayPool Pool;
+    double Now = 100.0;
+    TestFalse(TEXT("A pool which has not started is never due"), Pool.IsRefreshDue(Now));
+    Pool.Start(Settings, FMultiplayerSessionScoringWeights(), Now);
+    TestTrue(TEXT("The first refresh is due immediately"), Pool.IsRefreshDue(Now));
+
+    // Results of an earlier refresh are ignored, and refreshes never overlap.
+    const uint32 FirstRefreshId = Pool.BeginRefresh();
+    TestFalse(TEXT("No refresh is due while one is running"), Pool.IsRefreshDue(Now + 1000.0));
+    Pool.ProcessResults(FirstRefreshId - 1, Search, true, Now);
+    TestFalse(TEXT("Stale results do not finish the refresh"), Pool.Tick(Now));
+    TestTrue(TEXT("The refresh is still running"), Pool.IsRefreshing());
+
+    // Duplicates are dropped, and the best sessions fill the pool.
+    Now += 1.0;
+    Pool.ProcessResults(FirstRefreshId, Search, true, Now);
+    if (!TestTrue(TEXT("The refresh finishes"), WaitForRefresh(Pool, Now)))
+    {
+        return false;
+    }
+    TestEqual(TEXT("The pool holds MaxCandidates sessions"), Pool.NumCandidates(), Settings.MaxCandidates);
+    TestEqual(TEXT("Every result is processed"), Pool.GetStats().ResultsProcessed, (int64)(NumSessions + NumDuplicates));
+    TestEqual(TEXT("Duplicates are dropped"), Pool.GetStats().DuplicatesDropped, (int64)NumDuplicates);
+    TestTrue(TEXT("A healthy pool backs off"), Pool.GetRefreshInterval() == 6.0);
+    TestTrue(TEXT("The next refresh is scheduled after the interval"), Pool.GetNextRefreshTime() == Now + 6.0);
+    TestFalse(TEXT("A finished refresh is reported once"), Pool.Tick(Now));
+
+    // The backoff grows with each healthy refresh, up to MaxRefreshIntervalSeconds.
+    for (const double Expected : { 12.0, 20.0, 20.0 })
+    {
+        Now = Pool.GetNextRefreshTime();
+        TestFalse(TEXT("The refresh is not due before its time"), Pool.IsRefreshDue(Now - 0.01));
+        TestTrue(TEXT("The refresh is due at its time"), Pool.IsRefreshDue(Now));
+        Pool.ProcessResults(Pool.BeginRefresh(), Search, true, Now);
+        TestTrue(TEXT("The healthy refresh finishes"), WaitForRefresh(Pool, Now));
+        TestTrue(FString::Printf(TEXT("The interval backs off to %.0fs"), Expected), Pool.GetRefreshInterval() == Expected);
+    }
+
+    // Candidates are taken in rank order, each session once, and leave the pool empty.
+    TSharedPtr<FOnlineSessionSearch> Candidates;
+    TArray<int32> Indices;
+    TestTrue(TEXT("Candidates are taken"), Pool.TakeCandidates(Candidates, Indices));
+    TestTrue(TEXT("Indices cover the candidates in order"), Indices == TArray<int32>{ 0, 1, 2, 3, 4 });
+    TSet<FString> SessionIds;
+    for (const FOnlineSessionSearchResult& Candidate : Candidates->SearchResults)
+    {
+        bool bAlreadyTaken = false;
+        SessionIds.Add(Candidate.GetSessionIdStr(), &bAlreadyTaken);
+        TestFalse(TEXT("Each session is a candidate once"), bAlreadyTaken);
+        TestTrue(TEXT("Candidates have open slots"), Candidate.Session.NumOpenPublicConnections > 0);
+    }
+    TestEqual(TEXT("The pool is empty"), Pool.NumCandidates(), 0);
+    TestFalse(TEXT("An empty pool has no candidates to take"), Pool.TakeCandidates(Candidates, Indices));
+
+    // RefreshNow makes the next refresh due, and a failed refresh resets the interval without a worker.
+    Now += 1.0;
+    Pool.RefreshNow(Now);
+    TestTrue(TEXT("RefreshNow makes a refresh due"), Pool.IsRefreshDue(Now));
+    Pool.ProcessResults(Pool.BeginRefresh(), nullptr, false, Now);
+    TestTrue(TEXT("A failed refresh finishes at once"), Pool.Tick(Now));
+    TestEqual(TEXT("A failed refresh is counted as empty"), Pool.GetStats().EmptyRefreshes, 1);
+    TestTrue(TEXT("An empty pool refreshes at the shortest interval"), Pool.GetRefreshInterval() == 3.0);
+
+    // Stopping discards a refresh which is still being processed.
+    Now = Pool.GetNextRefreshTime();
+    Pool.ProcessResults(Pool.BeginRefresh(), Search, true, Now);
+    Pool.Stop();
+    TestFalse(TEXT("A stopped pool is not active"), Pool.IsActive());
+    TestFalse(TEXT("A stopped pool reports no refresh"), Pool.Tick(Now));
+    TestEqual(TEXT("A stopped pool has no candidates"), Pool.NumCandidates(), 0);
+    TestFalse(TEXT("A stopped pool is never due"), Pool.IsRefreshDue(Now + 1000.0));
+    TestEqual(TEXT("Every refresh is counted"), Pool.GetStats().Refreshes, 6);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuickPlayWithoutBackendTest, "MultiplayerSessions.QuickPlay.WithoutBackend",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that quick play does not start while the subsystem has no backend.
+bool FQuickPlayWithoutBackendTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    Sessions->SetBackend(nullptr);
+
+    // The rejection is logged as an error on the logging thread. Earlier messages are flushed first, so only this test's error is expected,
+    // and again after the call, so the error is written before the test ends. Errors are enabled for the call when the configured level hides them.
+    Logger::Flush();
+    const EMultiplayerLogLevel PreviousLevel = Logger::GetRuntimeLevel();
+    ON_SCOPE_EXIT
+    {
+        Logger::SetRuntimeLevel(PreviousLevel);
+    };
+    if (!Logger::IsEnabled(EMultiplayerLogLevel::Error))
+    {
+        Logger::SetRuntimeLevel(EMultiplayerLogLevel::Error);
+    }
+    if (Logger::IsEnabled(EMultiplayerLogLevel::Error))
+    {
+        AddExpectedError(TEXT("StartQuickPlay: Failed to get SessionInterface"), EAutomationExpectedErrorFlags::Contains, 1);
+    }
+    Sessions->StartQuickPlay(FMultiplayerSessionSearchFilter());
+    Logger::Flush();
+
+    TestFalse(TEXT("Quick play does not start without a backend"), Sessions->IsQuickPlayActive());
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // HostAndComplete hosts SessionName with MatchType, and delivers every completion of the manual-clock mock.
+    // bOutAlwaysAdvertised is set to 'false' when the session disappeared from the backend at any point.
+    bool HostAndComplete(UMultiplayerSessionsSubsystem& Sessions, FMockSessionBackend& Backend, FName SessionName, const FString& MatchType, bool& bOutAlwaysAdvertised)
+    {
+        TFuture<bool> Create = Sessions.CreateSessionAsync(4, MatchType, SessionName);
+        bOutAlwaysAdvertised = Backend.HasSession(SessionName);
+        while (Backend.AdvanceToNext())
+        {
+            bOutAlwaysAdvertised &= Backend.HasSession(SessionName);
+        }
+        return Create.IsReady() && Create.Get();
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRehostTest, "MultiplayerSessions.Subsystem.Rehost",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest hosts a session again with new settings, and checks that it is updated in place without downtime,
+// recreated when warm re-hosting is disabled, and recreated when the provider rejects the update.
+bool FRehostTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    const TSharedRef<FMockSessionBackend> Backend = MakeShared<FMockSessionBackend>(FMultiplayerMockBackendSettings(), true);
+    Sessions->SetBackend(Backend);
+    Sessions->ResetMetrics();
+
+    const FName PartySession(TEXT("Party"));
+    bool bAlwaysAdvertised = false;
+    if (!TestTrue(TEXT("The session is created"), HostAndComplete(*Sessions, *Backend, PartySession, TEXT("FreeForAll"), bAlwaysAdvertised)))
+    {
+        return false;
+    }
+
+    // Hosting again while hosting updates the live session, which stays visible throughout.
+    TestTrue(TEXT("The session is re-hosted"), HostAndComplete(*Sessions, *Backend, PartySession, TEXT("TeamDeathmatch"), bAlwaysAdvertised));
+    TestTrue(TEXT("An updated session is always advertised"), bAlwaysAdvertised);
+    const FMultiplayerRehostStats& Stats = Sessions->GetRehostStats();
+    TestEqual(TEXT("The session is updated in place"), Stats.Updates, 1);
+    TestEqual(TEXT("The session is not recreated"), Stats.Recreates, 0);
+    TestEqual(TEXT("The update latency is recorded"), Stats.UpdateLatency.GetCount(), (int64)1);
+    TestTrue(TEXT("An update has no downtime"), Stats.LastDowntimeSeconds == 0.0);
+
+    const FSessionOperationMetrics& Create = Sessions->GetMetrics().Get(EMultiplayerSessionOperation::Create);
+    TestTrue(TEXT("The update is reported as a result"), Create.Results.FindRef(TEXT("Updated")) == 1);
+
+    // Without warm re-hosting, the session is destroyed and created again.
+    {
+        TGuardValue<bool> WarmRehostGuard(GetMutableDefault<UMultiplayerSessionsSettings>()->bWarmRehost, false);
+        TestTrue(TEXT("The session is re-hosted without warm re-hosting"), HostAndComplete(*Sessions, *Backend, PartySession, TEXT("FreeForAll"), bAlwaysAdvertised));
+    }
+    TestFalse(TEXT("A recreated session is not advertised for a while"), bAlwaysAdvertised);
+    TestEqual(TEXT("The session is recreated"), Stats.Recreates, 1);
+    TestEqual(TEXT("The downtime is recorded"), Stats.RecreateDowntime.GetCount(), (int64)1);
+    TestTrue(TEXT("The recreation is reported as a result"), Create.Results.FindRef(TEXT("Recreated")) == 1);
+
+    // A provider which rejects updates falls back to recreating the session.
+    FMultiplayerMockBackendSettings RejectingSettings;
+    RejectingSettings.Update.FailureRate = 1.f;
+    const TSharedRef<FMockSessionBackend> RejectingBackend = MakeShared<FMockSessionBackend>(RejectingSettings, true);
+    Sessions->SetBackend(RejectingBackend);
+    TestTrue(TEXT("The session is created on the new backend"), HostAndComplete(*Sessions, *RejectingBackend, PartySession, TEXT("FreeForAll"), bAlwaysAdvertised));
+    TestTrue(TEXT("The rejected session is re-hosted"), HostAndComplete(*Sessions, *RejectingBackend, PartySession, TEXT("TeamDeathmatch"), bAlwaysAdvertised));
+    TestEqual(TEXT("The rejected update falls back"), Sessions->GetRehostStats().UpdateFallbacks, 1);
+    TestEqual(TEXT("The rejected update is recreated"), Sessions->GetRehostStats().Recreates, 2);
+    TestEqual(TEXT("Only accepted updates are counted"), Sessions->GetRehostStats().Updates, 1);
+    TestTrue(TEXT("The session exists after the fallback"), RejectingBackend->HasSession(PartySession));
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "Containers/Ticker.h"
+#include "OnlineSessionSettings.h"
+
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+#include "SessionSearchFilter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // FStreamedBatch records one broadcast of MultiplayerOnFindSessionsBatch.
+    struct FStreamedBatch
+    {
+        int32 NumResults{ 0 };
+        bool bIsFinal{ false };
+        FString LastSessionId;
+    };
+
+    // RunSearch advances the mock in small steps, ticking the core ticker after each, until the final batch arrives.
+    void RunSearch(FMockSessionBackend& Backend, const TArray<FStreamedBatch>& Batches)
+    {
+        for (int32 Step = 0; Step < 1000 && (Batches.Num() == 0 || !Batches.Last().bIsFinal); ++Step)
+        {
+            Backend.Advance(0.01);
+            FTSTicker::GetCoreTicker().Tick(0.01f);
+        }
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSearchStreamingTest, "MultiplayerSessions.Subsystem.StreamingSearch",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest streams a search whose results arrive gradually, and checks that every result is delivered once, in bounded batches,
+// with a single final batch. A second search stops at the first result which satisfies its predicate.
+bool FSearchStreamingTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    constexpr int32 NumSessions = 40;
+    constexpr int32 BatchSize = 8;
+    FMultiplayerMockBackendSettings Settings;
+    Settings.NumSessions = NumSessions;
+    Settings.Find.MinLatencySeconds = 0.2f;
+    Settings.Find.MaxLatencySeconds = 0.2f;
+    const TSharedRef<FMockSessionBackend> Backend = MakeShared<FMockSessionBackend>(Settings, true);
+    Sessions->SetBackend(Backend);
+
+    TArray<FStreamedBatch> Batches;
+    const FDelegateHandle BatchHandle = Sessions->MultiplayerOnFindSessionsBatch.AddLambda(
+        [&Batches](TArrayView<const FOnlineSessionSearchResult> Results, bool bIsFinalBatch)
+        {
+            FStreamedBatch& Batch = Batches.AddDefaulted_GetRef();
+            Batch.NumResults = Results.Num();
+            Batch.bIsFinal = bIsFinalBatch;
+            Batch.LastSessionId = Results.Num() > 0 ? Results.Last().GetSessionIdStr() : FString();
+        });
+    TArray<FString> Matches;
+    const FDelegateHandle MatchHandle = Sessions->MultiplayerOnFindSessionsMatch.AddLambda(
+        [&Matches](const FOnlineSessionSearchResult& Result) { Matches.Add(Result.GetSessionIdStr()); });
+
+    Sessions->FindSessionsStreaming(NumSessions, FMultiplayerSessionSearchFilter(), BatchSize);
+    RunSearch(*Backend, Batches);
+
+    int32 NumStreamed = 0;
+    int32 NumFinal = 0;
+    bool bBatchesBounded = true;
+    for (const FStreamedBatch& Batch : Batches)
+    {
+        NumStreamed += Batch.NumResults;
+        NumFinal += Batch.bIsFinal ? 1 : 0;
+        bBatchesBounded &= Batch.NumResults <= BatchSize;
+    }
+    TestTrue(TEXT("Results arrive in more than one batch"), Batches.Num() > 1);
+    TestTrue(TEXT("No batch is larger than the batch size"), bBatchesBounded);
+    TestEqual(TEXT("Every result is streamed once"), NumStreamed, NumSessions);
+    TestEqual(TEXT("There is one final batch"), NumFinal, 1);
+    TestTrue(TEXT("The final batch is the last"), Batches.Num() > 0 && Batches.Last().bIsFinal);
+
+    const FMultiplayerSearchStreamStats& Stats = Sessions->GetLastSearchStreamStats();
+    TestEqual(TEXT("Stats count every batch"), Stats.BatchesEmitted, Batches.Num());
+    TestEqual(TEXT("Stats count every result"), Stats.ResultsEmitted, NumSessions);
+    TestTrue(TEXT("The first result arrives before the search completes"), Stats.TimeToFirstResult >= 0.0 && Stats.TimeToFirstResult <= Stats.TimeToComplete);
+    TestFalse(TEXT("A search without a predicate does not exit early"), Stats.bExitedEarly);
+    TestEqual(TEXT("Nothing matches without a predicate"), Matches.Num(), 0);
+
+    // The fifth result satisfies the predicate, so the search stops there.
+    Batches.Reset();
+    Sessions->InvalidateSearchCache();
+    int32 NumChecked = 0;
+    Sessions->FindSessionsStreaming(NumSessions, FMultiplayerSessionSearchFilter(), BatchSize,
+        [&NumChecked](const FOnlineSessionSearchResult&) { return ++NumChecked == 5; });
+    RunSearch(*Backend, Batches);
+
+    NumStreamed = 0;
+    for (const FStreamedBatch& Batch : Batches)
+    {
+        NumStreamed += Batch.NumResults;
+    }
+    TestEqual(TEXT("Results stop at the match"), NumStreamed, 5);
+    TestEqual(TEXT("The match is broadcast once"), Matches.Num(), 1);
+    TestTrue(TEXT("The final batch ends with the match"), Batches.Num() > 0 && Batches.Last().bIsFinal && Matches.Num() == 1 && Batches.Last().LastSessionId == Matches[0]);
+    TestTrue(TEXT("The search exits early"), Sessions->GetLastSearchStreamStats().bExitedEarly);
+    TestTrue(TEXT("The time to the match is recorded"), Sessions->GetLastSearchStreamStats().TimeToFirstJoinableSession >= 0.0);
+
+    Sessions->MultiplayerOnFindSessionsBatch.Remove(BatchHandle);
+    Sessions->MultiplayerOnFindSessionsMatch.Remove(MatchHandle);
+    return true;
+}
+
+#endif
\ No newline at end of file
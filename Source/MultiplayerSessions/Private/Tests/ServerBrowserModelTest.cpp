@@ -0,0 +1,133 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformProcess.h"
+#include "OnlineSessionSettings.h"
+
+#include "ServerBrowserModel.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // MakeResults returns search results for hosts "Host<First>" onwards, with pings and player counts which repeat,
+    // so sorts have ties to break by arrival order.
+    TArray<FOnlineSessionSearchResult> MakeResults(int32 First, int32 Num)
+    {
+        TArray<FOnlineSessionSearchResult> Results;
+        for (int32 Index = First; Index < First + Num; ++Index)
+        {
+            FOnlineSessionSearchResult& Result = Results.AddDefaulted_GetRef();
+            Result.PingInMs = 20 + (Index * 37) % 100;
+            Result.Session.OwningUserName = FString::Printf(TEXT("Host%03d"), Index);
+            Result.Session.SessionSettings.NumPublicConnections = 4;
+            Result.Session.NumOpenPublicConnections = Index % 5;
+            Result.Session.SessionSettings.Set(SETTING_MAPNAME, FString::Printf(TEXT("/Game/Maps/Map%d"), Index % 3), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+        return Results;
+    }
+
+    // WaitForSort ticks the model until the requested order has been applied.
+    void WaitForSort(FServerBrowserModel& Model)
+    {
+        const double Deadline = FPlatformTime::Seconds() + 10.0;
+        while (Model.IsSorting() && FPlatformTime::Seconds() < Deadline)
+        {
+            Model.Tick();
+            FPlatformProcess::Sleep(0.001f);
+        }
+    }
+
+    // IsViewSorted returns 'true' when each visible row sorts before the next one by the model's sort key.
+    bool IsViewSorted(const FServerBrowserModel& Model)
+    {
+        const TConstArrayView<int32> View = Model.GetView();
+        for (int32 Position = 1; Position < View.Num(); ++Position)
+        {
+            const FServerBrowserRow& A = Model.GetRow(View[Position - 1]);
+            const FServerBrowserRow& B = Model.GetRow(View[Position]);
+            int32 Comparison = 0;
+            switch (Model.GetSortKey())
+            {
+            case EServerBrowserSortKey::Ping: Comparison = A.PingMs - B.PingMs; break;
+            case EServerBrowserSortKey::Players: Comparison = A.NumPlayers - B.NumPlayers; break;
+            case EServerBrowserSortKey::Name: Comparison = A.OwnerName.Compare(B.OwnerName, ESearchCase::IgnoreCase); break;
+            case EServerBrowserSortKey::Map: Comparison = A.MapName.Compare(B.MapName, ESearchCase::IgnoreCase); break;
+            }
+            if (!Model.IsAscending())
+            {
+                Comparison = -Comparison;
+            }
+            if (Comparison > 0 || (Comparison == 0 && View[Position - 1] > View[Position]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FServerBrowserModelTest, "MultiplayerSessions.ServerBrowser.Model",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest streams batches into the model while sorts and filters run on worker threads, and checks the visible rows after each step.
+bool FServerBrowserModelTest::RunTest(const FString& Parameters)
+{
+    FServerBrowserModel Model;
+
+    // Streamed batches are merged into the visible rows in the applied order, without a sort.
+    for (int32 Batch = 0; Batch < 4; ++Batch)
+    {
+        Model.AddResults(MakeResults(Batch * 25, 25), Batch * 25);
+        TestTrue(TEXT("The view changes when a batch arrives"), Model.Tick());
+    }
+    TestEqual(TEXT("Every result becomes a row"), Model.NumRows(), 100);
+    TestEqual(TEXT("Every row is visible"), Model.GetView().Num(), 100);
+    TestTrue(TEXT("Merged rows are sorted by ping"), IsViewSorted(Model));
+    TestEqual(TEXT("Rows record their position in the search"), Model.GetRow(42).ResultIndex, 42);
+    TestEqual(TEXT("Rows show the map's short name"), Model.GetRow(4).MapName, FString(TEXT("Map1")));
+    TestEqual(TEXT("Rows count the players in the session"), Model.GetRow(4).NumPlayers, 0);
+    TestFalse(TEXT("Nothing changes without a batch"), Model.Tick());
+
+    // Rows which arrive while a sort is running are merged in when it is applied.
+    Model.SetSort(EServerBrowserSortKey::Name, false);
+    TestTrue(TEXT("The sort is pending"), Model.IsSorting());
+    Model.AddResults(MakeResults(100, 25), 100);
+    WaitForSort(Model);
+    TestFalse(TEXT("The sort completes"), Model.IsSorting());
+    TestEqual(TEXT("Rows added during the sort are visible"), Model.GetView().Num(), 125);
+    TestTrue(TEXT("Rows are sorted by name, descending"), IsViewSorted(Model));
+    TestEqual(TEXT("The last host is first"), Model.GetRow(Model.GetView()[0]).OwnerName, FString(TEXT("Host124")));
+
+    // Filters hide rows, and later batches are filtered as they arrive.
+    FServerBrowserFilter Filter;
+    Filter.bHideFullSessions = true;
+    Filter.Text = TEXT("Map2");
+    Model.SetFilter(Filter);
+    WaitForSort(Model);
+    Model.AddResults(MakeResults(125, 25), 125);
+    int32 NumExpected = 0;
+    for (int32 RowIndex = 0; RowIndex < Model.NumRows(); ++RowIndex)
+    {
+        const FServerBrowserRow& Row = Model.GetRow(RowIndex);
+        NumExpected += Row.NumPlayers < Row.MaxPlayers && Row.MapName == TEXT("Map2") ? 1 : 0;
+    }
+    TestEqual(TEXT("Only matching rows are visible"), Model.GetView().Num(), NumExpected);
+    TestTrue(TEXT("Filtered rows stay sorted"), IsViewSorted(Model));
+    for (const int32 RowIndex : Model.GetView())
+    {
+        TestFalse(TEXT("Full sessions are hidden"), Model.GetRow(RowIndex).NumPlayers >= Model.GetRow(RowIndex).MaxPlayers);
+    }
+
+    // A sort started before a reset is discarded, since its rows no longer exist.
+    const int32 SortsApplied = Model.GetStats().SortsApplied;
+    Model.SetSort(EServerBrowserSortKey::Ping, true);
+    Model.Reset();
+    WaitForSort(Model);
+    TestEqual(TEXT("The stale sort is discarded"), Model.GetStats().SortsDiscarded, 1);
+    TestEqual(TEXT("The stale sort is not applied"), Model.GetStats().SortsApplied, SortsApplied);
+    TestEqual(TEXT("The reset model has no rows"), Model.GetView().Num(), 0);
+    return true;
+}
+
+#endif
\ No newline at end of file
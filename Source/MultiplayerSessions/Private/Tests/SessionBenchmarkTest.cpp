@@ -0,0 +1,95 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformProcess.h"
+
+#include "MultiplayerSessionBackend.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+#include "SessionBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionBenchmarkConfigTest, "MultiplayerSessions.Benchmark.Config",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that Parse reads each key, and keeps defaults for missing or invalid values.
+bool FSessionBenchmarkConfigTest::RunTest(const FString& Parameters)
+{
+    const FSessionBenchmarkConfig Config = FSessionBenchmarkConfig::Parse({
+        TEXT("Backend=Directory"), TEXT("Cycles=3"), TEXT("MaxResults=10,0,20"), TEXT("Concurrency=x"), TEXT("MaxP95Ms=50"), TEXT("-exit")
+    });
+    TestTrue(TEXT("The backend is read"), Config.Backend == FName("Directory"));
+    TestEqual(TEXT("Cycles are read"), Config.Cycles, 3);
+    TestTrue(TEXT("Invalid counts are skipped"), Config.MaxSearchResults == TArray<int32>{ 10, 20 });
+    TestTrue(TEXT("A list without valid counts keeps the default"), Config.Concurrency == FSessionBenchmarkConfig().Concurrency);
+    TestTrue(TEXT("Thresholds are read"), Config.MaxCycleP95Ms == 50.0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionBenchmarkSmokeTest, "MultiplayerSessions.Benchmark.Smoke",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest runs a couple of small cycles against the mock and directory backends, ticking the core ticker as the game would,
+// and checks that every cycle completes, latencies are recorded, and the subsystem gets its backend back.
+bool FSessionBenchmarkSmokeTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+    const TSharedPtr<IMultiplayerSessionBackend> OriginalBackend = Sessions->GetBackend();
+
+    for (const FName Backend : { FName("Mock"), FName("Directory") })
+    {
+        FSessionBenchmarkConfig Config;
+        Config.Backend = Backend;
+        Config.Cycles = 2;
+        Config.MaxSearchResults = { 10 };
+        Config.Concurrency = { 1 };
+        Config.Sessions = { 1 };
+
+        const TSharedRef<FSessionBenchmark> Benchmark = MakeShared<FSessionBenchmark>(Sessions, Config);
+        bool bFinished = false;
+        bool bPassed = false;
+        Benchmark->Start([&bFinished, &bPassed](bool bInPassed)
+        {
+            bFinished = true;
+            bPassed = bInPassed;
+        });
+
+        const double Deadline = FPlatformTime::Seconds() + 30.0;
+        while (Benchmark->IsRunning() && FPlatformTime::Seconds() < Deadline)
+        {
+            FTSTicker::GetCoreTicker().Tick(0.01f);
+            FPlatformProcess::Sleep(0.001f);
+        }
+        if (!TestTrue(FString::Printf(TEXT("The %s run finishes"), *Backend.ToString()), bFinished))
+        {
+            Benchmark->Stop();
+            return false;
+        }
+
+        TestTrue(TEXT("The run passes without thresholds"), bPassed);
+        if (TestEqual(TEXT("One scenario runs"), Benchmark->GetResults().Num(), 1))
+        {
+            const FSessionBenchmarkScenarioResult& Scenario = Benchmark->GetResults()[0];
+            TestEqual(TEXT("Every cycle completes"), Scenario.CyclesCompleted, Config.Cycles);
+            TestEqual(TEXT("Every cycle is timed"), Scenario.CycleLatency.GetCount(), (int64)Config.Cycles);
+            // Join makes no request when the search found no joinable session.
+            TestTrue(TEXT("Operations are counted"), Scenario.Operations >= Config.Cycles * (NumSessionBenchmarkSteps - 1));
+            TestTrue(TEXT("Searches find sessions"), Scenario.ResultsFound > 0);
+        }
+
+        TArray<FString> Lines;
+        Benchmark->ToCsv().ParseIntoArrayLines(Lines);
+        TestEqual(TEXT("The CSV has a header and one row"), Lines.Num(), 2);
+        TestTrue(TEXT("The subsystem's backend is restored"), Sessions->GetBackend() == OriginalBackend);
+    }
+    return true;
+}
+
+#endif
\ No newline at end of file
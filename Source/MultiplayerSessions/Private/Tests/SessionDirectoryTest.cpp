@@ -0,0 +1,174 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#include "DirectorySessionBackend.h"
+#include "SessionDirectory.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // MakeEntry returns a session for the directory, with every slot open.
+    FSessionDirectoryEntry MakeEntry(int32 Index, const FString& MatchType, const FString& Region, int32 NumOpenSlots)
+    {
+        FSessionDirectoryEntry Entry;
+        Entry.SessionId = FString::Printf(TEXT("Session%d"), Index);
+        Entry.OwnerName = FString::Printf(TEXT("Host%d"), Index);
+        Entry.HostAddress = TEXT("127.0.0.1:7777");
+        Entry.MatchType = MatchType;
+        Entry.Region = Region;
+        Entry.NumPublicConnections = 8;
+        Entry.NumOpenPublicConnections = NumOpenSlots;
+        return Entry;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionDirectoryQueryTest, "MultiplayerSessions.Directory.Query",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest pages through a sharded directory, and checks filtering, removal and expiry.
+bool FSessionDirectoryQueryTest::RunTest(const FString& Parameters)
+{
+    const TCHAR* MatchTypes[] = { TEXT("FreeForAll"), TEXT("TeamDeathmatch") };
+    const TCHAR* Regions[] = { TEXT("us-east"), TEXT("eu-west"), TEXT("ap-south") };
+
+    FSessionDirectory Directory(4);
+    TArray<FSessionDirectoryEntry> Entries;
+    for (int32 Index = 0; Index < 60; ++Index)
+    {
+        Entries.Add(MakeEntry(Index, MatchTypes[Index % 2], Regions[Index % 3], Index % 4));
+    }
+    Directory.Register(MoveTemp(Entries), 0.0);
+    TestEqual(TEXT("Every session is registered"), Directory.Num(), 60);
+
+    // Paging returns every session once, in registration order, across all shards.
+    TArray<FString> Paged;
+    FSessionDirectoryQuery Query;
+    Query.PageSize = 7;
+    int32 NumPages = 0;
+    do
+    {
+        const FSessionDirectoryPage Page = Directory.Query(Query);
+        TestTrue(TEXT("Pages are no larger than the page size"), Page.Entries.Num() <= Query.PageSize);
+        for (const FSessionDirectoryEntry& Entry : Page.Entries)
+        {
+            Paged.Add(Entry.SessionId);
+        }
+        Query.Cursor = Page.NextCursor;
+        NumPages++;
+    }
+    while (Query.Cursor != 0 && NumPages < 100);
+    TestEqual(TEXT("Paging returns every session"), Paged.Num(), 60);
+    for (int32 Index = 0; Index < Paged.Num(); ++Index)
+    {
+        TestEqual(TEXT("Pages are in registration order"), Paged[Index], FString::Printf(TEXT("Session%d"), Index));
+    }
+
+    // Filters are applied inside the directory.
+    FSessionDirectoryQuery Filtered;
+    Filtered.MatchType = TEXT("FreeForAll");
+    Filtered.Region = TEXT("us-east");
+    Filtered.MinOpenSlots = 2;
+    Filtered.PageSize = 100;
+    const FSessionDirectoryPage FilteredPage = Directory.Query(Filtered);
+    for (const FSessionDirectoryEntry& Entry : FilteredPage.Entries)
+    {
+        TestTrue(TEXT("Filtered sessions match"), Entry.MatchType == Filtered.MatchType && Entry.Region == Filtered.Region && Entry.NumOpenPublicConnections >= 2);
+    }
+    TestEqual(TEXT("Every matching session is returned"), FilteredPage.Entries.Num(), 5);
+    TestTrue(TEXT("A short page is the last page"), FilteredPage.NextCursor == 0);
+
+    // Removal, heartbeats and expiry.
+    TestEqual(TEXT("Registered sessions are removed"), Directory.Remove({ TEXT("Session0"), TEXT("Session1"), TEXT("Missing") }), 2);
+    TestEqual(TEXT("Heartbeats count registered sessions"), Directory.Heartbeat({ TEXT("Session2"), TEXT("Session3"), TEXT("Session0") }, 10.0), 2);
+    TestEqual(TEXT("Sessions without a heartbeat expire"), Directory.ExpireStale(12.0, 5.0), 56);
+    TestEqual(TEXT("Sessions with a heartbeat are kept"), Directory.Num(), 2);
+
+    FSessionDirectoryEntry Found;
+    TestTrue(TEXT("Kept sessions can be found"), Directory.Find(TEXT("Session2"), Found));
+    TestFalse(TEXT("Expired sessions cannot be found"), Directory.Find(TEXT("Session4"), Found));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDirectorySessionBackendTest, "MultiplayerSessions.Directory.Backend",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest hosts sessions on one manually ticked backend, and finds and joins them from another through a private directory.
+bool FDirectorySessionBackendTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerDirectoryBackendSettings Settings;
+    Settings.PageSize = 4;
+    const TSharedRef<FSessionDirectory> Directory = MakeShared<FSessionDirectory>(4);
+    FDirectorySessionBackend Host(Settings, Directory, true);
+    FDirectorySessionBackend Client(Settings, Directory, true);
+
+    int32 NumCreated = 0;
+    Host.AddOnCreateSessionCompleteDelegate_Handle(FOnCreateSessionCompleteDelegate::CreateLambda([&NumCreated](FName Name, bool bWasSuccessful)
+    {
+        NumCreated += bWasSuccessful ? 1 : 0;
+    }));
+
+    // Registrations are sent as one batch by the next tick, and completions follow it.
+    FOnlineSessionSettings SessionSettings;
+    SessionSettings.NumPublicConnections = 4;
+    SessionSettings.bShouldAdvertise = true;
+    SessionSettings.Set(FName("MatchType"), FString(TEXT("FreeForAll")), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+    const FUniqueNetIdPtr HostId = Host.GetDefaultPlayerId();
+    for (int32 Index = 0; Index < 10; ++Index)
+    {
+        TestTrue(TEXT("CreateSession starts"), Host.CreateSession(*HostId, FName(*FString::Printf(TEXT("Hosted%d"), Index)), SessionSettings));
+    }
+    TestEqual(TEXT("Nothing is registered before the tick"), Directory->Num(), 0);
+    Host.ProcessPending();
+    TestEqual(TEXT("Every session is registered by one batch"), Directory->Num(), 10);
+    TestEqual(TEXT("One batch is sent"), Host.GetStats().Batches, int64(1));
+    TestEqual(TEXT("Every creation completes"), NumCreated, 10);
+
+    // Searches fetch one page per tick.
+    bool bSearchSucceeded = false;
+    Client.AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateLambda([&bSearchSucceeded](bool bWasSuccessful)
+    {
+        bSearchSucceeded = bWasSuccessful;
+    }));
+    const TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+    Search->MaxSearchResults = 100;
+    Search->QuerySettings.Set(FName("MatchType"), FString(TEXT("FreeForAll")), EOnlineComparisonOp::Equals);
+    const FUniqueNetIdPtr ClientId = Client.GetDefaultPlayerId();
+    TestTrue(TEXT("FindSessions starts"), Client.FindSessions(*ClientId, Search));
+    Client.ProcessPending();
+    TestEqual(TEXT("The first tick fetches one page"), Search->SearchResults.Num(), 4);
+    int32 NumTicks = 1;
+    while (Client.ProcessPending() && NumTicks < 100)
+    {
+        NumTicks++;
+    }
+    TestTrue(TEXT("The search succeeds"), bSearchSucceeded);
+    TestEqual(TEXT("The search finds every session"), Search->SearchResults.Num(), 10);
+    TestEqual(TEXT("The search fetches three pages"), Client.GetStats().PagesFetched, int64(3));
+
+    // Joins look the session up in the directory.
+    EOnJoinSessionCompleteResult::Type JoinResult = EOnJoinSessionCompleteResult::UnknownError;
+    Client.AddOnJoinSessionCompleteDelegate_Handle(FOnJoinSessionCompleteDelegate::CreateLambda([&JoinResult](FName Name, EOnJoinSessionCompleteResult::Type Result)
+    {
+        JoinResult = Result;
+    }));
+    TestTrue(TEXT("JoinSession starts"), Client.JoinSession(*ClientId, NAME_GameSession, Search->SearchResults[0]));
+    Client.ProcessPending();
+    TestTrue(TEXT("The join succeeds"), JoinResult == EOnJoinSessionCompleteResult::Success);
+    FString ConnectInfo;
+    TestTrue(TEXT("The joined session has an address"), Client.GetResolvedConnectString(NAME_GameSession, ConnectInfo));
+    TestEqual(TEXT("The address is the host's"), ConnectInfo, Settings.HostAddress);
+
+    // Destroyed sessions are removed from the directory, and cannot be joined.
+    TestTrue(TEXT("DestroySession starts"), Host.DestroySession(FName(TEXT("Hosted1"))));
+    Host.ProcessPending();
+    TestEqual(TEXT("The destroyed session is removed"), Directory->Num(), 9);
+    TestTrue(TEXT("JoinSession starts for a destroyed session"), Client.JoinSession(*ClientId, FName(TEXT("Other")), Search->SearchResults[1]));
+    Client.ProcessPending();
+    TestTrue(TEXT("Joining a destroyed session fails"), JoinResult == EOnJoinSessionCompleteResult::SessionDoesNotExist);
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformProcess.h"
+
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+#include "SessionMetrics.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLatencyHistogramTest, "MultiplayerSessions.Metrics.Histogram",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest records a uniform spread of durations, and checks that percentiles are within the histogram's precision,
+// that the extremes are exact, and that merged histograms match one recorded directly.
+bool FLatencyHistogramTest::RunTest(const FString& Parameters)
+{
+    FLatencyHistogram Empty;
+    TestTrue(TEXT("An empty histogram reports zero"), Empty.GetPercentile(50.0) == 0.0 && Empty.GetMinSeconds() == 0.0 && Empty.GetMeanSeconds() == 0.0);
+
+    // One sample per millisecond from 1ms to 1000ms, split across two histograms.
+    FLatencyHistogram All;
+    FLatencyHistogram Odd;
+    FLatencyHistogram Even;
+    for (int32 Milliseconds = 1; Milliseconds <= 1000; ++Milliseconds)
+    {
+        const double Seconds = Milliseconds * 1e-3;
+        All.Record(Seconds);
+        (Milliseconds % 2 == 1 ? Odd : Even).Record(Seconds);
+    }
+
+    TestEqual(TEXT("Every sample is counted"), All.GetCount(), (int64)1000);
+    TestTrue(TEXT("The minimum is exact"), FMath::IsNearlyEqual(All.GetMinSeconds(), 0.001, 1e-5));
+    TestTrue(TEXT("The maximum is exact"), FMath::IsNearlyEqual(All.GetMaxSeconds(), 1.0, 1e-5));
+    TestTrue(TEXT("The mean is exact"), FMath::IsNearlyEqual(All.GetMeanSeconds(), 0.5005, 1e-5));
+    TestTrue(TEXT("p0 is the minimum"), FMath::IsNearlyEqual(All.GetPercentile(0.0), All.GetMinSeconds()));
+    TestTrue(TEXT("p100 is the maximum"), FMath::IsNearlyEqual(All.GetPercentile(100.0), All.GetMaxSeconds()));
+    for (const double Percentile : { 50.0, 95.0, 99.0 })
+    {
+        const double Expected = Percentile * 1e-2;
+        TestTrue(
+            FString::Printf(TEXT("p%.0f is within the bucket precision"), Percentile),
+            FMath::Abs(All.GetPercentile(Percentile) - Expected) <= Expected * 0.04
+        );
+    }
+
+    Odd.Merge(Even);
+    TestEqual(TEXT("Merging adds the counts"), Odd.GetCount(), All.GetCount());
+    TestTrue(TEXT("Merging keeps the extremes"), Odd.GetMinSeconds() == All.GetMinSeconds() && Odd.GetMaxSeconds() == All.GetMaxSeconds());
+    TestTrue(TEXT("Merging loses no precision"), Odd.GetPercentile(95.0) == All.GetPercentile(95.0));
+
+    All.Record(-1.0);
+    TestTrue(TEXT("Negative durations are recorded as zero"), All.GetMinSeconds() == 0.0);
+    All.Reset();
+    TestEqual(TEXT("Reset discards every sample"), All.GetCount(), (int64)0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionMetricsTest, "MultiplayerSessions.Metrics.Operations",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks the counters directly, that nested game thread scopes are counted once, and that the subsystem
+// records a request, a latency sample and a result for an operation run through a mock.
+bool FSessionMetricsTest::RunTest(const FString& Parameters)
+{
+    FSessionMetrics Metrics;
+    Metrics.NoteRequested(EMultiplayerSessionOperation::Join);
+    Metrics.NoteRequested(EMultiplayerSessionOperation::Join);
+    Metrics.NoteCompleted(EMultiplayerSessionOperation::Join, 0.25, false, TEXT("SessionIsFull"));
+    Metrics.NoteResult(EMultiplayerSessionOperation::Join, true, TEXT("Cached"));
+
+    const FSessionOperationMetrics& Join = Metrics.Get(EMultiplayerSessionOperation::Join);
+    TestEqual(TEXT("Requests are counted"), Join.Requests, (int64)2);
+    TestTrue(TEXT("Outcomes are counted"), Join.Succeeded == 1 && Join.Failed == 1);
+    TestTrue(TEXT("Results are counted by code"), Join.Results.FindRef(TEXT("SessionIsFull")) == 1 && Join.Results.FindRef(TEXT("Cached")) == 1);
+    TestEqual(TEXT("Only completed operations are timed"), Join.Latency.GetCount(), (int64)1);
+    TestEqual(TEXT("Other operations are untouched"), Metrics.Get(EMultiplayerSessionOperation::Create).Requests, (int64)0);
+
+    TArray<FString> Lines;
+    Metrics.ToCsv({}).ParseIntoArrayLines(Lines);
+    TestEqual(TEXT("The CSV has a header and a row per operation"), Lines.Num(), NumMultiplayerSessionOperations + 1);
+
+    const double StartTime = FPlatformTime::Seconds();
+    {
+        FSessionMetrics::FGameThreadScope Outer(Metrics);
+        FSessionMetrics::FGameThreadScope Inner(Metrics);
+        FPlatformProcess::Sleep(0.01f);
+    }
+    const double WallSeconds = FPlatformTime::Seconds() - StartTime;
+    TestTrue(TEXT("Game thread time is counted"), Metrics.GetGameThreadSeconds() >= 0.009);
+    TestTrue(TEXT("Nested scopes are counted once"), Metrics.GetGameThreadSeconds() <= WallSeconds);
+
+    Metrics.Reset();
+    TestTrue(TEXT("Reset clears counters and time"), Metrics.Get(EMultiplayerSessionOperation::Join).Requests == 0 && Metrics.GetGameThreadSeconds() == 0.0);
+
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+    const TSharedRef<FMockSessionBackend> Backend = MakeShared<FMockSessionBackend>(FMultiplayerMockBackendSettings(), true);
+    Sessions->SetBackend(Backend);
+    Sessions->ResetMetrics();
+
+    const FName PartySession(TEXT("Party"));
+    Sessions->CreateSession(4, TEXT("FreeForAll"), PartySession);
+    while (Backend->AdvanceToNext())
+    {
+    }
+    const FSessionOperationMetrics& Create = Sessions->GetMetrics().Get(EMultiplayerSessionOperation::Create);
+    TestEqual(TEXT("The subsystem counts the request"), Create.Requests, (int64)1);
+    TestEqual(TEXT("The subsystem times the operation"), Create.Latency.GetCount(), (int64)1);
+    TestTrue(TEXT("The subsystem records the result"), Create.Succeeded == 1 && Create.Results.FindRef(TEXT("Success")) == 1);
+    TestTrue(TEXT("The subsystem counts game thread time"), Sessions->GetMetrics().GetGameThreadSeconds() > 0.0);
+    return true;
+}
+
+#endif
\ No newline at end of file
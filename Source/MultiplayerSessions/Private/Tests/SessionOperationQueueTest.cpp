@@ -0,0 +1,146 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformProcess.h"
+#include "OnlineSessionSettings.h"
+
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+#include "SessionOperationQueue.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // TimeOutInFlightOperations runs the subsystem's timeout check with a timeout which every in-flight operation has exceeded.
+    void TimeOutInFlightOperations()
+    {
+        TGuardValue<float> TimeoutGuard(GetMutableDefault<UMultiplayerSessionsSettings>()->OperationTimeoutSeconds, 0.001f);
+        FPlatformProcess::Sleep(0.01f);
+        FTSTicker::GetCoreTicker().Tick(1.f);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionOperationQueueTest, "MultiplayerSessions.OperationQueue.Order",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that operations run one at a time in the order they were queued, including operations which complete
+// as they start, and that cancelled and timed out operations are reported.
+bool FSessionOperationQueueTest::RunTest(const FString& Parameters)
+{
+    FSessionOperationQueue Queue(TEXT("Test"));
+    TArray<EMultiplayerSessionOperation> Started;
+    Queue.Enqueue(EMultiplayerSessionOperation::Create, [&Started]() { Started.Add(EMultiplayerSessionOperation::Create); });
+    Queue.Enqueue(EMultiplayerSessionOperation::Start, [&Started, &Queue]()
+    {
+        Started.Add(EMultiplayerSessionOperation::Start);
+        Queue.Complete(EMultiplayerSessionOperation::Start);
+    });
+    Queue.Enqueue(EMultiplayerSessionOperation::Destroy, [&Started]() { Started.Add(EMultiplayerSessionOperation::Destroy); });
+
+    TestTrue(TEXT("Only the first operation starts"), Started == TArray<EMultiplayerSessionOperation>{ EMultiplayerSessionOperation::Create });
+    TestTrue(TEXT("The first operation is in flight"), Queue.IsInFlight(EMultiplayerSessionOperation::Create));
+    TestEqual(TEXT("The others wait"), Queue.NumQueued(), 2);
+    TestTrue(TEXT("The in-flight operation records when it was queued"), Queue.GetInFlightRequestTime() > 0.0);
+
+    Queue.Complete(EMultiplayerSessionOperation::Start);
+    TestTrue(TEXT("Completing an operation which is not in flight is ignored"), Queue.IsInFlight(EMultiplayerSessionOperation::Create));
+
+    Queue.Complete(EMultiplayerSessionOperation::Create);
+    TestTrue(
+        TEXT("An operation which completes as it starts lets the next one start"),
+        Started == TArray<EMultiplayerSessionOperation>{ EMultiplayerSessionOperation::Create, EMultiplayerSessionOperation::Start, EMultiplayerSessionOperation::Destroy }
+    );
+    TestTrue(TEXT("The last operation is in flight"), Queue.IsInFlight(EMultiplayerSessionOperation::Destroy));
+    TestEqual(TEXT("Every operation was started"), Queue.Stats.Started, 3);
+
+    Queue.Enqueue(EMultiplayerSessionOperation::Join, []() {});
+    Queue.Enqueue(EMultiplayerSessionOperation::Join, []() {});
+    TestEqual(TEXT("Queued operations are counted by type"), Queue.NumQueued(EMultiplayerSessionOperation::Join), 2);
+    TestTrue(
+        TEXT("Cancelling returns the queued operations"),
+        Queue.CancelQueued() == TArray<EMultiplayerSessionOperation>{ EMultiplayerSessionOperation::Join, EMultiplayerSessionOperation::Join }
+    );
+    TestEqual(TEXT("Cancelled operations are counted"), Queue.Stats.Cancelled, 2);
+    TestTrue(TEXT("Cancelling leaves the in-flight operation alone"), Queue.IsInFlight(EMultiplayerSessionOperation::Destroy));
+
+    TArray<EMultiplayerSessionOperation> TimedOut;
+    Queue.OnTimedOut.BindLambda([&TimedOut, &Queue](EMultiplayerSessionOperation Operation)
+    {
+        TimedOut.Add(Operation);
+        Queue.Complete(Operation);
+    });
+    const double Now = FPlatformTime::Seconds();
+    Queue.Tick(Now + 60.0, 0.0);
+    TestEqual(TEXT("A timeout of zero waits forever"), TimedOut.Num(), 0);
+    Queue.Tick(Now, 30.0);
+    TestEqual(TEXT("An operation does not time out early"), TimedOut.Num(), 0);
+    Queue.Tick(Now + 60.0, 30.0);
+    TestTrue(TEXT("An operation times out once it has run too long"), TimedOut == TArray<EMultiplayerSessionOperation>{ EMultiplayerSessionOperation::Destroy });
+    TestEqual(TEXT("Timeouts are counted"), Queue.Stats.TimedOut, 1);
+    TestFalse(TEXT("The handler completed the timed out operation"), Queue.IsInFlight(EMultiplayerSessionOperation::Destroy));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionStaleCompletionTest, "MultiplayerSessions.Subsystem.StaleCompletions",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest times out a search and a join, and checks that the backend's late completions of them are dropped
+// instead of completing the search and join queued after them.
+bool FSessionStaleCompletionTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    FMultiplayerMockBackendSettings Settings;
+    Settings.NumSessions = 20;
+    const TSharedRef<FMockSessionBackend> Backend = MakeShared<FMockSessionBackend>(Settings, true);
+    Sessions->SetBackend(Backend);
+    const FMultiplayerSessionSearchFilter Filter;
+
+    // The first search times out, and the second starts. A backend which ignores the cancel still completes the first.
+    TFuture<FMultiplayerFindSessionsResult> TimedOutFind = Sessions->FindSessionsAsync(10, Filter);
+    TFuture<FMultiplayerFindSessionsResult> NextFind = Sessions->FindSessionsAsync(20, Filter);
+    TimeOutInFlightOperations();
+    TestTrue(TEXT("The timed out search fails"), TimedOutFind.IsReady() && !TimedOutFind.Get().bWasSuccessful);
+    TestFalse(TEXT("The next search is in flight"), NextFind.IsReady());
+
+    Backend->TriggerOnFindSessionsCompleteDelegates(true);
+    TestFalse(TEXT("The late completion does not complete the next search"), NextFind.IsReady());
+    TestEqual(TEXT("The late search completion is dropped"), Sessions->GetOperationQueueStats().StaleCompletions, 1);
+
+    while (!NextFind.IsReady() && Backend->AdvanceToNext())
+    {
+    }
+    if (!TestTrue(TEXT("The next search completes with its own results"), NextFind.IsReady() && NextFind.Get().bWasSuccessful))
+    {
+        return false;
+    }
+
+    // The first join times out, and the next is rejected while the backend still holds the first. The first then succeeds.
+    FOnlineSessionSearchResult Candidate = NextFind.Get().Search->SearchResults[0];
+    Candidate.Session.NumOpenPublicConnections = FMath::Max(Candidate.Session.NumOpenPublicConnections, 1);
+    TFuture<EOnJoinSessionCompleteResult::Type> TimedOutJoin = Sessions->JoinSessionAsync(Candidate);
+    TimeOutInFlightOperations();
+    TestTrue(TEXT("The timed out join fails"), TimedOutJoin.IsReady() && TimedOutJoin.Get() == EOnJoinSessionCompleteResult::UnknownError);
+
+    TFuture<EOnJoinSessionCompleteResult::Type> NextJoin = Sessions->JoinSessionAsync(Candidate);
+    while (Backend->AdvanceToNext())
+    {
+    }
+    TestTrue(
+        TEXT("The next join completes with its own result, not the late success"),
+        NextJoin.IsReady() && NextJoin.Get() == EOnJoinSessionCompleteResult::AlreadyInSession
+    );
+    TestEqual(TEXT("The late join completion is dropped"), Sessions->GetOperationQueueStats().StaleCompletions, 2);
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#include "MockSessionBackend.h"
+#include "SessionBenchmark.h"
+#include "SessionScorer.h"
+#include "SessionSearchIndex.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // AddResult appends a result with the given ping, slots and region to Search.
+    void AddResult(FOnlineSessionSearch& Search, int32 PingInMs, int32 OpenSlots, int32 TotalSlots, const FString& Region)
+    {
+        FOnlineSessionSearchResult& Result = Search.SearchResults.AddDefaulted_GetRef();
+        Result.PingInMs = PingInMs;
+        Result.Session.NumOpenPublicConnections = OpenSlots;
+        Result.Session.SessionSettings.NumPublicConnections = TotalSlots;
+        Result.Session.SessionSettings.Set(FName("Region"), Region, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionScorerRankBestTest, "MultiplayerSessions.Scorer.RankBest",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest ranks a handful of results with known costs, then checks that a large parallel-scored result set
+// ranks the same costs as a full sort.
+bool FSessionScorerRankBestTest::RunTest(const FString& Parameters)
+{
+    const TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+    AddResult(*Search, 50, 2, 8, TEXT("us-east"));  // 50 + 50 * 2/8 = 62.5
+    AddResult(*Search, 20, 0, 8, TEXT("us-east"));  // Full
+    AddResult(*Search, 10, 4, 8, TEXT("eu-west"));  // 10 + 50 * 4/8 = 35
+    AddResult(*Search, 100, 1, 8, TEXT("us-east")); // 100 + 50 * 1/8 = 106.25
+    AddResult(*Search, 30, 8, 8, TEXT("eu-west"));  // 30 + 50 * 8/8 = 80
+
+    FSessionSearchIndex Index;
+    Index.Build(Search);
+    FMultiplayerSessionScoringWeights Weights;
+
+    TArray<float> Costs;
+    FSessionScorer::Score(Index, Weights, Costs);
+    TestTrue(TEXT("Costs follow the weights"), Costs == TArray<float>{ 62.5f, MAX_flt, 35.f, 106.25f, 80.f });
+
+    TArray<int32> Best;
+    FSessionScorer::RankBest(Index, Weights, 3, Best);
+    TestTrue(TEXT("The cheapest results are ranked first"), Best == TArray<int32>{ 2, 0, 4 });
+
+    FSessionScorer::RankBest(Index, Weights, 10, Best);
+    TestTrue(TEXT("Full sessions are never ranked"), Best == TArray<int32>{ 2, 0, 4, 3 });
+
+    const TArray<int32> Candidates{ 3, 1, 4 };
+    FSessionScorer::RankBest(Index, Weights, 2, Best, &Candidates);
+    TestTrue(TEXT("Only candidates are ranked"), Best == TArray<int32>{ 4, 3 });
+
+    FSessionScorer::RankBest(Index, Weights, 0, Best);
+    TestEqual(TEXT("A count of zero ranks nothing"), Best.Num(), 0);
+
+    Weights.PreferredRegion = TEXT("eu-west");
+    FSessionScorer::RankBest(Index, Weights, 4, Best);
+    TestTrue(TEXT("Results outside the preferred region rank after those inside it"), Best == TArray<int32>{ 2, 4, 0, 3 });
+
+    // Enough results to be scored in parallel chunks. Costs are compared rather than indices, since mock sessions can tie.
+    FMultiplayerMockBackendSettings MockSettings;
+    MockSettings.NumSessions = FSessionScorer::ParallelThreshold * 2 + 1;
+    FMockSessionBackend Backend(MockSettings, true);
+    const TSharedRef<FOnlineSessionSearch> LargeSearch = MakeShared<FOnlineSessionSearch>();
+    LargeSearch->MaxSearchResults = MockSettings.NumSessions;
+    Backend.FindSessions(*Backend.GetDefaultPlayerId(), LargeSearch);
+    while (Backend.AdvanceToNext())
+    {
+    }
+    if (!TestEqual(TEXT("The mock returns every session"), LargeSearch->SearchResults.Num(), MockSettings.NumSessions))
+    {
+        return false;
+    }
+
+    Index.Build(LargeSearch);
+    FSessionScorer::Score(Index, Weights, Costs);
+    TArray<float> SortedCosts = Costs.FilterByPredicate([](float Cost) { return Cost != MAX_flt; });
+    SortedCosts.Sort();
+
+    constexpr int32 Count = 50;
+    FSessionScorer::RankBest(Index, Weights, Count, Best);
+    TestEqual(TEXT("Count results are ranked"), Best.Num(), FMath::Min(Count, SortedCosts.Num()));
+    for (int32 Rank = 0; Rank < Best.Num(); ++Rank)
+    {
+        if (!TestTrue(FString::Printf(TEXT("Rank %d has the %d-th lowest cost"), Rank, Rank), Costs[Best[Rank]] == SortedCosts[Rank]))
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionScorerTiesTest, "MultiplayerSessions.Scorer.Ties",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest ranks results with equal costs, and checks that they keep the order of the search results,
+// including when the heap has to choose which of them to keep and when candidates are given in another order.
+bool FSessionScorerTiesTest::RunTest(const FString& Parameters)
+{
+    const TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+    for (int32 Index = 0; Index < 8; ++Index)
+    {
+        // Odd indices cost 60, even indices cost 10 + 50 * 4/8 = 35.
+        AddResult(*Search, Index % 2 == 0 ? 10 : 35, 4, 8, TEXT("us-east"));
+    }
+
+    FSessionSearchIndex Index;
+    Index.Build(Search);
+    const FMultiplayerSessionScoringWeights Weights;
+
+    TArray<int32> Best;
+    FSessionScorer::RankBest(Index, Weights, 8, Best);
+    TestTrue(TEXT("Equal costs are ranked in index order"), Best == TArray<int32>{ 0, 2, 4, 6, 1, 3, 5, 7 });
+
+    FSessionScorer::RankBest(Index, Weights, 3, Best);
+    TestTrue(TEXT("The lowest indices are kept among equal costs"), Best == TArray<int32>{ 0, 2, 4 });
+
+    const TArray<int32> Candidates{ 7, 6, 5, 4, 3, 2, 1, 0 };
+    FSessionScorer::RankBest(Index, Weights, 6, Best, &Candidates);
+    TestTrue(TEXT("Candidate order does not affect ties"), Best == TArray<int32>{ 0, 2, 4, 6, 1, 3 });
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionScorerBenchmarkTest, "MultiplayerSessions.Scorer.Benchmark",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest runs the scorer benchmark at a small scale, and checks that each phase is timed once per iteration.
+bool FSessionScorerBenchmarkTest::RunTest(const FString& Parameters)
+{
+    const FSessionScorerBenchmarkResult Result = FSessionScorerBenchmark::Run(100, 3, 8);
+    TestEqual(TEXT("Indexing is timed every iteration"), Result.IndexLatency.GetCount(), (int64)3);
+    TestEqual(TEXT("Scoring is timed every iteration"), Result.ScoreLatency.GetCount(), (int64)3);
+    TestEqual(TEXT("Ranking is timed every iteration"), Result.RankLatency.GetCount(), (int64)3);
+
+    TArray<FString> Lines;
+    FSessionScorerBenchmark::ToCsv({ Result }).ParseIntoArrayLines(Lines);
+    TestEqual(TEXT("The CSV has a header and one row"), Lines.Num(), 2);
+    TestTrue(TEXT("The row starts with the scale"), Lines.Num() == 2 && Lines[1].StartsWith(TEXT("100,8,3,")));
+    return true;
+}
+
+#endif
\ No newline at end of file
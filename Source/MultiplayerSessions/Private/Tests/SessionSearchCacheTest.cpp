@@ -0,0 +1,73 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#include "SessionSearchCache.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // MakeKey returns a cache key which differs from other indices by its result count.
+    FSessionSearchCacheKey MakeKey(int32 Index)
+    {
+        FSessionSearchCacheKey Key;
+        Key.MaxSearchResults = Index + 1;
+        return Key;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionSearchCacheTest, "MultiplayerSessions.SearchCache.Lifetimes",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest stores searches at simulated times, and checks fresh hits, stale hits while revalidating, expiry, and eviction.
+bool FSessionSearchCacheTest::RunTest(const FString& Parameters)
+{
+    FSessionSearchCache Cache;
+    Cache.SetLifetimes(10.0, 60.0, true);
+
+    const FSessionSearchCacheKey Key = MakeKey(0);
+    const TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+    TSharedPtr<FOnlineSessionSearch> Found;
+    TestTrue(TEXT("An empty cache misses"), Cache.Lookup(Key, 0.0, Found) == FSessionSearchCache::ELookupResult::Miss);
+
+    Cache.Store(Key, Search, 100.0);
+    TestTrue(TEXT("A search within the TTL is fresh"), Cache.Lookup(Key, 105.0, Found) == FSessionSearchCache::ELookupResult::Fresh);
+    TestTrue(TEXT("The stored search object is served without a copy"), Found == Search);
+    TestTrue(TEXT("An expired search is served stale"), Cache.Lookup(Key, 130.0, Found) == FSessionSearchCache::ELookupResult::Stale);
+    TestTrue(TEXT("Another key misses"), Cache.Lookup(MakeKey(1), 130.0, Found) == FSessionSearchCache::ELookupResult::Miss);
+
+    // Past MaxStaleSeconds the entry is removed, rather than kept for a lookup which will never serve it.
+    TestTrue(TEXT("A search past MaxStaleSeconds misses"), Cache.Lookup(Key, 161.0, Found) == FSessionSearchCache::ELookupResult::Miss);
+    TestEqual(TEXT("The expired entry is evicted"), Cache.Num(), 0);
+    TestEqual(TEXT("The eviction is counted"), Cache.Stats.Evictions, 1);
+
+    // Without stale-while-revalidate, entries expire with the TTL, and stores sweep expired entries of other keys.
+    Cache.SetLifetimes(10.0, 60.0, false);
+    Cache.Store(Key, Search, 200.0);
+    TestTrue(TEXT("An expired search is not served stale"), Cache.Lookup(Key, 215.0, Found) == FSessionSearchCache::ELookupResult::Miss);
+    Cache.Store(MakeKey(1), Search, 300.0);
+    Cache.Store(MakeKey(2), Search, 315.0);
+    TestEqual(TEXT("Storing sweeps entries which expired"), Cache.Num(), 1);
+
+    // A full cache evicts its oldest entry to make room, and replacing an entry does not evict another.
+    Cache.Invalidate();
+    for (int32 Index = 0; Index < FSessionSearchCache::MaxEntries; ++Index)
+    {
+        Cache.Store(MakeKey(Index), Search, 400.0 + Index * 0.1);
+    }
+    Cache.Store(MakeKey(3), Search, 402.0);
+    TestEqual(TEXT("Replacing an entry keeps every entry"), Cache.Num(), FSessionSearchCache::MaxEntries);
+    Cache.Store(MakeKey(FSessionSearchCache::MaxEntries), Search, 403.0);
+    TestEqual(TEXT("The cache never holds more than MaxEntries"), Cache.Num(), FSessionSearchCache::MaxEntries);
+    TestTrue(TEXT("The oldest entry was evicted"), Cache.Lookup(MakeKey(0), 403.0, Found) == FSessionSearchCache::ELookupResult::Miss);
+    TestTrue(TEXT("The replaced entry was kept"), Cache.Lookup(MakeKey(3), 403.0, Found) == FSessionSearchCache::ELookupResult::Fresh);
+
+    TestEqual(TEXT("Fresh hits are counted"), Cache.Stats.Hits, 2);
+    TestEqual(TEXT("Stale hits are counted"), Cache.Stats.StaleHits, 1);
+    TestEqual(TEXT("Every eviction is counted"), Cache.Stats.Evictions, 4);
+    return true;
+}
+
+#endif
\ No newline at end of file
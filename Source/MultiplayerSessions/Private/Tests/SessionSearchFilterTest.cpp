@@ -0,0 +1,97 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#include "SessionBenchmark.h"
+#include "SessionSearchFilter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // MakeResult returns a result advertising MatchType and Region, with OpenSlots open slots.
+    FOnlineSessionSearchResult MakeResult(const FString& MatchType, const FString& Region, int32 OpenSlots)
+    {
+        FOnlineSessionSearchResult Result;
+        Result.Session.NumOpenPublicConnections = OpenSlots;
+        Result.Session.SessionSettings.NumPublicConnections = 8;
+        Result.Session.SessionSettings.Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        Result.Session.SessionSettings.Set(FName("Region"), Region, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        return Result;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionSearchFilterMatcherTest, "MultiplayerSessions.SearchFilter.Matcher",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest checks that a filter is pushed into query settings for providers which support them,
+// and that the local matcher rejects results on each field while keeping the order of the rest.
+bool FSessionSearchFilterMatcherTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionSearchFilter Filter;
+    Filter.MatchType = TEXT("FreeForAll");
+    Filter.Region = TEXT("eu-west");
+    Filter.MinOpenSlots = 2;
+
+    TestFalse(TEXT("The NULL subsystem filters locally"), FMultiplayerSessionSearchFilter::SupportsQueryFilters(FName("NULL")));
+    TestTrue(TEXT("Other subsystems filter server-side"), FMultiplayerSessionSearchFilter::SupportsQueryFilters(FName("Steam")));
+
+    FOnlineSearchSettings QuerySettings;
+    Filter.ApplyToQuerySettings(QuerySettings);
+    const FOnlineSessionSearchParam* MatchTypeParam = QuerySettings.SearchParams.Find(FName("MatchType"));
+    TestTrue(TEXT("The match type is queried for equality"), MatchTypeParam && MatchTypeParam->ComparisonOp == EOnlineComparisonOp::Equals);
+    const FOnlineSessionSearchParam* SlotsParam = QuerySettings.SearchParams.Find(SEARCH_MINSLOTSAVAILABLE);
+    TestTrue(TEXT("Open slots are queried as a minimum"), SlotsParam && SlotsParam->ComparisonOp == EOnlineComparisonOp::GreaterThanEquals);
+
+    TArray<FOnlineSessionSearchResult> Results;
+    Results.Add(MakeResult(TEXT("FreeForAll"), TEXT("eu-west"), 4));
+    Results.Add(MakeResult(TEXT("TeamDeathmatch"), TEXT("eu-west"), 4));
+    Results.Add(MakeResult(TEXT("FreeForAll"), TEXT("us-east"), 4));
+    Results.Add(MakeResult(TEXT("FreeForAll"), TEXT("eu-west"), 1));
+    Results.Add(MakeResult(TEXT("FreeForAll"), TEXT("eu-west"), 2));
+    Results[4].PingInMs = 42;
+
+    const FSessionSearchFilterMatcher Matcher(Filter);
+    TestTrue(TEXT("A result satisfying every field matches"), Matcher.Matches(Results[0]));
+    TestFalse(TEXT("Another match type is rejected"), Matcher.Matches(Results[1]));
+    TestFalse(TEXT("Another region is rejected"), Matcher.Matches(Results[2]));
+    TestFalse(TEXT("Too few open slots are rejected"), Matcher.Matches(Results[3]));
+
+    TestEqual(TEXT("Results before StartIndex are kept"), Matcher.RemoveNonMatching(Results, 2), 2);
+    TestEqual(TEXT("Matching results remain"), Results.Num(), 3);
+    TestTrue(TEXT("Matching results keep their order"), Results.Num() == 3 && Results[2].PingInMs == 42);
+    TestTrue(
+        TEXT("A result's size includes its string settings"),
+        FSessionSearchFilterMatcher::EstimateResultBytes(Results[0]) > (int64)sizeof(FOnlineSessionSearchResult)
+    );
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSearchFilterBenchmarkTest, "MultiplayerSessions.SearchFilter.Benchmark",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest runs the filter benchmark at a small scale, and checks that filtering server-side downloads fewer bytes
+// while local filtering still finds only results the server-side search returned.
+bool FSearchFilterBenchmarkTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionSearchFilter Filter;
+    Filter.MatchType = TEXT("FreeForAll");
+    Filter.Region = TEXT("eu-west");
+    Filter.MinOpenSlots = 1;
+
+    constexpr int32 NumSessions = 300;
+    const FSearchFilterBenchmarkResult Result = FSearchFilterBenchmark::Run(NumSessions, Filter);
+    TestEqual(TEXT("The unfiltered search returns every session"), Result.LocalResults, NumSessions);
+    TestTrue(TEXT("The filtered search returns fewer sessions"), Result.ServerSideResults < Result.LocalResults);
+    TestTrue(TEXT("Some sessions match"), Result.MatchingResults > 0);
+    TestTrue(TEXT("Every match is returned by the filtered search"), Result.MatchingResults <= Result.ServerSideResults);
+    TestTrue(TEXT("Filtering server-side saves bytes"), Result.GetBytesSaved() > 0);
+
+    TArray<FString> Lines;
+    FSearchFilterBenchmark::ToCsv({ Result }).ParseIntoArrayLines(Lines);
+    TestEqual(TEXT("The CSV has a header and one row"), Lines.Num(), 2);
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#include "SessionSearchIndex.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // AddResult appends a result to Search. Empty strings leave the setting unadvertised.
+    void AddResult(FOnlineSessionSearch& Search, const FString& MatchType, const FString& Region, int32 OpenSlots, int32 PingInMs)
+    {
+        FOnlineSessionSearchResult& Result = Search.SearchResults.AddDefaulted_GetRef();
+        Result.PingInMs = PingInMs;
+        Result.Session.NumOpenPublicConnections = OpenSlots;
+        Result.Session.SessionSettings.NumPublicConnections = 8;
+        Result.Session.SessionSettings.BuildUniqueId = 7;
+        if (!MatchType.IsEmpty())
+        {
+            Result.Session.SessionSettings.Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+        if (!Region.IsEmpty())
+        {
+            Result.Session.SessionSettings.Set(FName("Region"), Region, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionSearchIndexTest, "MultiplayerSessions.SearchIndex.Queries",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest indexes a small search, and checks the interned IDs, the per-result field arrays, and match type and open slot queries.
+bool FSessionSearchIndexTest::RunTest(const FString& Parameters)
+{
+    const TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+    AddResult(*Search, TEXT("FreeForAll"), TEXT("eu-west"), 0, 40);
+    AddResult(*Search, TEXT("TeamDeathmatch"), TEXT("us-east"), 3, 20);
+    AddResult(*Search, TEXT("FreeForAll"), TEXT("us-east"), 2, 30);
+    AddResult(*Search, FString(), FString(), 5, 10);
+
+    FSessionSearchIndex Index;
+    Index.Build(Search);
+    TestEqual(TEXT("Every result is indexed"), Index.Num(), 4);
+    TestTrue(TEXT("The index remembers its search"), Index.IsBuiltFrom(Search));
+    TestTrue(TEXT("Results resolve to the search's results"), &Index.GetResult(2) == &Search->SearchResults[2]);
+
+    const int32 FreeForAll = Index.FindMatchTypeId(TEXT("FreeForAll"));
+    const int32 TeamDeathmatch = Index.FindMatchTypeId(TEXT("TeamDeathmatch"));
+    TestTrue(TEXT("Match types are interned in the order they are seen"), FreeForAll == 0 && TeamDeathmatch == 1);
+    TestEqual(TEXT("An unseen match type has no ID"), Index.FindMatchTypeId(TEXT("CaptureTheFlag")), (int32)INDEX_NONE);
+    TestTrue(TEXT("Equal values share an ID"), Index.GetMatchTypeIds()[0] == Index.GetMatchTypeIds()[2]);
+    TestTrue(TEXT("Regions are interned separately"), Index.GetRegionIds()[1] == Index.FindRegionId(TEXT("us-east")) && Index.GetRegionIds()[0] != Index.GetRegionIds()[1]);
+    TestTrue(TEXT("A result without a setting has no ID"), Index.GetMatchTypeIds()[3] == INDEX_NONE && Index.GetRegionIds()[3] == INDEX_NONE);
+
+    TestTrue(TEXT("Open slots are copied"), TArray<int32>(Index.GetOpenSlots()) == TArray<int32>{ 0, 3, 2, 5 });
+    TestTrue(TEXT("Pings are copied"), TArray<int32>(Index.GetPings()) == TArray<int32>{ 40, 20, 30, 10 });
+    TestTrue(TEXT("Total slots are copied"), TArray<int32>(Index.GetTotalSlots()) == TArray<int32>{ 8, 8, 8, 8 });
+    TestTrue(TEXT("Build IDs are copied"), TArray<int32>(Index.GetBuildIds()) == TArray<int32>{ 7, 7, 7, 7 });
+
+    TestEqual(TEXT("FindFirst skips full sessions"), Index.FindFirst(FreeForAll, 1), 2);
+    TestEqual(TEXT("FindFirst with any match type"), Index.FindFirst(INDEX_NONE, 4), 3);
+    TestEqual(TEXT("FindFirst reports no match"), Index.FindFirst(TeamDeathmatch, 4), (int32)INDEX_NONE);
+
+    TArray<int32> Indices{ 99 };
+    Index.FindAll(FreeForAll, 0, Indices);
+    TestTrue(TEXT("FindAll appends every match"), Indices == TArray<int32>{ 99, 0, 2 });
+    Indices.Reset();
+    Index.FindAll(INDEX_NONE, 2, Indices);
+    TestTrue(TEXT("FindAll with any match type"), Indices == TArray<int32>{ 1, 2, 3 });
+
+    TestTrue(TEXT("A result's match type is compared without copying"), FSessionSearchIndex::ResultHasMatchType(Search->SearchResults[1], FVariantData(FString(TEXT("TeamDeathmatch")))));
+    TestFalse(TEXT("A result without a match type matches none"), FSessionSearchIndex::ResultHasMatchType(Search->SearchResults[3], FVariantData(FString(TEXT("FreeForAll")))));
+
+    Index.Reset();
+    TestEqual(TEXT("Reset empties the index"), Index.Num(), 0);
+    TestFalse(TEXT("Reset releases the search"), Index.IsBuiltFrom(Search));
+    return true;
+}
+
+#endif
\ No newline at end of file
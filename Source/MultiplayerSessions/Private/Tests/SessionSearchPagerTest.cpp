@@ -0,0 +1,106 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#include "DirectorySessionBackend.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+#include "SessionDirectory.h"
+#include "SessionSearchPager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionSearchPagerTest, "MultiplayerSessions.Subsystem.SearchPager",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest pages through a private session directory with a pager capped to a single page, and checks that every session is
+// returned once, that evicted pages are fetched again, and that requests for a page being fetched share its fetch.
+bool FSessionSearchPagerTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumSessions = 30;
+    constexpr int32 PageSize = 10;
+
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    const TSharedRef<FSessionDirectory> Directory = MakeShared<FSessionDirectory>(4);
+    TArray<FSessionDirectoryEntry> Entries;
+    for (int32 Index = 0; Index < NumSessions; ++Index)
+    {
+        FSessionDirectoryEntry& Entry = Entries.AddDefaulted_GetRef();
+        Entry.SessionId = FString::Printf(TEXT("Session%d"), Index);
+        Entry.OwnerName = FString::Printf(TEXT("Host%d"), Index);
+        Entry.NumPublicConnections = 8;
+        Entry.NumOpenPublicConnections = 8;
+    }
+    Directory->Register(MoveTemp(Entries), FPlatformTime::Seconds());
+
+    const TSharedRef<FDirectorySessionBackend> Backend = MakeShared<FDirectorySessionBackend>(FMultiplayerDirectoryBackendSettings(), Directory, true);
+    Sessions->SetBackend(Backend);
+
+    // Wait ticks the backend until the page has been fetched.
+    auto Wait = [&Backend](const TFuture<TSharedPtr<FOnlineSessionSearch>>& Future) -> TSharedPtr<FOnlineSessionSearch>
+    {
+        for (int32 Tick = 0; Tick < 100 && !Future.IsReady(); ++Tick)
+        {
+            Backend->ProcessPending();
+        }
+        return Future.IsReady() ? Future.Get() : nullptr;
+    };
+
+    // A one-byte cap retains only the page being viewed.
+    const TSharedRef<FSessionSearchPager> Pager = MakeShared<FSessionSearchPager>(Sessions, FMultiplayerSessionSearchFilter(), PageSize, 1);
+    TSet<FString> SessionIds;
+    for (int32 PageIndex = 0; PageIndex < 3; ++PageIndex)
+    {
+        if (!TestTrue(TEXT("The page's cursor is known"), PageIndex < Pager->GetNumKnownPages()))
+        {
+            return false;
+        }
+        const TSharedPtr<FOnlineSessionSearch> Page = Wait(Pager->GetPageAsync(PageIndex));
+        if (!TestTrue(TEXT("The page is fetched"), Page.IsValid()))
+        {
+            return false;
+        }
+        TestEqual(TEXT("The page is full"), Page->SearchResults.Num(), PageSize);
+        for (const FOnlineSessionSearchResult& Result : Page->SearchResults)
+        {
+            bool bAlreadyPaged = false;
+            SessionIds.Add(Result.GetSessionIdStr(), &bAlreadyPaged);
+            TestFalse(TEXT("Each session is on one page"), bAlreadyPaged);
+        }
+    }
+    TestEqual(TEXT("Paging returns every session"), SessionIds.Num(), NumSessions);
+    TestTrue(TEXT("The last page has been reached"), Pager->IsComplete());
+    TestEqual(TEXT("Every page's cursor is known"), Pager->GetNumKnownPages(), 3);
+
+    const FSessionSearchPagerStats& Stats = Pager->GetStats();
+    TestEqual(TEXT("Three pages are fetched"), Stats.PagesFetched, 3);
+    TestEqual(TEXT("Pages beyond the cap are evicted"), Stats.PagesEvicted, 2);
+    TestEqual(TEXT("Only the viewed page is retained"), Stats.RetainedResults, PageSize);
+    TestTrue(TEXT("The last page is retained"), Pager->GetRetainedPage(2).IsValid());
+    TestFalse(TEXT("The first page is evicted"), Pager->GetRetainedPage(0).IsValid());
+
+    // Retained pages are served from memory, and evicted pages are fetched again from their cursor.
+    TestTrue(TEXT("The retained page is served"), Wait(Pager->GetPageAsync(2)).IsValid());
+    TestEqual(TEXT("The retained page is served from memory"), Stats.PagesServedFromMemory, 1);
+    const TSharedPtr<FOnlineSessionSearch> Refetched = Wait(Pager->GetPageAsync(0));
+    TestTrue(TEXT("The evicted page is fetched again"), Refetched.IsValid() && Refetched->SearchResults.Num() == PageSize);
+    TestEqual(TEXT("The evicted page counts as refetched"), Stats.PagesRefetched, 1);
+
+    // Requests for a page which is being fetched share its fetch.
+    Pager->Reset();
+    TFuture<TSharedPtr<FOnlineSessionSearch>> First = Pager->GetPageAsync(0);
+    TFuture<TSharedPtr<FOnlineSessionSearch>> Second = Pager->GetPageAsync(0);
+    const TSharedPtr<FOnlineSessionSearch> FirstPage = Wait(First);
+    TestTrue(TEXT("Both requests receive the same page"), FirstPage.IsValid() && Second.IsReady() && Second.Get() == FirstPage);
+    TestEqual(TEXT("The page is fetched once for both requests"), Stats.PagesFetched, 5);
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+// (c) 2023 Will Roberts
+
+#include "Misc/AutomationTest.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformProcess.h"
+#include "OnlineSessionSettings.h"
+
+#include "MockSessionBackend.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsTestInstance.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // WaitForUpdate ticks the core ticker in real time until the subsystem sends an update to the manual-clock mock,
+    // then returns when it was sent, or negative if it was not sent within 10 seconds.
+    double WaitForUpdate(FMockSessionBackend& Backend)
+    {
+        const double Deadline = FPlatformTime::Seconds() + 10.0;
+        while (FPlatformTime::Seconds() < Deadline)
+        {
+            FTSTicker::GetCoreTicker().Tick(0.01f);
+            if (Backend.NumPending() > 0)
+            {
+                return FPlatformTime::Seconds();
+            }
+            FPlatformProcess::Sleep(0.01f);
+        }
+        return -1.0;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSettingsUpdateTest, "MultiplayerSessions.Subsystem.SettingsUpdates",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// RunTest changes a hosted session's settings several times, and checks that the changes are coalesced into one update,
+// that settings which match the advertised value are not sent, that the next update waits for the interval,
+// and that FlushSessionSettings sends at once.
+bool FSettingsUpdateTest::RunTest(const FString& Parameters)
+{
+    FMultiplayerSessionsTestInstance Instance;
+    UMultiplayerSessionsSubsystem* Sessions = Instance.GetSubsystem();
+    if (!TestNotNull(TEXT("Subsystem exists"), Sessions))
+    {
+        return false;
+    }
+
+    UMultiplayerSessionsSettings* Settings = GetMutableDefault<UMultiplayerSessionsSettings>();
+    TGuardValue<float> WindowGuard(Settings->SettingsUpdateWindowSeconds, 0.05f);
+    TGuardValue<float> IntervalGuard(Settings->SettingsUpdateIntervalSeconds, 0.3f);
+
+    const TSharedRef<FMockSessionBackend> Backend = MakeShared<FMockSessionBackend>(FMultiplayerMockBackendSettings(), true);
+    Sessions->SetBackend(Backend);
+
+    // Settings made before hosting are advertised by the new session.
+    const FName PartySession(TEXT("Party"));
+    const FName RoundKey(TEXT("Round"));
+    const FName PlayersKey(TEXT("Players"));
+    const FName ModeKey(TEXT("Mode"));
+    Sessions->UpdateSessionSetting(ModeKey, FVariantData(FString(TEXT("Ranked"))), PartySession);
+    TFuture<bool> Create = Sessions->CreateSessionAsync(4, TEXT("FreeForAll"), PartySession);
+    while (Backend->AdvanceToNext())
+    {
+    }
+    if (!TestTrue(TEXT("The session is created"), Create.IsReady() && Create.Get()))
+    {
+        return false;
+    }
+    const FMultiplayerSettingsUpdateStats Before = Sessions->GetSettingsUpdateStats();
+    TestEqual(TEXT("Settings made before hosting are not sent as updates"), Before.UpdatesSent, (int64)0);
+
+    // Repeated changes to a setting are coalesced, and a setting which matches the advertised value is dropped.
+    Sessions->UpdateSessionSetting(RoundKey, FVariantData(1), PartySession);
+    Sessions->UpdateSessionSetting(RoundKey, FVariantData(2), PartySession);
+    Sessions->UpdateSessionSetting(RoundKey, FVariantData(3), PartySession);
+    Sessions->UpdateSessionSetting(PlayersKey, FVariantData(2), PartySession);
+    Sessions->UpdateSessionSetting(ModeKey, FVariantData(FString(TEXT("Ranked"))), PartySession);
+    TestEqual(TEXT("Nothing is sent during the window"), Backend->NumPending(), 0);
+
+    const double FirstSendTime = WaitForUpdate(*Backend);
+    if (!TestTrue(TEXT("The changes are sent"), FirstSendTime >= 0.0))
+    {
+        return false;
+    }
+    TestEqual(TEXT("The changes are sent in one update"), Backend->NumPending(), 1);
+    while (Backend->AdvanceToNext())
+    {
+    }
+
+    const FMultiplayerSettingsUpdateStats& Stats = Sessions->GetSettingsUpdateStats();
+    TestEqual(TEXT("Every change is counted"), Stats.ChangesRequested - Before.ChangesRequested, (int64)5);
+    TestEqual(TEXT("Changes to a waiting setting are coalesced"), Stats.ChangesCoalesced - Before.ChangesCoalesced, (int64)2);
+    TestEqual(TEXT("The advertised setting is dropped"), Stats.ChangesUnchanged - Before.ChangesUnchanged, (int64)1);
+    TestEqual(TEXT("One update is sent"), Stats.UpdatesSent - Before.UpdatesSent, (int64)1);
+    TestEqual(TEXT("Only the settings which differ are sent"), Stats.SettingsPushed - Before.SettingsPushed, (int64)2);
+    TestEqual(TEXT("The update latency is recorded"), Stats.UpdateLatency.GetCount() - Before.UpdateLatency.GetCount(), (int64)1);
+    TestTrue(TEXT("Updates are saved"), Stats.GetUpdatesSaved() > Before.GetUpdatesSaved());
+
+    // The next update waits for the interval since the previous one.
+    Sessions->UpdateSessionSetting(RoundKey, FVariantData(4), PartySession);
+    const double SecondSendTime = WaitForUpdate(*Backend);
+    if (!TestTrue(TEXT("The next change is sent"), SecondSendTime >= 0.0))
+    {
+        return false;
+    }
+    TestTrue(TEXT("Updates are no closer than the interval"), SecondSendTime - FirstSendTime >= Settings->SettingsUpdateIntervalSeconds);
+    while (Backend->AdvanceToNext())
+    {
+    }
+
+    // Flushing sends without waiting for the window or interval.
+    Sessions->UpdateSessionSetting(RoundKey, FVariantData(5), PartySession);
+    Sessions->FlushSessionSettings(PartySession);
+    TestEqual(TEXT("A flush sends at once"), Backend->NumPending(), 1);
+    while (Backend->AdvanceToNext())
+    {
+    }
+    TestEqual(TEXT("Every update is sent"), Stats.UpdatesSent - Before.UpdatesSent, (int64)3);
+    TestEqual(TEXT("No update fails"), Stats.UpdatesFailed - Before.UpdatesFailed, (int64)0);
+    return true;
+}
+
+#endif
\ No newline at end of file
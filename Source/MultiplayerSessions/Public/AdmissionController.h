@@ -0,0 +1,179 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "SessionMetrics.h"
+
+#include "AdmissionController.generated.h"
+
+/*
+ * FMultiplayerAdmissionSettings configures how a host admits logins when many clients join at once.
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerAdmissionSettings
+{
+	GENERATED_BODY()
+
+	// Logins admitted per second once the burst is spent, so the host loads players at a steady rate instead of hitching.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Admission Control", meta=(ClampMin="0.1"))
+	float LoginsPerSecond{ 2.f };
+
+	// Logins admitted at once before LoginsPerSecond applies.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Admission Control", meta=(ClampMin="1"))
+	int32 LoginBurst{ 4 };
+
+	// Player slots, including players still logging in. Zero uses the hosted session's NumPublicConnections.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Admission Control", meta=(ClampMin="0"))
+	int32 MaxPlayers{ 0 };
+
+	// Clients waiting for a slot or a login. Clients beyond it are rejected.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Admission Control", meta=(ClampMin="0"))
+	int32 MaxQueueLength{ 32 };
+
+	// Queued clients must retry within this time to keep their place.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Admission Control", meta=(ClampMin="1.0", Units="s"))
+	float QueueTicketTimeoutSeconds{ 15.f };
+
+	// Admitted clients which do not finish logging in within this time give up their slot.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Admission Control", meta=(ClampMin="1.0", Units="s"))
+	float ReservationTimeoutSeconds{ 20.f };
+
+	// Shortest retry delay sent to queued clients. Clients further back in the queue are asked to wait longer.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Admission Control", meta=(ClampMin="0.1", Units="s"))
+	float MinRetryAfterSeconds{ 1.f };
+};
+
+/*
+ * EAdmissionDecision is the outcome of a login attempt.
+ */
+enum class EAdmissionDecision : uint8
+{
+	// The client has a reserved slot, and may log in.
+	Admitted,
+
+	// The client holds a place in the queue, and should retry after RetryAfterSeconds.
+	Queued,
+
+	// The queue is full. The client may try again after RetryAfterSeconds.
+	Rejected
+};
+
+/*
+ * FAdmissionResult is the decision for one login attempt, and the backpressure sent to the client.
+ */
+struct MULTIPLAYERSESSIONS_API FAdmissionResult
+{
+	EAdmissionDecision Decision{ EAdmissionDecision::Admitted };
+	float RetryAfterSeconds{ 0.f };
+
+	// One-based position in the queue, or zero when the client is not queued.
+	int32 QueuePosition{ 0 };
+
+	// ToErrorMessage formats a queued or rejected result as a PreLogin error, which the client receives as its network failure message.
+	// Admitted results return an empty string.
+	FString ToErrorMessage() const;
+};
+
+/*
+ * FAdmissionStats counts a host's login decisions.
+ */
+struct MULTIPLAYERSESSIONS_API FAdmissionStats
+{
+	// Logins admitted, of which some had waited in the queue.
+	int64 Accepted{ 0 };
+	int64 AcceptedFromQueue{ 0 };
+
+	// Clients which entered the queue, and later attempts made while queued.
+	int64 Queued{ 0 };
+	int64 QueueRetries{ 0 };
+
+	int64 Rejected{ 0 };
+
+	// Admitted clients which did not log in in time, and queued clients which stopped retrying.
+	int64 ReservationsExpired{ 0 };
+	int64 TicketsExpired{ 0 };
+
+	int32 PeakQueueLength{ 0 };
+
+	// Players and reserved slots at their highest. Never above MaxPlayers unless players arrived without a reservation, e.g. by seamless travel.
+	int32 PeakUsedSlots{ 0 };
+
+	// Time from entering the queue until admission.
+	FLatencyHistogram QueueWait;
+};
+
+/*
+ * FAdmissionController decides which logins a host admits, so a join storm fills the session at a steady rate without overcommitting slots.
+ * Logins spend tokens from a bucket which refills at LoginsPerSecond, and each admitted login reserves a slot until it completes.
+ * Clients which arrive while no token or slot is free take a place in a bounded queue, and are told when to retry.
+ * Slots and tokens are reserved for the front of the queue as they free up, and the reservation is claimed when that client retries.
+ * Times are passed in by the caller, so the controller can be driven by a simulated clock.
+ */
+class MULTIPLAYERSESSIONS_API FAdmissionController
+{
+public:
+	explicit FAdmissionController(const FMultiplayerAdmissionSettings& InSettings);
+
+	// UpdateCapacity sets the number of logged in players, and the number of slots. MaxPlayers of zero or less means slots are not limited.
+	void UpdateCapacity(int32 InNumPlayers, int32 InMaxPlayers);
+
+	// PreLogin decides whether a client may log in. ClientKey identifies the client across attempts, e.g. its unique net ID.
+	// When bUniqueKey is 'false', e.g. for a bare address which clients behind one NAT share, each admission reserves its own slot,
+	// and an attempt never claims a reservation or queue place made for an earlier attempt under the same key. Such clients cannot
+	// hold a place in the queue, so they are rejected with a retry delay while it is not empty or no slot is free.
+	FAdmissionResult PreLogin(const FString& ClientKey, double Now, bool bUniqueKey = true);
+
+	// PostLogin releases one of the client's reservations, since it is now counted as a player.
+	void PostLogin(const FString& ClientKey);
+
+	// Tick refills tokens, expires reservations and queue places, and reserves free slots for the front of the queue.
+	void Tick(double Now);
+
+	int32 NumQueued() const { return Queue.Num(); }
+	int32 NumReserved() const;
+	const FAdmissionStats& GetStats() const { return Stats; }
+	const FMultiplayerAdmissionSettings& GetSettings() const { return Settings; }
+
+	// ParseErrorMessage reads the retry delay and queue position from a PreLogin error made by ToErrorMessage.
+	// Returns 'false' when the message was not made by admission control.
+	static bool ParseErrorMessage(const FString& ErrorMessage, float& OutRetryAfterSeconds, int32& OutQueuePosition);
+
+private:
+	/*
+	 * FTicket is a queued client's place in the queue.
+	 */
+	struct FTicket
+	{
+		FString ClientKey;
+		double EnqueueTime{ 0.0 };
+		double LastAttemptTime{ 0.0 };
+
+		// Set when a slot and token have been reserved for the client, which it claims by retrying.
+		bool bReserved{ false };
+		double ReservedTime{ 0.0 };
+	};
+
+	void Refill(double Now);
+	bool TakeToken();
+	int32 NumFreeSlots() const;
+	float GetRetryAfterSeconds(int32 QueuePosition) const;
+	void NoteUsedSlots();
+
+	FMultiplayerAdmissionSettings Settings;
+	int32 NumPlayers{ 0 };
+	int32 MaxPlayers{ 0 };
+
+	double Tokens{ 0.0 };
+	double LastRefillTime{ -1.0 };
+
+	// Oldest first. The queue is bounded by MaxQueueLength, so it is searched linearly.
+	TArray<FTicket> Queue;
+
+	// Admitted clients which have not finished logging in, and when they were admitted.
+	// Clients without a unique key may hold several reservations under one key.
+	TMultiMap<FString, double> Reservations;
+
+	FAdmissionStats Stats;
+};
@@ -0,0 +1,40 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AdmissionController.h"
+#include "DebugGameMode.h"
+
+#include "AdmissionGameMode.generated.h"
+
+/*
+ * AAdmissionGameMode extends the debug Game Mode with admission control, for listen servers which many clients join at once.
+ * PreLogin admits logins at a steady rate, reserves a slot for each admitted client until its login completes,
+ * and queues the clients which arrive while no login or slot is free. Queued and rejected clients are disconnected
+ * with an error message which tells them when to retry (see FAdmissionController::ParseErrorMessage).
+ * Slots default to the hosted game session's NumPublicConnections. Settings are read from UMultiplayerSessionsSettings.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API AAdmissionGameMode : public ADebugGameMode
+{
+	GENERATED_BODY()
+
+public:
+	AAdmissionGameMode();
+
+	virtual void PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage) override;
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	const FAdmissionController& GetAdmissionController() const { return Admission; }
+
+private:
+	// GetClientKey identifies a client by its unique net ID, or by its address when it has none.
+	static FString GetClientKey(const FUniqueNetIdRepl& UniqueId, const FString& Address);
+
+	void UpdateCapacity();
+
+	FAdmissionController Admission;
+};
@@ -1,21 +1,25 @@
-// (c) 2023 Will Roberts
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/GameModeBase.h"
-#include "DebugGameMode.generated.h"
-
-/*
- * ADebugGameMode provides a Game Mode class which overrides login and logout handlers.
- * The new handlers will print players' names as they connect or disconnect, as well as total player counts.
- */
-UCLASS()
-class MULTIPLAYERSESSIONS_API ADebugGameMode : public AGameModeBase
-{
-	GENERATED_BODY()
-
-public:
-	virtual void PostLogin(APlayerController* NewPlayer) override;
-	virtual void Logout(AController* ExitingPlayer) override;
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameModeBase.h"
+#include "DebugGameMode.generated.h"
+
+/*
+ * ADebugGameMode provides a Game Mode class which overrides login and logout handlers.
+ * The new handlers will print players' names as they connect or disconnect, as well as total player counts.
+ * Server travel from a map using this Game Mode is seamless, so connected clients keep their connection and load the
+ * next map behind the transition map instead of reconnecting.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API ADebugGameMode : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	ADebugGameMode();
+
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	virtual void Logout(AController* ExitingPlayer) override;
 };
\ No newline at end of file
@@ -1,81 +1,107 @@
-// (c) 2023 Will Roberts
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "Blueprint/UserWidget.h"
-#include "Interfaces/OnlineSessionInterface.h"
-
-#include "DebugMenu.generated.h"
-
-/*
- * UDebugMenu provides a widget with buttons for hosting and joining games.
- * The menu binds a series of custom delegate callbacks used for session management.
- * When creating the widget, callers can provide the number of players, game mode, and lobby map for the session.
- */
-UCLASS()
-class MULTIPLAYERSESSIONS_API UDebugMenu : public UUserWidget
-{
-	GENERATED_BODY()
-
-public:
-	UFUNCTION(BlueprintCallable, Category="Utilities")
-	void AddMultiplayerDebugMenu(
-		int32 MaxSearchResults = 1000,
-		int32 NumPlayers = 8,
-		FString GameMode = FString(TEXT("YourGameMode")),
-		FString LobbyMap = FString(TEXT("YourLobbyMap"))
-	);
-
-protected:
-	virtual bool Initialize() override;
-
-	// Replaced OnLevelRemovedFromWorld() in UE 5.1.
-	virtual void NativeDestruct() override;
-
-	UFUNCTION()
-	void OnCreateSession(bool bWasSuccessful);
-
-	// Not dynamic, and therefore not a UFUNCTION.
-	void OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
-
-	// Not dynamic, and therefore not a UFUNCTION.
-	void OnJoinSession(EOnJoinSessionCompleteResult::Type Result);
-
-	UFUNCTION()
-	void OnDestroySession(bool bWasSuccessful);
-
-	UFUNCTION()
-	void OnStartSession(bool bWasSuccessful);
-
-private:
-	void Destroy();
-
-	UPROPERTY()
-	class UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem;
-
-	/********************
-	Host and Join buttons
-	********************/
-
-	UPROPERTY(meta = (BindWidget))
-	class UButton* HostButton;
-
-	UPROPERTY(meta = (BindWidget))
-	UButton* JoinButton;
-
-	UFUNCTION()
-	void HostButtonClicked();
-
-	UFUNCTION()
-	void JoinButtonClicked();
-
-	/************************
-	Saved Session Information
-	************************/
-
-	int32 SessionSearchLimit{0};
-	int32 NumPublicConnections{0};
-	FString MatchType{TEXT("")};
-	FString LobbyMapPath{TEXT("")};
-};
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "Interfaces/OnlineSessionInterface.h"
+
+#include "SessionSearchFilter.h"
+
+#include "DebugMenu.generated.h"
+
+/*
+ * UDebugMenu provides a widget with buttons for hosting and joining games.
+ * The menu binds a series of custom delegate callbacks used for session management.
+ * When creating the widget, callers can provide the number of players, game mode, and lobby map for the session.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UDebugMenu : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	// Set to 'true' to rank all search results and join the best session.
+	// Set to 'false' to stream search results and join the first joinable session.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Utilities")
+	bool bJoinBestSession{true};
+
+	UFUNCTION(BlueprintCallable, Category="Utilities")
+	void AddMultiplayerDebugMenu(
+		int32 MaxSearchResults = 1000,
+		int32 NumPlayers = 8,
+		FString GameMode = FString(TEXT("YourGameMode")),
+		FString LobbyMap = FString(TEXT("YourLobbyMap"))
+	);
+
+protected:
+	virtual bool Initialize() override;
+
+	// Replaced OnLevelRemovedFromWorld() in UE 5.1.
+	virtual void NativeDestruct() override;
+
+	UFUNCTION()
+	void OnCreateSession(bool bWasSuccessful);
+
+	// Not dynamic, and therefore not a UFUNCTION. The search callbacks are virtual, so subclasses such as UServerBrowser
+	// can list results instead of joining.
+	virtual void OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
+
+	// Not dynamic, and therefore not a UFUNCTION.
+	virtual void OnFindSessionsBatch(TArrayView<const FOnlineSessionSearchResult> SessionResults, bool bIsFinalBatch);
+
+	// Not dynamic, and therefore not a UFUNCTION.
+	virtual void OnFindSessionsMatch(const FOnlineSessionSearchResult& SessionResult);
+
+	// Not dynamic, and therefore not a UFUNCTION.
+	void OnJoinSession(EOnJoinSessionCompleteResult::Type Result);
+
+	// MakeSearchFilter returns the filter used by Join and Quick Play: the menu's match type, with an open slot.
+	FMultiplayerSessionSearchFilter MakeSearchFilter() const;
+
+	UFUNCTION()
+	void OnDestroySession(bool bWasSuccessful);
+
+	UFUNCTION()
+	void OnStartSession(bool bWasSuccessful);
+
+	UPROPERTY()
+	class UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem;
+
+	/********************
+	Host and Join buttons
+	********************/
+
+	UPROPERTY(meta = (BindWidget))
+	class UButton* HostButton;
+
+	UPROPERTY(meta = (BindWidget))
+	UButton* JoinButton;
+
+	UFUNCTION()
+	void HostButtonClicked();
+
+	UFUNCTION()
+	virtual void JoinButtonClicked();
+
+	// Optional. When bound, the menu keeps quick play candidates warm while it is open, and Quick Play joins the best of them.
+	UPROPERTY(meta = (BindWidgetOptional))
+	UButton* QuickPlayButton;
+
+	UFUNCTION()
+	void QuickPlayButtonClicked();
+
+	/************************
+	Saved Session Information
+	************************/
+
+	int32 SessionSearchLimit{0};
+	int32 SessionSearchBatchSize{16};
+	bool bSearchMatched{false};
+	int32 NumPublicConnections{0};
+	FString MatchType{TEXT("")};
+	FString LobbyMapPath{TEXT("")};
+
+private:
+	void Destroy();
+};
@@ -0,0 +1,130 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+#include "MultiplayerSessionBackend.h"
+#include "SessionDirectory.h"
+#include "SessionMetrics.h"
+
+#include "DirectorySessionBackend.generated.h"
+
+/*
+ * FMultiplayerDirectoryBackendSettings configures how the directory backend registers sessions and pages through searches.
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerDirectoryBackendSettings
+{
+	GENERATED_BODY()
+
+	// Address advertised by hosted sessions, which joining clients travel to.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Directory Backend")
+	FString HostAddress{ TEXT("127.0.0.1:7777") };
+
+	// Sessions fetched per page. Each tick fetches one page, so large searches never stall a frame and streaming searches see partial results.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Directory Backend", meta=(ClampMin="1"))
+	int32 PageSize{ 100 };
+
+	// How often hosted sessions send a heartbeat, and how long the directory keeps a session without one.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Directory Backend", meta=(ClampMin="0.1", Units="s"))
+	float HeartbeatIntervalSeconds{ 5.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Directory Backend", meta=(ClampMin="0.1", Units="s"))
+	float ExpirySeconds{ 15.f };
+};
+
+/*
+ * FDirectoryBackendStats counts the directory traffic of one backend.
+ */
+struct MULTIPLAYERSESSIONS_API FDirectoryBackendStats
+{
+	// Registration batches sent, and the registrations and removals they carried.
+	int64 Batches{ 0 };
+	int64 Registrations{ 0 };
+	int64 Removals{ 0 };
+	int64 Heartbeats{ 0 };
+
+	int64 PagesFetched{ 0 };
+	FLatencyHistogram PageLatency;
+};
+
+/*
+ * FDirectorySessionBackend advertises and finds sessions through a session directory instead of an Online Subsystem.
+ * The directory is in-process only, so only game instances in the same process, e.g. PIE clients, find each other's sessions.
+ * Registrations, updates and removals are buffered and sent as one batch per tick, hosted sessions send batched heartbeats,
+ * and searches page through the directory with a cursor until MaxSearchResults are found.
+ * Completions are delivered on the next tick, after the batch they depend on has been sent.
+ */
+class MULTIPLAYERSESSIONS_API FDirectorySessionBackend final : public IMultiplayerSessionBackend
+{
+public:
+	// When bInManualTick is 'true', work only happens through ProcessPending, e.g. when driven by the benchmark.
+	FDirectorySessionBackend(
+		const FMultiplayerDirectoryBackendSettings& InSettings,
+		TSharedRef<FSessionDirectory> InDirectory = FSessionDirectory::GetShared(),
+		bool bInManualTick = false
+	);
+	virtual ~FDirectorySessionBackend();
+
+	virtual FName GetSubsystemName() const override { return FName("Directory"); }
+	virtual bool CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool CancelFindSessions() override;
+	virtual bool JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual bool DestroySession(FName SessionName) override;
+	virtual bool StartSession(FName SessionName) override;
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData = true) override;
+	virtual bool HasSession(FName SessionName) const override;
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo) override;
+	virtual FUniqueNetIdPtr GetDefaultPlayerId() const override;
+	virtual bool SupportsSearchPages() const override { return true; }
+	virtual bool FindSessionsPage(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings, uint64 Cursor) override;
+
+	// ProcessPending sends the buffered batch and due heartbeats, fetches one page of the in-flight search, and delivers completions.
+	// Returns 'true' while a search or completions are still pending.
+	bool ProcessPending();
+
+	const FDirectoryBackendStats& GetStats() const { return Stats; }
+	const FSessionDirectory& GetDirectory() const { return *Directory; }
+
+private:
+	/*
+	 * FNamedSession is a session this player hosts or has joined.
+	 */
+	struct FNamedSession
+	{
+		FString SessionId;
+		FString OwnerName;
+		FString ConnectAddress;
+		bool bIsHost{ false };
+	};
+
+	bool Tick(float DeltaTime);
+	bool StartSearch(const TSharedRef<FOnlineSessionSearch>& SearchSettings, uint64 Cursor, bool bIsPage);
+	FSessionDirectoryEntry MakeEntry(const FString& SessionId, const FString& OwnerName, const FOnlineSessionSettings& SessionSettings) const;
+	void FetchSearchPage();
+
+	FMultiplayerDirectoryBackendSettings Settings;
+	TSharedRef<FSessionDirectory> Directory;
+	FTSTicker::FDelegateHandle TickerHandle;
+	double LastHeartbeatTime{ 0.0 };
+
+	TMap<FName, FNamedSession> NamedSessions;
+
+	// Sent to the directory as one batch by the next ProcessPending.
+	TArray<FSessionDirectoryEntry> PendingRegistrations;
+	TArray<FString> PendingRemovals;
+
+	// Delivered by the next ProcessPending, after the batch has been sent.
+	TArray<TUniqueFunction<void()>> PendingCompletions;
+
+	// The in-flight search, and the query for its next page.
+	// A search started by FindSessionsPage fetches a single page of MaxSearchResults sessions.
+	TSharedPtr<FOnlineSessionSearch> ActiveSearch;
+	FSessionDirectoryQuery ActiveQuery;
+	bool bActiveSearchIsPage{ false };
+
+	FDirectoryBackendStats Stats;
+};
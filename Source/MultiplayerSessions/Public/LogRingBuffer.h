@@ -0,0 +1,97 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+/*
+ * TMpscRingBuffer is a bounded, lock-free queue for many producers and a single consumer.
+ * Each cell carries a sequence number which tells producers and the consumer whose turn it is, so neither side ever blocks.
+ * Elements are written and read in place, so producing an element never allocates.
+ */
+template <typename ElementType, uint32 Capacity>
+class TMpscRingBuffer
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+public:
+	TMpscRingBuffer():
+		Cells(MakeUnique<FCell[]>(Capacity))
+	{
+		for (uint32 Index = 0; Index < Capacity; ++Index)
+		{
+			Cells[Index].Sequence.store(Index, std::memory_order_relaxed);
+		}
+	}
+
+	// TryProduce claims a free cell and passes its element to Write. Returns 'false' without waiting when the buffer is full.
+	// Safe to call from any thread.
+	template <typename WriterType>
+	bool TryProduce(WriterType&& Write)
+	{
+		uint64 Position = EnqueuePosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			FCell& Cell = Cells[Position & (Capacity - 1)];
+			const uint64 Sequence = Cell.Sequence.load(std::memory_order_acquire);
+			const int64 Difference = static_cast<int64>(Sequence) - static_cast<int64>(Position);
+			if (Difference == 0)
+			{
+				if (EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+				{
+					Write(Cell.Element);
+					Cell.Sequence.store(Position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (Difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Position = EnqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// TryConsume passes the oldest element to Read. Returns 'false' when the buffer is empty.
+	// Must only be called from the consumer thread.
+	template <typename ReaderType>
+	bool TryConsume(ReaderType&& Read)
+	{
+		const uint64 Position = DequeuePosition.load(std::memory_order_relaxed);
+		FCell& Cell = Cells[Position & (Capacity - 1)];
+		const uint64 Sequence = Cell.Sequence.load(std::memory_order_acquire);
+		if (static_cast<int64>(Sequence) - static_cast<int64>(Position + 1) < 0)
+		{
+			return false;
+		}
+
+		Read(Cell.Element);
+		Cell.Sequence.store(Position + Capacity, std::memory_order_release);
+		DequeuePosition.store(Position + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Num is approximate while producers are running.
+	uint32 Num() const
+	{
+		return static_cast<uint32>(EnqueuePosition.load(std::memory_order_relaxed) - DequeuePosition.load(std::memory_order_relaxed));
+	}
+
+private:
+	struct FCell
+	{
+		std::atomic<uint64> Sequence;
+		ElementType Element;
+	};
+
+	TUniquePtr<FCell[]> Cells;
+
+	// Producers and the consumer write different positions, so keep them on separate cache lines.
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> EnqueuePosition{ 0 };
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> DequeuePosition{ 0 };
+};
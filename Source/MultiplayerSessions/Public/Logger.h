@@ -1,19 +1,231 @@
-// (c) 2023 Will Roberts
-
-#pragma once
-
-#include "CoreMinimal.h"
-
-DECLARE_LOG_CATEGORY_EXTERN(LogMultiplayerSessions, Log, All);
-
-/*
- * Logger provides static methods for logging information.
- */
-class MULTIPLAYERSESSIONS_API Logger
-{
-public:
-	Logger();
-	~Logger();
-
-	static void Log(FString Message, bool bIsError);
-};
\ No newline at end of file
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Tuple.h"
+
+#include "MultiplayerLogLevel.h"
+
+#include <atomic>
+#include <type_traits>
+
+DECLARE_LOG_CATEGORY_EXTERN(LogMultiplayerSessions, Log, All);
+
+// The most verbose level compiled into the build, and the sinks which receive messages. Set per configuration in MultiplayerSessions.Build.cs.
+#ifndef MULTIPLAYERSESSIONS_LOG_LEVEL
+#define MULTIPLAYERSESSIONS_LOG_LEVEL 4
+#endif
+#ifndef MULTIPLAYERSESSIONS_LOG_TO_SCREEN
+#define MULTIPLAYERSESSIONS_LOG_TO_SCREEN 1
+#endif
+#ifndef MULTIPLAYERSESSIONS_LOG_TO_FILE
+#define MULTIPLAYERSESSIONS_LOG_TO_FILE 1
+#endif
+#ifndef MULTIPLAYERSESSIONS_LOG_TO_TRACE
+#define MULTIPLAYERSESSIONS_LOG_TO_TRACE 0
+#endif
+
+// MULTIPLAYER_LOG writes a printf-style message at one of the EMultiplayerLogLevel levels, e.g. MULTIPLAYER_LOG(Error, TEXT("Failed: %s"), *Reason).
+// Levels above MULTIPLAYERSESSIONS_LOG_LEVEL compile to nothing, so their arguments are never evaluated.
+#define MULTIPLAYER_LOG(Level, Format, ...) \
+	do \
+	{ \
+		if constexpr (Logger::IsCompiledIn(EMultiplayerLogLevel::Level)) \
+		{ \
+			if (Logger::IsEnabled(EMultiplayerLogLevel::Level)) \
+			{ \
+				Logger::Logf(EMultiplayerLogLevel::Level, Format, ##__VA_ARGS__); \
+			} \
+		} \
+	} while (0)
+
+/*
+ * FLogPayload holds a log message's arguments until the logging thread formats them.
+ */
+struct MULTIPLAYERSESSIONS_API FLogPayload
+{
+	virtual ~FLogPayload() {}
+	virtual FString Format() const = 0;
+
+protected:
+	// FormatVarArgs formats printf-style arguments. Strings must be passed as TCHAR pointers.
+	static FString FormatVarArgs(const TCHAR* Format, ...);
+};
+
+/*
+ * FLogMessagePayload holds a message which was formatted by the caller.
+ */
+struct MULTIPLAYERSESSIONS_API FLogMessagePayload final : public FLogPayload
+{
+	explicit FLogMessagePayload(FString InMessage): Message(MoveTemp(InMessage)) {}
+	virtual FString Format() const override { return Message; }
+
+	FString Message;
+};
+
+// TLogArg maps each Logf argument to the type stored until formatting. Strings are copied, since they may not outlive the call.
+template <typename T> struct TLogArg { using Type = T; };
+template <> struct TLogArg<const TCHAR*> { using Type = FString; };
+template <> struct TLogArg<TCHAR*> { using Type = FString; };
+
+template <typename T> const T& UnwrapLogArg(const T& Value) { return Value; }
+inline const TCHAR* UnwrapLogArg(const FString& Value) { return *Value; }
+
+/*
+ * TLogFormatPayload holds a printf-style format string and copies of its arguments.
+ */
+template <typename... ArgTypes>
+struct TLogFormatPayload final : public FLogPayload
+{
+	TLogFormatPayload(const TCHAR* InFormatString, ArgTypes... InArgs):
+		FormatString(InFormatString),
+		Args(MoveTemp(InArgs)...)
+	{}
+
+	virtual FString Format() const override
+	{
+		return Args.ApplyAfter([this](const auto&... Captured) { return FormatVarArgs(FormatString, UnwrapLogArg(Captured)...); });
+	}
+
+	const TCHAR* FormatString;
+	TTuple<ArgTypes...> Args;
+};
+
+/*
+ * FLogRecord is one entry in the logger's queue.
+ * Payloads are constructed in the record's inline storage when they fit, so queueing a typical message does not allocate.
+ */
+struct MULTIPLAYERSESSIONS_API FLogRecord
+{
+	FLogRecord() {}
+	FLogRecord(const FLogRecord&) = delete;
+	FLogRecord& operator=(const FLogRecord&) = delete;
+	~FLogRecord() { Reset(); }
+
+	template <typename PayloadType, typename... ArgTypes>
+	void Emplace(ArgTypes&&... Args)
+	{
+		if constexpr (sizeof(PayloadType) <= InlineBytes && alignof(PayloadType) <= InlineAlignment)
+		{
+			Payload = new (Storage) PayloadType(Forward<ArgTypes>(Args)...);
+			bIsInline = true;
+		}
+		else
+		{
+			Payload = new PayloadType(Forward<ArgTypes>(Args)...);
+			bIsInline = false;
+		}
+	}
+
+	FString Format() const { return Payload ? Payload->Format() : FString(); }
+	void Reset();
+
+	static constexpr SIZE_T InlineBytes = 96;
+	static constexpr SIZE_T InlineAlignment = 16;
+
+	double Time{ 0.0 };
+	EMultiplayerLogLevel Level{ EMultiplayerLogLevel::Info };
+
+private:
+	alignas(InlineAlignment) uint8 Storage[InlineBytes];
+	FLogPayload* Payload{ nullptr };
+	bool bIsInline{ false };
+};
+
+/*
+ * FLoggerStats reports the logger's throughput.
+ */
+struct MULTIPLAYERSESSIONS_API FLoggerStats
+{
+	uint64 Queued{ 0 };
+
+	// Messages discarded because the queue was full. The caller is never blocked.
+	uint64 Dropped{ 0 };
+	uint64 Written{ 0 };
+
+	// On-screen messages merged into an identical message which was still displayed.
+	uint64 OnScreenDeduplicated{ 0 };
+
+	// On-screen messages hidden by the rate limit. These are still written to the log file.
+	uint64 OnScreenSuppressed{ 0 };
+};
+
+/*
+ * Logger provides static methods for logging information.
+ * Messages are queued in a lock-free ring buffer and written by a background thread, so callers never format or wait on I/O.
+ * On-screen messages are rate limited and deduplicated on the game thread.
+ * Before Startup and after Shutdown, messages are written immediately on the calling thread.
+ * Use the MULTIPLAYER_LOG macros rather than calling Logf directly, so disabled levels are compiled out.
+ */
+class MULTIPLAYERSESSIONS_API Logger
+{
+public:
+	Logger();
+	~Logger();
+
+	// IsCompiledIn returns 'true' when messages at Level are compiled into this build.
+	static constexpr bool IsCompiledIn(EMultiplayerLogLevel Level)
+	{
+		return Level != EMultiplayerLogLevel::Off && static_cast<int32>(Level) <= MULTIPLAYERSESSIONS_LOG_LEVEL;
+	}
+
+	// IsEnabled returns 'true' when messages at Level pass the configured runtime level.
+	static bool IsEnabled(EMultiplayerLogLevel Level)
+	{
+		return static_cast<uint8>(Level) <= RuntimeLevel.load(std::memory_order_relaxed);
+	}
+
+	// GetRuntimeLevel returns the configured level, after clamping to the compiled level.
+	static EMultiplayerLogLevel GetRuntimeLevel()
+	{
+		return static_cast<EMultiplayerLogLevel>(RuntimeLevel.load(std::memory_order_relaxed));
+	}
+
+	// SetRuntimeLevel changes the configured level. Levels which were not compiled in stay disabled.
+	static void SetRuntimeLevel(EMultiplayerLogLevel Level);
+
+	// Log queues a message which has already been formatted. Errors are written at the Error level, and other messages at the Info level.
+	static void Log(FString Message, bool bIsError);
+
+	// Logf queues a printf-style message, which is formatted on the logging thread instead of by the caller.
+	// Format must be a string literal. Pass strings as TCHAR pointers or FStrings.
+	template <typename FmtType, typename... ArgTypes>
+	static void Logf(EMultiplayerLogLevel Level, const FmtType& Format, ArgTypes... Args)
+	{
+		static_assert(TIsArrayOrRefOfType<FmtType, TCHAR>::Value, "Formatting string must be a TCHAR array.");
+		static_assert(
+			((std::is_arithmetic_v<ArgTypes> || std::is_pointer_v<ArgTypes> || std::is_enum_v<ArgTypes> || std::is_same_v<ArgTypes, FString>) && ...),
+			"Logf arguments must be numbers, enums, pointers, or strings.");
+		Enqueue<TLogFormatPayload<typename TLogArg<ArgTypes>::Type...>>(Level, Format, MoveTemp(Args)...);
+	}
+
+	// Startup starts the logging thread. Shutdown writes every queued message and stops it.
+	static void Startup();
+	static void Shutdown();
+
+	// Flush waits until every message queued before the call has been written, e.g. before a test checks the output log.
+	static void Flush();
+
+	static FLoggerStats GetStats();
+
+	// LogImmediate writes a message to the compiled-in sinks on the calling thread.
+	static void LogImmediate(const FString& Message, EMultiplayerLogLevel Level);
+
+private:
+	template <typename PayloadType, typename... ArgTypes>
+	static void Enqueue(EMultiplayerLogLevel Level, ArgTypes&&... Args)
+	{
+		const bool bQueued = TryEnqueue(Level, [&](FLogRecord& Record) { Record.Emplace<PayloadType>(Forward<ArgTypes>(Args)...); });
+		if (!bQueued && !IsRunning())
+		{
+			LogImmediate(PayloadType(Forward<ArgTypes>(Args)...).Format(), Level);
+		}
+	}
+
+	// TryEnqueue returns 'false' when the logging thread is not running, or the queue is full.
+	static bool TryEnqueue(EMultiplayerLogLevel Level, TFunctionRef<void(FLogRecord&)> Write);
+	static bool IsRunning();
+
+	static std::atomic<uint8> RuntimeLevel;
+};
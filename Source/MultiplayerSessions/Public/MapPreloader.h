@@ -0,0 +1,71 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+
+#include "SessionMetrics.h"
+
+class UWorld;
+
+/*
+ * FMapPreloadStats records how long host and join flows took to reach their map, with and without preloading.
+ */
+struct MULTIPLAYERSESSIONS_API FMapPreloadStats
+{
+	// Time from the start of a host or join flow until its map finished loading.
+	FLatencyHistogram TimeToMapPreloaded;
+	FLatencyHistogram TimeToMapNotPreloaded;
+
+	// Time the most recent preload took to load the map, or negative if it did not finish.
+	double LastPreloadSeconds{ -1.0 };
+	double LastTimeToMapSeconds{ -1.0 };
+
+	int32 Preloads{ 0 };
+
+	// Preloads released before their map was traveled to, e.g. because the session could not be created or joined.
+	int32 Released{ 0 };
+};
+
+/*
+ * FMapPreloader loads a map and its dependencies in the background while a session is being created or joined,
+ * so travel finds the map already in memory instead of loading it after the backend responds.
+ * The loaded packages are held until the map has been traveled to, or until Release is called.
+ */
+class MULTIPLAYERSESSIONS_API FMapPreloader
+{
+public:
+	FMapPreloader();
+	~FMapPreloader();
+
+	// Begin starts timing a host or join flow to the map in MapURL, e.g. "/Game/Maps/Lobby?listen".
+	// When bPreload is 'true', the map starts loading immediately. A preload of another map is released,
+	// and a flow to the same map keeps its preload and start time.
+	void Begin(const FString& MapURL, bool bPreload);
+
+	// GetMapPackageName strips the options from MapURL, and returns an empty string when it is not a long package name.
+	static FString GetMapPackageName(const FString& MapURL);
+
+	// Release drops the preloaded map, so it can be garbage collected, and stops timing the flow.
+	void Release();
+
+	bool IsLoading() const;
+	bool IsLoaded() const;
+	const FMapPreloadStats& GetStats() const { return Stats; }
+
+private:
+	void OnPreloadComplete();
+	void OnPostLoadMap(UWorld* LoadedWorld);
+
+	FStreamableManager StreamableManager;
+	TSharedPtr<FStreamableHandle> Handle;
+	FDelegateHandle PostLoadMapHandle;
+
+	// The map of the flow being timed, or empty when no flow is in progress.
+	FString PackageName;
+	bool bPreloading{ false };
+	double BeginTime{ 0.0 };
+
+	FMapPreloadStats Stats;
+};
@@ -0,0 +1,171 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Math/RandomStream.h"
+
+#include "MultiplayerSessionBackend.h"
+
+#include "MockSessionBackend.generated.h"
+
+/*
+ * FMultiplayerMockOperationSettings configures the latency and failure rate of one mock operation.
+ * Latencies are drawn uniformly between the minimum and maximum, and TailChance of operations take TailLatencySeconds instead.
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerMockOperationSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend", meta=(ClampMin="0.0", Units="s"))
+	float MinLatencySeconds{ 0.05f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend", meta=(ClampMin="0.0", Units="s"))
+	float MaxLatencySeconds{ 0.2f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend", meta=(ClampMin="0.0", ClampMax="1.0"))
+	float TailChance{ 0.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend", meta=(ClampMin="0.0", Units="s"))
+	float TailLatencySeconds{ 5.f };
+
+	// Fraction of operations which complete with a failure.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend", meta=(ClampMin="0.0", ClampMax="1.0"))
+	float FailureRate{ 0.f };
+};
+
+/*
+ * FMultiplayerMockBackendSettings configures the in-process mock backend.
+ * The same seed always produces the same sessions, latencies, failures and orderings.
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerMockBackendSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	int32 Seed{ 1 };
+
+	// Number of remote sessions which searches can find, before filtering and MaxSearchResults are applied.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend", meta=(ClampMin="0"))
+	int32 NumSessions{ 100 };
+
+	// Match types and regions advertised by the remote sessions, chosen at random for each session.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	TArray<FString> MatchTypes{ TEXT("FreeForAll") };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	TArray<FString> Regions{ TEXT("us-east"), TEXT("us-west"), TEXT("eu-west") };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend", meta=(ClampMin="1"))
+	int32 MaxPlayersPerSession{ 8 };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend", meta=(ClampMin="0"))
+	int32 MaxPingMs{ 250 };
+
+	// Fraction of completions which are delivered after the next pending completion, rather than in order.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend", meta=(ClampMin="0.0", ClampMax="1.0"))
+	float ReorderChance{ 0.f };
+
+	// When 'true', search results are returned in a random order instead of the order the sessions were created in.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	bool bShuffleResults{ false };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	FMultiplayerMockOperationSettings Create;
+
+	// Search results arrive gradually over the search's latency, so streaming searches see partial results.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	FMultiplayerMockOperationSettings Find;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	FMultiplayerMockOperationSettings Join;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	FMultiplayerMockOperationSettings Destroy;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	FMultiplayerMockOperationSettings Start;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Mock Backend")
+	FMultiplayerMockOperationSettings Update;
+};
+
+/*
+ * FMockSessionBackend simulates a session provider in process, without a network or platform services.
+ * Completions are delivered by a ticker after a simulated latency, or by Advance when the backend is driven manually,
+ * so the subsystem can be exercised headless with large result sets, slow responses and injected failures.
+ */
+class MULTIPLAYERSESSIONS_API FMockSessionBackend final : public IMultiplayerSessionBackend
+{
+public:
+	// When bInManualClock is 'true', time only moves forward through Advance, which makes runs fully deterministic.
+	explicit FMockSessionBackend(const FMultiplayerMockBackendSettings& InSettings, bool bInManualClock = false);
+	virtual ~FMockSessionBackend();
+
+	virtual FName GetSubsystemName() const override { return FName("Mock"); }
+	virtual bool CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool CancelFindSessions() override;
+	virtual bool JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual bool DestroySession(FName SessionName) override;
+	virtual bool StartSession(FName SessionName) override;
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData = true) override;
+	virtual bool HasSession(FName SessionName) const override;
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo) override;
+	virtual FUniqueNetIdPtr GetDefaultPlayerId() const override;
+
+	// Advance moves the backend's clock forward and delivers every completion which is due.
+	void Advance(double DeltaSeconds);
+
+	// AdvanceToNext moves the clock to the next pending completion and delivers it, skipping the simulated wait.
+	// Returns 'false' when nothing is pending.
+	bool AdvanceToNext();
+
+	// NumPending returns the number of operations which have not completed yet.
+	int32 NumPending() const { return Pending.Num(); }
+
+	const FMultiplayerMockBackendSettings& GetSettings() const { return Settings; }
+
+private:
+	struct FPendingCompletion
+	{
+		double DueTime;
+		uint64 Sequence;
+		TUniqueFunction<void()> Complete;
+	};
+
+	bool Tick(float DeltaTime);
+	double DrawLatency(const FMultiplayerMockOperationSettings& Operation);
+	bool DrawFailure(const FMultiplayerMockOperationSettings& Operation);
+	void Schedule(double Latency, TUniqueFunction<void()> Complete);
+	void GenerateSessions();
+	void DeliverSearchResults(double Progress);
+	bool MatchesQuery(const FOnlineSessionSearchResult& Result, const FOnlineSessionSearch& Search) const;
+
+	FMultiplayerMockBackendSettings Settings;
+	FRandomStream Random;
+	double Now{ 0.0 };
+	uint64 NextSequence{ 0 };
+	bool bManualClock{ false };
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	// Completions ordered by due time, then by the order they were scheduled in.
+	TArray<FPendingCompletion> Pending;
+
+	// Remote sessions which searches can find, generated once from the seed.
+	TArray<FOnlineSessionSearchResult> Sessions;
+
+	// The in-flight search, its matching results, and the window over which they are delivered.
+	// Callers may filter delivered results out of the search, so the number delivered is counted separately.
+	TSharedPtr<FOnlineSessionSearch> ActiveSearch;
+	TArray<int32> ActiveSearchMatches;
+	int32 ActiveSearchNumDelivered{ 0 };
+	double ActiveSearchStartTime{ 0.0 };
+	double ActiveSearchLatency{ 0.0 };
+
+	// Sessions which have been created or joined, with the address of each joined session.
+	TMap<FName, FString> NamedSessions;
+};
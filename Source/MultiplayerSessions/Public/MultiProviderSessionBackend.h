@@ -0,0 +1,179 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+#include "MultiplayerSessionBackend.h"
+#include "SessionMetrics.h"
+
+#include "MultiProviderSessionBackend.generated.h"
+
+/*
+ * FMultiplayerMultiProviderSettings configures which providers are searched together, and how their results are merged.
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerMultiProviderSettings
+{
+	GENERATED_BODY()
+
+	// Providers searched at the same time, e.g. "NULL" for LAN, "Steam" and "EOS" for crossplay.
+	// "Mock" and "Directory" add the in-process backends, and each additional "Mock" simulates different sessions.
+	// Sessions are hosted on the first provider. List two or more providers to search them together.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Multi-Provider Search")
+	TArray<FName> Providers;
+
+	// Providers which have not completed this long after the first one did are cancelled, and the search completes
+	// with the results received so far. Set to 0 to always wait for every provider.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Multi-Provider Search", meta=(ClampMin="0.0", Units="s"))
+	float StragglerTimeoutSeconds{ 5.f };
+
+	// When 'true', results are also merged by the host's name, for hosts which advertise the same session on several providers
+	// under different session IDs. Results are always merged by session ID.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Multi-Provider Search")
+	bool bMergeByOwnerName{ false };
+};
+
+/*
+ * FSearchProviderStats counts the searches of one provider, and how long they took.
+ */
+struct MULTIPLAYERSESSIONS_API FSearchProviderStats
+{
+	FName Name;
+
+	// Searches sent, those which failed, and those cancelled by the straggler timeout.
+	int32 Searches{ 0 };
+	int32 Failures{ 0 };
+	int32 TimedOut{ 0 };
+
+	// Completions dropped because their search was rejected, cancelled, timed out, or replaced by a later one.
+	int32 StaleCompletions{ 0 };
+
+	// Results received, and those dropped because another provider had already returned the session.
+	int64 ResultsReceived{ 0 };
+	int64 DuplicatesDropped{ 0 };
+
+	// Time from the start of a search until this provider completed it.
+	FLatencyHistogram SearchLatency;
+};
+
+/*
+ * FMultiProviderSessionBackend searches several providers at the same time, and merges their results into one search.
+ * Results are appended to the caller's search as each provider delivers them, without duplicates,
+ * so streaming searches see every provider's results as soon as they arrive. The search completes when every provider has,
+ * or when the slowest providers exceed the straggler timeout. Sessions are hosted on the first provider,
+ * joins go to the provider which found the session, and later operations on a named session go to the provider it was created or joined on.
+ */
+class MULTIPLAYERSESSIONS_API FMultiProviderSessionBackend final : public IMultiplayerSessionBackend
+{
+public:
+	// When bInManualTick is 'true', results are only merged and stragglers cancelled through ProcessPending, e.g. when driven by a test.
+	FMultiProviderSessionBackend(
+		TArray<TSharedRef<IMultiplayerSessionBackend>> InProviders,
+		const FMultiplayerMultiProviderSettings& InSettings,
+		bool bInManualTick = false
+	);
+	virtual ~FMultiProviderSessionBackend();
+
+	// Create returns a backend for the providers in the settings, skipping those which are not available or listed twice.
+	// Returns nullptr when none are available.
+	static TSharedPtr<FMultiProviderSessionBackend> Create(const FMultiplayerMultiProviderSettings& InSettings);
+
+	virtual FName GetSubsystemName() const override { return FName("MultiProvider"); }
+	virtual bool IsLANProvider() const override { return Providers[0].Backend->IsLANProvider(); }
+	virtual bool CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool CancelFindSessions() override;
+	virtual bool JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual bool DestroySession(FName SessionName) override;
+	virtual bool StartSession(FName SessionName) override;
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData = true) override;
+	virtual bool HasSession(FName SessionName) const override;
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo) override;
+	virtual FUniqueNetIdPtr GetDefaultPlayerId() const override;
+
+	// ProcessPending fails rejected searches, merges results delivered since the previous call, and completes the search when it is done.
+	void ProcessPending();
+
+	int32 NumProviders() const { return Providers.Num(); }
+	IMultiplayerSessionBackend& GetProvider(int32 ProviderIndex) const { return *Providers[ProviderIndex].Backend; }
+
+	const FSearchProviderStats& GetProviderStats(int32 ProviderIndex) const { return Providers[ProviderIndex].Stats; }
+
+	// Merged searches, and results dropped because the merged search already held MaxSearchResults.
+	int32 GetSearches() const { return Searches; }
+	int64 GetResultsOverLimit() const { return ResultsOverLimit; }
+
+private:
+	/*
+	 * FProvider is one provider, and its part of the in-flight search.
+	 */
+	struct FProvider
+	{
+		explicit FProvider(TSharedRef<IMultiplayerSessionBackend> InBackend): Backend(MoveTemp(InBackend)) {}
+
+		TSharedRef<IMultiplayerSessionBackend> Backend;
+
+		// The provider's own copy of the search, and how many of its results have been merged.
+		TSharedPtr<FOnlineSessionSearch> Search;
+		int32 NumMerged{ 0 };
+		bool bSucceeded{ false };
+
+		// The serial of the merged search the provider is searching for, or 0 when it is not searching.
+		// Completions are only accepted for the current serial, once the provider's own search has finished.
+		uint32 SearchSerial{ 0 };
+
+		bool IsSearching() const { return SearchSerial != 0; }
+
+		FSearchProviderStats Stats;
+
+		// The provider's delegates stay bound for the backend's lifetime, and forward to the backend's delegates.
+		FDelegateHandle CreateSessionCompleteHandle;
+		FDelegateHandle FindSessionsCompleteHandle;
+		FDelegateHandle JoinSessionCompleteHandle;
+		FDelegateHandle DestroySessionCompleteHandle;
+		FDelegateHandle StartSessionCompleteHandle;
+		FDelegateHandle UpdateSessionCompleteHandle;
+	};
+
+	bool Tick(float DeltaTime);
+	void OnProviderSearchComplete(int32 ProviderIndex, bool bWasSuccessful);
+	void MergeResults(int32 ProviderIndex);
+	void CancelStragglers();
+	void CompleteSearch();
+	int32 FindResultProvider(const FOnlineSessionSearchResult& Result) const;
+	int32 GetSessionProvider(FName SessionName) const;
+	static FUniqueNetIdRef GetProviderPlayerId(const IMultiplayerSessionBackend& Provider, const FUniqueNetId& PlayerId);
+
+	TArray<FProvider> Providers;
+	FMultiplayerMultiProviderSettings Settings;
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	// The caller's search, which receives the merged results, and the time it started.
+	TSharedPtr<FOnlineSessionSearch> ActiveSearch;
+	double SearchStartTime{ 0.0 };
+
+	// Incremented by each search, so providers which still complete a cancelled or timed out search are not mistaken for the current one.
+	uint32 SearchSerial{ 0 };
+
+	// Set once the first provider completes, when the straggler timeout starts.
+	double FirstCompletionTime{ -1.0 };
+
+	// Set while FindSessions sends the search to each provider, so completions delivered synchronously wait for the next tick.
+	bool bStartingSearch{ false };
+
+	// Searches started while another was in flight, which fail on the next tick.
+	int32 NumRejectedSearches{ 0 };
+
+	// The provider which returned each merged session, by session ID, and the hosts merged when merging by owner name.
+	// Reset by each search.
+	TMap<FString, int32> ResultProviders;
+	TSet<FString> MergedOwners;
+
+	// The provider each named session was created or joined on.
+	TMap<FName, int32> SessionProviders;
+
+	int32 Searches{ 0 };
+	int64 ResultsOverLimit{ 0 };
+};
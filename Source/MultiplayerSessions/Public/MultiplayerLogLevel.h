@@ -0,0 +1,21 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MultiplayerLogLevel.generated.h"
+
+/*
+ * EMultiplayerLogLevel orders the plugin's log levels from least to most verbose.
+ * Messages are written when their level is at or below both the compiled and the configured level.
+ */
+UENUM()
+enum class EMultiplayerLogLevel : uint8
+{
+	Off,
+	Error,
+	Warning,
+	Info,
+	Verbose
+};
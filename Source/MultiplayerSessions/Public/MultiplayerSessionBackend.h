@@ -0,0 +1,106 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "OnlineDelegateMacros.h"
+
+class FOnlineSessionSearch;
+class FOnlineSessionSettings;
+class FUniqueNetId;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnFindSessionsPageComplete, bool, uint64);
+typedef FOnFindSessionsPageComplete::FDelegate FOnFindSessionsPageCompleteDelegate;
+
+/*
+ * IMultiplayerSessionBackend is the subset of IOnlineSession used by the subsystem and the debug menu.
+ * The subsystem only talks to a backend, so an in-process mock can stand in for Steam, EOS or the NULL subsystem.
+ * Completion delegates are declared with the Online Subsystem's macros, so they are bound and cleared exactly like IOnlineSession's.
+ */
+class MULTIPLAYERSESSIONS_API IMultiplayerSessionBackend
+{
+public:
+	virtual ~IMultiplayerSessionBackend() {}
+
+	// GetSubsystemName returns the provider's name, e.g. "Steam", "NULL" or "Mock".
+	virtual FName GetSubsystemName() const = 0;
+
+	// IsLANProvider returns 'true' for providers which find sessions by LAN broadcast, such as the NULL subsystem.
+	// Their sessions are hosted as LAN matches, and searched for with LAN queries.
+	virtual bool IsLANProvider() const { return false; }
+
+	virtual bool CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) = 0;
+	virtual bool FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) = 0;
+	virtual bool CancelFindSessions() = 0;
+	virtual bool JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) = 0;
+	virtual bool DestroySession(FName SessionName) = 0;
+	virtual bool StartSession(FName SessionName) = 0;
+
+	// UpdateSession changes the settings of a live session, which stays advertised throughout.
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData = true) = 0;
+
+	// HasSession returns 'true' when a session with this name has been created or joined, and not destroyed.
+	virtual bool HasSession(FName SessionName) const = 0;
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo) = 0;
+
+	// GetDefaultPlayerId returns the ID to use when there is no local player, e.g. on a headless client. Providers require a local player.
+	virtual FUniqueNetIdPtr GetDefaultPlayerId() const { return nullptr; }
+
+	// SupportsSearchPages returns 'true' when FindSessionsPage can resume a search from a cursor, e.g. for the session directory.
+	virtual bool SupportsSearchPages() const { return false; }
+
+	// FindSessionsPage finds at most SearchSettings->MaxSearchResults sessions after Cursor, which is zero for the first page.
+	// It completes through OnFindSessionsPageComplete with the next page's cursor, which is zero after the last page.
+	// Only called when SupportsSearchPages returns 'true'.
+	virtual bool FindSessionsPage(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings, uint64 Cursor) { return false; }
+
+	DEFINE_ONLINE_DELEGATE_TWO_PARAM(OnCreateSessionComplete, FName, bool);
+	DEFINE_ONLINE_DELEGATE_ONE_PARAM(OnFindSessionsComplete, bool);
+	DEFINE_ONLINE_DELEGATE_TWO_PARAM(OnFindSessionsPageComplete, bool, uint64);
+	DEFINE_ONLINE_DELEGATE_TWO_PARAM(OnJoinSessionComplete, FName, EOnJoinSessionCompleteResult::Type);
+	DEFINE_ONLINE_DELEGATE_TWO_PARAM(OnDestroySessionComplete, FName, bool);
+	DEFINE_ONLINE_DELEGATE_TWO_PARAM(OnStartSessionComplete, FName, bool);
+	DEFINE_ONLINE_DELEGATE_TWO_PARAM(OnUpdateSessionComplete, FName, bool);
+};
+
+/*
+ * FOnlineSessionBackend forwards to the session interface of an Online Subsystem, such as Steam or NULL.
+ */
+class MULTIPLAYERSESSIONS_API FOnlineSessionBackend final : public IMultiplayerSessionBackend
+{
+public:
+	FOnlineSessionBackend(FName InSubsystemName, IOnlineSessionPtr InSessionInterface);
+	virtual ~FOnlineSessionBackend();
+
+	// Create returns a backend for the named Online Subsystem, or the default one when no name is given.
+	// Returns nullptr when the subsystem is not available or has no session interface.
+	static TSharedPtr<IMultiplayerSessionBackend> Create(FName SubsystemName = NAME_None);
+
+	virtual FName GetSubsystemName() const override { return SubsystemName; }
+	virtual bool IsLANProvider() const override { return bIsLANProvider; }
+	virtual bool CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool CancelFindSessions() override;
+	virtual bool JoinSession(const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual bool DestroySession(FName SessionName) override;
+	virtual bool StartSession(FName SessionName) override;
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData = true) override;
+	virtual bool HasSession(FName SessionName) const override;
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo) override;
+
+private:
+	FName SubsystemName;
+	IOnlineSessionPtr SessionInterface;
+
+	// Whether the subsystem is NULL, which is checked once here rather than by name on every session operation.
+	bool bIsLANProvider{ false };
+
+	// The session interface's delegates stay bound for the backend's lifetime, and forward to the backend's delegates.
+	FDelegateHandle CreateSessionCompleteHandle;
+	FDelegateHandle FindSessionsCompleteHandle;
+	FDelegateHandle JoinSessionCompleteHandle;
+	FDelegateHandle DestroySessionCompleteHandle;
+	FDelegateHandle StartSessionCompleteHandle;
+	FDelegateHandle UpdateSessionCompleteHandle;
+};
@@ -0,0 +1,158 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+
+#include "AdmissionController.h"
+#include "DirectorySessionBackend.h"
+#include "MockSessionBackend.h"
+#include "MultiProviderSessionBackend.h"
+#include "MultiplayerLogLevel.h"
+#include "QuickPlayPool.h"
+#include "SessionScorer.h"
+
+#include "MultiplayerSessionsSettings.generated.h"
+
+/*
+ * UMultiplayerSessionsSettings exposes the plugin's tunables in Project Settings.
+ * Values are saved to the project's DefaultGame.ini under [/Script/MultiplayerSessions.MultiplayerSessionsSettings].
+ */
+UCLASS(Config=Game, DefaultConfig, meta=(DisplayName="Multiplayer Sessions"))
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UMultiplayerSessionsSettings();
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Region advertised by hosted sessions, which searches can filter on. Leave empty to not advertise a region.
+	UPROPERTY(Config, EditAnywhere, Category="Sessions")
+	FString Region;
+
+	// Session operations which receive no response within this time are failed, so later operations can run. Set to 0 to wait forever.
+	UPROPERTY(Config, EditAnywhere, Category="Sessions", meta=(ClampMin="0.0", Units="s"))
+	float OperationTimeoutSeconds{ 30.f };
+
+	// When 'true', hosting again while hosting updates the live session's settings instead of destroying and recreating it,
+	// so the session stays visible to searches. Sessions are still recreated when the provider rejects the update.
+	UPROPERTY(Config, EditAnywhere, Category="Sessions")
+	bool bWarmRehost{ true };
+
+	// When 'true', hosting starts loading the lobby map while the session is being created, and joining starts loading
+	// the map the session advertises while the join is in flight, so travel does not wait for the load.
+	// Set to 'false' to measure the time to the map without preloading.
+	UPROPERTY(Config, EditAnywhere, Category="Sessions")
+	bool bPreloadLobbyMap{ true };
+
+	/***********************
+	Session settings updates
+	***********************/
+
+	// Settings changed by UpdateSessionSetting are collected for this long after the first change, then sent in one update.
+	UPROPERTY(Config, EditAnywhere, Category="Settings Updates", meta=(ClampMin="0.0", Units="s"))
+	float SettingsUpdateWindowSeconds{ 0.5f };
+
+	// Least time between two updates of a session's settings, so frequent changes, e.g. during a join storm, do not flood the backend.
+	UPROPERTY(Config, EditAnywhere, Category="Settings Updates", meta=(ClampMin="0.0", Units="s"))
+	float SettingsUpdateIntervalSeconds{ 2.f };
+
+	/*******************
+	Session search cache
+	*******************/
+
+	// Set to 'false' to run a full search on every FindSessions call.
+	UPROPERTY(Config, EditAnywhere, Category="Search Cache")
+	bool bEnableSearchCache{ true };
+
+	// Cached search results younger than this are served without contacting the backend.
+	UPROPERTY(Config, EditAnywhere, Category="Search Cache", meta=(ClampMin="0.0", Units="s"))
+	float SearchCacheTTLSeconds{ 10.f };
+
+	// When 'true', expired results are served immediately while a fresh search runs in the background.
+	UPROPERTY(Config, EditAnywhere, Category="Search Cache")
+	bool bStaleWhileRevalidate{ true };
+
+	// Expired results older than this are never served, even when stale-while-revalidate is enabled.
+	UPROPERTY(Config, EditAnywhere, Category="Search Cache", meta=(ClampMin="0.0", Units="s"))
+	float SearchCacheMaxStaleSeconds{ 60.f };
+
+	/***********
+	Paged search
+	***********/
+
+	// Sessions fetched per page by FSessionSearchPager, e.g. for server browsers which scroll through every session.
+	UPROPERTY(Config, EditAnywhere, Category="Paged Search", meta=(ClampMin="1"))
+	int32 SearchPageSize{ 50 };
+
+	// Estimated size of the pages a pager keeps in memory. Least recently used pages are evicted beyond it, and fetched again when needed.
+	UPROPERTY(Config, EditAnywhere, Category="Paged Search", meta=(ClampMin="1", Units="KB"))
+	int32 SearchPageMaxRetainedKB{ 256 };
+
+	/**********
+	Matchmaking
+	**********/
+
+	// Default weights used to rank search results when choosing which session to join.
+	UPROPERTY(Config, EditAnywhere, Category="Matchmaking")
+	FMultiplayerSessionScoringWeights ScoringWeights;
+
+	// Number of ranked sessions the debug menu will try to join before giving up.
+	UPROPERTY(Config, EditAnywhere, Category="Matchmaking", meta=(ClampMin="1"))
+	int32 MaxJoinAttempts{ 3 };
+
+	/*********
+	Quick play
+	*********/
+
+	// Background search size, pool size and refresh backoff used by StartQuickPlay. Candidates are ranked with ScoringWeights.
+	UPROPERTY(Config, EditAnywhere, Category="Quick Play")
+	FMultiplayerQuickPlaySettings QuickPlay;
+
+	/****************
+	Admission control
+	****************/
+
+	// Login rate, slot reservations and wait queue used by AAdmissionGameMode when many clients join at once.
+	UPROPERTY(Config, EditAnywhere, Category="Admission Control")
+	FMultiplayerAdmissionSettings AdmissionControl;
+
+	/******
+	Logging
+	******/
+
+	// Most verbose level written at runtime. Levels which are not compiled into the build configuration are never written.
+	UPROPERTY(Config, EditAnywhere, Category="Logging")
+	EMultiplayerLogLevel LogLevel{ EMultiplayerLogLevel::Info };
+
+	/******
+	Backend
+	******/
+
+	// When 'true', sessions are simulated in process instead of using the Online Subsystem. Also enabled by -MultiplayerSessionsMock.
+	UPROPERTY(Config, EditAnywhere, Category="Backend")
+	bool bUseMockBackend{ false };
+
+	// Sessions, latencies and failures simulated by the mock backend.
+	UPROPERTY(Config, EditAnywhere, Category="Backend")
+	FMultiplayerMockBackendSettings MockBackend;
+
+	// When 'true', sessions are advertised through the in-process session directory instead of the Online Subsystem,
+	// so large numbers of sessions can be hosted and searched by game instances in this process, e.g. PIE clients.
+	// Other processes, even on the same machine, cannot see them. Also enabled by -MultiplayerSessionsDirectory.
+	UPROPERTY(Config, EditAnywhere, Category="Backend")
+	bool bUseDirectoryBackend{ false };
+
+	// Registration, heartbeat and paging behavior of the directory backend.
+	UPROPERTY(Config, EditAnywhere, Category="Backend")
+	FMultiplayerDirectoryBackendSettings DirectoryBackend;
+
+	// Providers searched together, e.g. for crossplay, and how their results are merged. Also set by -MultiplayerSessionsProviders=NULL,Steam.
+	UPROPERTY(Config, EditAnywhere, Category="Backend")
+	FMultiplayerMultiProviderSettings MultiProvider;
+};
@@ -1,86 +1,647 @@
-// (c) 2023 Will Roberts
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "Interfaces/OnlineSessionInterface.h"
-#include "Subsystems/GameInstanceSubsystem.h"
-
-#include "MultiplayerSessionsSubsystem.generated.h"
-
-DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnCreateSessionComplete, bool, bWasSuccessful);
-DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsComplete, const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
-DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnJoinSessionComplete, EOnJoinSessionCompleteResult::Type Result);
-DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnDestroySessionComplete, bool, bWasSuccessful);
-DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnStartSessionComplete, bool, bWasSuccessful);
-
-/*
- * UMultiplayerSessionsSubsystem provides an implementation of the Online Subsystem using the Steam provider.
- * When using the plugin, players can host and join games when logged into Steam.
- * The hosting player will act as a listen server, resulting in a peer-to-peer network topology.
- */
-UCLASS()
-class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstanceSubsystem
-{
-	GENERATED_BODY()
-
-public:
-	UMultiplayerSessionsSubsystem();
-
-	void CreateSession(int32 NumPublicConnections, FString MatchType);
-	void FindSessions(int32 MaxSearchResults);
-	void JoinSession(const FOnlineSessionSearchResult& SessionResult);
-	void DestroySession();
-	void StartSession();
-
-	/************************
-	Bindable custom delegates
-	************************/
-
-	FMultiplayerOnCreateSessionComplete MultiplayerOnCreateSessionComplete;
-	FMultiplayerOnFindSessionsComplete MultiplayerOnFindSessionsComplete;
-	FMultiplayerOnJoinSessionComplete MultiplayerOnJoinSessionComplete;
-	FMultiplayerOnDestroySessionComplete MultiplayerOnDestroySessionComplete;
-	FMultiplayerOnStartSessionComplete MultiplayerOnStartSessionComplete;
-
-protected:
-	/*****************
-	Delegate callbacks
-	*****************/
-
-	void OnCreateSessionComplete(FName SessionName, bool bWasSuccessful);
-	void OnFindSessionsComplete(bool bWasSuccessful);
-	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
-	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
-	void OnStartSessionComplete(FName SessionName, bool bWasSuccessful);
-
-private:
-	IOnlineSessionPtr SessionInterface;
-
-	// Set to 'true' to automatically create a new session when the current session is destroyed.
-	bool bCreateSessionOnDestroy{ false };
-
-	/*************************************************************************
-	Save information about the last session to enable fast session recreation.
-	*************************************************************************/
-
-	TSharedPtr<FOnlineSessionSettings> LastSessionSettings;
-	TSharedPtr<FOnlineSessionSearch> LastSessionSearch;
-	int32 LastNumPublicConnections;
-	FString LastMatchType;
-
-	/****************************************************************
-	Save delegates and their handles (so we can clear them as needed)
-	****************************************************************/
-
-	FOnCreateSessionCompleteDelegate CreateSessionCompleteDelegate;
-	FDelegateHandle CreateSessionCompleteDelegateHandle;
-	FOnFindSessionsCompleteDelegate FindSessionsCompleteDelegate;
-	FDelegateHandle FindSessionsCompleteDelegateHandle;
-	FOnJoinSessionCompleteDelegate JoinSessionCompleteDelegate;
-	FDelegateHandle JoinSessionCompleteDelegateHandle;
-	FOnDestroySessionCompleteDelegate DestroySessionCompleteDelegate;
-	FDelegateHandle DestroySessionCompleteDelegateHandle;
-	FOnStartSessionCompleteDelegate StartSessionCompleteDelegate;
-	FDelegateHandle StartSessionCompleteDelegateHandle;
-};
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+
+#include "MapPreloader.h"
+#include "MultiplayerSessionBackend.h"
+#include "QuickPlayPool.h"
+#include "SessionMetrics.h"
+#include "SessionOperationQueue.h"
+#include "SessionSearchCache.h"
+#include "SessionScorer.h"
+#include "SessionSearchIndex.h"
+
+#include "MultiplayerSessionsSubsystem.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnCreateSessionComplete, bool, bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsComplete, const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnJoinSessionComplete, EOnJoinSessionCompleteResult::Type Result);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnDestroySessionComplete, bool, bWasSuccessful);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnStartSessionComplete, bool, bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsBatch, TArrayView<const FOnlineSessionSearchResult> SessionResults, bool bIsFinalBatch);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnFindSessionsMatch, const FOnlineSessionSearchResult& SessionResult);
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FMultiplayerOnSessionOperationComplete, FName SessionName, EMultiplayerSessionOperation Operation, bool bWasSuccessful);
+
+// Returns 'true' when a streamed search result is good enough to stop searching.
+using FMultiplayerSessionSearchPredicate = TFunction<bool(const FOnlineSessionSearchResult&)>;
+
+/*
+ * FMultiplayerSearchStreamStats records timings for the most recent streaming search.
+ * Times are measured in seconds from the FindSessionsStreaming call, and are negative when the event did not occur.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSearchStreamStats
+{
+	double TimeToFirstResult{ -1.0 };
+	double TimeToFirstJoinableSession{ -1.0 };
+	double TimeToComplete{ -1.0 };
+	int32 BatchesEmitted{ 0 };
+	int32 ResultsEmitted{ 0 };
+
+	// Set to 'true' when the search was cancelled because the stop predicate was satisfied.
+	bool bExitedEarly{ false };
+};
+
+/*
+ * FMultiplayerJoinAttempt records one join attempt made by a join pipeline.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerJoinAttempt
+{
+	// Index of the attempted session in the search index.
+	int32 CandidateIndex{ INDEX_NONE };
+	EOnJoinSessionCompleteResult::Type Result{ EOnJoinSessionCompleteResult::UnknownError };
+	double Seconds{ 0.0 };
+};
+
+/*
+ * FMultiplayerJoinPipelineStats records every attempt made by the most recent join pipeline.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerJoinPipelineStats
+{
+	TArray<FMultiplayerJoinAttempt> Attempts;
+
+	// Seconds from JoinRankedSessions until a join succeeded, or negative if every attempt failed.
+	double TimeToJoined{ -1.0 };
+};
+
+/*
+ * FMultiplayerRehostStats records how sessions were re-hosted, and how long they were not advertised while it happened.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerRehostStats
+{
+	// Re-hosts which updated the live session in place, and those which destroyed and recreated it.
+	int32 Updates{ 0 };
+	int32 Recreates{ 0 };
+
+	// Updates which the provider rejected, and which were recreated instead.
+	int32 UpdateFallbacks{ 0 };
+
+	// Time from sending an update until the session advertised the new settings. The session stays visible throughout.
+	FLatencyHistogram UpdateLatency;
+
+	// Time from destroying the old session until the new session was created, during which searches cannot find it.
+	FLatencyHistogram RecreateDowntime;
+
+	// Downtime of the most recent re-host, which is zero when the session was updated in place.
+	double LastDowntimeSeconds{ 0.0 };
+};
+
+/*
+ * FMultiplayerSettingsUpdateStats counts the advertised settings changes made while hosting, and the backend updates they were coalesced into.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSettingsUpdateStats
+{
+	// UpdateSessionSetting calls, and those which replaced a change still waiting to be sent.
+	int64 ChangesRequested{ 0 };
+	int64 ChangesCoalesced{ 0 };
+
+	// Changed settings which matched the advertised value when the update was sent, and were dropped.
+	int64 ChangesUnchanged{ 0 };
+
+	// Updates sent to the backend, the settings they carried, and updates the backend rejected.
+	int64 UpdatesSent{ 0 };
+	int64 SettingsPushed{ 0 };
+	int64 UpdatesFailed{ 0 };
+
+	// When the first change was requested, or negative before any change.
+	double FirstChangeTime{ -1.0 };
+
+	// Time from sending an update until the backend completed it.
+	FLatencyHistogram UpdateLatency;
+
+	// GetUpdatesSaved returns the backend updates avoided, compared to sending one update per change.
+	int64 GetUpdatesSaved() const { return FMath::Max<int64>(ChangesRequested - UpdatesSent, 0); }
+};
+
+/*
+ * FMultiplayerFindSessionsResult is the result of FindSessionsAsync.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerFindSessionsResult
+{
+	// The completed search. Holding it keeps its results alive, even after later searches complete.
+	TSharedPtr<FOnlineSessionSearch> Search;
+
+	// Set to 'false' when the search failed, was cancelled, or found no sessions.
+	bool bWasSuccessful{ false };
+};
+
+/*
+ * FMultiplayerSessionsPage is one page of a paged search, the result of FindSessionsPageAsync.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionsPage
+{
+	// The page's results. Holding it keeps only this page alive.
+	TSharedPtr<FOnlineSessionSearch> Search;
+
+	// The cursor the page was fetched from, and the cursor of the next page, which is zero after the last page.
+	uint64 Cursor{ 0 };
+	uint64 NextCursor{ 0 };
+
+	// Set to 'false' when the page could not be fetched. An empty last page is still successful.
+	bool bWasSuccessful{ false };
+};
+
+/*
+ * UMultiplayerSessionsSubsystem provides an implementation of the Online Subsystem using the Steam provider.
+ * When using the plugin, players can host and join games when logged into Steam.
+ * The hosting player will act as a listen server, resulting in a peer-to-peer network topology.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UMultiplayerSessionsSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Creates, joins, destroys and starts act on a named session, which defaults to the game session.
+	// Each named session has its own operation queue, so a party session can be hosted while a game session is joined.
+	// Operations on the same session still run one at a time. Searches are shared by every session.
+	void CreateSession(int32 NumPublicConnections, FString MatchType, FName SessionName = NAME_GameSession);
+	void FindSessions(int32 MaxSearchResults, FString MatchType = FString());
+	void FindSessions(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter);
+	void JoinSession(const FOnlineSessionSearchResult& SessionResult, FName SessionName = NAME_GameSession);
+	void JoinRankedSessions(const TArray<int32>& RankedIndices, FName SessionName = NAME_GameSession);
+	void DestroySession(FName SessionName = NAME_GameSession);
+	void StartSession(FName SessionName = NAME_GameSession);
+
+	// FindSessionsStreaming delivers results through MultiplayerOnFindSessionsBatch as they arrive, instead of waiting for the search to complete.
+	// When StopPredicate is set, the first satisfying result is broadcast through MultiplayerOnFindSessionsMatch and the search ends early.
+	void FindSessionsStreaming(
+		int32 MaxSearchResults,
+		const FMultiplayerSessionSearchFilter& Filter,
+		int32 BatchSize,
+		FMultiplayerSessionSearchPredicate StopPredicate = nullptr
+	);
+
+	/********
+	Async API
+	********/
+
+	// Each async call returns a future which is fulfilled with that call's result, and the delegates below are still broadcast.
+	// Continuations attached with Next() or Then() run on the game thread as soon as the operation completes,
+	// so operations can be chained without waiting for another tick.
+	// Requests coalesced into an existing operation are fulfilled with that operation's result.
+
+	TFuture<bool> CreateSessionAsync(int32 NumPublicConnections, FString MatchType, FName SessionName = NAME_GameSession);
+	TFuture<FMultiplayerFindSessionsResult> FindSessionsAsync(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter);
+	TFuture<EOnJoinSessionCompleteResult::Type> JoinSessionAsync(const FOnlineSessionSearchResult& SessionResult, FName SessionName = NAME_GameSession);
+	TFuture<EOnJoinSessionCompleteResult::Type> JoinRankedSessionsAsync(const TArray<int32>& RankedIndices, FName SessionName = NAME_GameSession);
+	TFuture<bool> DestroySessionAsync(FName SessionName = NAME_GameSession);
+	TFuture<bool> StartSessionAsync(FName SessionName = NAME_GameSession);
+
+	/***********
+	Paged search
+	***********/
+
+	// FindSessionsPageAsync fetches at most PageSize sessions matching the filter, starting at Cursor, which is zero for the first page.
+	// Pages are not cached, indexed or broadcast, so only the pages a caller holds stay in memory.
+	// Use FSessionSearchPager to hold a bounded number of pages while scrolling through a long list.
+	// Backends with cursors, such as the session directory, fetch only the page. Other providers repeat the search with a larger limit
+	// and drop the results before the page, so memory stays bounded, but pages can shift between calls.
+	TFuture<FMultiplayerSessionsPage> FindSessionsPageAsync(const FMultiplayerSessionSearchFilter& Filter, int32 PageSize, uint64 Cursor = 0);
+
+	const FMultiplayerSearchStreamStats& GetLastSearchStreamStats() const { return LastSearchStreamStats; }
+
+	// GetSearchIndex returns the index over the most recently delivered search results.
+	// Use it to filter results by index instead of copying and comparing each result.
+	const FSessionSearchIndex& GetSearchIndex() const { return SearchIndex; }
+
+	// GetBestSessions ranks the most recent search results and writes the indices of the best Count joinable sessions.
+	// Indices refer to GetSearchIndex(). When Candidates is set, only those indices are ranked.
+	// The default weights are read from UMultiplayerSessionsSettings.
+	void GetBestSessions(int32 Count, TArray<int32>& OutIndices, const TArray<int32>* Candidates = nullptr);
+	void GetBestSessions(
+		int32 Count,
+		const FMultiplayerSessionScoringWeights& Weights,
+		TArray<int32>& OutIndices,
+		const TArray<int32>* Candidates = nullptr
+	);
+
+	// Time taken by the most recent GetBestSessions call, in seconds.
+	double GetLastRankSeconds() const { return LastRankSeconds; }
+
+	const FMultiplayerJoinPipelineStats& GetLastJoinPipelineStats(FName SessionName = NAME_GameSession) const;
+
+	// GetHostedPublicConnections returns the number of public connections of a session this player hosts, or zero when it hosts none.
+	int32 GetHostedPublicConnections(FName SessionName = NAME_GameSession) const;
+
+	const FMultiplayerRehostStats& GetRehostStats() const { return RehostStats; }
+
+	/**************************
+	Advertised settings updates
+	**************************/
+
+	// UpdateSessionSetting changes a setting advertised by the named session, e.g. its player count, map or round state.
+	// Changes are not sent one at a time. Changed settings are collected for SettingsUpdateWindowSeconds, then compared to the
+	// advertised settings, and only settings which differ are sent, in one update no sooner than SettingsUpdateIntervalSeconds
+	// after the previous one. The setting is also advertised by sessions created under the name later, until the session is destroyed.
+	void UpdateSessionSetting(
+		FName Key,
+		const FVariantData& Value,
+		FName SessionName = NAME_GameSession,
+		EOnlineDataAdvertisementType::Type AdvertisementType = EOnlineDataAdvertisementType::ViaOnlineServiceAndPing
+	);
+
+	// FlushSessionSettings sends the named session's changed settings now, without waiting for the window or interval.
+	void FlushSessionSettings(FName SessionName = NAME_GameSession);
+
+	const FMultiplayerSettingsUpdateStats& GetSettingsUpdateStats() const { return SettingsUpdateStats; }
+
+	/*********
+	Quick play
+	*********/
+
+	// StartQuickPlay keeps a pool of the best sessions matching Filter warm, by searching in the background, so QuickPlay can join
+	// without waiting for a search. Background searches only run while no other search is queued or in flight, and are not broadcast.
+	// Deduplication and ranking run on a worker thread. Refreshes are frequent while the pool is short of candidates,
+	// and back off while it is healthy (see FMultiplayerQuickPlaySettings).
+	void StartQuickPlay(const FMultiplayerSessionSearchFilter& Filter);
+	void StopQuickPlay();
+	bool IsQuickPlayActive() const { return QuickPlayPool.IsActive(); }
+
+	// QuickPlay joins the pooled sessions in rank order through the join pipeline, like JoinRankedSessions.
+	// When the pool is empty, the join waits for a refresh, and fails if the refresh finds no sessions.
+	// Quick play stops once a join succeeds. Requests made while a quick play join is pending share its result.
+	void QuickPlay(FName SessionName = NAME_GameSession);
+	TFuture<EOnJoinSessionCompleteResult::Type> QuickPlayAsync(FName SessionName = NAME_GameSession);
+
+	const FQuickPlayStats& GetQuickPlayStats() const { return QuickPlayPool.GetStats(); }
+	int32 GetNumQuickPlayCandidates() const { return QuickPlayPool.NumCandidates(); }
+
+	/****************
+	Lobby map preload
+	****************/
+
+	// PreloadMap starts loading the map in MapURL, which the host will travel to once its session is created.
+	// Call it before CreateSession so the load overlaps session creation. The map is released if creation fails.
+	// The map is also advertised by sessions created afterwards, so joining clients can prefetch it while they join.
+	// When preloading is disabled in the settings, the time to the map is still recorded for comparison.
+	void PreloadMap(const FString& MapURL);
+	void ReleasePreloadedMap() { MapPreloader.Release(); }
+
+	const FMapPreloadStats& GetMapPreloadStats() const { return MapPreloader.GetStats(); }
+
+	/**************
+	Session backend
+	**************/
+
+	// SetBackend replaces the backend which sessions are created, found and joined through, e.g. with an FMockSessionBackend.
+	// Pending operations are cancelled first, since their completions would arrive from the old backend.
+	void SetBackend(TSharedPtr<IMultiplayerSessionBackend> InBackend);
+	TSharedPtr<IMultiplayerSessionBackend> GetBackend() const { return SessionInterface; }
+
+	// GetResolvedConnectString writes the address of the joined session, for client travel.
+	bool GetResolvedConnectString(FString& OutAddress, FName SessionName = NAME_GameSession) const;
+
+	/**********************
+	Session operation queue
+	**********************/
+
+	// CancelPendingOperations fails every queued operation of every session, and cancels the in-flight search if there is one.
+	// Other in-flight operations cannot be cancelled by the backend, so they are left to complete.
+	void CancelPendingOperations();
+
+	// GetOperationQueueStats sums the stats of the search queue and every session's queue.
+	FSessionOperationQueueStats GetOperationQueueStats() const;
+
+	/****************
+	Operation metrics
+	****************/
+
+	// Latency histograms and result counts for each operation. Also available through the MultiplayerSessions.Metrics console command.
+	const FSessionMetrics& GetMetrics() const { return Metrics; }
+	void ResetMetrics() { Metrics.Reset(); }
+
+	// ExportMetrics writes the metrics to Saved/MultiplayerSessions as CSV or JSON, and returns the file's path, or an empty string on failure.
+	FString ExportMetrics(bool bAsJson) const;
+
+	// LogMetrics writes one line per operation to the log.
+	void LogMetrics() const;
+
+	/*******************
+	Session search cache
+	*******************/
+
+	const FSessionSearchCacheStats& GetSearchCacheStats() const { return SearchCache.Stats; }
+	void InvalidateSearchCache();
+
+	// GetSearchFilterStats reports how many results were rejected locally, and would be avoided by server-side filtering.
+	const FMultiplayerSearchFilterStats& GetSearchFilterStats() const { return SearchFilterStats; }
+
+	/************************
+	Bindable custom delegates
+	************************/
+
+	FMultiplayerOnCreateSessionComplete MultiplayerOnCreateSessionComplete;
+	FMultiplayerOnFindSessionsComplete MultiplayerOnFindSessionsComplete;
+	FMultiplayerOnJoinSessionComplete MultiplayerOnJoinSessionComplete;
+	FMultiplayerOnDestroySessionComplete MultiplayerOnDestroySessionComplete;
+	FMultiplayerOnStartSessionComplete MultiplayerOnStartSessionComplete;
+	FMultiplayerOnFindSessionsBatch MultiplayerOnFindSessionsBatch;
+	FMultiplayerOnFindSessionsMatch MultiplayerOnFindSessionsMatch;
+
+	// Reports create, join, destroy and start results for every named session.
+	// The create, join, destroy and start delegates above only report results for the game session.
+	FMultiplayerOnSessionOperationComplete MultiplayerOnSessionOperationComplete;
+
+protected:
+	/*****************
+	Delegate callbacks
+	*****************/
+
+	void OnCreateSessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnFindSessionsComplete(bool bWasSuccessful);
+	void OnFindSessionsPageComplete(bool bWasSuccessful, uint64 NextCursor);
+	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
+	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnStartSessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnUpdateSessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnRehostDestroyComplete(FName SessionName, bool bWasSuccessful);
+	void OnSettingsUpdateComplete(FName SessionName, bool bWasSuccessful);
+
+	// The backend's search and join delegates are bound to these, which drop completions of calls that timed out.
+	void OnBackendFindSessionsComplete(bool bWasSuccessful);
+	void OnBackendFindSessionsPageComplete(bool bWasSuccessful, uint64 NextCursor);
+	void OnBackendJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
+
+private:
+	// How the in-flight creation reaches the requested settings.
+	enum class ECreateMode : uint8
+	{
+		Create,
+		Update,
+		Recreate
+	};
+
+	/*
+	 * FNamedSession holds the operations and settings of one named session.
+	 * It is allocated the first time the name is used and reused afterwards, so operations allocate no session state.
+	 */
+	struct FNamedSession
+	{
+		explicit FNamedSession(FName InName): Name(InName), OperationQueue(InName.ToString()) {}
+
+		FName Name;
+
+		// Serializes this session's operations, so its backend calls never overlap or race.
+		FSessionOperationQueue OperationQueue;
+
+		// Promises made by the async API, fulfilled when their operations complete.
+		TSessionOperationPromises<bool> CreatePromises;
+		TSessionOperationPromises<EOnJoinSessionCompleteResult::Type> JoinPromises;
+		TSessionOperationPromises<bool> DestroyPromises;
+		TSessionOperationPromises<bool> StartPromises;
+
+		// Candidates for the queued join. Newer requests replace these until the join starts.
+		TSharedPtr<FOnlineSessionSearch> QueuedJoinSearch;
+		TArray<int32> QueuedJoinIndices;
+
+		// Set while a join pipeline is in progress. Holds the search which the candidate indices refer to.
+		TSharedPtr<FOnlineSessionSearch> JoinCandidatesSearch;
+		TArray<int32> JoinCandidateIndices;
+		int32 JoinCandidatePosition{ 0 };
+		double JoinPipelineStartTime{ 0.0 };
+		double JoinAttemptStartTime{ 0.0 };
+		FMultiplayerJoinPipelineStats LastJoinPipelineStats;
+
+		// The Insights region of the in-flight join attempt, named by session and attempt so concurrent joins do not overlap.
+		FString JoinAttemptRegionName;
+		uint32 NumJoinAttempts{ 0 };
+
+		// The serial of the last join sent to the backend, and the serials of the joins it has not completed yet, oldest first.
+		// More than one is outstanding only after an attempt timed out, and a completion for any but the last is dropped.
+		uint32 JoinCallSerial{ 0 };
+		TArray<uint32, TInlineAllocator<2>> OutstandingJoinSerials;
+
+		// The most recently requested parameters, and the settings the session was created or updated with.
+		TSharedPtr<FOnlineSessionSettings> LastSessionSettings;
+		int32 LastNumPublicConnections{ 0 };
+		FString LastMatchType;
+
+		ECreateMode CreateMode{ ECreateMode::Create };
+
+		// Set to 'true' while this player hosts the session, which is required to update it.
+		bool bHostingSession{ false };
+
+		// When the in-flight creation was sent, and when the previous session was destroyed, or negative if it was not.
+		double CreateStartTime{ 0.0 };
+		double RehostDowntimeStartTime{ -1.0 };
+
+		// Settings set by UpdateSessionSetting, which every creation and update of the session advertises.
+		TMap<FName, FOnlineSessionSetting> CustomSettings;
+
+		// Custom settings changed since the last update was sent, and when the oldest of them changed, or negative when none have.
+		TSet<FName> DirtySettings;
+		double FirstDirtyTime{ -1.0 };
+
+		// When the last update was sent, or negative before the first.
+		double LastSettingsUpdateTime{ -1.0 };
+
+		// The settings sent by the in-flight update, which become LastSessionSettings when it succeeds, and the keys it changed.
+		TSharedPtr<FOnlineSessionSettings> PendingSettings;
+		TArray<FName> PendingSettingsKeys;
+		double SettingsUpdateStartTime{ 0.0 };
+	};
+
+	/*
+	 * FSearchPageRequest is a page requested by FindSessionsPageAsync, which is sent when its turn in the search queue comes.
+	 */
+	struct FSearchPageRequest
+	{
+		// MaxSearchResults holds the page size.
+		FSessionSearchCacheKey SearchKey;
+		uint64 Cursor{ 0 };
+		TPromise<FMultiplayerSessionsPage> Promise;
+
+		// Set to 'true' when the backend resumes from the cursor, rather than the search repeating from the first result.
+		bool bUsesCursor{ false };
+	};
+
+	FNamedSession& FindOrAddSession(FName SessionName);
+	FNamedSession* FindSession(FName SessionName) const;
+	TArray<const FSessionOperationQueue*> GetOperationQueues() const;
+	void BindBackendDelegates();
+	void UnbindBackendDelegates();
+	void BroadcastSessionResult(const FNamedSession& Session, EMultiplayerSessionOperation Operation, bool bWasSuccessful);
+
+	void RequestCreateSession(FNamedSession& Session, int32 NumPublicConnections, const FString& MatchType, TFuture<bool>* OutFuture);
+	void RequestFindSessions(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter, TFuture<FMultiplayerFindSessionsResult>* OutFuture);
+	void RequestJoinSessions(
+		FNamedSession& Session,
+		const TSharedPtr<FOnlineSessionSearch>& Search,
+		const TArray<int32>& Indices,
+		TFuture<EOnJoinSessionCompleteResult::Type>* OutFuture
+	);
+	void RequestDestroySession(FNamedSession& Session, TFuture<bool>* OutFuture);
+	void RequestStartSession(FNamedSession& Session, TFuture<bool>* OutFuture);
+	void RequestQuickPlay(FName SessionName, TFuture<EOnJoinSessionCompleteResult::Type>* OutFuture);
+	void FailAllPromises();
+	void SendCreateSession(FNamedSession& Session);
+	void SendCreateNewSession(FNamedSession& Session);
+	void SendUpdateSession(FNamedSession& Session);
+	void SendRehostDestroy(FNamedSession& Session);
+	TSharedRef<FOnlineSessionSettings> MakeSessionSettings(const FNamedSession& Session) const;
+	void SendFindSessions();
+	void SendFindSessionsPage();
+	TSharedRef<FOnlineSessionSearch> MakeSessionSearch(const FSessionSearchCacheKey& SearchKey, int32 MaxSearchResults);
+	void SendJoinCandidates(FNamedSession& Session);
+	void SendDestroySession(FNamedSession& Session);
+	void SendStartSession(FNamedSession& Session);
+	void MarkSettingChanged(FNamedSession& Session, FName Key, double Now);
+	void QueueSettingsUpdate(FNamedSession& Session);
+	void SendSettingsUpdate(FNamedSession& Session);
+	bool TickSettingsUpdates(float DeltaTime);
+	bool IsSettingsUpdateDue(const FNamedSession& Session, double Now) const;
+	bool TickQuickPlay(float DeltaTime);
+	void StartQuickPlayJoin(bool bFromWarmPool);
+	void OnQuickPlayJoinComplete(EOnJoinSessionCompleteResult::Type Result);
+	bool TickOperationQueue(float DeltaTime);
+	void OnOperationTimedOut(EMultiplayerSessionOperation Operation, FName SessionName);
+	void OnOperationCancelled(EMultiplayerSessionOperation Operation, FNamedSession* Session);
+	void RecordOperationResult(const FSessionOperationQueue& Queue, EMultiplayerSessionOperation Operation, bool bSucceeded, const TCHAR* Result);
+	void StartSessionSearch(
+		const FSessionSearchCacheKey& SearchKey,
+		bool bIsBackgroundRefresh,
+		TFuture<FMultiplayerFindSessionsResult>* OutFuture = nullptr
+	);
+	FSessionSearchCacheKey MakeSearchKey(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter) const;
+	void SendJoinSession(FNamedSession& Session, const FOnlineSessionSearchResult& SessionResult);
+	void SendNextJoinCandidate(FNamedSession& Session);
+	bool LookupCachedSearch(const FSessionSearchCacheKey& SearchKey, TSharedPtr<FOnlineSessionSearch>& OutSearch);
+	void FilterPendingResults();
+	void SetLastSessionSearch(const TSharedRef<FOnlineSessionSearch>& Search);
+	bool TickSearchStream(float DeltaTime);
+	bool EmitSearchStreamBatches(const TArray<FOnlineSessionSearchResult>& Results, bool bIsComplete);
+	void FinishSearchStream(bool bExitedEarly);
+	FUniqueNetIdPtr GetLocalPlayerId() const;
+
+	TSharedPtr<IMultiplayerSessionBackend> SessionInterface;
+
+	/******************************************************************************
+	Serialize each session's operations, and searches, so backend calls never race.
+	******************************************************************************/
+
+	// Named sessions, by name. Entries are never removed, so operations can hold references to them.
+	TMap<FName, TUniquePtr<FNamedSession>> NamedSessions;
+
+	// Searches are not tied to a session, and providers run one search at a time, so searches have their own queue.
+	FSessionOperationQueue SearchQueue{ TEXT("Search") };
+	FTSTicker::FDelegateHandle OperationTickerHandle;
+
+	// Parameters for the queued search. Newer requests replace these until the search starts.
+	FSessionSearchCacheKey QueuedSearchKey;
+	bool bQueuedSearchIsBackgroundRefresh{ false };
+	TSessionOperationPromises<FMultiplayerFindSessionsResult> FindPromises;
+
+	// Records the latency and result of every operation.
+	FSessionMetrics Metrics;
+
+	// Set while OnOperationTimedOut completes an operation, so its result is recorded as a timeout.
+	bool bOperationIsTimingOut{ false };
+
+	/********************************************
+	Save the most recent search, and its ranking.
+	********************************************/
+
+	TSharedPtr<FOnlineSessionSearch> LastSessionSearch;
+	FSessionSearchIndex SearchIndex;
+	double LastRankSeconds{ 0.0 };
+
+	// Re-hosts of every session, which update the live session or destroy and recreate it.
+	FMultiplayerRehostStats RehostStats;
+
+	// Changes to advertised settings, and the updates they were coalesced into.
+	FMultiplayerSettingsUpdateStats SettingsUpdateStats;
+
+	// Runs while any session has changed settings which have not been sent.
+	FTSTicker::FDelegateHandle SettingsUpdateTickerHandle;
+
+	// Held by the subsystem rather than the menu, since the menu is destroyed by travel.
+	FMapPreloader MapPreloader;
+
+	// The map the game session advertises, or empty to advertise none.
+	FString AdvertisedMapName;
+
+	/**********************************************************
+	Cache search results to avoid repeating identical searches.
+	**********************************************************/
+
+	FSessionSearchCache SearchCache;
+	TSharedPtr<FOnlineSessionSearch> PendingSessionSearch;
+	FSessionSearchCacheKey PendingSearchKey;
+
+	// Applies the in-flight search's filter locally. Results before PendingSearchNumFiltered have already been checked.
+	TUniquePtr<FSessionSearchFilterMatcher> PendingSearchMatcher;
+	int32 PendingSearchNumFiltered{ 0 };
+	FMultiplayerSearchFilterStats SearchFilterStats;
+
+	// Set to 'true' while a search is in flight.
+	bool bSearchInProgress{ false };
+
+	// Set to 'true' when the in-flight search only refreshes the cache, and its results should not be broadcast.
+	bool bSearchIsBackgroundRefresh{ false };
+
+	/****************************************************************
+	Keep quick play's candidates warm, and serve quick play requests.
+	****************************************************************/
+
+	FQuickPlayPool QuickPlayPool;
+	FSessionSearchCacheKey QuickPlaySearchKey;
+	FTSTicker::FDelegateHandle QuickPlayTickerHandle;
+
+	// The pending quick play request, which waits for candidates while QuickPlayRequestTime is not negative.
+	FName QuickPlaySessionName{ NAME_GameSession };
+	double QuickPlayRequestTime{ -1.0 };
+	bool bQuickPlayJoining{ false };
+	TArray<TPromise<EOnJoinSessionCompleteResult::Type>> QuickPlayPromises;
+
+	/*********************************************************
+	Track paged searches, which share the queue with searches.
+	*********************************************************/
+
+	// One request for each queued FindPage operation, in queue order.
+	TArray<FSearchPageRequest> QueuedSearchPages;
+	TOptional<FSearchPageRequest> InFlightSearchPage;
+	TSharedPtr<FOnlineSessionSearch> PendingPageSearch;
+
+	/**********************************************************
+	Track streaming searches, which deliver results in batches.
+	**********************************************************/
+
+	// Set to 'true' while a streaming search is delivering batches.
+	bool bSearchIsStreaming{ false };
+	FSessionSearchCacheKey SearchStreamKey;
+	int32 SearchStreamBatchSize{ 0 };
+	int32 SearchStreamNumEmitted{ 0 };
+	double SearchStreamStartTime{ 0.0 };
+	FMultiplayerSessionSearchPredicate SearchStreamStopPredicate;
+	FMultiplayerSearchStreamStats LastSearchStreamStats;
+	FTSTicker::FDelegateHandle SearchStreamTickerHandle;
+
+	/************************************************************************************************
+	Save delegates and their handles. They stay bound to the backend, and are routed by session name.
+	************************************************************************************************/
+
+	FOnCreateSessionCompleteDelegate CreateSessionCompleteDelegate;
+	FDelegateHandle CreateSessionCompleteDelegateHandle;
+	FOnFindSessionsCompleteDelegate FindSessionsCompleteDelegate;
+	FDelegateHandle FindSessionsCompleteDelegateHandle;
+	FOnFindSessionsPageCompleteDelegate FindSessionsPageCompleteDelegate;
+	FDelegateHandle FindSessionsPageCompleteDelegateHandle;
+	FOnJoinSessionCompleteDelegate JoinSessionCompleteDelegate;
+	FDelegateHandle JoinSessionCompleteDelegateHandle;
+	FOnDestroySessionCompleteDelegate DestroySessionCompleteDelegate;
+	FDelegateHandle DestroySessionCompleteDelegateHandle;
+	FOnStartSessionCompleteDelegate StartSessionCompleteDelegate;
+	FDelegateHandle StartSessionCompleteDelegateHandle;
+	FOnUpdateSessionCompleteDelegate UpdateSessionCompleteDelegate;
+	FDelegateHandle UpdateSessionCompleteDelegateHandle;
+};
@@ -0,0 +1,39 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "Trace/Trace.h"
+
+class UWorld;
+
+// Enable with -trace=cpu,region,bookmark,MultiplayerSessions, or "Trace.Enable MultiplayerSessions" at runtime.
+UE_TRACE_CHANNEL_EXTERN(MultiplayerSessionsChannel, MULTIPLAYERSESSIONS_API);
+
+// MULTIPLAYER_TRACE_SCOPE records a CPU timing event on the MultiplayerSessions channel for the rest of the enclosing scope.
+#define MULTIPLAYER_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(Name, MultiplayerSessionsChannel)
+
+/*
+ * FMultiplayerSessionsTrace marks spans which outlive a single function, such as travel and map loads, as Insights timing regions.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionsTrace
+{
+public:
+	// BeginTravel opens the travel region, which is closed once the destination map has loaded.
+	static void BeginTravel();
+
+	// Startup closes the travel region when a map finishes loading. Shutdown removes the hook.
+	static void Startup();
+	static void Shutdown();
+
+	// IsTraveling returns 'true' while the travel region is open.
+	static bool IsTraveling() { return bIsTraveling; }
+
+private:
+	static void EndTravel(UWorld* LoadedWorld);
+
+	static bool bIsTraveling;
+	static FDelegateHandle PostLoadMapHandle;
+};
@@ -0,0 +1,164 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+
+#include "SessionMetrics.h"
+#include "SessionScorer.h"
+
+#include "QuickPlayPool.generated.h"
+
+class FOnlineSessionSearch;
+
+/*
+ * FMultiplayerQuickPlaySettings configures how quick play keeps its pool of candidate sessions warm.
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerQuickPlaySettings
+{
+	GENERATED_BODY()
+
+	// Sessions requested by each background search.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Quick Play", meta=(ClampMin="1"))
+	int32 MaxSearchResults{ 100 };
+
+	// Best ranked sessions kept in the pool. A quick play join tries them in order.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Quick Play", meta=(ClampMin="1"))
+	int32 MaxCandidates{ 5 };
+
+	// Pools with at least this many candidates are healthy, and are refreshed less and less often.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Quick Play", meta=(ClampMin="1"))
+	int32 HealthyPoolSize{ 3 };
+
+	// Time between refreshes while the pool is not healthy, and the longest time reached by backing off while it is.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Quick Play", meta=(ClampMin="0.5", Units="s"))
+	float MinRefreshIntervalSeconds{ 3.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Quick Play", meta=(ClampMin="0.5", Units="s"))
+	float MaxRefreshIntervalSeconds{ 60.f };
+
+	// Factor the time between refreshes grows by after each healthy refresh.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Quick Play", meta=(ClampMin="1.0"))
+	float BackoffMultiplier{ 2.f };
+};
+
+/*
+ * FQuickPlayStats counts a quick play pool's refreshes, and how quick play joins were served.
+ */
+struct MULTIPLAYERSESSIONS_API FQuickPlayStats
+{
+	// Background searches started, and those which failed or found no sessions.
+	int32 Refreshes{ 0 };
+	int32 EmptyRefreshes{ 0 };
+
+	// Results post-processed on worker threads, and copies of a session which appeared more than once in a search.
+	int64 ResultsProcessed{ 0 };
+	int64 DuplicatesDropped{ 0 };
+
+	// Quick play joins, of which some started from the warm pool without waiting for a search.
+	int32 Joins{ 0 };
+	int32 JoinsFromWarmPool{ 0 };
+
+	// Worker thread time per refresh, and game thread time to apply its result.
+	FLatencyHistogram ProcessTime;
+	FLatencyHistogram ApplyTime;
+
+	// Time from a quick play request until its join started, which is near zero when the pool was warm.
+	FLatencyHistogram TimeToJoin;
+};
+
+/*
+ * FQuickPlayPool keeps a pool of the best ranked sessions warm, so quick play can start joining without a search round trip.
+ * The owner starts a background search whenever IsRefreshDue() returns 'true', and passes its results to ProcessResults.
+ * Results are deduplicated by session ID and ranked on a worker thread, and Tick swaps the new candidates in on the game thread.
+ * Refreshes run every MinRefreshIntervalSeconds while the pool has fewer than HealthyPoolSize candidates,
+ * and back off exponentially up to MaxRefreshIntervalSeconds while it stays healthy.
+ * Times are passed in by the caller, so the schedule can be driven by a simulated clock.
+ */
+class MULTIPLAYERSESSIONS_API FQuickPlayPool
+{
+public:
+	// Start begins refreshing, with the first refresh due immediately. Candidates and refreshes from an earlier start are dropped.
+	void Start(const FMultiplayerQuickPlaySettings& InSettings, const FMultiplayerSessionScoringWeights& InWeights, double Now);
+
+	// Stop ends refreshing and drops the candidates. A refresh which is still running is discarded when it completes.
+	void Stop();
+
+	bool IsActive() const { return bActive; }
+
+	// IsRefreshDue returns 'true' when the next refresh should start. Refreshes never overlap.
+	bool IsRefreshDue(double Now) const;
+
+	// RefreshNow makes the next refresh due immediately, e.g. after a join used up the candidates.
+	void RefreshNow(double Now);
+
+	// BeginRefresh marks a refresh as started, and returns its ID, which is passed to ProcessResults.
+	uint32 BeginRefresh();
+
+	// ProcessResults starts post-processing a refresh's search on a worker thread.
+	// Results of a stale refresh are ignored, and a failed or empty search empties the pool without a worker.
+	void ProcessResults(uint32 RefreshId, const TSharedPtr<FOnlineSessionSearch>& Search, bool bWasSuccessful, double Now);
+
+	// Tick applies completed post-processing, and schedules the next refresh.
+	// Returns 'true' when a refresh finished since the previous Tick, whether or not it found candidates.
+	bool Tick(double Now);
+
+	// TakeCandidates moves the candidates out of the pool, as a search which holds only them, and their indices in rank order.
+	// Returns 'false' when the pool is empty.
+	bool TakeCandidates(TSharedPtr<FOnlineSessionSearch>& OutSearch, TArray<int32>& OutIndices);
+
+	// NoteJoin records a quick play join, and how long it waited for candidates.
+	void NoteJoin(double WaitSeconds, bool bFromWarmPool);
+
+	int32 NumCandidates() const;
+	bool IsRefreshing() const { return bRefreshing; }
+	double GetRefreshInterval() const { return RefreshInterval; }
+	double GetNextRefreshTime() const { return NextRefreshTime; }
+	const FMultiplayerQuickPlaySettings& GetSettings() const { return Settings; }
+	const FQuickPlayStats& GetStats() const { return Stats; }
+
+private:
+	/*
+	 * FProcessedResults is the output of post-processing a search on a worker thread.
+	 */
+	struct FProcessedResults
+	{
+		// The best ranked sessions, in rank order.
+		TSharedPtr<FOnlineSessionSearch> Candidates;
+
+		uint32 RefreshId{ 0 };
+		int32 NumResults{ 0 };
+		int32 NumDuplicates{ 0 };
+		double Seconds{ 0.0 };
+	};
+
+	static FProcessedResults Process(
+		const TSharedRef<FOnlineSessionSearch>& Search,
+		const FMultiplayerSessionScoringWeights& Weights,
+		int32 MaxCandidates
+	);
+
+	void FinishRefresh(double Now);
+
+	FMultiplayerQuickPlaySettings Settings;
+	FMultiplayerSessionScoringWeights Weights;
+	bool bActive{ false };
+
+	// Set from BeginRefresh until the refresh's results have been applied.
+	bool bRefreshing{ false };
+	bool bRefreshFinished{ false };
+	uint32 RefreshId{ 0 };
+
+	double RefreshInterval{ 0.0 };
+	double NextRefreshTime{ 0.0 };
+
+	// Ranked candidates, or nullptr when the pool is empty.
+	TSharedPtr<FOnlineSessionSearch> Candidates;
+
+	// At most one search is processed at a time, since refreshes never overlap.
+	TFuture<FProcessedResults> Processing;
+
+	FQuickPlayStats Stats;
+};
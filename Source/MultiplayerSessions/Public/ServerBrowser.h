@@ -0,0 +1,186 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/IUserObjectListEntry.h"
+#include "Blueprint/UserWidget.h"
+
+#include "DebugMenu.h"
+#include "ServerBrowserModel.h"
+
+#include "ServerBrowser.generated.h"
+
+class UServerBrowser;
+
+/*
+ * UServerBrowserItem is the list item for one row of a server browser.
+ * Items only hold a row index, and read the row's fields from the browser, so there is one small object per row.
+ * They are kept by the browser and reused by later searches.
+ */
+UCLASS(BlueprintType)
+class MULTIPLAYERSESSIONS_API UServerBrowserItem : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintPure, Category="Server Browser")
+	FString GetOwnerName() const;
+
+	UFUNCTION(BlueprintPure, Category="Server Browser")
+	FString GetMapName() const;
+
+	UFUNCTION(BlueprintPure, Category="Server Browser")
+	int32 GetPingMs() const;
+
+	UFUNCTION(BlueprintPure, Category="Server Browser")
+	int32 GetNumPlayers() const;
+
+	UFUNCTION(BlueprintPure, Category="Server Browser")
+	int32 GetMaxPlayers() const;
+
+	// Join joins the row's session. Returns 'false' when the search has not finished, or the session is no longer in its results.
+	UFUNCTION(BlueprintCallable, Category="Server Browser")
+	bool Join();
+
+	// GetRow returns nullptr once the browser has been destroyed or reset.
+	const FServerBrowserRow* GetRow() const;
+
+	TWeakObjectPtr<UServerBrowser> Browser;
+	int32 RowIndex{ INDEX_NONE };
+};
+
+/*
+ * UServerBrowserEntry displays one row of a server browser. Set a Blueprint subclass as the list view's entry widget class.
+ * The list view only creates entries for the rows on screen, and recycles them while scrolling,
+ * so the number of widgets does not grow with the number of sessions. Each text block and the Join button are optional.
+ */
+UCLASS(Abstract)
+class MULTIPLAYERSESSIONS_API UServerBrowserEntry : public UUserWidget, public IUserObjectListEntry
+{
+	GENERATED_BODY()
+
+protected:
+	virtual bool Initialize() override;
+	virtual void NativeOnListItemObjectSet(UObject* ListItemObject) override;
+
+private:
+	UFUNCTION()
+	void JoinButtonClicked();
+
+	UPROPERTY()
+	UServerBrowserItem* Item;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* NameText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UTextBlock* MapText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UTextBlock* PlayersText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UTextBlock* PingText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UButton* JoinButton;
+};
+
+/*
+ * UServerBrowser extends the debug menu with a list of every session found, instead of joining the first match.
+ * Clicking Join searches with streamed results, which are inserted into the list in sorted order as they arrive.
+ * The list is virtualized, sorting and filtering run on a worker thread over compact rows (see FServerBrowserModel),
+ * and the list view is updated at most once per frame, so thousands of sessions do not stall the game thread.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UServerBrowser : public UDebugMenu
+{
+	GENERATED_BODY()
+
+public:
+	// RefreshSessions clears the list and starts a new streamed search for the menu's match type.
+	UFUNCTION(BlueprintCallable, Category="Server Browser")
+	void RefreshSessions();
+
+	UFUNCTION(BlueprintCallable, Category="Server Browser")
+	void SetSort(EServerBrowserSortKey SortKey, bool bAscending);
+
+	UFUNCTION(BlueprintCallable, Category="Server Browser")
+	void SetFilter(const FServerBrowserFilter& Filter);
+
+	// JoinRow joins the session of a row. Rows can be joined once the search has finished, since joins use its results.
+	bool JoinRow(int32 RowIndex);
+
+	const FServerBrowserModel& GetModel() const { return Model; }
+
+protected:
+	virtual bool Initialize() override;
+	virtual void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
+
+	virtual void JoinButtonClicked() override;
+	virtual void OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful) override;
+	virtual void OnFindSessionsBatch(TArrayView<const FOnlineSessionSearchResult> SessionResults, bool bIsFinalBatch) override;
+	virtual void OnFindSessionsMatch(const FOnlineSessionSearchResult& SessionResult) override;
+
+private:
+	void RefreshList();
+	void ToggleSort(EServerBrowserSortKey SortKey);
+
+	UFUNCTION()
+	void FilterTextChanged(const FText& Text);
+
+	UFUNCTION()
+	void SortByNameClicked();
+
+	UFUNCTION()
+	void SortByMapClicked();
+
+	UFUNCTION()
+	void SortByPlayersClicked();
+
+	UFUNCTION()
+	void SortByPingClicked();
+
+	/******
+	Widgets
+	******/
+
+	UPROPERTY(meta = (BindWidget))
+	class UListView* SessionList;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UEditableTextBox* FilterTextBox;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* StatusText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UButton* SortByNameButton;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UButton* SortByMapButton;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UButton* SortByPlayersButton;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UButton* SortByPingButton;
+
+	/***********
+	Browser rows
+	***********/
+
+	FServerBrowserModel Model;
+
+	// One item per row, indexed by row, which is reused by later searches.
+	UPROPERTY()
+	TArray<UServerBrowserItem*> Items;
+
+	// The items of the visible rows in display order, passed to the list view. Kept alive by Items.
+	TArray<UServerBrowserItem*> VisibleItems;
+
+	// Results received from the current search, and whether it has finished.
+	int32 NumResultsReceived{ 0 };
+	bool bSearchComplete{ false };
+};
@@ -0,0 +1,178 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+
+#include "SessionMetrics.h"
+
+#include "ServerBrowserModel.generated.h"
+
+class FOnlineSessionSearchResult;
+
+/*
+ * EServerBrowserSortKey selects the column the server browser is sorted by.
+ */
+UENUM(BlueprintType)
+enum class EServerBrowserSortKey : uint8
+{
+	Ping,
+	Players,
+	Name,
+	Map
+};
+
+/*
+ * FServerBrowserFilter selects the rows shown by the server browser. Empty fields show every row.
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FServerBrowserFilter
+{
+	GENERATED_BODY()
+
+	// Case-insensitive text matched against the host and map names.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Server Browser")
+	FString Text;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Server Browser")
+	bool bHideFullSessions{ false };
+
+	// Sessions with a higher ping are hidden. Zero shows every session.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Server Browser", meta=(ClampMin="0", Units="ms"))
+	int32 MaxPingMs{ 0 };
+};
+
+/*
+ * FServerBrowserRow is the compact copy of a search result which the browser displays, sorts and filters.
+ * The full result stays in the subsystem's search, and is found again through ResultIndex when the row is joined.
+ */
+struct MULTIPLAYERSESSIONS_API FServerBrowserRow
+{
+	FString SessionId;
+	FString OwnerName;
+
+	// The advertised map's short name, e.g. "Lobby".
+	FString MapName;
+
+	// Position of the result in the search, which indexes the subsystem's GetSearchIndex() once the search completes.
+	int32 ResultIndex{ INDEX_NONE };
+
+	int32 PingMs{ 0 };
+	int32 NumPlayers{ 0 };
+	int32 MaxPlayers{ 0 };
+};
+
+/*
+ * FServerBrowserModelStats measures the browser's game thread work, and how long sorts took to reach the screen.
+ */
+struct MULTIPLAYERSESSIONS_API FServerBrowserModelStats
+{
+	// Rows merged into the visible rows as results streamed in, without a full sort.
+	int64 RowsInserted{ 0 };
+
+	// Sorts applied, and sorts discarded because the rows were reset while they ran.
+	int32 SortsApplied{ 0 };
+	int32 SortsDiscarded{ 0 };
+
+	// Game thread time per AddResults call, and per applied sort.
+	FLatencyHistogram InsertTime;
+	FLatencyHistogram ApplyTime;
+
+	// Time from a sort or filter change until its rows were applied, which is mostly spent on a worker thread.
+	FLatencyHistogram SortLatency;
+};
+
+/*
+ * FServerBrowserModel holds the rows of a server browser, and the order they are shown in.
+ * Rows are stored in immutable blocks, one per streamed batch, so sorting and filtering run on a worker thread
+ * over a snapshot of the blocks while new batches keep arriving. Each new batch is sorted and merged into the visible rows
+ * on the game thread, so streamed results appear in place without a full sort.
+ */
+class MULTIPLAYERSESSIONS_API FServerBrowserModel
+{
+public:
+	// Reset removes every row, e.g. before a new search. A sort which is still running is discarded when it completes.
+	void Reset();
+
+	// AddResults copies the displayed fields of streamed results into a new block, and merges the rows which pass the filter
+	// into the visible rows. FirstResultIndex is the position of the first result in the search.
+	void AddResults(TConstArrayView<FOnlineSessionSearchResult> Results, int32 FirstResultIndex);
+
+	// SetSort and SetFilter sort the rows again on a worker thread. The previous order is shown until the new one is ready.
+	void SetSort(EServerBrowserSortKey InSortKey, bool bInAscending);
+	void SetFilter(const FServerBrowserFilter& InFilter);
+
+	// Tick applies a completed sort. Returns 'true' when the visible rows changed since the previous Tick.
+	bool Tick();
+
+	// IsSorting returns 'true' while a sort or filter change has not reached the visible rows.
+	bool IsSorting() const { return Sort.IsValid() || bSortRequested; }
+
+	int32 NumRows() const { return Rows.Num(); }
+	const FServerBrowserRow& GetRow(int32 RowIndex) const { return *Rows[RowIndex]; }
+
+	// GetView returns the row indices of the visible rows, in display order.
+	TConstArrayView<int32> GetView() const { return View; }
+
+	EServerBrowserSortKey GetSortKey() const { return RequestedOrder.SortKey; }
+	bool IsAscending() const { return RequestedOrder.bAscending; }
+	const FServerBrowserFilter& GetFilter() const { return RequestedOrder.Filter; }
+
+	const FServerBrowserModelStats& GetStats() const { return Stats; }
+
+private:
+	typedef TArray<FServerBrowserRow> FRowBlock;
+
+	/*
+	 * FOrder is a sort and filter, which the visible rows follow.
+	 */
+	struct FOrder
+	{
+		EServerBrowserSortKey SortKey{ EServerBrowserSortKey::Ping };
+		bool bAscending{ true };
+		FServerBrowserFilter Filter;
+	};
+
+	/*
+	 * FSortResult is the output of a sort on a worker thread.
+	 */
+	struct FSortResult
+	{
+		TArray<int32> View;
+		FOrder Order;
+
+		// Rows which existed when the sort started. Later rows are merged in when the result is applied.
+		int32 NumRows{ 0 };
+		uint32 ResetCount{ 0 };
+	};
+
+	void StartSort();
+	void MergeRows(int32 FirstRowIndex);
+
+	static bool Matches(const FServerBrowserRow& Row, const FServerBrowserFilter& Filter);
+
+	// IsBefore compares two rows by the order's sort key. Ties are broken by row index, so streamed rows keep their arrival order.
+	static bool IsBefore(const FServerBrowserRow& A, int32 AIndex, const FServerBrowserRow& B, int32 BIndex, const FOrder& Order);
+
+	TArray<TSharedRef<const FRowBlock, ESPMode::ThreadSafe>> Blocks;
+
+	// Points into Blocks, which are never changed once added, so row indices stay valid until Reset.
+	TArray<const FServerBrowserRow*> Rows;
+
+	TArray<int32> View;
+
+	// The order of View, and the order requested by SetSort and SetFilter, which differ while a sort is running.
+	FOrder AppliedOrder;
+	FOrder RequestedOrder;
+
+	// At most one sort runs at a time. Changes made while it runs start another sort when it completes.
+	TFuture<FSortResult> Sort;
+	double SortRequestTime{ 0.0 };
+	bool bSortRequested{ false };
+	uint32 ResetCount{ 0 };
+
+	bool bViewChanged{ false };
+
+	FServerBrowserModelStats Stats;
+};
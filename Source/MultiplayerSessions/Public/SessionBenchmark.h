@@ -0,0 +1,224 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+#include "SessionMetrics.h"
+
+class FDirectorySessionBackend;
+class FMockSessionBackend;
+class IMultiplayerSessionBackend;
+class UMultiplayerSessionsSubsystem;
+struct FMultiplayerSessionSearchFilter;
+
+/*
+ * FSessionBenchmarkConfig describes a benchmark run, and the regression thresholds which fail it.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionBenchmarkConfig
+{
+	// "Mock" for the in-process mock backend, "Directory" for a private session directory, or the name of an Online Subsystem, such as "NULL" for LAN sessions on loopback.
+	// Providers joined with '+', e.g. "NULL+Mock+Mock", are searched together by an FMultiProviderSessionBackend, and run in real time.
+	FName Backend{ "Mock" };
+
+	// Cycles run at each scale point.
+	int32 Cycles{ 20 };
+
+	// Scale points. Every combination of MaxSearchResults, Concurrency and Sessions runs as its own scenario.
+	// Concurrency is the number of requests made at once for each step of a cycle.
+	// Sessions is the number of named sessions which are hosted, joined and destroyed side by side. Searches are shared by all of them.
+	TArray<int32> MaxSearchResults{ 10, 1000, 100000 };
+	TArray<int32> Concurrency{ 1, 8 };
+	TArray<int32> Sessions{ 1 };
+
+	// Thresholds which fail the run when exceeded by any scenario. Zero disables a threshold.
+	double MaxCycleP95Ms{ 0.0 };
+	double MinOperationsPerSecond{ 0.0 };
+	double MaxGameThreadMsPerCycle{ 0.0 };
+
+	// Parse reads Key=Value arguments, e.g. "Backend=NULL Cycles=10 MaxResults=10,1000 Concurrency=1,4 Sessions=1,16 MaxP95Ms=50".
+	static FSessionBenchmarkConfig Parse(const TArray<FString>& Args);
+};
+
+/*
+ * ESessionBenchmarkStep lists the steps of a benchmark cycle, in order.
+ * The host's session is destroyed before joining, since a player cannot be in two game sessions at once.
+ */
+enum class ESessionBenchmarkStep : uint8
+{
+	Create,
+	Start,
+	Find,
+	DestroyHost,
+	Join,
+	Destroy
+};
+
+constexpr int32 NumSessionBenchmarkSteps = 6;
+
+MULTIPLAYERSESSIONS_API const TCHAR* LexToString(ESessionBenchmarkStep Step);
+
+/*
+ * FSessionBenchmarkScenarioResult records one scale point of a benchmark run.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionBenchmarkScenarioResult
+{
+	int32 MaxSearchResults{ 0 };
+	int32 Concurrency{ 0 };
+	int32 NumSessions{ 0 };
+	int32 CyclesCompleted{ 0 };
+
+	// Requests which completed, and how many of them failed.
+	int64 Operations{ 0 };
+	int64 Failures{ 0 };
+
+	// Search results found by the most recent search.
+	int32 ResultsFound{ 0 };
+
+	double WallSeconds{ 0.0 };
+
+	// Time the game thread spent inside the subsystem, from its metrics.
+	double GameThreadSeconds{ 0.0 };
+
+	// Time from the first request of a cycle until its last step completed.
+	FLatencyHistogram CycleLatency;
+
+	// Time from each request until its future was fulfilled.
+	FLatencyHistogram StepLatency[NumSessionBenchmarkSteps];
+
+	// Thresholds this scenario exceeded.
+	TArray<FString> Regressions;
+
+	double GetOperationsPerSecond() const { return WallSeconds > 0.0 ? Operations / WallSeconds : 0.0; }
+	double GetGameThreadMsPerCycle() const { return CyclesCompleted > 0 ? GameThreadSeconds * 1e3 / CyclesCompleted : 0.0; }
+};
+
+/*
+ * FSessionBenchmark runs create, start, find, join and destroy cycles through the subsystem's async API, at several scale points.
+ * The subsystem's backend is replaced for the duration of the run, and restored afterwards.
+ * The mock backend is driven with a manual clock and fast-forwarded every tick, so its runs measure the plugin's own cost
+ * rather than simulated network latency. Online Subsystem backends run in real time.
+ */
+class MULTIPLAYERSESSIONS_API FSessionBenchmark : public TSharedFromThis<FSessionBenchmark>
+{
+public:
+	FSessionBenchmark(UMultiplayerSessionsSubsystem* InSubsystem, const FSessionBenchmarkConfig& InConfig);
+	~FSessionBenchmark();
+
+	// Start runs the first scenario. OnFinished receives 'true' when every scenario completed within the thresholds.
+	void Start(TUniqueFunction<void(bool)> InOnFinished);
+
+	// Stop abandons the run and restores the subsystem's backend. OnFinished is not called.
+	void Stop();
+
+	bool IsRunning() const { return bRunning; }
+	const TArray<FSessionBenchmarkScenarioResult>& GetResults() const { return Results; }
+
+	// ToCsv writes one row per scenario, with latencies in milliseconds.
+	FString ToCsv() const;
+
+private:
+	bool Tick(float DeltaTime);
+	void StartScenario();
+	void FinishScenario();
+	void StartCycle();
+	void FinishCycle();
+	void RunStep(ESessionBenchmarkStep Step);
+	void OnRequestDone(uint32 Serial, double RequestTime, bool bSucceeded);
+	void OnStepDone();
+	void Finish(bool bPassed);
+	void RestoreBackend();
+
+	TWeakObjectPtr<UMultiplayerSessionsSubsystem> Subsystem;
+	FSessionBenchmarkConfig Config;
+	TUniqueFunction<void(bool)> OnFinished;
+	FTSTicker::FDelegateHandle TickerHandle;
+	bool bRunning{ false };
+
+	// The subsystem's backend before the run, and the backend of the current scenario.
+	TSharedPtr<IMultiplayerSessionBackend> OriginalBackend;
+	TSharedPtr<FMockSessionBackend> MockBackend;
+	TSharedPtr<FDirectorySessionBackend> DirectoryBackend;
+
+	TArray<FSessionBenchmarkScenarioResult> Results;
+	int32 ScenarioIndex{ 0 };
+	double ScenarioStartTime{ 0.0 };
+	double ScenarioStartGameThreadSeconds{ 0.0 };
+	double CycleStartTime{ 0.0 };
+	bool bCycleHosted{ false };
+
+	// The game session, followed by one benchmark session for each additional session of the scenario.
+	TArray<FName> SessionNames;
+
+	// The step in progress. Requests from earlier steps, or an abandoned run, carry an older serial and are ignored.
+	ESessionBenchmarkStep CurrentStep{ ESessionBenchmarkStep::Create };
+	uint32 StepSerial{ 0 };
+	int32 OutstandingRequests{ 0 };
+	bool bStepSucceeded{ false };
+};
+
+/*
+ * FSessionScorerBenchmarkResult records the cost of indexing, scoring and ranking one synthetic result set.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionScorerBenchmarkResult
+{
+	int32 NumSessions{ 0 };
+	int32 Count{ 0 };
+
+	// Time to build the search index, to score every result, and to rank the Count best, once per iteration.
+	FLatencyHistogram IndexLatency;
+	FLatencyHistogram ScoreLatency;
+	FLatencyHistogram RankLatency;
+};
+
+/*
+ * FSessionScorerBenchmark times FSessionSearchIndex and FSessionScorer on mock search results, without a subsystem.
+ * Runs are synchronous, so they suit large result sets better than the cycles of FSessionBenchmark.
+ */
+class MULTIPLAYERSESSIONS_API FSessionScorerBenchmark
+{
+public:
+	// Run finds NumSessions mock sessions, then indexes, scores and ranks them Iterations times.
+	static FSessionScorerBenchmarkResult Run(int32 NumSessions, int32 Iterations, int32 Count);
+
+	// ToCsv writes one row per result, with latencies in milliseconds.
+	static FString ToCsv(const TArray<FSessionScorerBenchmarkResult>& Results);
+};
+
+/*
+ * FSearchFilterBenchmarkResult compares the results downloaded for one filter when the provider filters them
+ * with the results downloaded when every session is returned and filtered locally.
+ */
+struct MULTIPLAYERSESSIONS_API FSearchFilterBenchmarkResult
+{
+	int32 NumSessions{ 0 };
+
+	// Results received, and their estimated size, with the filter in the query settings.
+	int32 ServerSideResults{ 0 };
+	int64 ServerSideBytes{ 0 };
+
+	// Results received, and their estimated size, without it.
+	int32 LocalResults{ 0 };
+	int64 LocalBytes{ 0 };
+
+	// Results which pass the filter, and the time taken to find them among the unfiltered results.
+	int32 MatchingResults{ 0 };
+	double LocalFilterSeconds{ 0.0 };
+
+	int64 GetBytesSaved() const { return LocalBytes - ServerSideBytes; }
+};
+
+/*
+ * FSearchFilterBenchmark measures the download saved by pushing a filter into a search's query settings, using mock search results.
+ * The mock applies equality query settings as providers with server-side filtering do.
+ */
+class MULTIPLAYERSESSIONS_API FSearchFilterBenchmark
+{
+public:
+	// Run searches NumSessions mock sessions, once with Filter in the query settings and once without it.
+	static FSearchFilterBenchmarkResult Run(int32 NumSessions, const FMultiplayerSessionSearchFilter& Filter);
+
+	// ToCsv writes one row per result.
+	static FString ToCsv(const TArray<FSearchFilterBenchmarkResult>& Results);
+};
@@ -0,0 +1,154 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+/*
+ * FSessionDirectoryEntry is one session advertised in the directory.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionDirectoryEntry
+{
+	FString SessionId;
+	FString OwnerName;
+
+	// Address clients travel to after joining, e.g. "127.0.0.1:7777".
+	FString HostAddress;
+
+	// Indexed fields, which queries filter on inside the directory.
+	FString MatchType;
+	FString Region;
+	int32 NumPublicConnections{ 0 };
+	int32 NumOpenPublicConnections{ 0 };
+	int32 BuildUniqueId{ 0 };
+
+	// Other advertised settings, such as the map, which are returned with results but not indexed.
+	TMap<FName, FString> Attributes;
+
+	// Assigned when the session is first registered. Pages are ordered by it, so cursors stay valid while sessions come and go.
+	uint64 Sequence{ 0 };
+};
+
+/*
+ * FSessionDirectoryQuery selects one page of sessions. Empty fields match every session.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionDirectoryQuery
+{
+	FString MatchType;
+	FString Region;
+	int32 MinOpenSlots{ 0 };
+	int32 PageSize{ 100 };
+
+	// The previous page's NextCursor, or zero for the first page.
+	uint64 Cursor{ 0 };
+};
+
+/*
+ * FSessionDirectoryPage holds the sessions of one page, in registration order.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionDirectoryPage
+{
+	TArray<FSessionDirectoryEntry> Entries;
+
+	// Passed as the next query's cursor. Zero when there are no more pages.
+	uint64 NextCursor{ 0 };
+};
+
+/*
+ * FSessionDirectoryStats counts the directory's work since it was created.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionDirectoryStats
+{
+	int32 NumSessions{ 0 };
+	int64 Registered{ 0 };
+	int64 Updated{ 0 };
+	int64 Removed{ 0 };
+	int64 Expired{ 0 };
+	int64 Heartbeats{ 0 };
+	int64 Batches{ 0 };
+	int64 Queries{ 0 };
+
+	// Sessions examined by queries, including those which did not match. Low values mean queries were answered by one shard.
+	int64 EntriesScanned{ 0 };
+};
+
+/*
+ * FSessionDirectory is a thread-safe, in-memory index of advertised sessions, which hosts register with and clients page through.
+ * Sessions are sharded by match type and region, so a query for both reads a single shard, and each shard has its own lock,
+ * so queries on different shards never contend. Updates are applied in batches, taking each lock once per batch,
+ * and sessions which stop sending heartbeats are expired.
+ * The directory only exists in memory in the current process. It is not a LAN or network service, so other processes cannot query it.
+ */
+class MULTIPLAYERSESSIONS_API FSessionDirectory
+{
+public:
+	explicit FSessionDirectory(int32 InNumShards = 16);
+
+	// GetShared returns the process-wide directory, so every game instance in the process, e.g. PIE clients, sees the same sessions.
+	static TSharedRef<FSessionDirectory> GetShared();
+
+	// Register adds sessions, or replaces those with the same SessionId. Registering a session also counts as a heartbeat.
+	void Register(TArray<FSessionDirectoryEntry> Entries, double Now);
+
+	// Remove deletes sessions by SessionId, and returns how many were registered.
+	int32 Remove(const TArray<FString>& SessionIds);
+
+	// Heartbeat keeps sessions alive, and returns how many were registered.
+	int32 Heartbeat(const TArray<FString>& SessionIds, double Now);
+
+	// ExpireStale removes sessions without a heartbeat for ExpirySeconds, and returns how many were removed.
+	int32 ExpireStale(double Now, double ExpirySeconds);
+
+	// Query returns the first page of matching sessions registered after the query's cursor.
+	FSessionDirectoryPage Query(const FSessionDirectoryQuery& Query) const;
+
+	// Find copies a session by SessionId. Returns 'false' when it is not registered.
+	bool Find(const FString& SessionId, FSessionDirectoryEntry& OutEntry) const;
+
+	int32 Num() const;
+	FSessionDirectoryStats GetStats() const;
+
+private:
+	/*
+	 * FShard holds the sessions of some match type and region pairs, ordered by Sequence.
+	 */
+	struct FShard
+	{
+		mutable FRWLock Lock;
+		TArray<FSessionDirectoryEntry> Entries;
+
+		int32 IndexOf(uint64 Sequence) const;
+	};
+
+	/*
+	 * FLocation records where a session is stored, and when it last sent a heartbeat.
+	 */
+	struct FLocation
+	{
+		int32 ShardIndex{ 0 };
+		uint64 Sequence{ 0 };
+		double LastHeartbeatTime{ 0.0 };
+	};
+
+	int32 GetShardIndex(const FString& MatchType, const FString& Region) const;
+	void RemoveFromShards(const TArray<TArray<uint64>>& SequencesByShard);
+
+	TArray<TUniquePtr<FShard>> Shards;
+
+	// Locations are only changed with this lock held for writing, which also orders Sequence within each shard.
+	// It is always taken before a shard's lock. Queries do not take it.
+	mutable FRWLock LocationsLock;
+	TMap<FString, FLocation> Locations;
+	uint64 NextSequence{ 1 };
+
+	std::atomic<int64> Registered{ 0 };
+	std::atomic<int64> Updated{ 0 };
+	std::atomic<int64> Removed{ 0 };
+	std::atomic<int64> Expired{ 0 };
+	std::atomic<int64> Heartbeats{ 0 };
+	std::atomic<int64> Batches{ 0 };
+	mutable std::atomic<int64> Queries{ 0 };
+	mutable std::atomic<int64> EntriesScanned{ 0 };
+};
@@ -0,0 +1,117 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "SessionOperationQueue.h"
+
+/*
+ * FLatencyHistogram records durations in log-linear buckets, like an HDR histogram.
+ * Each power of two is split into 16 buckets, so percentiles are accurate to within about 3% at any scale,
+ * and recording a sample never allocates.
+ */
+class MULTIPLAYERSESSIONS_API FLatencyHistogram
+{
+public:
+	// Record adds one duration. Negative durations are recorded as zero.
+	void Record(double Seconds);
+	void Reset();
+
+	// Merge adds every sample of another histogram, e.g. one recorded by another thread.
+	void Merge(const FLatencyHistogram& Other);
+
+	// GetPercentile returns the duration below which Percentile (0-100) of the samples fall, or zero when empty.
+	double GetPercentile(double Percentile) const;
+
+	int64 GetCount() const { return Count; }
+	double GetMinSeconds() const { return Count > 0 ? MinMicroseconds * 1e-6 : 0.0; }
+	double GetMaxSeconds() const { return MaxMicroseconds * 1e-6; }
+	double GetMeanSeconds() const { return Count > 0 ? TotalMicroseconds * 1e-6 / Count : 0.0; }
+
+private:
+	static constexpr uint32 SubBucketBits = 4;
+	static constexpr uint32 SubBucketCount = 1 << SubBucketBits;
+
+	// Durations are recorded in microseconds, up to 2^40 (about 12 days).
+	static constexpr uint32 MaxExponent = 40;
+	static constexpr uint32 NumBuckets = (MaxExponent - SubBucketBits + 1) * SubBucketCount;
+
+	static uint32 GetBucketIndex(uint64 Microseconds);
+	static uint64 GetBucketLowerBound(uint32 Index);
+	static uint64 GetBucketWidth(uint32 Index);
+
+	uint32 Buckets[NumBuckets]{};
+	int64 Count{ 0 };
+	uint64 MinMicroseconds{ MAX_uint64 };
+	uint64 MaxMicroseconds{ 0 };
+	double TotalMicroseconds{ 0.0 };
+};
+
+/*
+ * FSessionOperationMetrics records the outcomes of one type of session operation.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionOperationMetrics
+{
+	// Calls made, including calls coalesced into an existing operation or served from the search cache.
+	int64 Requests{ 0 };
+	int64 Succeeded{ 0 };
+	int64 Failed{ 0 };
+
+	// Completions by result code, e.g. "SessionIsFull" or "TimedOut".
+	TMap<FString, int64> Results;
+
+	// Time from the call which queued the operation until its completion callback.
+	FLatencyHistogram Latency;
+};
+
+/*
+ * FSessionMetrics records latency and result counts for each session operation, and exports them for comparison across builds.
+ * Gauges are read from the operation queue when exporting, so they are always current.
+ */
+class MULTIPLAYERSESSIONS_API FSessionMetrics
+{
+public:
+	void NoteRequested(EMultiplayerSessionOperation Operation);
+
+	// NoteCompleted records an operation which ran, with its latency and result code.
+	void NoteCompleted(EMultiplayerSessionOperation Operation, double LatencySeconds, bool bSucceeded, const TCHAR* Result);
+
+	// NoteResult records a result code without a latency sample, e.g. for cached or cancelled requests.
+	void NoteResult(EMultiplayerSessionOperation Operation, bool bSucceeded, const TCHAR* Result);
+
+	void Reset();
+
+	const FSessionOperationMetrics& Get(EMultiplayerSessionOperation Operation) const { return Operations[static_cast<int32>(Operation)]; }
+
+	// Time the game thread has spent inside the subsystem's calls and callbacks.
+	double GetGameThreadSeconds() const { return GameThreadSeconds; }
+
+	/*
+	 * FGameThreadScope adds the time until it is destroyed to GetGameThreadSeconds.
+	 * Scopes nested inside another scope are not counted again, so every entry point into the subsystem can be wrapped.
+	 */
+	class FGameThreadScope
+	{
+	public:
+		explicit FGameThreadScope(FSessionMetrics& InMetrics);
+		~FGameThreadScope();
+
+	private:
+		FSessionMetrics& Metrics;
+		double StartTime{ 0.0 };
+	};
+
+	// ToCsv writes one row per operation, with latencies in milliseconds.
+	// The in-flight and queued gauges are summed over Queues, e.g. the search queue and every named session's queue.
+	FString ToCsv(const TArray<const FSessionOperationQueue*>& Queues) const;
+	FString ToJson(const TArray<const FSessionOperationQueue*>& Queues) const;
+
+	// ToSummary writes one human-readable line per operation, for the console.
+	TArray<FString> ToSummary(const TArray<const FSessionOperationQueue*>& Queues) const;
+
+private:
+	FSessionOperationMetrics Operations[NumMultiplayerSessionOperations];
+	double GameThreadSeconds{ 0.0 };
+	int32 GameThreadScopeDepth{ 0 };
+};
@@ -0,0 +1,163 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+
+/*
+ * EMultiplayerSessionOperation lists the backend operations which the subsystem serializes.
+ */
+enum class EMultiplayerSessionOperation : uint8
+{
+	Create,
+	Find,
+	Join,
+	Destroy,
+	Start,
+
+	// One page of a paged search. Pages share the search queue with Find, since providers run one search at a time.
+	FindPage,
+
+	// A coalesced update of a hosted session's advertised settings.
+	Update
+};
+
+constexpr int32 NumMultiplayerSessionOperations = 7;
+
+MULTIPLAYERSESSIONS_API const TCHAR* LexToString(EMultiplayerSessionOperation Operation);
+
+/*
+ * FSessionOperationQueueStats counts the work done and avoided by the operation queue.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionOperationQueueStats
+{
+	// Operations sent to the backend.
+	int32 Started{ 0 };
+
+	// Requests merged into an operation which was already queued or in flight.
+	int32 Coalesced{ 0 };
+
+	// Operations abandoned because the backend did not respond in time.
+	int32 TimedOut{ 0 };
+
+	// Queued operations removed before they started.
+	int32 Cancelled{ 0 };
+
+	// Completions which the backend delivered after their operation timed out, and which were dropped.
+	int32 StaleCompletions{ 0 };
+};
+
+/*
+ * FSessionOperationQueue runs session operations one at a time, in the order they were requested.
+ * An operation starts when the previous operation completes, so backend calls never overlap.
+ * Operations read their parameters when they start, so a queued operation can be coalesced with newer requests.
+ */
+class MULTIPLAYERSESSIONS_API FSessionOperationQueue
+{
+public:
+	DECLARE_DELEGATE_OneParam(FOnOperationTimedOut, EMultiplayerSessionOperation);
+
+	// InName identifies the queue in its Insights regions, e.g. the session name.
+	explicit FSessionOperationQueue(FString InName): Name(MoveTemp(InName)) {}
+
+	// Enqueue adds an operation, and starts it immediately if nothing is in flight.
+	// Execute must eventually lead to Complete being called with the same operation type.
+	void Enqueue(EMultiplayerSessionOperation Operation, TUniqueFunction<void()> Execute);
+
+	// Complete finishes the in-flight operation and starts the next queued operation.
+	// Calls for an operation which is not in flight are ignored.
+	void Complete(EMultiplayerSessionOperation Operation);
+
+	// CancelQueued removes every queued operation which has not started, and returns their types.
+	TArray<EMultiplayerSessionOperation> CancelQueued();
+
+	// Tick reports the in-flight operation through OnTimedOut once it has run for longer than TimeoutSeconds.
+	// The handler must complete the operation. When no handler is bound, the operation is completed without one.
+	void Tick(double Now, double TimeoutSeconds);
+
+	// RestartTimeout restarts the in-flight operation's timer, e.g. when a join moves on to another candidate.
+	void RestartTimeout();
+
+	// NoteCoalesced records a request which was merged into an existing operation rather than queued.
+	void NoteCoalesced() { Stats.Coalesced++; }
+
+	bool IsQueued(EMultiplayerSessionOperation Operation) const;
+	bool IsInFlight(EMultiplayerSessionOperation Operation) const;
+	bool IsQueuedOrInFlight(EMultiplayerSessionOperation Operation) const { return IsQueued(Operation) || IsInFlight(Operation); }
+	int32 NumQueued() const { return Queued.Num(); }
+	int32 NumQueued(EMultiplayerSessionOperation Operation) const;
+
+	// GetInFlightRequestTime returns when the in-flight operation was queued, or zero when nothing is in flight.
+	double GetInFlightRequestTime() const { return InFlight.IsSet() ? InFlightRequestTime : 0.0; }
+
+	FOnOperationTimedOut OnTimedOut;
+	FSessionOperationQueueStats Stats;
+
+private:
+	void StartNext();
+	FString GetTraceRegionName(EMultiplayerSessionOperation Operation, uint32 Serial, bool bQueued) const;
+
+	struct FQueuedOperation
+	{
+		EMultiplayerSessionOperation Operation;
+		TUniqueFunction<void()> Execute;
+		double RequestTime;
+		uint32 Serial;
+		FString RegionName;
+	};
+
+	FString Name;
+	uint32 NextSerial{ 0 };
+
+	TArray<FQueuedOperation> Queued;
+	TOptional<EMultiplayerSessionOperation> InFlight;
+	FString InFlightRegionName;
+	double InFlightStartTime{ 0.0 };
+	double InFlightRequestTime{ 0.0 };
+
+	// Set while StartNext is running, since operations may complete synchronously when they start.
+	bool bIsStartingNext{ false };
+};
+
+/*
+ * TSessionOperationPromises holds the promises made for one operation type by the subsystem's async API.
+ * Requests coalesced into the queued operation share its result, and their promises move to InFlight when it starts.
+ * Every promise must be fulfilled, so failed, cancelled and superseded operations fulfill theirs with a failure result.
+ */
+template <typename ResultType>
+class TSessionOperationPromises
+{
+public:
+	// Add returns a future for the queued operation, or for the in-flight operation when bInFlight is 'true'.
+	TFuture<ResultType> Add(bool bInFlight)
+	{
+		TArray<TPromise<ResultType>>& Promises = bInFlight ? InFlight : Queued;
+		return Promises.Emplace_GetRef().GetFuture();
+	}
+
+	// Start moves the queued operation's promises to the in-flight operation.
+	void Start()
+	{
+		InFlight.Append(MoveTemp(Queued));
+		Queued.Reset();
+	}
+
+	void FulfillInFlight(const ResultType& Result) { Fulfill(InFlight, Result); }
+	void FulfillQueued(const ResultType& Result) { Fulfill(Queued, Result); }
+
+private:
+	// Fulfill moves the promises out before setting them, since continuations may make new requests.
+	static void Fulfill(TArray<TPromise<ResultType>>& Promises, const ResultType& Result)
+	{
+		TArray<TPromise<ResultType>> Fulfilled = MoveTemp(Promises);
+		Promises.Reset();
+		for (TPromise<ResultType>& Promise : Fulfilled)
+		{
+			Promise.SetValue(Result);
+		}
+	}
+
+	TArray<TPromise<ResultType>> Queued;
+	TArray<TPromise<ResultType>> InFlight;
+};
@@ -0,0 +1,68 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "SessionScorer.generated.h"
+
+class FSessionSearchIndex;
+
+/*
+ * FMultiplayerSessionScoringWeights configures the cost used to rank sessions. Lower costs are better.
+ * Cost = PingWeight * Ping + EmptinessWeight * (OpenSlots / TotalSlots) + region and preferred setting mismatch costs.
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionScoringWeights
+{
+	GENERATED_BODY()
+
+	// Cost per millisecond of ping.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Matchmaking")
+	float PingWeight{ 1.f };
+
+	// Cost of a completely empty session. Positive values fill existing lobbies before empty ones.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Matchmaking")
+	float EmptinessWeight{ 50.f };
+
+	// Sessions outside this region cost RegionMismatchCost. Leave empty to ignore regions.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Matchmaking")
+	FString PreferredRegion;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Matchmaking")
+	float RegionMismatchCost{ 150.f };
+
+	// Each advertised setting which differs from these values costs PreferredSettingMismatchCost.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Matchmaking")
+	TMap<FName, FString> PreferredSettings;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Matchmaking")
+	float PreferredSettingMismatchCost{ 100.f };
+};
+
+/*
+ * FSessionScorer ranks indexed search results using a weighted cost.
+ * Costs are computed from the index's flat per-field arrays, in parallel chunks for large result sets.
+ */
+class MULTIPLAYERSESSIONS_API FSessionScorer
+{
+public:
+	// Score writes one cost per indexed result to OutCosts. Full sessions cost MAX_flt.
+	static void Score(const FSessionSearchIndex& Index, const FMultiplayerSessionScoringWeights& Weights, TArray<float>& OutCosts);
+
+	// RankBest writes the indices of the Count cheapest joinable results to OutIndices, cheapest first, and lower indices first among equal costs.
+	// When Candidates is set, only those indices are considered, e.g. the output of FSessionSearchIndex::FindAll.
+	static void RankBest(
+		const FSessionSearchIndex& Index,
+		const FMultiplayerSessionScoringWeights& Weights,
+		int32 Count,
+		TArray<int32>& OutIndices,
+		const TArray<int32>* Candidates = nullptr
+	);
+
+	// Result sets smaller than this are scored on the calling thread.
+	static constexpr int32 ParallelThreshold = 4096;
+
+	// Number of results scored by each parallel task.
+	static constexpr int32 ChunkSize = 2048;
+};
@@ -0,0 +1,108 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "SessionSearchFilter.h"
+
+class FOnlineSessionSearch;
+
+/*
+ * FSessionSearchCacheKey identifies a session search by the parameters which affect its results.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionSearchCacheKey
+{
+	bool bIsLanQuery{ false };
+	bool bUsePresence{ true };
+	FMultiplayerSessionSearchFilter Filter;
+	int32 MaxSearchResults{ 0 };
+
+	bool operator==(const FSessionSearchCacheKey& Other) const
+	{
+		return bIsLanQuery == Other.bIsLanQuery
+			&& bUsePresence == Other.bUsePresence
+			&& MaxSearchResults == Other.MaxSearchResults
+			&& Filter == Other.Filter;
+	}
+
+	friend uint32 GetTypeHash(const FSessionSearchCacheKey& Key)
+	{
+		uint32 Hash = GetTypeHash(Key.Filter);
+		Hash = HashCombine(Hash, GetTypeHash(Key.MaxSearchResults));
+		return HashCombine(Hash, (Key.bIsLanQuery ? 1u : 0u) | (Key.bUsePresence ? 2u : 0u));
+	}
+};
+
+/*
+ * FSessionSearchCacheStats counts cache lookups so the TTL can be tuned.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionSearchCacheStats
+{
+	// Lookups served from results younger than the TTL.
+	int32 Hits{ 0 };
+
+	// Lookups served from expired results while a refresh ran in the background.
+	int32 StaleHits{ 0 };
+
+	// Lookups which required a full search.
+	int32 Misses{ 0 };
+
+	// Background searches started to revalidate stale results.
+	int32 Refreshes{ 0 };
+
+	// Entries removed because they were too old to serve, or to make room for a newer search.
+	int32 Evictions{ 0 };
+};
+
+/*
+ * FSessionSearchCache saves completed session searches so repeated searches can be served without a backend query.
+ * Entries hold the search object itself, so serving a cached result never copies the result array.
+ * Entries which are too old to serve are evicted, and at most MaxEntries searches are kept, so memory stays bounded.
+ */
+class MULTIPLAYERSESSIONS_API FSessionSearchCache
+{
+public:
+	enum class ELookupResult : uint8
+	{
+		Miss,
+		Fresh,
+		Stale
+	};
+
+	// Lookup finds the saved search for a key and classifies it by age. Entries too old to serve are evicted.
+	ELookupResult Lookup(const FSessionSearchCacheKey& Key, double Now, TSharedPtr<FOnlineSessionSearch>& OutSearch);
+
+	// Store saves a completed search, replacing any existing entry for the key, and evicts entries which are too old to serve.
+	// When the cache is full, the oldest entry is evicted to make room.
+	void Store(const FSessionSearchCacheKey& Key, const TSharedRef<FOnlineSessionSearch>& Search, double Now);
+
+	// Invalidate removes all saved searches, e.g. after a join fails on a stale result.
+	void Invalidate();
+
+	// SetLifetimes sets how long entries are served fresh, and how long they may be served stale while revalidating.
+	void SetLifetimes(double InTTLSeconds, double InMaxStaleSeconds, bool bInStaleWhileRevalidate);
+
+	int32 Num() const { return Entries.Num(); }
+
+	FSessionSearchCacheStats Stats;
+
+	// Searches with different filters or result counts are cached separately, so the number of entries is capped.
+	static constexpr int32 MaxEntries = 16;
+
+private:
+	// GetMaxAge returns the age after which an entry can no longer be served.
+	double GetMaxAge() const { return bStaleWhileRevalidate ? MaxStaleSeconds : TTLSeconds; }
+
+	struct FEntry
+	{
+		TSharedPtr<FOnlineSessionSearch> Search;
+		double StoredAt{ 0.0 };
+	};
+
+	TMap<FSessionSearchCacheKey, FEntry> Entries;
+
+	double TTLSeconds{ 0.0 };
+	double MaxStaleSeconds{ 0.0 };
+	bool bStaleWhileRevalidate{ false };
+};
@@ -0,0 +1,90 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineKeyValuePair.h"
+
+class FOnlineSearchSettings;
+class FOnlineSessionSearchResult;
+
+/*
+ * FMultiplayerSessionSearchFilter describes which sessions a search should return.
+ * Empty or negative fields accept any value.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionSearchFilter
+{
+	FString MatchType;
+	int32 MinOpenSlots{ 0 };
+	int32 BuildId{ INDEX_NONE };
+	FString Region;
+
+	// Additional advertised settings which must be equal to the given values.
+	TArray<TPair<FName, FString>> CustomSettings;
+
+	// ApplyToQuerySettings adds the filter to a search's query settings, so providers which support it can filter server-side.
+	void ApplyToQuerySettings(FOnlineSearchSettings& QuerySettings) const;
+
+	// SupportsQueryFilters returns 'false' for providers which ignore query settings, such as the NULL (LAN) subsystem.
+	static bool SupportsQueryFilters(FName SubsystemName);
+
+	bool operator==(const FMultiplayerSessionSearchFilter& Other) const
+	{
+		return MinOpenSlots == Other.MinOpenSlots
+			&& BuildId == Other.BuildId
+			&& MatchType == Other.MatchType
+			&& Region == Other.Region
+			&& CustomSettings == Other.CustomSettings;
+	}
+
+	friend uint32 GetTypeHash(const FMultiplayerSessionSearchFilter& Filter)
+	{
+		uint32 Hash = GetTypeHash(Filter.MatchType);
+		Hash = HashCombine(Hash, GetTypeHash(Filter.MinOpenSlots));
+		Hash = HashCombine(Hash, GetTypeHash(Filter.BuildId));
+		Hash = HashCombine(Hash, GetTypeHash(Filter.Region));
+		for (const TPair<FName, FString>& Setting : Filter.CustomSettings)
+		{
+			Hash = HashCombine(Hash, HashCombine(GetTypeHash(Setting.Key), GetTypeHash(Setting.Value)));
+		}
+		return Hash;
+	}
+};
+
+/*
+ * FSessionSearchFilterMatcher applies a filter to search results locally, for providers which cannot filter server-side.
+ * Filter values are converted to variant data once, so each result is checked without allocating.
+ */
+class MULTIPLAYERSESSIONS_API FSessionSearchFilterMatcher
+{
+public:
+	explicit FSessionSearchFilterMatcher(const FMultiplayerSessionSearchFilter& Filter);
+
+	bool Matches(const FOnlineSessionSearchResult& Result) const;
+
+	// RemoveNonMatching compacts Results in place from StartIndex, preserving order. Returns the number of results removed.
+	int32 RemoveNonMatching(TArray<FOnlineSessionSearchResult>& Results, int32 StartIndex) const;
+
+	// EstimateResultBytes approximates the memory used by a deserialized result, for reporting filtering savings.
+	static int64 EstimateResultBytes(const FOnlineSessionSearchResult& Result);
+
+private:
+	int32 MinOpenSlots{ 0 };
+	int32 BuildId{ INDEX_NONE };
+
+	// Required settings, including MatchType and Region when they are set.
+	TArray<TPair<FName, FVariantData>> RequiredSettings;
+};
+
+/*
+ * FMultiplayerSearchFilterStats counts the results rejected by local filtering.
+ * With server-side filtering these results would not have been downloaded at all.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSearchFilterStats
+{
+	int32 SearchesFilteredServerSide{ 0 };
+	int32 SearchesFilteredLocally{ 0 };
+	int64 ResultsReceived{ 0 };
+	int64 ResultsRejectedLocally{ 0 };
+	int64 BytesRejectedLocally{ 0 };
+};
@@ -0,0 +1,70 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineKeyValuePair.h"
+
+class FOnlineSessionSearch;
+class FOnlineSessionSearchResult;
+
+/*
+ * FSessionSearchIndex stores the fields used to filter search results in flat arrays, one entry per result.
+ * MatchType and Region values are interned once when the index is built, so queries compare integers instead of strings.
+ * Queries return indices into the indexed search, which can be resolved to results by const reference.
+ */
+class MULTIPLAYERSESSIONS_API FSessionSearchIndex
+{
+public:
+	// Build indexes the results of a search. The index keeps a reference to the search, so results remain valid.
+	void Build(const TSharedRef<FOnlineSessionSearch>& InSearch);
+	void Reset();
+
+	bool IsBuiltFrom(const TSharedPtr<FOnlineSessionSearch>& InSearch) const { return Search == InSearch; }
+	int32 Num() const { return MatchTypeIds.Num(); }
+	const FOnlineSessionSearchResult& GetResult(int32 Index) const;
+
+	// FindMatchTypeId returns the interned ID of a MatchType, or INDEX_NONE if no indexed result uses it.
+	int32 FindMatchTypeId(const FString& MatchType) const;
+
+	// FindRegionId returns the interned ID of a Region, or INDEX_NONE if no indexed result uses it.
+	int32 FindRegionId(const FString& Region) const;
+
+	// FindFirst returns the index of the first result with the given MatchType and at least MinOpenSlots open connections.
+	// Pass INDEX_NONE as MatchTypeId to accept any MatchType. Returns INDEX_NONE when nothing matches.
+	int32 FindFirst(int32 MatchTypeId, int32 MinOpenSlots) const;
+
+	// FindAll appends the indices of all matching results to OutIndices. Callers may reuse OutIndices to avoid allocations.
+	void FindAll(int32 MatchTypeId, int32 MinOpenSlots, TArray<int32>& OutIndices) const;
+
+	// ResultHasMatchType compares a result's MatchType setting against a prepared value without copying the setting.
+	static bool ResultHasMatchType(const FOnlineSessionSearchResult& Result, const FVariantData& MatchType);
+
+	/**********************
+	Per-result field arrays
+	**********************/
+
+	TConstArrayView<int32> GetMatchTypeIds() const { return MatchTypeIds; }
+	TConstArrayView<int32> GetRegionIds() const { return RegionIds; }
+	TConstArrayView<int32> GetOpenSlots() const { return OpenSlots; }
+	TConstArrayView<int32> GetTotalSlots() const { return TotalSlots; }
+	TConstArrayView<int32> GetPings() const { return Pings; }
+	TConstArrayView<int32> GetBuildIds() const { return BuildIds; }
+
+private:
+	static int32 InternValue(TArray<FVariantData>& Values, const FOnlineSessionSearchResult& Result, FName Key);
+	static int32 FindValueId(const TArray<FVariantData>& Values, const FString& Value);
+
+	TSharedPtr<FOnlineSessionSearch> Search;
+
+	// Distinct values seen while building. A result's MatchType or Region ID is the value's position in these arrays.
+	TArray<FVariantData> MatchTypeValues;
+	TArray<FVariantData> RegionValues;
+
+	TArray<int32> MatchTypeIds;
+	TArray<int32> RegionIds;
+	TArray<int32> OpenSlots;
+	TArray<int32> TotalSlots;
+	TArray<int32> Pings;
+	TArray<int32> BuildIds;
+};
@@ -0,0 +1,109 @@
+// (c) 2023 Will Roberts
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+
+#include "SessionSearchFilter.h"
+
+class FOnlineSessionSearch;
+class UMultiplayerSessionsSubsystem;
+struct FMultiplayerSessionsPage;
+
+/*
+ * FSessionSearchPagerStats counts the pages a pager fetched and evicted, and the memory its pages held.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionSearchPagerStats
+{
+	// Pages fetched through the subsystem, of which some were fetched again after being evicted.
+	int32 PagesFetched{ 0 };
+	int32 PagesRefetched{ 0 };
+	int32 PagesEvicted{ 0 };
+
+	// Requests answered from retained pages, without a fetch.
+	int32 PagesServedFromMemory{ 0 };
+
+	// Estimated size of the retained pages, now and at their largest.
+	int64 RetainedBytes{ 0 };
+	int64 PeakRetainedBytes{ 0 };
+	int32 RetainedResults{ 0 };
+	int32 PeakRetainedResults{ 0 };
+};
+
+/*
+ * FSessionSearchPager pages through the sessions matching a filter, for lists which scroll through every session.
+ * Pages are fetched on demand with FindSessionsPageAsync, and once the retained pages exceed the memory cap,
+ * the least recently used pages are evicted, so memory stays flat however many sessions exist.
+ * Evicted pages keep only their cursor, so they can be fetched again when they scroll back into view.
+ * Pagers must be created with MakeShared, since fetches complete through a weak pointer.
+ */
+class MULTIPLAYERSESSIONS_API FSessionSearchPager : public TSharedFromThis<FSessionSearchPager>
+{
+public:
+	// PageSize and MaxRetainedBytes default to the SearchPageSize and SearchPageMaxRetainedKB settings when zero.
+	FSessionSearchPager(
+		UMultiplayerSessionsSubsystem* InSubsystem,
+		const FMultiplayerSessionSearchFilter& InFilter,
+		int32 InPageSize = 0,
+		int64 InMaxRetainedBytes = 0
+	);
+	~FSessionSearchPager();
+
+	// GetPageAsync returns a page's results, or nullptr when it could not be fetched.
+	// Each page's cursor comes from the page before it, so PageIndex must be less than GetNumKnownPages().
+	// Callers should release the page once it scrolls out of view, since pages they hold are not freed by eviction.
+	TFuture<TSharedPtr<FOnlineSessionSearch>> GetPageAsync(int32 PageIndex);
+
+	// GetRetainedPage returns a page without fetching it, or nullptr when it is not retained.
+	TSharedPtr<FOnlineSessionSearch> GetRetainedPage(int32 PageIndex);
+
+	// Reset drops every page and cursor, e.g. to refresh the list from the first page. Pending requests receive nullptr.
+	void Reset();
+
+	// GetNumKnownPages returns the number of pages whose cursor is known, which grows as pages are fetched.
+	int32 GetNumKnownPages() const { return PageCursors.Num(); }
+
+	// IsComplete returns 'true' once the last page has been fetched, after which GetNumKnownPages() is the number of pages.
+	bool IsComplete() const { return bReachedLastPage; }
+
+	int32 GetPageSize() const { return PageSize; }
+	const FSessionSearchPagerStats& GetStats() const { return Stats; }
+
+private:
+	/*
+	 * FRetainedPage is a page held in memory, and when it was last used.
+	 */
+	struct FRetainedPage
+	{
+		TSharedPtr<FOnlineSessionSearch> Search;
+		int64 Bytes{ 0 };
+		uint64 LastUsed{ 0 };
+	};
+
+	void OnPageFetched(int32 PageIndex, uint32 FetchGeneration, const FMultiplayerSessionsPage& Page);
+	void Retain(int32 PageIndex, const TSharedPtr<FOnlineSessionSearch>& Search);
+	void EvictBeyondCap(int32 KeepPageIndex);
+	void FailPendingRequests();
+
+	TWeakObjectPtr<UMultiplayerSessionsSubsystem> Subsystem;
+	FMultiplayerSessionSearchFilter Filter;
+	int32 PageSize{ 0 };
+	int64 MaxRetainedBytes{ 0 };
+
+	// The cursor of every known page, and which of them have been fetched before.
+	TArray<uint64> PageCursors;
+	TBitArray<> FetchedPages;
+	bool bReachedLastPage{ false };
+
+	TMap<int32, FRetainedPage> RetainedPages;
+	uint64 UseCount{ 0 };
+
+	// Requests waiting for a page which is being fetched, so each page has at most one fetch in flight.
+	TMap<int32, TArray<TPromise<TSharedPtr<FOnlineSessionSearch>>>> PendingRequests;
+
+	// Incremented by Reset, so pages fetched before it are ignored.
+	uint32 Generation{ 0 };
+
+	FSessionSearchPagerStats Stats;
+};